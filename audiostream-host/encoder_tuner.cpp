@@ -0,0 +1,142 @@
+#include "encoder_tuner.h"
+
+#include <opus/opus.h>
+#include <stdio.h>
+
+// 一个统计窗口的音频时长
+#define TUNER_WINDOW_US 500000
+// 连续这么多个好窗口才升一级，降级则一个坏窗口就执行，防止来回抖动
+#define TUNER_UPGRADE_WINDOWS 10
+
+// 编码耗时超过帧长的一半就有赶不上实时的风险，低于四分之一才认为有余量
+#define CPU_BAD_PERCENT 50
+#define CPU_GOOD_PERCENT 25
+#define JITTER_BAD_US 20000
+#define JITTER_GOOD_US 5000
+
+static const int complexity_ladder[] = {9, 7, 5, 3, 1};
+#define CPU_LEVELS (int)(sizeof(complexity_ladder) / sizeof(complexity_ladder[0]))
+
+struct link_step {
+    int bitrate_bps;
+    int cvbr;
+    int bandwidth;
+};
+static const link_step link_ladder[] = {
+    {120000, 0, OPUS_BANDWIDTH_FULLBAND},
+    {120000, 1, OPUS_BANDWIDTH_FULLBAND},
+    {96000, 1, OPUS_BANDWIDTH_FULLBAND},
+    {64000, 1, OPUS_BANDWIDTH_SUPERWIDEBAND},
+    {48000, 1, OPUS_BANDWIDTH_WIDEBAND},
+};
+#define LINK_LEVELS (int)(sizeof(link_ladder) / sizeof(link_ladder[0]))
+
+EncoderTuner::EncoderTuner(int frame_us)
+    : frame_us_(frame_us),
+      cpu_level_(0),
+      link_level_(0),
+      cpu_good_windows_(0),
+      link_good_windows_(0),
+      frames_(0),
+      encode_us_sum_(0),
+      max_send_queue_(0),
+      max_jitter_us_(0),
+      underruns_(0),
+      last_underruns_(0),
+      max_sink_queue_(0) {
+    update_settings();
+}
+
+void EncoderTuner::on_frame(int encode_us, int send_queue_bytes) {
+    frames_++;
+    encode_us_sum_ += encode_us;
+    if (send_queue_bytes > max_send_queue_) {
+        max_send_queue_ = send_queue_bytes;
+    }
+}
+
+void EncoderTuner::on_report(const link_report& report) {
+    if (report.jitter_us > max_jitter_us_) {
+        max_jitter_us_ = report.jitter_us;
+    }
+    if (report.sink_queue > max_sink_queue_) {
+        max_sink_queue_ = report.sink_queue;
+    }
+    underruns_ = report.underruns;
+}
+
+bool EncoderTuner::poll(encoder_settings* out) {
+    if (frames_ == 0 || (long long)frames_ * frame_us_ < TUNER_WINDOW_US) {
+        return false;
+    }
+
+    int encode_percent = (int)(encode_us_sum_ * 100 / ((long long)frames_ * frame_us_));
+    // 发送队列里超过两帧的数据说明链路跟不上当前码率
+    int frame_bytes = (int)((long long)current_.bitrate_bps * frame_us_ / 8000000);
+    int new_underruns = underruns_ - last_underruns_;
+
+    bool cpu_bad = encode_percent > CPU_BAD_PERCENT;
+    bool cpu_good = encode_percent < CPU_GOOD_PERCENT;
+    bool link_bad = max_send_queue_ > 2 * frame_bytes ||
+                    max_jitter_us_ > JITTER_BAD_US || new_underruns > 0;
+    bool link_good = max_send_queue_ <= frame_bytes &&
+                     max_jitter_us_ < JITTER_GOOD_US && new_underruns == 0;
+
+    int old_cpu = cpu_level_;
+    int old_link = link_level_;
+
+    if (cpu_bad) {
+        cpu_good_windows_ = 0;
+        if (cpu_level_ < CPU_LEVELS - 1) cpu_level_++;
+    } else if (cpu_good) {
+        if (++cpu_good_windows_ >= TUNER_UPGRADE_WINDOWS && cpu_level_ > 0) {
+            cpu_level_--;
+            cpu_good_windows_ = 0;
+        }
+    } else {
+        cpu_good_windows_ = 0;
+    }
+
+    if (link_bad) {
+        link_good_windows_ = 0;
+        if (link_level_ < LINK_LEVELS - 1) link_level_++;
+    } else if (link_good) {
+        if (++link_good_windows_ >= TUNER_UPGRADE_WINDOWS && link_level_ > 0) {
+            link_level_--;
+            link_good_windows_ = 0;
+        }
+    } else {
+        link_good_windows_ = 0;
+    }
+
+    printf("tuner: encode %d%% of frame, send queue %dB, jitter %dus, "
+           "underruns +%d, sink queue %d -> cpu level %d, link level %d\n",
+           encode_percent, max_send_queue_, max_jitter_us_, new_underruns,
+           max_sink_queue_, cpu_level_, link_level_);
+
+    frames_ = 0;
+    encode_us_sum_ = 0;
+    max_send_queue_ = 0;
+    max_jitter_us_ = 0;
+    max_sink_queue_ = 0;
+    last_underruns_ = underruns_;
+
+    if (old_cpu == cpu_level_ && old_link == link_level_) {
+        return false;
+    }
+    update_settings();
+    printf("tuner: complexity %d, bitrate %d, cvbr %d, bandwidth %d\n",
+           current_.complexity, current_.bitrate_bps, current_.cvbr,
+           current_.bandwidth);
+    if (out) {
+        *out = current_;
+    }
+    return true;
+}
+
+void EncoderTuner::update_settings() {
+    current_.complexity = complexity_ladder[cpu_level_];
+    current_.bitrate_bps = link_ladder[link_level_].bitrate_bps;
+    current_.cvbr = link_ladder[link_level_].cvbr;
+    current_.bandwidth = link_ladder[link_level_].bandwidth;
+}
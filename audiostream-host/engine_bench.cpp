@@ -0,0 +1,65 @@
+// 多路编码扩展性测试：固定路数，工作线程数从1到N，统计每核能实时支撑的路数
+// 用法: ./engine_bench [路数] [每路帧数] [最大线程数] [信号分析间隔，默认和app一样是8] [复杂度，默认9]
+// opus只在复杂度10时做信号分析，分析间隔在更低的复杂度下没有影响
+#include "stream_engine.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <thread>
+
+#define RATE 48000
+#define CHANNELS 2
+#define FRAME_SIZE (RATE / 1000 * 20)
+
+// 每一路一个不同频率的正弦加少量噪声，避免编码器走静音捷径
+struct synth_source {
+    double phase;
+    double step;
+    unsigned int seed;
+    bool operator()(opus_int16* pcm, int frame_size) {
+        for (int i = 0; i < frame_size; i++) {
+            seed = seed * 1103515245 + 12345;
+            int noise = (int)((seed >> 16) & 0x3ff) - 512;
+            opus_int16 v = (opus_int16)(8000 * sin(phase) + noise);
+            phase += step;
+            for (int c = 0; c < CHANNELS; c++) {
+                pcm[i * CHANNELS + c] = v;
+            }
+        }
+        return true;
+    }
+};
+
+int main(int argc, char** argv) {
+    int streams = argc > 1 ? atoi(argv[1]) : 32;
+    int frames = argc > 2 ? atoi(argv[2]) : 100;
+    int max_workers = argc > 3 ? atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+    int analysis_interval = argc > 4 ? atoi(argv[4]) : 8;
+    int complexity = argc > 5 ? atoi(argv[5]) : 9;
+    if (max_workers < 1) max_workers = 1;
+
+    printf("%d streams, %d frames each, 20ms frames, 1-%d workers, complexity %d, analysis every %d frames\n",
+           streams, frames, max_workers, complexity, analysis_interval);
+    printf("workers  wall(ms)  streams/core  deadline misses  stolen\n");
+    for (int w = 1; w <= max_workers; w++) {
+        StreamEngine engine(w, true);
+        for (int i = 0; i < streams; i++) {
+            session_config config;
+            config.rate = RATE;
+            config.channels = CHANNELS;
+            config.frame_size = FRAME_SIZE;
+            config.bitrate_bps = 120000;
+            config.complexity = complexity;
+            config.analysis_interval = analysis_interval;
+            synth_source src = {0, 2 * M_PI * (220 + 37 * i) / RATE, (unsigned int)i + 1};
+            config.source = src;
+            engine.add_session(config);
+        }
+        engine_stats st = engine.run(frames, false);
+        printf("%7d  %8lld  %12.2f  %15lld  %6lld\n", w, st.wall_us / 1000,
+               st.streams_per_core(), st.deadline_misses, st.stolen);
+    }
+    return 0;
+}
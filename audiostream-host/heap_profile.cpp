@@ -0,0 +1,187 @@
+// 板子堆分配采样结果的解析工具：读串口日志里heap_caps_profile_dump()的输出，用addr2line把调用地址
+// 换成函数名和行号，去掉malloc/heap_caps_*这些分配器自己的栈帧，按调用点合并后乘上采样间隔，
+// 按估算的未释放字节数从大到小输出
+// 用法: ./heap_profile build/hello_world.elf [日志文件] [行数]   不给日志文件就读标准输入
+//       环境变量ADDR2LINE可以换addr2line程序，默认xtensa-esp32-elf-addr2line
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#define MAX_DEPTH 8  // 和板子端MULTI_HEAP_PROFILE_MAX_DEPTH一致
+
+struct profile_site {
+    unsigned long long allocs, bytes, live_allocs, live_bytes;
+    std::vector<uint32_t> callers;
+};
+
+// 合并后的调用点，计数都是乘过采样间隔的估算值
+struct call_site {
+    std::string stack;
+    unsigned long long allocs, bytes, live_allocs, live_bytes;
+};
+
+// 分配器内部的函数，调用栈开头的这些帧不算调用点
+static const char* allocator_prefixes[] = {
+    "heap_caps_", "multi_heap_", "heap_profile_", "malloc", "calloc", "realloc", "_malloc_r", "_calloc_r",
+    "_realloc_r", "__wrap_", "pvPortMalloc", "esp_heap_", "operator new", "strdup", "_strdup_r",
+};
+
+static bool is_allocator(const std::string& func) {
+    for (const char* prefix : allocator_prefixes) {
+        if (func.compare(0, strlen(prefix), prefix) == 0) return true;
+    }
+    return false;
+}
+
+// 读最后一次dump，前面的dump都被后面的覆盖
+static bool read_profile(FILE* in, unsigned* interval, std::vector<profile_site>* sites) {
+    char line[512];
+    bool found = false;
+    while (fgets(line, sizeof(line), in)) {
+        const char* header = strstr(line, "heap profile: interval ");
+        if (header) {
+            sscanf(header, "heap profile: interval %u", interval);
+            sites->clear();
+            found = true;
+            continue;
+        }
+        // 串口日志的行首可能带着颜色控制符之类的东西
+        const char* hp = strstr(line, "HP ");
+        if (!hp || !found) continue;
+        profile_site site;
+        int consumed = 0;
+        if (sscanf(hp, "HP %llu %llu %llu %llu%n", &site.allocs, &site.bytes, &site.live_allocs, &site.live_bytes,
+                   &consumed) != 4) {
+            continue;
+        }
+        // 调用地址是"0x...:0x..."，最里层在前
+        const char* p = hp + consumed;
+        while (*p == ' ') p++;
+        while (*p && site.callers.size() < MAX_DEPTH) {
+            char* end;
+            unsigned long addr = strtoul(p, &end, 16);
+            if (end == p) break;
+            site.callers.push_back((uint32_t)addr);
+            p = (*end == ':') ? end + 1 : end;
+        }
+        sites->push_back(site);
+    }
+    return found;
+}
+
+// 一次调用addr2line解析所有地址，每个地址输出函数名和文件行号两行
+static std::map<uint32_t, std::pair<std::string, std::string>> symbolize(const char* elf,
+                                                                        const std::vector<uint32_t>& addrs) {
+    std::map<uint32_t, std::pair<std::string, std::string>> symbols;
+    if (addrs.empty()) return symbols;
+    const char* tool = getenv("ADDR2LINE");
+    std::string cmd = std::string(tool ? tool : "xtensa-esp32-elf-addr2line") + " -f -C -e '" + elf + "'";
+    for (uint32_t addr : addrs) {
+        // 返回地址指向call指令的下一条，减1落回call指令所在的那一行
+        char buf[16];
+        snprintf(buf, sizeof(buf), " 0x%x", addr - 1);
+        cmd += buf;
+    }
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (pipe == NULL) {
+        perror("popen error");
+        return symbols;
+    }
+    char func[512], where[512];
+    for (uint32_t addr : addrs) {
+        if (!fgets(func, sizeof(func), pipe) || !fgets(where, sizeof(where), pipe)) break;
+        func[strcspn(func, "\n")] = 0;
+        where[strcspn(where, "\n")] = 0;
+        // 只留文件名，完整路径太长
+        const char* file = strrchr(where, '/');
+        symbols[addr] = std::make_pair(std::string(func), std::string(file ? file + 1 : where));
+    }
+    pclose(pipe);
+    return symbols;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <elf> [log file] [lines]\n", argv[0]);
+        return 1;
+    }
+    FILE* in = stdin;
+    if (argc > 2 && strcmp(argv[2], "-") != 0) {
+        in = fopen(argv[2], "r");
+        if (in == NULL) {
+            perror("fopen error");
+            return 1;
+        }
+    }
+    size_t max_lines = argc > 3 ? atoi(argv[3]) : 30;
+
+    unsigned interval = 1;
+    std::vector<profile_site> sites;
+    if (!read_profile(in, &interval, &sites)) {
+        fprintf(stderr, "no heap profile in the log, is CONFIG_HEAP_PROFILING enabled?\n");
+        return 1;
+    }
+    if (in != stdin) fclose(in);
+
+    std::vector<uint32_t> addrs;
+    for (const profile_site& site : sites) {
+        addrs.insert(addrs.end(), site.callers.begin(), site.callers.end());
+    }
+    std::sort(addrs.begin(), addrs.end());
+    addrs.erase(std::unique(addrs.begin(), addrs.end()), addrs.end());
+    auto symbols = symbolize(argv[1], addrs);
+
+    // 去掉开头的分配器栈帧，剩下的栈相同的调用点合并
+    std::map<std::string, call_site> merged;
+    for (const profile_site& site : sites) {
+        size_t first = 0;
+        while (first + 1 < site.callers.size() && symbols.count(site.callers[first]) &&
+               is_allocator(symbols[site.callers[first]].first)) {
+            first++;
+        }
+        std::string stack;
+        for (size_t i = first; i < site.callers.size(); i++) {
+            auto it = symbols.find(site.callers[i]);
+            char addr[16];
+            snprintf(addr, sizeof(addr), "0x%08x", site.callers[i]);
+            if (!stack.empty()) stack += " <- ";
+            stack += it != symbols.end() ? it->second.first + " (" + it->second.second + ")" : addr;
+        }
+        if (stack.empty()) stack = "(no backtrace)";
+        call_site& c = merged[stack];
+        c.stack = stack;
+        c.allocs += site.allocs * interval;
+        c.bytes += site.bytes * interval;
+        c.live_allocs += site.live_allocs * interval;
+        c.live_bytes += site.live_bytes * interval;
+    }
+
+    std::vector<call_site> sorted;
+    call_site total = {"", 0, 0, 0, 0};
+    for (auto& it : merged) {
+        sorted.push_back(it.second);
+        total.allocs += it.second.allocs;
+        total.bytes += it.second.bytes;
+        total.live_allocs += it.second.live_allocs;
+        total.live_bytes += it.second.live_bytes;
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const call_site& a, const call_site& b) {
+        return a.live_bytes != b.live_bytes ? a.live_bytes > b.live_bytes : a.bytes > b.bytes;
+    });
+
+    printf("sampling interval %u, %zu call sites, estimated %llu bytes in %llu blocks not freed, "
+           "%llu bytes in %llu allocations in total\n",
+           interval, sorted.size(), total.live_bytes, total.live_allocs, total.bytes, total.allocs);
+    printf("%12s %8s %12s %10s  %s\n", "live bytes", "live", "total bytes", "allocs", "call site");
+    for (size_t i = 0; i < sorted.size() && i < max_lines; i++) {
+        const call_site& c = sorted[i];
+        printf("%12llu %8llu %12llu %10llu  %s\n", c.live_bytes, c.live_allocs, c.bytes, c.allocs, c.stack.c_str());
+    }
+    return 0;
+}
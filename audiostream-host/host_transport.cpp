@@ -0,0 +1,252 @@
+#include "host_transport.h"
+
+#include <errno.h>
+#include <linux/errqueue.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+int transport_buffer_bytes(int bitrate_bps, int latency_us, int max_packet) {
+    long long bytes = (long long)bitrate_bps / 8 * latency_us / 1000000;
+    return bytes < max_packet ? max_packet : (int)bytes;
+}
+
+TcpTransport::TcpTransport(int fd, const transport_config& config)
+    : fd_(fd), config_(config) {
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+int TcpTransport::tune(int bitrate_bps) {
+    config_.bitrate_bps = bitrate_bps;
+    int bytes = transport_buffer_bytes(bitrate_bps, config_.latency_us, config_.max_packet);
+    int one = 1;
+    if (setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes)) < 0 ||
+        setsockopt(fd_, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &bytes, sizeof(bytes)) < 0 ||
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) < 0) {
+        perror("setsockopt error");
+        return -1;
+    }
+    return 0;
+}
+
+int TcpTransport::send(const void* header, int header_len, const void* payload, int payload_len) {
+    iovec iov[2];
+    int n = 0;
+    if (header_len > 0) {
+        iov[n].iov_base = const_cast<void*>(header);
+        iov[n].iov_len = header_len;
+        n++;
+    }
+    iov[n].iov_base = const_cast<void*>(payload);
+    iov[n].iov_len = payload_len;
+    n++;
+
+    int total = header_len + payload_len;
+    int sent = 0;
+    // 阻塞socket一般一次写完，被信号打断或者缓冲满了只写进去一部分时接着写剩下的
+    while (sent < total) {
+        ssize_t len = writev(fd_, iov, n);
+        stats_.syscalls++;
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        sent += len;
+        while (n > 0 && (size_t)len >= iov[0].iov_len) {
+            len -= iov[0].iov_len;
+            iov[0] = iov[1];
+            n--;
+        }
+        if (n > 0) {
+            iov[0].iov_base = (char*)iov[0].iov_base + len;
+            iov[0].iov_len -= len;
+        }
+    }
+    stats_.frames++;
+    stats_.bytes += total;
+    return total;
+}
+
+UdpTransport::UdpTransport(const transport_config& config)
+    : fd_(-1),
+      config_(config),
+      zerocopy_(false),
+      next_zerocopy_id_(0),
+      zerocopy_sent_(0),
+      batch_len_(0),
+      batch_zerocopy_(false) {
+    memset(&stats_, 0, sizeof(stats_));
+    if (config_.batch < 1) config_.batch = 1;
+    if (config_.batch > TRANSPORT_MAX_BATCH) config_.batch = TRANSPORT_MAX_BATCH;
+}
+
+UdpTransport::~UdpTransport() {
+    if (fd_ >= 0) {
+        flush();
+        close(fd_);
+    }
+}
+
+int UdpTransport::open() {
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ == -1) {
+        perror("socket error");
+        return -1;
+    }
+    // UDP的积压主要在网卡队列里，发送缓冲按同样的时延目标给，满了就丢帧而不是越积越多
+    int bytes = transport_buffer_bytes(config_.bitrate_bps, config_.latency_us, config_.max_packet);
+    if (setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes)) < 0) {
+        perror("setsockopt error");
+    }
+    if (config_.zerocopy_min_bytes > 0) {
+        int one = 1;
+        if (setsockopt(fd_, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) {
+            zerocopy_ = true;
+        } else {
+            // UDP的MSG_ZEROCOPY要5.0以后的内核
+            perror("SO_ZEROCOPY unavailable, sending by copy");
+        }
+    }
+    return 0;
+}
+
+int UdpTransport::add_destination(const sockaddr_in& addr) {
+    destinations_.push_back(addr);
+    return (int)destinations_.size() - 1;
+}
+
+void UdpTransport::queue(int dest, const void* header, int header_len, const frame_payload& payload) {
+    bool zc = zerocopy_ && header_len + (int)payload->size() >= config_.zerocopy_min_bytes;
+    if (batch_len_ > 0 && zc != batch_zerocopy_) {
+        flush();
+    }
+    batch_zerocopy_ = zc;
+
+    int i = batch_len_++;
+    unsigned char* h;
+    if (zc) {
+        pending_.push_back(zerocopy_frame());
+        zerocopy_frame& f = pending_.back();
+        f.payload = payload;
+        h = f.header;
+    } else {
+        payloads_[i] = payload;
+        h = headers_[i];
+    }
+    if (header_len > TRANSPORT_MAX_HEADER) header_len = TRANSPORT_MAX_HEADER;
+    memcpy(h, header, header_len);
+
+    int n = 0;
+    if (header_len > 0) {
+        iovs_[i][n].iov_base = h;
+        iovs_[i][n].iov_len = header_len;
+        n++;
+    }
+    iovs_[i][n].iov_base = const_cast<unsigned char*>(payload->data());
+    iovs_[i][n].iov_len = payload->size();
+    n++;
+
+    msghdr& msg = msgs_[i].msg_hdr;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &destinations_[dest];
+    msg.msg_namelen = sizeof(sockaddr_in);
+    msg.msg_iov = iovs_[i];
+    msg.msg_iovlen = n;
+
+    if (batch_len_ >= config_.batch) {
+        flush();
+    }
+}
+
+int UdpTransport::flush() {
+    if (batch_len_ == 0) {
+        return 0;
+    }
+    int flags = batch_zerocopy_ ? MSG_ZEROCOPY : 0;
+    // 批次的零拷贝帧在pending_末尾，发出去的依次拿到内核的编号
+    size_t first = pending_.size() - (batch_zerocopy_ ? batch_len_ : 0);
+    int sent = 0;
+    while (sent < batch_len_) {
+        int n = sendmmsg(fd_, msgs_ + sent, batch_len_ - sent, flags);
+        stats_.syscalls++;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            // 零拷贝锁住的页超过了optmem/RLIMIT_MEMLOCK，先收完成通知再试
+            if (errno == ENOBUFS && batch_zerocopy_ && zerocopy_sent_ > 0) {
+                size_t before = zerocopy_sent_;
+                reap();
+                if (zerocopy_sent_ < before) {
+                    first -= before - zerocopy_sent_;
+                    continue;
+                }
+            }
+            break;
+        }
+        for (int i = sent; i < sent + n; i++) {
+            stats_.bytes += msgs_[i].msg_len;
+            if (batch_zerocopy_) {
+                pending_[first + i].id = next_zerocopy_id_++;
+                zerocopy_sent_++;
+            }
+        }
+        sent += n;
+    }
+    stats_.frames += sent;
+    stats_.dropped += batch_len_ - sent;
+
+    if (batch_zerocopy_) {
+        for (int i = sent; i < batch_len_; i++) {
+            pending_.pop_back();
+        }
+        stats_.zerocopy_frames += sent;
+    } else {
+        for (int i = 0; i < batch_len_; i++) {
+            payloads_[i].reset();
+        }
+    }
+    batch_len_ = 0;
+    return sent;
+}
+
+int UdpTransport::reap() {
+    while (zerocopy_sent_ > 0) {
+        char control[128];
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        stats_.syscalls++;
+        if (recvmsg(fd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;
+        }
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (cm->cmsg_level != SOL_IP || cm->cmsg_type != IP_RECVERR) continue;
+            const sock_extended_err* err = (const sock_extended_err*)CMSG_DATA(cm);
+            if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+            // 编号ee_info到ee_data的发送都完成了，通知按发送顺序来，比较时考虑32位回绕
+            unsigned int hi = err->ee_data;
+            while (zerocopy_sent_ > 0 && (int)(hi - pending_.front().id) >= 0) {
+                if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                    stats_.zerocopy_copied++;
+                }
+                pending_.pop_front();
+                zerocopy_sent_--;
+            }
+        }
+    }
+    return (int)zerocopy_sent_;
+}
@@ -0,0 +1,59 @@
+#ifndef ENCODER_TUNER_H
+#define ENCODER_TUNER_H
+
+// 编码参数自动调节：根据每帧编码耗时、发送队列积压和板子回传的抖动/欠载报告，
+// 在实时性和音质之间调整复杂度、码率、约束VBR和带宽。
+// 只包含控制逻辑，不碰socket和编码器，方便用模拟的链路轨迹测试(tuner_sim)。
+
+// 板子在每个确认包里回传的链路报告
+struct link_report {
+    int jitter_us;    // 到达抖动(RFC3550算法)
+    int underruns;    // 解码任务等不到数据的累计次数
+    int sink_queue;   // 板子解码队列里积压的包数
+};
+
+struct encoder_settings {
+    int complexity;
+    int bitrate_bps;
+    int cvbr;         // 1: 约束VBR
+    int bandwidth;    // OPUS_BANDWIDTH_*
+};
+
+class EncoderTuner {
+public:
+    // frame_us: 一个编码帧的音频时长
+    explicit EncoderTuner(int frame_us);
+
+    // 每编码并发送一帧调用一次
+    void on_frame(int encode_us, int send_queue_bytes);
+    // 收到板子报告时调用
+    void on_report(const link_report& report);
+    // 每个统计窗口结束时做一次决策，参数变化时返回true并写入out
+    bool poll(encoder_settings* out);
+
+    const encoder_settings& settings() const { return current_; }
+    int cpu_level() const { return cpu_level_; }
+    int link_level() const { return link_level_; }
+
+private:
+    void update_settings();
+
+    int frame_us_;
+    int cpu_level_;       // 0最好，越大复杂度越低
+    int link_level_;      // 0最好，越大码率/带宽越低
+    int cpu_good_windows_;
+    int link_good_windows_;
+
+    // 当前窗口的统计
+    int frames_;
+    long long encode_us_sum_;
+    int max_send_queue_;
+    int max_jitter_us_;
+    int underruns_;
+    int last_underruns_;
+    int max_sink_queue_;
+
+    encoder_settings current_;
+};
+
+#endif
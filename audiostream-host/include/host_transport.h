@@ -0,0 +1,125 @@
+#ifndef HOST_TRANSPORT_H
+#define HOST_TRANSPORT_H
+
+// 主机发送层：把编码好的帧交给内核时尽量少做系统调用、少拷贝。
+// TCP每帧一次writev，头和负载不用先拼到一块缓冲里。
+// UDP把多帧、多个目的地排成一批，一次sendmmsg发出；大的帧可以用MSG_ZEROCOPY，
+// 负载按引用计数共享，内核通知发送完成之前一直持有。
+// 发送缓冲按时延目标和码率计算，积压不会超过时延目标对应的音频时长。
+// 板子的协议：TCP上每个包前面是2字节大端的包长(tcp_packet_header())，板子按它分包，
+// 不能靠PSH，连着发的包可能被合并进一个段；UDP一个数据报就是一个包，没有包头。
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+// 编码帧的负载，多个目的地共享一份
+typedef std::shared_ptr<const std::vector<unsigned char>> frame_payload;
+
+#define TRANSPORT_MAX_HEADER 16
+// TCP包头的长度，和板子audio_mem.h的PACKET_HEADER_LEN一致
+#define TCP_PACKET_HEADER_LEN 2
+
+// 填TCP包头，len是包的字节数，不超过板子的MAX_AGGREGATE_PACKET
+inline void tcp_packet_header(unsigned char* header, int len) {
+    header[0] = (unsigned char)(len >> 8);
+    header[1] = (unsigned char)(len & 0xFF);
+}
+// 一次sendmmsg最多发的帧数，和内核的UIO_MAXIOV无关，只是批次数组的大小
+#define TRANSPORT_MAX_BATCH 64
+
+struct transport_config {
+    int latency_us;          // 发送缓冲里允许积压的音频时长
+    int bitrate_bps;         // 用来把时延目标换算成字节数
+    int max_packet;          // 一帧最大字节数，缓冲至少放得下一帧
+    int batch;               // UDP每次sendmmsg的最大帧数，1到TRANSPORT_MAX_BATCH
+    int zerocopy_min_bytes;  // 大于0时，不小于这个长度的UDP帧用MSG_ZEROCOPY发送
+};
+
+struct transport_stats {
+    long long frames;           // 发出的帧数，每个目的地各算一帧
+    long long bytes;
+    long long syscalls;         // writev/sendmsg/sendmmsg和读完成通知的次数
+    long long dropped;          // UDP发送缓冲满或出错没发出去的帧
+    long long zerocopy_frames;
+    long long zerocopy_copied;  // 内核退回成拷贝发送的零拷贝帧，比如回环和不支持分散/聚集的网卡
+};
+
+// 时延目标内按码率产生的字节数，至少一帧。
+// Linux会把设置的SO_SNDBUF翻倍来容纳skb的开销，并且有约4.5KB的下限，
+// 低码率时真正限住积压的是TCP_NOTSENT_LOWAT
+int transport_buffer_bytes(int bitrate_bps, int latency_us, int max_packet);
+
+class TcpTransport {
+public:
+    // fd是已经创建的TCP socket，连接前后都可以
+    TcpTransport(int fd, const transport_config& config);
+
+    // 按时延目标设置SO_SNDBUF、TCP_NOTSENT_LOWAT和TCP_NODELAY，码率变化时重新调用
+    int tune(int bitrate_bps);
+    // 一帧一次writev，返回发出的字节数，出错返回-1
+    int send(const void* header, int header_len, const void* payload, int payload_len);
+
+    int fd() const { return fd_; }
+    const transport_stats& stats() const { return stats_; }
+
+private:
+    int fd_;
+    transport_config config_;
+    transport_stats stats_;
+};
+
+class UdpTransport {
+public:
+    explicit UdpTransport(const transport_config& config);
+    ~UdpTransport();
+
+    // 创建socket并设置发送缓冲，零拷贝打不开时退回普通发送，出错返回-1
+    int open();
+    // 返回目的地编号
+    int add_destination(const sockaddr_in& addr);
+
+    // 把一帧排进批次，批次满了或者和批次的零拷贝与否不同时先flush
+    void queue(int dest, const void* header, int header_len, const frame_payload& payload);
+    // 一次sendmmsg发出排着的帧，返回发出的帧数，发不出去的丢掉计入dropped
+    int flush();
+    // 读零拷贝的完成通知，释放发完的负载，返回还在等通知的帧数
+    int reap();
+
+    int fd() const { return fd_; }
+    bool zerocopy() const { return zerocopy_; }
+    const transport_stats& stats() const { return stats_; }
+
+private:
+    // 零拷贝发送的帧，头和负载要保持不动直到内核通知完成，deque两端增删不会移动元素
+    struct zerocopy_frame {
+        unsigned int id;   // 内核按socket上成功的零拷贝发送依次编号
+        unsigned char header[TRANSPORT_MAX_HEADER];
+        frame_payload payload;
+    };
+
+    int fd_;
+    transport_config config_;
+    transport_stats stats_;
+    bool zerocopy_;
+    unsigned int next_zerocopy_id_;
+    size_t zerocopy_sent_;   // pending_开头已经发出、在等通知的帧数，后面是还没发的批次
+    std::vector<sockaddr_in> destinations_;
+
+    // 当前批次
+    int batch_len_;
+    // MSG_ZEROCOPY对整次sendmmsg生效，一个批次要么全是零拷贝帧，要么全不是。
+    // 零拷贝批次的帧放在pending_的末尾
+    bool batch_zerocopy_;
+    mmsghdr msgs_[TRANSPORT_MAX_BATCH];
+    iovec iovs_[TRANSPORT_MAX_BATCH][2];
+    unsigned char headers_[TRANSPORT_MAX_BATCH][TRANSPORT_MAX_HEADER];
+    frame_payload payloads_[TRANSPORT_MAX_BATCH];
+    std::deque<zerocopy_frame> pending_;
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef SINK_REACTOR_H
+#define SINK_REACTOR_H
+
+// 一个线程管理多个音箱连接的事件循环：所有socket非阻塞，挂在一个epoll上。
+// 每个连接有自己的输出队列，队列里是共享的编码帧(引用计数)，同一帧发给所有音箱只编码、存一份。
+// 连接沿用板子的停等协议：每发一个包等板子回一个链路报告，报告就是下一个包的发送额度(credit)。
+// 每个包前面带2字节的包长(tcp_packet_header())，板子按它分包。
+// 定时器用时间轮，负责节拍(每个编码周期广播一帧)、报告超时检测和断线重连的退避。
+
+#include <netinet/in.h>
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "encoder_tuner.h"
+#include "host_transport.h"
+
+// 哈希时间轮：每格一个tick，超过一圈的定时器记下还要转几圈。
+// 加入、取消O(1)，每个tick只看一格
+class TimerWheel {
+public:
+    TimerWheel(int tick_us, int slots);
+
+    // delay_us后执行cb，返回定时器编号
+    uint64_t add(long long now_us, long long delay_us, const std::function<void()>& cb);
+    void cancel(uint64_t id);
+    // 执行到now_us为止到期的定时器
+    void advance(long long now_us);
+    // 下一个tick的时间，给epoll_wait算超时
+    long long next_tick_us() const { return (current_ + 1) * tick_us_; }
+    size_t size() const { return index_.size(); }
+
+private:
+    struct timer {
+        uint64_t id;
+        long long rounds;
+        std::function<void()> cb;
+    };
+    typedef std::list<timer> slot;
+
+    int tick_us_;
+    std::vector<slot> slots_;
+    long long current_;   // 已经处理到的tick
+    uint64_t next_id_;
+    std::unordered_map<uint64_t, std::pair<int, slot::iterator>> index_;
+};
+
+struct reactor_config {
+    int credits;            // 不等报告最多连发的包数，板子的停等协议是1，小于1按1算。
+                            // 连发的包可能被TCP合并进一个段，板子靠包头里的包长分开
+    int max_queue;          // 每个连接最多排队的帧数，满了丢最旧的
+    int report_timeout_ms;  // 发出包后这么久没收到报告就断开重连
+    int reconnect_min_ms;   // 重连退避，失败一次翻一倍
+    int reconnect_max_ms;
+    transport_config transport;   // 发送缓冲按时延目标设置
+};
+
+struct sink_stats {
+    long long frames_sent;
+    long long frames_dropped;   // 队列满或者没连上时丢掉的帧
+    long long reports;
+    long long connects;
+    long long disconnects;
+    long long rtt_us_sum;       // 发出包到收到报告
+    long long rtt_us_max;
+    link_report last_report;
+};
+
+class SinkReactor {
+public:
+    explicit SinkReactor(const reactor_config& config);
+    ~SinkReactor();
+
+    // 返回连接编号，立即开始非阻塞连接
+    int add_sink(const sockaddr_in& addr);
+
+    // 把一帧排进所有已连接音箱的队列并尽量发出
+    void broadcast(const frame_payload& frame);
+    // period_us执行一次cb，第一次在period_us之后
+    void every(long long period_us, const std::function<void()>& cb);
+
+    // 处理事件和定时器直到until_us(steady_clock的微秒)
+    void run_until(long long until_us);
+
+    int connected() const;
+    const sink_stats& stats(int sink) const;
+    size_t sinks() const { return conns_.size(); }
+    // 定时器实际执行时间比预定晚的最大值
+    long long max_timer_lateness_us() const { return max_lateness_us_; }
+
+private:
+    enum conn_state { DISCONNECTED, CONNECTING, CONNECTED };
+    struct conn {
+        int id;
+        int fd;
+        conn_state state;
+        sockaddr_in addr;
+        std::deque<frame_payload> queue;
+        size_t head_offset;          // 队首帧已经写进去的字节数，包括包头
+        bool want_write;             // epoll里是否关注了EPOLLOUT
+        int credits;
+        std::deque<long long> sent_us;   // 在等报告的包的发送时间
+        unsigned char report[16];
+        int report_len;
+        int last_underruns;          // 报告里的欠载次数是8位回绕的
+        int backoff_ms;
+        uint64_t timeout_timer;
+        sink_stats stats;
+    };
+
+    void start_connect(conn* c);
+    void on_connected(conn* c);
+    void close_conn(conn* c, bool reconnect);
+    void on_readable(conn* c);
+    void flush(conn* c);
+    void update_events(conn* c, bool want_write);
+    void arm_timeout(conn* c);
+    void repeat(long long period_us, long long due_us, const std::function<void()>& cb);
+
+    reactor_config config_;
+    int epfd_;
+    TimerWheel timers_;
+    std::vector<conn*> conns_;
+    long long max_lateness_us_;
+};
+
+long long reactor_now_us();
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef STREAM_ENGINE_H
+#define STREAM_ENGINE_H
+
+// 多路编码引擎：一台主机同时给多个音箱/分区供流，每一路有自己的音源和OpusEncoder。
+// 固定数量的工作线程，每个线程一个任务队列，自己的队列空了就去别的线程偷任务；
+// 每一路有一个"主"线程，编码器在主线程上创建(首次访问分配到本地NUMA节点)，
+// 工作线程可以绑核。每个编码周期给每一路发一个编码任务，截止时间是周期结束。
+
+#include <opus/opus.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 取一帧PCM，返回false表示音源结束
+typedef std::function<bool(opus_int16* pcm, int frame_size)> pcm_source;
+// 一帧编码结果
+typedef std::function<void(const unsigned char* data, int len)> packet_sink;
+
+struct session_config {
+    opus_int32 rate;
+    int channels;
+    int frame_size;      // 每声道采样点数
+    int bitrate_bps;
+    int complexity;
+    int analysis_interval;   // OPUS_SET_ANALYSIS_INTERVAL，1是每帧都做信号分析(opus的默认)
+    pcm_source source;
+    packet_sink sink;
+};
+
+struct session_stats {
+    long long frames;
+    long long encode_us;
+    long long deadline_misses;   // 编码完成时已经过了本周期的截止时间
+    long long stolen;            // 被非主线程执行的次数
+};
+
+struct engine_stats {
+    long long frames;
+    long long audio_us;          // 编码的音频总时长
+    long long wall_us;
+    long long deadline_misses;
+    long long stolen;
+    int workers;
+    // 每个核能实时支撑的路数 = 音频时长 / 墙钟时间 / 线程数
+    double streams_per_core() const {
+        if (wall_us == 0 || workers == 0) return 0;
+        return (double)audio_us / wall_us / workers;
+    }
+};
+
+class StreamEngine {
+public:
+    // workers: 工作线程数；pin_cores: 第i个线程绑到第i个CPU
+    StreamEngine(int workers, bool pin_cores);
+    ~StreamEngine();
+
+    // 返回会话编号，必须在run之前调用
+    int add_session(const session_config& config);
+
+    // 运行frames个编码周期。realtime为true时按帧长节拍发任务，
+    // 否则上一周期完成就开始下一周期(用于测吞吐)。所有音源结束时提前返回
+    engine_stats run(int frames, bool realtime);
+
+    const session_stats& stats(int session) const;
+
+private:
+    struct session;
+    struct worker_queue {
+        std::mutex lock;
+        std::deque<int> jobs;
+    };
+
+    void worker_main(int id);
+    bool next_job(int id, int* job, bool* stolen);
+    void run_job(int id, int job, bool stolen);
+
+    int workers_;
+    bool pin_cores_;
+    std::vector<session*> sessions_;
+    std::vector<worker_queue*> queues_;
+    std::vector<std::thread> threads_;
+
+    // 一个周期的同步
+    std::mutex round_lock_;
+    std::condition_variable round_start_;
+    std::condition_variable round_done_;
+    long long round_;
+    int pending_;
+    std::atomic<int> queued_;
+    std::atomic<long long> deadline_us_;
+    bool stop_;
+};
+
+#endif
@@ -9,6 +9,11 @@
 #include <sys/time.h>
 #include<arpa/inet.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+
+#include "encoder_tuner.h"
+#include "host_transport.h"
 
 #define MAX_PACKET 1500
 #define MAX_FRAME_SIZE 6 * 960
@@ -21,9 +26,22 @@
 #define CHANNELS 2
 #define FRAMESIZE (RATE * CHANNELS * 2 * FRAMELEN / 1000)
 
+// 帧聚合：用repacketizer把多个编码帧合成一个Opus包再发送，降低每秒包数
+// 聚合等待的最大时延，板子端的解码缓冲按这个时长分配，两边要一致
+#define AGGREGATE_BUDGET_MS 40
+// 一个Opus包最多120ms
+#define AGGREGATE_MAX_FRAMES 48
+#define MAX_AGGREGATE_PACKET 1500
+// 发送缓冲里最多积压的音频时长，按当前码率换算成SO_SNDBUF和TCP_NOTSENT_LOWAT
+#define SEND_LATENCY_MS 40
+
 OpusEncoder* encoder_init(opus_int32 sampling_rate,
                           int channels,
                           int application);
+int update_aggregation(int aggregate, double airtime_us, int frame_us,
+                       int max_aggregate);
+int parse_link_report(const char* buff, int len, link_report* report);
+void apply_encoder_settings(OpusEncoder* enc, const encoder_settings& settings);
 
 int main() {
     // 初始化mpg123解码器
@@ -68,6 +86,28 @@ int main() {
 
     //初始化Opus编码器
     OpusEncoder* enc = encoder_init(rate, channels, OPUS_APPLICATION_AUDIO);
+
+    // 初始化repacketizer，聚合帧数在1和时延预算允许的最大值之间自适应
+    OpusRepacketizer* rp = opus_repacketizer_create();
+    int frame_us = frame_size * 1000 / (rate / 1000);
+    int max_aggregate = AGGREGATE_BUDGET_MS * 1000 / frame_us;
+    if (max_aggregate < 1) max_aggregate = 1;
+    if (max_aggregate > AGGREGATE_MAX_FRAMES) max_aggregate = AGGREGATE_MAX_FRAMES;
+    int aggregate = 1;
+    int pending = 0;
+    int pending_bytes = 0;   // 合成后包长的上限估计
+    unsigned char aggregate_buf[MAX_AGGREGATE_PACKET];
+    double airtime_us = 0;
+    // 编码参数根据编码耗时、发送队列和板子的链路报告自动调节
+    EncoderTuner tuner(frame_us);
+    encoder_settings tuned;
+    link_report report;
+    int send_queue = 0;
+    // 每秒统计一次包数和聚合级别
+    int packets_per_sec = 0;
+    int frames_per_sec = 0;
+    timeval stat_start, stat_now;
+    gettimeofday(&stat_start, NULL);
     timeval start, end,start1,end1;
     timeval start4, end4;
     int totalBytes;
@@ -112,10 +152,13 @@ printf( "The current date/time in Shanghai is: %s", strftime_buf);
 	
 	
 	recvbuf=300 ;
-	sendbuf =500;
 	
 	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &recvbuf, sizeof(int));
-	setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendbuf, sizeof(int));
+	// 发送缓冲不再固定500字节，由发送层按时延目标和码率设置，码率调整后跟着重设
+	transport_config tconfig = {SEND_LATENCY_MS * 1000, tuner.settings().bitrate_bps,
+	                            MAX_AGGREGATE_PACKET, 1, 0};
+	TcpTransport transport(fd, tconfig);
+	transport.tune(tconfig.bitrate_bps);
 	
 	recvbuf=0 ;
 	sendbuf =0;
@@ -150,8 +193,67 @@ printf( "The current date/time in Shanghai is: %s", strftime_buf);
         perror("connect error");
         return -1;
     }
-    char * buff;
+    char buff[30];
 	int a=0;
+
+    // 把攒着的帧合成一个包发出去并等板子的报告。合包失败只丢掉这几帧，不结束推流
+    auto send_aggregate = [&]() {
+        if (pending == 0) {
+            return;
+        }
+        int frames = pending;
+        int packet_len = opus_repacketizer_out(rp, aggregate_buf, MAX_AGGREGATE_PACKET);
+        opus_repacketizer_init(rp);
+        pending = 0;
+        pending_bytes = 0;
+        if (packet_len < 0) {
+            std::cout << "failed to repacketize " << frames << " frames: "
+                      << opus_strerror(packet_len) << std::endl;
+            return;
+        }
+
+        //*(int*)cbits_vtmp =tv;
+		gettimeofday(&start1, NULL);
+        // 包头是包长，和包一起一次writev发出去，板子按包长分包
+        unsigned char header[TCP_PACKET_HEADER_LEN];
+        tcp_packet_header(header, packet_len);
+        int len =transport.send(header,TCP_PACKET_HEADER_LEN,aggregate_buf,packet_len);
+		if (len>0){
+			a+=1;
+			//usleep(8000);
+        }
+        else{
+			transport.send(header,TCP_PACKET_HEADER_LEN,aggregate_buf,packet_len);
+        }
+		//int b=strlen(buff);
+		//printf("b=%d\n",b);
+		
+		//usleep(9350);
+		len=recv(fd,buff,30,0);
+		gettimeofday(&end1, NULL);
+		if (parse_link_report(buff, len, &report)) {
+			tuner.on_report(report);
+		}
+		// 发送到收到板子确认的时间作为这一包的空口时间
+		double elapsed_us = (end1.tv_sec - start1.tv_sec) * 1000000.0 +
+		                    (end1.tv_usec - start1.tv_usec);
+		airtime_us = airtime_us == 0 ? elapsed_us : airtime_us * 0.875 + elapsed_us * 0.125;
+		std::cout << "send+ack " << elapsed_us << "us, " << frames
+		          << " frames, " << packet_len << " bytes" << std::endl;
+
+		packets_per_sec++;
+		frames_per_sec += frames;
+		aggregate = update_aggregation(aggregate, airtime_us, frame_us, max_aggregate);
+
+		gettimeofday(&stat_now, NULL);
+		if (stat_now.tv_sec - stat_start.tv_sec >= 1) {
+			printf("aggregate %d frames: %d packets/s, %d frames/s, airtime %.0fus\n",
+			       aggregate, packets_per_sec, frames_per_sec, airtime_us);
+			packets_per_sec = 0;
+			frames_per_sec = 0;
+			stat_start = stat_now;
+		}
+    };
 	
 	
     for (totalBytes = 0;
@@ -174,35 +276,51 @@ printf( "The current date/time in Shanghai is: %s", strftime_buf);
 		gettimeofday(&start1, NULL);
         len_opus[counter] = opus_encode(enc,tst, frame_size, cbits_vtmp, MAX_PACKET_SIZE);				
 		gettimeofday(&end1, NULL);
-		std::cout << "opus_encode " << (end1.tv_usec - start1.tv_usec)<< "us" << std::endl;
+		int encode_us = (end1.tv_sec - start1.tv_sec) * 1000000 +
+		                (end1.tv_usec - start1.tv_usec);
+		std::cout << "opus_encode " << encode_us << "us" << std::endl;
+		// 内核发送队列里还没发出去的字节数，积压说明链路跟不上
+		if (ioctl(fd, SIOCOUTQ, &send_queue) < 0) {
+			send_queue = 0;
+		}
+		tuner.on_frame(encode_us, send_queue);
 		printf("len_opus[]=%d\n",len_opus[counter]);
         if (len_opus[counter] < 0) {
             std::cout << "failed to encode: "
                       << opus_strerror(len_opus[counter]) << std::endl;
+            continue;
         }
-        //*(int*)cbits_vtmp =tv;
-		gettimeofday(&start1, NULL);
-        int len =send(fd,cbits_vtmp,len_opus[counter],0);
-		gettimeofday(&end1, NULL);
-		std::cout << "send is" << (end1.tv_usec - start1.tv_usec)<< "us" << std::endl;
-		if (len>0){
-			std::cout << "len = "<<len<<std::endl;
-			a+=1;
-			std::cout << "a= "<<a<<std::endl;
-			//usleep(8000);
+        // 加上这一帧可能超出板子的包缓冲时，先把攒着的发出去。
+        // code 3的包每帧去掉自己的TOC，加上最多2字节的长度，包头是TOC和帧数各1字节
+        if (pending > 0 && pending_bytes + len_opus[counter] + 2 + 2 > MAX_AGGREGATE_PACKET) {
+            send_aggregate();
         }
-        else{
-			send(fd,cbits_vtmp,len_opus[counter],0);
+        // 编码帧在cbits里一直有效，直接交给repacketizer，不用拷贝
+        if (opus_repacketizer_cat(rp, cbits_vtmp, len_opus[counter]) != OPUS_OK) {
+            // 和攒着的帧TOC不同(编码器换了模式或带宽)，或者超过120ms：先发出去，这一帧开始新的一包
+            send_aggregate();
+            if (opus_repacketizer_cat(rp, cbits_vtmp, len_opus[counter]) != OPUS_OK) {
+                std::cout << "failed to aggregate frame, dropped" << std::endl;
+                cbits_vtmp = cbits_vtmp + len_opus[counter];
+                counter = counter + 1;
+                continue;
+            }
         }
-		//int b=strlen(buff);
-		//printf("b=%d\n",b);
-		
-		//usleep(9350);
-		gettimeofday(&start1, NULL);
-		len=recv(fd,buff,30,0);
-		gettimeofday(&end1, NULL);
-		std::cout << "       recv is" << (end1.tv_usec - start1.tv_usec)
-                  << "us" << std::endl;
+        pending++;
+        pending_bytes += len_opus[counter] + 2;
+        cbits_vtmp = cbits_vtmp + len_opus[counter];
+        counter = counter + 1;
+        // 新参数从下一帧开始生效，带宽变了TOC就不同，不能和攒着的帧合成一包，先发出去再调
+        if (tuner.poll(&tuned)) {
+            send_aggregate();
+            apply_encoder_settings(enc, tuned);
+            transport.tune(tuned.bitrate_bps);
+            continue;
+        }
+        if (pending < aggregate) {
+            continue;
+        }
+        send_aggregate();
         /*
 		if(a==2){
 			len=recv(fd,buff,sizeof(buff),0);
@@ -221,12 +339,12 @@ printf( "The current date/time in Shanghai is: %s", strftime_buf);
 		}*/
       //运行到此处说明接收成功，接受的数据存放在buff中
       //运行到此处说明send成功
-
-        // 数组地址向前移动编码长度
-        cbits_vtmp = cbits_vtmp + len_opus[counter];
-        counter = counter + 1;
     }
 
+    // 把最后不足一组的帧发出去
+    send_aggregate();
+    opus_repacketizer_destroy(rp);
+
     std::cout << "total pcm bytes is " << totalBytes << std::endl;
    /* gettimeofday(&end, NULL);
     std::cout << 1000 * (end.tv_sec - start.tv_sec) +
@@ -283,6 +401,10 @@ OpusEncoder* encoder_init(opus_int32 sampling_rate,
     opus_encoder_ctl(enc, OPUS_SET_FORCE_CHANNELS(forcechannels));//强制双声道
     opus_encoder_ctl(enc, OPUS_SET_DTX(use_dtx));				//不使用不连续传输 (DTX)，在静音或背景噪音期间降低比特率，主要适用于voip
     opus_encoder_ctl(enc, OPUS_SET_PACKET_LOSS_PERC(packet_loss_perc));//预期丢包，用降低比特率，来防丢包
+    // 信号类型已经固定为音乐，信号分析每8帧只跑连续3帧，省下的主要是tonality/MLP的计算
+    // 只有esp-player-sink/components/components/opus里的opus有这个请求，Makefile链接的就是它。
+    // opus只在复杂度10时做信号分析，现在的复杂度9(以及encoder_tuner降下来的)下这个设置不起作用
+    opus_encoder_ctl(enc, OPUS_SET_ANALYSIS_INTERVAL(8));
 	//opus_encoder_ctl(OPUS_SET_PREDICTION_DISABLED	(0))	//默认启用预测，LPC线性预测？不启用好像每一帧都有帧头，且会降低质量
 
     // opus_encoder_ctl(enc, OPUS_GET_LOOKAHEAD(&skip));
@@ -294,3 +416,43 @@ OpusEncoder* encoder_init(opus_int32 sampling_rate,
 
     return enc;
 }
+
+// 根据测得的每包空口时间（发送到收到确认）调整聚合帧数：
+// 一包的往返时间占到它所含音频时长的一半以上时，说明每包的固定开销太大，
+// 增加聚合帧数；低于四分之一时减少聚合帧数以降低时延。中间区间保持不变，防止来回抖动
+int update_aggregation(int aggregate, double airtime_us, int frame_us,
+                       int max_aggregate) {
+    double packet_us = (double)aggregate * frame_us;
+    if (airtime_us > packet_us / 2 && aggregate < max_aggregate) {
+        return aggregate + 1;
+    }
+    if (airtime_us < packet_us / 4 && aggregate > 1) {
+        return aggregate - 1;
+    }
+    return aggregate;
+}
+
+// 板子的确认包：前两个字节是"ok"，后面依次是解码队列积压包数(1字节)、
+// 欠载累计次数的低8位(1字节)、到达抖动(2字节大端，单位100us)
+int parse_link_report(const char* buff, int len, link_report* report) {
+    if (len < 6 || buff[0] != 'o' || buff[1] != 'k') {
+        return 0;
+    }
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(buff);
+    static int underruns = 0;
+    static unsigned char last_underruns = 0;
+    // 欠载计数在板子上按8位回绕，这里累加差值还原成累计值
+    underruns += (unsigned char)(p[3] - last_underruns);
+    last_underruns = p[3];
+    report->sink_queue = p[2];
+    report->underruns = underruns;
+    report->jitter_us = ((p[4] << 8) | p[5]) * 100;
+    return 1;
+}
+
+void apply_encoder_settings(OpusEncoder* enc, const encoder_settings& settings) {
+    opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(settings.complexity));
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(settings.bitrate_bps));
+    opus_encoder_ctl(enc, OPUS_SET_VBR_CONSTRAINT(settings.cvbr));
+    opus_encoder_ctl(enc, OPUS_SET_BANDWIDTH(settings.bandwidth));
+}
@@ -0,0 +1,255 @@
+// 事件循环的扩展性测试：回环上开N个桩音箱，SinkReactor每20ms给所有音箱广播一帧。
+// 桩音箱在另一个线程里，像板子一样按包头的包长分包，每收完一个包回一个10字节的链路报告；
+// 跑到一半时每8个音箱断开一个连接，模拟音箱重启，看重连。
+// 输出每种路数下发出/丢掉的帧、报告往返时间、节拍定时器的最大延迟，以及事件循环线程的CPU。
+// 额度大于1时连发的包会被合并进一个段，桩音箱按包头分包，包长不对直接退出。
+// 用法: ./reactor_bench [最大路数] [每轮秒数] [帧字节数] [额度]
+#include "sink_reactor.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define FRAME_US 20000
+#define BITRATE 120000
+#define REPORT_LEN 10
+
+static long long thread_cpu_us() {
+    rusage ru;
+    getrusage(RUSAGE_THREAD, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000LL + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+static sockaddr_in loopback(int port) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+// 桩音箱，每个一个监听端口，只接受一个连接，新连接进来就关掉旧的(和板子一样)
+struct stub_sink {
+    int listen_fd;
+    int fd;
+    int port;
+    unsigned char header[TCP_PACKET_HEADER_LEN];
+    int header_len;       // 当前包的包头已经收到的字节数
+    int remaining;        // 当前包还没收到的字节数
+};
+
+class StubSinks {
+public:
+    StubSinks(int count, int frame_bytes) : frame_bytes_(frame_bytes), stop_(false), drop_(false) {
+        ep_ = epoll_create1(0);
+        for (int i = 0; i < count; i++) {
+            stub_sink* s = new stub_sink();
+            s->fd = -1;
+            s->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            int one = 1;
+            setsockopt(s->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            sockaddr_in addr = loopback(0);
+            socklen_t len = sizeof(addr);
+            bind(s->listen_fd, (sockaddr*)&addr, sizeof(addr));
+            listen(s->listen_fd, 1);
+            getsockname(s->listen_fd, (sockaddr*)&addr, &len);
+            s->port = ntohs(addr.sin_port);
+            watch(s->listen_fd, s);
+            sinks_.push_back(s);
+        }
+        thread_ = std::thread([this] { loop(); });
+    }
+
+    ~StubSinks() {
+        stop_ = true;
+        thread_.join();
+        for (size_t i = 0; i < sinks_.size(); i++) {
+            if (sinks_[i]->fd >= 0) close(sinks_[i]->fd);
+            close(sinks_[i]->listen_fd);
+            delete sinks_[i];
+        }
+        close(ep_);
+    }
+
+    int port(int i) const { return sinks_[i]->port; }
+    // 让每8个音箱断开一个连接，在桩音箱线程里执行
+    void drop_some() { drop_ = true; }
+
+private:
+    void watch(int fd, stub_sink* s) {
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = (uint64_t)(uintptr_t)s;
+        epoll_ctl(ep_, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    void close_conn(stub_sink* s) {
+        epoll_ctl(ep_, EPOLL_CTL_DEL, s->fd, NULL);
+        close(s->fd);
+        s->fd = -1;
+    }
+
+    void loop() {
+        unsigned char report[REPORT_LEN] = {'o', 'k'};
+        epoll_event events[64];
+        while (!stop_) {
+            if (drop_.exchange(false)) {
+                for (size_t i = 0; i < sinks_.size(); i += 8) {
+                    if (sinks_[i]->fd >= 0) close_conn(sinks_[i]);
+                }
+            }
+            int n = epoll_wait(ep_, events, 64, 5);
+            for (int i = 0; i < n; i++) {
+                // 低位区分数据连接和监听socket
+                stub_sink* s = (stub_sink*)(uintptr_t)(events[i].data.u64 & ~1ULL);
+                if (events[i].data.u64 & 1) {
+                    on_data(s, report);
+                } else {
+                    on_accept(s);
+                }
+            }
+        }
+    }
+
+    void on_accept(stub_sink* s) {
+        int fd = accept4(s->listen_fd, NULL, NULL, SOCK_NONBLOCK);
+        if (fd < 0) return;
+        if (s->fd >= 0) close_conn(s);
+        s->fd = fd;
+        s->header_len = 0;
+        s->remaining = 0;
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = (uint64_t)(uintptr_t)s | 1;
+        epoll_ctl(ep_, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    void on_data(stub_sink* s, const unsigned char* report) {
+        static unsigned char buf[4096];
+        if (s->fd < 0) return;
+        for (;;) {
+            ssize_t len = recv(s->fd, buf, sizeof(buf), 0);
+            if (len == 0 || (len < 0 && errno != EAGAIN)) {
+                close_conn(s);
+                return;
+            }
+            if (len < 0) return;
+            for (ssize_t i = 0; i < len;) {
+                if (s->header_len < TCP_PACKET_HEADER_LEN) {
+                    s->header[s->header_len++] = buf[i++];
+                    if (s->header_len == TCP_PACKET_HEADER_LEN) {
+                        s->remaining = (s->header[0] << 8) | s->header[1];
+                        if (s->remaining != frame_bytes_) {
+                            fprintf(stderr, "stub sink: packet length %d, sent %d\n", s->remaining, frame_bytes_);
+                            exit(1);
+                        }
+                    }
+                    continue;
+                }
+                int take = len - i < s->remaining ? (int)(len - i) : s->remaining;
+                s->remaining -= take;
+                i += take;
+                if (s->remaining == 0) {
+                    s->header_len = 0;
+                    send(s->fd, report, REPORT_LEN, MSG_NOSIGNAL);
+                }
+            }
+        }
+    }
+
+    int frame_bytes_;
+    int ep_;
+    std::vector<stub_sink*> sinks_;
+    std::atomic<bool> stop_;
+    std::atomic<bool> drop_;
+    std::thread thread_;
+};
+
+static void run(int count, int seconds, int frame_bytes, int credits) {
+    StubSinks stubs(count, frame_bytes);
+    reactor_config config;
+    config.credits = credits;
+    config.max_queue = 8;
+    config.report_timeout_ms = 2000;
+    config.reconnect_min_ms = 50;
+    config.reconnect_max_ms = 2000;
+    config.transport.latency_us = 40000;
+    config.transport.bitrate_bps = BITRATE;
+    config.transport.max_packet = frame_bytes;
+    config.transport.batch = 1;
+    config.transport.zerocopy_min_bytes = 0;
+    SinkReactor reactor(config);
+    for (int i = 0; i < count; i++) {
+        reactor.add_sink(loopback(stubs.port(i)));
+    }
+    long long deadline = reactor_now_us() + 2000000;
+    while (reactor.connected() < count && reactor_now_us() < deadline) {
+        reactor.run_until(reactor_now_us() + 10000);
+    }
+
+    // 一帧编码结果所有音箱共享
+    int frame = 0;
+    long long frames = 0;
+    reactor.every(FRAME_US, [&] {
+        std::vector<unsigned char>* data = new std::vector<unsigned char>(frame_bytes, (unsigned char)frame++);
+        reactor.broadcast(frame_payload(data));
+        frames++;
+    });
+    long long start = reactor_now_us();
+    long long cpu = thread_cpu_us();
+    reactor.run_until(start + seconds * 1000000LL / 2);
+    stubs.drop_some();
+    reactor.run_until(start + seconds * 1000000LL);
+    long long cpu_us = thread_cpu_us() - cpu;
+    long long wall_us = reactor_now_us() - start;
+
+    sink_stats total;
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < count; i++) {
+        const sink_stats& s = reactor.stats(i);
+        total.frames_sent += s.frames_sent;
+        total.frames_dropped += s.frames_dropped;
+        total.reports += s.reports;
+        total.disconnects += s.disconnects;
+        total.connects += s.connects;
+        total.rtt_us_sum += s.rtt_us_sum;
+        if (s.rtt_us_max > total.rtt_us_max) total.rtt_us_max = s.rtt_us_max;
+    }
+    printf("%5d %8lld %9lld %7lld %8.0f %8lld %9lld %11d %7.1f%% %10.1f\n", count, frames * count,
+           total.frames_sent, total.frames_dropped, total.reports ? (double)total.rtt_us_sum / total.reports : 0,
+           total.rtt_us_max, reactor.max_timer_lateness_us(), (int)(total.connects - count),
+           100.0 * cpu_us / wall_us, (double)cpu_us / ((double)wall_us / 1000000) / count);
+}
+
+int main(int argc, char** argv) {
+    int max_sinks = argc > 1 ? atoi(argv[1]) : 256;
+    int seconds = argc > 2 ? atoi(argv[2]) : 4;
+    int frame_bytes = argc > 3 ? atoi(argv[3]) : BITRATE / 8 * FRAME_US / 1000000;
+    int credits = argc > 4 ? atoi(argv[4]) : 1;
+
+    // 每个音箱要3个fd(桩音箱的监听和连接、主机的连接)
+    rlimit lim;
+    getrlimit(RLIMIT_NOFILE, &lim);
+    lim.rlim_cur = lim.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &lim);
+
+    printf("%ds per run, one %d byte frame every %dms to every sink, %d credits, every 8th sink drops its "
+           "connection half way\n", seconds, frame_bytes, FRAME_US / 1000, credits);
+    printf("%5s %8s %9s %7s %8s %8s %9s %11s %8s %10s\n", "sinks", "frames", "sent", "dropped", "rtt(us)",
+           "max rtt", "late(us)", "reconnects", "cpu", "cpu us/s/sink");
+    for (int count = 16; count <= max_sinks; count *= 2) {
+        run(count, seconds, frame_bytes, credits);
+    }
+    return 0;
+}
@@ -0,0 +1,379 @@
+#include "sink_reactor.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <chrono>
+
+// 板子的链路报告长度，和audio_rx_raw.c的REPORT_LEN一致
+#define SINK_REPORT_LEN 10
+#define TIMER_TICK_US 1000
+#define TIMER_SLOTS 512
+
+long long reactor_now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+TimerWheel::TimerWheel(int tick_us, int slots)
+    : tick_us_(tick_us), slots_(slots), current_(reactor_now_us() / tick_us), next_id_(1) {}
+
+uint64_t TimerWheel::add(long long now_us, long long delay_us, const std::function<void()>& cb) {
+    long long target = (now_us + delay_us + tick_us_ - 1) / tick_us_;
+    if (target <= current_) target = current_ + 1;
+    long long n = (long long)slots_.size();
+    int s = (int)(target % n);
+    timer t = {next_id_++, (target - current_ - 1) / n, cb};
+    slots_[s].push_back(t);
+    index_[t.id] = std::make_pair(s, std::prev(slots_[s].end()));
+    return t.id;
+}
+
+void TimerWheel::cancel(uint64_t id) {
+    auto it = index_.find(id);
+    if (it == index_.end()) return;
+    slots_[it->second.first].erase(it->second.second);
+    index_.erase(it);
+}
+
+void TimerWheel::advance(long long now_us) {
+    long long until = now_us / tick_us_;
+    std::vector<std::function<void()>> due;
+    while (current_ < until) {
+        current_++;
+        slot& s = slots_[current_ % slots_.size()];
+        // 先从轮上摘下来再执行，回调里可以随便加、删定时器
+        for (slot::iterator it = s.begin(); it != s.end();) {
+            if (it->rounds > 0) {
+                it->rounds--;
+                ++it;
+                continue;
+            }
+            due.push_back(it->cb);
+            index_.erase(it->id);
+            it = s.erase(it);
+        }
+        for (size_t i = 0; i < due.size(); i++) {
+            due[i]();
+        }
+        due.clear();
+    }
+}
+
+SinkReactor::SinkReactor(const reactor_config& config)
+    : config_(config),
+      epfd_(epoll_create1(EPOLL_CLOEXEC)),
+      timers_(TIMER_TICK_US, TIMER_SLOTS),
+      max_lateness_us_(0) {
+    if (epfd_ < 0) {
+        perror("epoll_create1 error");
+    }
+    // 额度为0的话一个包也发不出去
+    if (config_.credits < 1) {
+        fprintf(stderr, "credits %d, using 1\n", config_.credits);
+        config_.credits = 1;
+    }
+}
+
+SinkReactor::~SinkReactor() {
+    for (size_t i = 0; i < conns_.size(); i++) {
+        if (conns_[i]->fd >= 0) {
+            close(conns_[i]->fd);
+        }
+        delete conns_[i];
+    }
+    close(epfd_);
+}
+
+int SinkReactor::add_sink(const sockaddr_in& addr) {
+    conn* c = new conn();
+    c->id = (int)conns_.size();
+    c->fd = -1;
+    c->state = DISCONNECTED;
+    c->addr = addr;
+    c->want_write = false;
+    c->backoff_ms = config_.reconnect_min_ms;
+    memset(&c->stats, 0, sizeof(c->stats));
+    conns_.push_back(c);
+    start_connect(c);
+    return c->id;
+}
+
+void SinkReactor::start_connect(conn* c) {
+    c->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (c->fd < 0) {
+        perror("socket error");
+        close_conn(c, true);
+        return;
+    }
+    TcpTransport(c->fd, config_.transport).tune(config_.transport.bitrate_bps);
+    c->state = CONNECTING;
+    epoll_event ev;
+    ev.events = EPOLLOUT;
+    ev.data.ptr = c;
+    epoll_ctl(epfd_, EPOLL_CTL_ADD, c->fd, &ev);
+    if (connect(c->fd, (sockaddr*)&c->addr, sizeof(c->addr)) == 0) {
+        on_connected(c);
+    } else if (errno != EINPROGRESS) {
+        close_conn(c, true);
+    }
+}
+
+void SinkReactor::on_connected(conn* c) {
+    c->state = CONNECTED;
+    c->credits = config_.credits;
+    c->head_offset = 0;
+    c->report_len = 0;
+    c->last_underruns = -1;
+    c->sent_us.clear();
+    c->backoff_ms = config_.reconnect_min_ms;
+    c->stats.connects++;
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    epoll_ctl(epfd_, EPOLL_CTL_MOD, c->fd, &ev);
+    c->want_write = false;
+}
+
+void SinkReactor::close_conn(conn* c, bool reconnect) {
+    if (c->fd >= 0) {
+        epoll_ctl(epfd_, EPOLL_CTL_DEL, c->fd, NULL);
+        close(c->fd);
+        c->fd = -1;
+    }
+    if (c->state == CONNECTED) {
+        c->stats.disconnects++;
+    }
+    c->state = DISCONNECTED;
+    c->want_write = false;
+    c->stats.frames_dropped += c->queue.size();
+    c->queue.clear();
+    c->sent_us.clear();
+    timers_.cancel(c->timeout_timer);
+    c->timeout_timer = 0;
+    if (reconnect) {
+        timers_.add(reactor_now_us(), c->backoff_ms * 1000LL, [this, c] { start_connect(c); });
+        c->backoff_ms = c->backoff_ms * 2 > config_.reconnect_max_ms ? config_.reconnect_max_ms : c->backoff_ms * 2;
+    }
+}
+
+void SinkReactor::update_events(conn* c, bool want_write) {
+    if (c->want_write == want_write) {
+        return;
+    }
+    epoll_event ev;
+    ev.events = want_write ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    ev.data.ptr = c;
+    epoll_ctl(epfd_, EPOLL_CTL_MOD, c->fd, &ev);
+    c->want_write = want_write;
+}
+
+void SinkReactor::arm_timeout(conn* c) {
+    timers_.cancel(c->timeout_timer);
+    c->timeout_timer = 0;
+    if (c->sent_us.empty()) {
+        return;
+    }
+    c->timeout_timer = timers_.add(reactor_now_us(), config_.report_timeout_ms * 1000LL, [this, c] {
+        c->timeout_timer = 0;
+        fprintf(stderr, "sink %d: no report for %dms, reconnecting\n", c->id, config_.report_timeout_ms);
+        close_conn(c, true);
+    });
+}
+
+// 报告格式见audio_rx_raw.c的link_report()
+void SinkReactor::on_readable(conn* c) {
+    bool got_report = false;
+    for (;;) {
+        ssize_t len = recv(c->fd, c->report + c->report_len, SINK_REPORT_LEN - c->report_len, 0);
+        if (len == 0 || (len < 0 && errno != EAGAIN && errno != EINTR)) {
+            close_conn(c, true);
+            return;
+        }
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        c->report_len += len;
+        if (c->report_len < SINK_REPORT_LEN) {
+            continue;
+        }
+        c->report_len = 0;
+        const unsigned char* p = c->report;
+        if (p[0] != 'o' || p[1] != 'k') {
+            fprintf(stderr, "sink %d: bad report\n", c->id);
+            close_conn(c, true);
+            return;
+        }
+        link_report& r = c->stats.last_report;
+        r.sink_queue = p[2];
+        if (c->last_underruns >= 0) {
+            r.underruns += (unsigned char)(p[3] - c->last_underruns);
+        }
+        c->last_underruns = p[3];
+        r.jitter_us = ((p[4] << 8) | p[5]) * 100;
+        c->stats.reports++;
+        if (!c->sent_us.empty()) {
+            long long rtt = reactor_now_us() - c->sent_us.front();
+            c->sent_us.pop_front();
+            c->stats.rtt_us_sum += rtt;
+            if (rtt > c->stats.rtt_us_max) c->stats.rtt_us_max = rtt;
+        }
+        if (c->credits < config_.credits) {
+            c->credits++;
+        }
+        got_report = true;
+    }
+    if (got_report) {
+        arm_timeout(c);
+        flush(c);
+    }
+}
+
+void SinkReactor::flush(conn* c) {
+    bool armed = !c->sent_us.empty();
+    while (c->credits > 0 && !c->queue.empty()) {
+        const std::vector<unsigned char>& frame = *c->queue.front();
+        // 包头和包一次sendmsg写进去，板子按包头里的包长分包。额度和TCP_NOTSENT_LOWAT保证写的时候缓冲基本是空的，
+        // 只写进去一部分的情况很少，剩下的等可写时接着写
+        unsigned char header[TCP_PACKET_HEADER_LEN];
+        tcp_packet_header(header, (int)frame.size());
+        iovec iov[2];
+        int n = 0;
+        if (c->head_offset < TCP_PACKET_HEADER_LEN) {
+            iov[n].iov_base = header + c->head_offset;
+            iov[n].iov_len = TCP_PACKET_HEADER_LEN - c->head_offset;
+            n++;
+        }
+        size_t payload_offset = c->head_offset > TCP_PACKET_HEADER_LEN ? c->head_offset - TCP_PACKET_HEADER_LEN : 0;
+        iov[n].iov_base = const_cast<unsigned char*>(frame.data()) + payload_offset;
+        iov[n].iov_len = frame.size() - payload_offset;
+        n++;
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n;
+        ssize_t len = sendmsg(c->fd, &msg, MSG_NOSIGNAL);
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                update_events(c, true);
+                return;
+            }
+            close_conn(c, true);
+            return;
+        }
+        c->head_offset += len;
+        if (c->head_offset < TCP_PACKET_HEADER_LEN + frame.size()) {
+            update_events(c, true);
+            return;
+        }
+        c->queue.pop_front();
+        c->head_offset = 0;
+        c->credits--;
+        c->sent_us.push_back(reactor_now_us());
+        c->stats.frames_sent++;
+    }
+    if (c->want_write) {
+        update_events(c, false);
+    }
+    if (!armed && !c->sent_us.empty()) {
+        arm_timeout(c);
+    }
+}
+
+void SinkReactor::broadcast(const frame_payload& frame) {
+    for (size_t i = 0; i < conns_.size(); i++) {
+        conn* c = conns_[i];
+        if (c->state != CONNECTED) {
+            c->stats.frames_dropped++;
+            continue;
+        }
+        if ((int)c->queue.size() >= config_.max_queue) {
+            // 丢最旧的，写了一半的队首不能丢；队列里只有它(max_queue小于2)时丢新来的这一帧
+            size_t oldest = c->head_offset > 0 ? 1 : 0;
+            c->stats.frames_dropped++;
+            if (oldest >= c->queue.size()) {
+                continue;
+            }
+            c->queue.erase(c->queue.begin() + oldest);
+        }
+        c->queue.push_back(frame);
+        flush(c);
+    }
+}
+
+void SinkReactor::every(long long period_us, const std::function<void()>& cb) {
+    repeat(period_us, reactor_now_us() + period_us, cb);
+}
+
+void SinkReactor::repeat(long long period_us, long long due_us, const std::function<void()>& cb) {
+    timers_.add(reactor_now_us(), due_us - reactor_now_us(), [this, period_us, due_us, cb] {
+        long long now = reactor_now_us();
+        if (now - due_us > max_lateness_us_) {
+            max_lateness_us_ = now - due_us;
+        }
+        cb();
+        // 按预定的时间排下一次，不累积误差；落后超过一个周期的跳过
+        long long next = due_us + period_us;
+        while (next <= now) {
+            next += period_us;
+        }
+        repeat(period_us, next, cb);
+    });
+}
+
+void SinkReactor::run_until(long long until_us) {
+    epoll_event events[64];
+    for (;;) {
+        long long now = reactor_now_us();
+        timers_.advance(now);
+        if (now >= until_us) {
+            break;
+        }
+        long long wake = timers_.next_tick_us() < until_us ? timers_.next_tick_us() : until_us;
+        int timeout_ms = (int)((wake - now + 999) / 1000);
+        int n = epoll_wait(epfd_, events, 64, timeout_ms);
+        for (int i = 0; i < n; i++) {
+            conn* c = (conn*)events[i].data.ptr;
+            uint32_t e = events[i].events;
+            if (c->state == CONNECTING) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err != 0) {
+                    close_conn(c, true);
+                } else {
+                    on_connected(c);
+                }
+                continue;
+            }
+            if (c->state != CONNECTED) {
+                continue;
+            }
+            if (e & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                on_readable(c);
+            }
+            if (c->state == CONNECTED && (e & EPOLLOUT)) {
+                flush(c);
+            }
+        }
+    }
+}
+
+int SinkReactor::connected() const {
+    int n = 0;
+    for (size_t i = 0; i < conns_.size(); i++) {
+        n += conns_[i]->state == CONNECTED;
+    }
+    return n;
+}
+
+const sink_stats& SinkReactor::stats(int sink) const {
+    return conns_[sink]->stats;
+}
@@ -0,0 +1,268 @@
+#include "stream_engine.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#include <chrono>
+
+#define MAX_ENGINE_PACKET 4000
+
+struct StreamEngine::session {
+    session_config config;
+    int home;                     // 主线程编号
+    OpusEncoder* enc;
+    std::vector<opus_int16> pcm;
+    unsigned char packet[MAX_ENGINE_PACKET];
+    bool finished;
+    session_stats stats;
+};
+
+static long long now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+StreamEngine::StreamEngine(int workers, bool pin_cores)
+    : workers_(workers < 1 ? 1 : workers),
+      pin_cores_(pin_cores),
+      round_(0),
+      pending_(0),
+      queued_(0),
+      deadline_us_(0),
+      stop_(false) {
+    for (int i = 0; i < workers_; i++) {
+        queues_.push_back(new worker_queue);
+    }
+}
+
+StreamEngine::~StreamEngine() {
+    {
+        std::lock_guard<std::mutex> guard(round_lock_);
+        stop_ = true;
+    }
+    round_start_.notify_all();
+    for (size_t i = 0; i < threads_.size(); i++) {
+        threads_[i].join();
+    }
+    for (size_t i = 0; i < sessions_.size(); i++) {
+        if (sessions_[i]->enc) {
+            opus_encoder_destroy(sessions_[i]->enc);
+        }
+        delete sessions_[i];
+    }
+    for (size_t i = 0; i < queues_.size(); i++) {
+        delete queues_[i];
+    }
+}
+
+int StreamEngine::add_session(const session_config& config) {
+    // 所有会话共用一个编码节拍，帧长必须一致
+    if (!threads_.empty() ||
+        (!sessions_.empty() &&
+         (long long)config.frame_size * sessions_[0]->config.rate !=
+             (long long)sessions_[0]->config.frame_size * config.rate)) {
+        return -1;
+    }
+    session* s = new session;
+    s->config = config;
+    s->home = (int)sessions_.size() % workers_;
+    s->enc = NULL;
+    s->finished = false;
+    s->stats = session_stats();
+    sessions_.push_back(s);
+    return (int)sessions_.size() - 1;
+}
+
+const session_stats& StreamEngine::stats(int session) const {
+    return sessions_[session]->stats;
+}
+
+engine_stats StreamEngine::run(int frames, bool realtime) {
+    engine_stats total = engine_stats();
+    total.workers = workers_;
+    if (sessions_.empty()) {
+        return total;
+    }
+
+    if (threads_.empty()) {
+        // 每个线程先创建自己负责的编码器，等全部创建完再开始
+        {
+            std::lock_guard<std::mutex> guard(round_lock_);
+            pending_ = workers_;
+        }
+        for (int i = 0; i < workers_; i++) {
+            threads_.push_back(std::thread(&StreamEngine::worker_main, this, i));
+        }
+        std::unique_lock<std::mutex> lock(round_lock_);
+        round_done_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+    const session_config& first = sessions_[0]->config;
+    long long period_us = (long long)first.frame_size * 1000000 / first.rate;
+    long long start = now_us();
+    long long release = start;
+
+    for (int f = 0; f < frames; f++) {
+        if (realtime) {
+            long long wait = release - now_us();
+            if (wait > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(wait));
+            }
+        } else {
+            release = now_us();
+        }
+
+        int jobs = 0;
+        for (size_t i = 0; i < sessions_.size(); i++) {
+            jobs += !sessions_[i]->finished && sessions_[i]->enc;
+        }
+        if (jobs == 0) {
+            break;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(round_lock_);
+            // 计数先发布再放任务：上一周期还在领任务的线程可能马上就取走新任务并减计数
+            pending_ = jobs;
+            queued_ = jobs;
+            deadline_us_ = release + period_us;
+        }
+        for (size_t i = 0; i < sessions_.size(); i++) {
+            session* s = sessions_[i];
+            if (s->finished || !s->enc) continue;
+            worker_queue* q = queues_[s->home];
+            std::lock_guard<std::mutex> guard(q->lock);
+            q->jobs.push_back((int)i);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(round_lock_);
+            round_++;
+            round_start_.notify_all();
+            round_done_.wait(lock, [this] { return pending_ == 0; });
+        }
+        release += period_us;
+    }
+
+    total.wall_us = now_us() - start;
+    for (size_t i = 0; i < sessions_.size(); i++) {
+        const session_stats& st = sessions_[i]->stats;
+        total.frames += st.frames;
+        total.audio_us += st.frames * sessions_[i]->config.frame_size * 1000000LL /
+                          sessions_[i]->config.rate;
+        total.deadline_misses += st.deadline_misses;
+        total.stolen += st.stolen;
+    }
+    return total;
+}
+
+void StreamEngine::worker_main(int id) {
+    if (pin_cores_) {
+        // 线程数多于CPU数时轮流绑
+        int ncpu = (int)std::thread::hardware_concurrency();
+        int cpu = ncpu > 0 ? id % ncpu : id;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+            fprintf(stderr, "worker %d: failed to pin to cpu %d\n", id, cpu);
+        }
+    }
+
+    // 编码器状态和PCM缓冲在主线程上分配和首次写入，绑核后落在本地内存节点
+    for (size_t i = 0; i < sessions_.size(); i++) {
+        session* s = sessions_[i];
+        if (s->home != id) continue;
+        int err;
+        s->enc = opus_encoder_create(s->config.rate, s->config.channels,
+                                     OPUS_APPLICATION_AUDIO, &err);
+        if (err != OPUS_OK) {
+            fprintf(stderr, "session %d: cannot create encoder: %s\n", (int)i,
+                    opus_strerror(err));
+            s->enc = NULL;
+            continue;
+        }
+        opus_encoder_ctl(s->enc, OPUS_SET_BITRATE(s->config.bitrate_bps));
+        opus_encoder_ctl(s->enc, OPUS_SET_COMPLEXITY(s->config.complexity));
+        opus_encoder_ctl(s->enc, OPUS_SET_SIGNAL(OPUS_SIGNAL_MUSIC));
+        opus_encoder_ctl(s->enc, OPUS_SET_ANALYSIS_INTERVAL(s->config.analysis_interval));
+        s->pcm.assign((size_t)s->config.frame_size * s->config.channels, 0);
+    }
+
+    long long seen;
+    {
+        std::lock_guard<std::mutex> guard(round_lock_);
+        seen = round_;
+        if (--pending_ == 0) {
+            round_done_.notify_all();
+        }
+    }
+
+    while (1) {
+        {
+            std::unique_lock<std::mutex> lock(round_lock_);
+            round_start_.wait(lock, [this, seen] { return stop_ || round_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = round_;
+        }
+        // 本周期的任务全部被领走就回去等下一周期
+        int job;
+        bool stolen;
+        while (queued_.load() > 0) {
+            if (next_job(id, &job, &stolen)) {
+                run_job(id, job, stolen);
+            }
+        }
+    }
+}
+
+// 先取自己队列的队头，空了就从其他线程的队尾偷
+bool StreamEngine::next_job(int id, int* job, bool* stolen) {
+    for (int k = 0; k < workers_; k++) {
+        worker_queue* q = queues_[(id + k) % workers_];
+        std::lock_guard<std::mutex> guard(q->lock);
+        if (q->jobs.empty()) continue;
+        if (k == 0) {
+            *job = q->jobs.front();
+            q->jobs.pop_front();
+        } else {
+            *job = q->jobs.back();
+            q->jobs.pop_back();
+        }
+        *stolen = k != 0;
+        queued_--;
+        return true;
+    }
+    return false;
+}
+
+void StreamEngine::run_job(int id, int job, bool stolen) {
+    (void)id;
+    session* s = sessions_[job];
+    if (!s->config.source(&s->pcm[0], s->config.frame_size)) {
+        s->finished = true;
+    } else {
+        long long start = now_us();
+        int len = opus_encode(s->enc, &s->pcm[0], s->config.frame_size, s->packet,
+                              MAX_ENGINE_PACKET);
+        long long end = now_us();
+        if (len < 0) {
+            fprintf(stderr, "session %d: encode failed: %s\n", job, opus_strerror(len));
+        } else {
+            s->stats.frames++;
+            s->stats.encode_us += end - start;
+            if (end > deadline_us_) s->stats.deadline_misses++;
+            if (stolen) s->stats.stolen++;
+            if (s->config.sink) s->config.sink(s->packet, len);
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(round_lock_);
+    if (--pending_ == 0) {
+        round_done_.notify_all();
+    }
+}
@@ -0,0 +1,277 @@
+// 板子音频链路跟踪的统计工具：从板子的跟踪导出端口收事件，按包序号把接收、解码、I2S各阶段对上，
+// 输出每个阶段的耗时分布和解码占用的CPU比例
+// 用法: ./trace_stats 192.168.100.8 [秒数] [保存文件]   连板子收指定秒数(默认10)，可同时存下原始数据
+//       ./trace_stats -r trace.bin                       统计之前存下的原始数据
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#define TRACE_PORT 1029
+#define HEADER_SIZE 8
+#define TRACE_VERSION 1
+#define MAX_CORES 2
+
+// 事件类型和记录格式，和板子端main/audio_trace.h保持一致
+enum {
+    TRACE_SYNC = 0,
+    TRACE_RX = 1,
+    TRACE_DECODE_START = 2,
+    TRACE_DECODE_END = 3,
+    TRACE_I2S_END = 4,
+    TRACE_UNDERRUN = 5,
+    TRACE_DROPPED = 6,
+};
+
+struct trace_record {
+    uint32_t cycles;
+    uint32_t arg;
+    uint16_t seq;
+    uint8_t event;
+    uint8_t core;
+};
+
+// 各阶段的起止事件
+struct stage {
+    const char* name;
+    int from;
+    int to;
+};
+
+static const stage stages[] = {
+    {"rx -> decode (pool queue wait)", TRACE_RX, TRACE_DECODE_START},
+    {"decode", TRACE_DECODE_START, TRACE_DECODE_END},
+    {"i2s_write", TRACE_DECODE_END, TRACE_I2S_END},
+    {"rx -> i2s done (total)", TRACE_RX, TRACE_I2S_END},
+};
+
+#define NUM_STAGES (int)(sizeof(stages) / sizeof(stages[0]))
+#define NUM_EVENTS (TRACE_I2S_END + 1)
+#define HIST_BUCKETS 18  // 第i桶是[2^(i-1), 2^i)us，最后一桶到131ms以上
+
+// 把每个核的周期计数换算到同一条微秒时间轴上，换算基准是该核最近的同步事件
+struct core_clock {
+    bool synced;
+    uint32_t sync_cycles;
+    long long sync_us;
+};
+
+struct packet_times {
+    double t[NUM_EVENTS];
+    unsigned seen;  // 按事件类型的位图
+};
+
+struct trace_stats {
+    int mhz;
+    core_clock clocks[MAX_CORES];
+    std::vector<packet_times> packets;  // 按16位包序号下标
+    std::vector<double> latencies[NUM_STAGES];
+    double first_us, last_us;
+    double decode_busy_us;
+    long long records, unsynced, dropped;
+    unsigned underruns;
+};
+
+static void stats_init(trace_stats* s, int mhz) {
+    s->mhz = mhz;
+    memset(s->clocks, 0, sizeof(s->clocks));
+    s->packets.assign(65536, packet_times());
+    s->first_us = -1;
+    s->last_us = 0;
+    s->decode_busy_us = 0;
+    s->records = s->unsynced = s->dropped = 0;
+    s->underruns = 0;
+}
+
+static void stats_add(trace_stats* s, const trace_record& r) {
+    s->records++;
+    if (r.event == TRACE_DROPPED) {
+        s->dropped += r.arg;
+        return;
+    }
+    if (r.core >= MAX_CORES) return;
+    core_clock* c = &s->clocks[r.core];
+    if (r.event == TRACE_SYNC) {
+        // 同步事件只带esp_timer_get_time()的低32位，按上一次的值展开
+        long long us = r.arg;
+        if (c->synced) us = c->sync_us + (int32_t)(r.arg - (uint32_t)c->sync_us);
+        c->synced = true;
+        c->sync_cycles = r.cycles;
+        c->sync_us = us;
+        return;
+    }
+    if (!c->synced) {
+        s->unsynced++;
+        return;
+    }
+    double t = c->sync_us + (double)(int32_t)(r.cycles - c->sync_cycles) / s->mhz;
+    if (s->first_us < 0) s->first_us = t;
+    s->last_us = std::max(s->last_us, t);
+    if (r.event == TRACE_UNDERRUN) {
+        s->underruns = r.arg;
+        return;
+    }
+    if (r.event >= NUM_EVENTS) return;
+
+    packet_times* p = &s->packets[r.seq];
+    if (r.event == TRACE_RX) p->seen = 0;  // 序号回绕，新的包
+    p->t[r.event] = t;
+    p->seen |= 1u << r.event;
+    if (r.event == TRACE_DECODE_END && (p->seen & (1u << TRACE_DECODE_START))) {
+        s->decode_busy_us += t - p->t[TRACE_DECODE_START];
+    }
+    if (r.event != TRACE_I2S_END) return;
+    for (int i = 0; i < NUM_STAGES; i++) {
+        unsigned need = (1u << stages[i].from) | (1u << stages[i].to);
+        if ((p->seen & need) == need) {
+            s->latencies[i].push_back(p->t[stages[i].to] - p->t[stages[i].from]);
+        }
+    }
+    p->seen = 0;
+}
+
+static void print_stage(const char* name, std::vector<double>& v) {
+    if (v.empty()) {
+        printf("%s: no samples\n", name);
+        return;
+    }
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    printf("%s: %zu packets, p50 %.0f us, p90 %.0f us, p99 %.0f us, max %.0f us\n", name, n,
+           v[n / 2], v[n * 9 / 10], v[n * 99 / 100], v[n - 1]);
+    unsigned hist[HIST_BUCKETS] = {0};
+    for (double x : v) {
+        unsigned us = x < 0 ? 0 : (unsigned)x;
+        int b = us == 0 ? 0 : 32 - __builtin_clz(us);
+        hist[std::min(b, HIST_BUCKETS - 1)]++;
+    }
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        if (hist[i] == 0) continue;
+        int bar = (int)(50.0 * hist[i] / n + 0.5);
+        printf("  %6u - %6u us %7u %5.1f%% %.*s\n", i ? 1u << (i - 1) : 0u, (1u << i) - 1, hist[i],
+               100.0 * hist[i] / n, bar, "##################################################");
+    }
+}
+
+static void print_stats(trace_stats* s) {
+    double span_us = s->last_us - s->first_us;
+    printf("%lld records over %.2f s, %lld before the first sync, %lld dropped on the board, %u underruns\n",
+           s->records, span_us / 1e6, s->unsynced, s->dropped, s->underruns);
+    if (span_us > 0) {
+        printf("decode task busy %.1f%% of the time\n", 100.0 * s->decode_busy_us / span_us);
+    }
+    for (int i = 0; i < NUM_STAGES; i++) {
+        print_stage(stages[i].name, s->latencies[i]);
+    }
+}
+
+// 读满n字节，连接断开或出错返回false
+static bool read_full(int fd, void* buf, size_t n) {
+    char* p = (char*)buf;
+    while (n > 0) {
+        ssize_t len = read(fd, p, n);
+        if (len <= 0) return false;
+        p += len;
+        n -= len;
+    }
+    return true;
+}
+
+static long long now_ms() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000LL + tv.tv_usec / 1000;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <board ip> [seconds] [save file]\n       %s -r <trace file>\n", argv[0], argv[0]);
+        return 1;
+    }
+    int fd;
+    int seconds = 0;
+    FILE* save = NULL;
+    if (strcmp(argv[1], "-r") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "missing trace file\n");
+            return 1;
+        }
+        fd = open(argv[2], O_RDONLY);
+        if (fd < 0) {
+            perror("open error");
+            return 1;
+        }
+    } else {
+        seconds = argc > 2 ? atoi(argv[2]) : 10;
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd == -1) {
+            perror("socket error");
+            return 1;
+        }
+        struct sockaddr_in saddr;
+        memset(&saddr, 0, sizeof(saddr));
+        saddr.sin_family = AF_INET;
+        saddr.sin_port = htons(TRACE_PORT);
+        if (inet_pton(AF_INET, argv[1], &saddr.sin_addr.s_addr) != 1) {
+            fprintf(stderr, "bad address %s\n", argv[1]);
+            return 1;
+        }
+        if (connect(fd, (struct sockaddr*)&saddr, sizeof(saddr)) == -1) {
+            perror("connect error");
+            return 1;
+        }
+        // 到时间后收不到数据也要能退出
+        struct timeval tv = {1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        if (argc > 3) {
+            save = fopen(argv[3], "wb");
+            if (save == NULL) {
+                perror("fopen error");
+                return 1;
+            }
+        }
+    }
+
+    unsigned char header[HEADER_SIZE];
+    if (!read_full(fd, header, sizeof(header)) || memcmp(header, "ATRC", 4) != 0 ||
+        header[4] != TRACE_VERSION || header[5] != sizeof(trace_record)) {
+        fprintf(stderr, "not an audio trace stream\n");
+        return 1;
+    }
+    if (save) fwrite(header, 1, sizeof(header), save);
+    int mhz = header[6] | header[7] << 8;
+    printf("board CPU %d MHz\n", mhz);
+
+    trace_stats stats;
+    stats_init(&stats, mhz);
+    long long end_ms = now_ms() + seconds * 1000LL;
+    trace_record batch[256];
+    size_t pending = 0;  // 上次读到的不完整记录的字节数
+    while (seconds == 0 || now_ms() < end_ms) {
+        ssize_t len = read(fd, (char*)batch + pending, sizeof(batch) - pending);
+        if (len < 0 && seconds != 0) continue;  // 接收超时，再看一下时间
+        if (len <= 0) break;
+        if (save) fwrite((char*)batch + pending, 1, len, save);
+        size_t bytes = pending + len;
+        size_t n = bytes / sizeof(trace_record);
+        for (size_t i = 0; i < n; i++) {
+            stats_add(&stats, batch[i]);
+        }
+        pending = bytes - n * sizeof(trace_record);
+        memmove(batch, (char*)batch + n * sizeof(trace_record), pending);
+    }
+    close(fd);
+    if (save) fclose(save);
+
+    print_stats(&stats);
+    return 0;
+}
@@ -0,0 +1,266 @@
+// 发送层测试：回环上开多个桩音箱(只收不回)，同一份编码帧发给所有音箱，比较几种发送方式的
+// 系统调用次数和发送线程的CPU时间。不按实时节拍发，发完所有帧为止，结果换算成实时播放时
+// 每秒的系统调用数和每一路占的CPU。
+//   tcp send      头和负载先拷进一块缓冲再send，原来的做法
+//   tcp writev    TcpTransport，头和负载一次writev
+//   udp 1/call    UdpTransport每次sendmmsg只发一帧，相当于逐帧sendto
+//   udp sendmmsg  每次sendmmsg发一批(默认64帧)
+//   udp zerocopy  再加MSG_ZEROCOPY，回环上内核总是退回拷贝，这里只能看出完成通知的开销
+// 用法: ./transport_bench [路数] [每路帧数] [帧字节数]
+#include "host_transport.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define FRAME_US 20000
+#define BITRATE 120000
+#define LATENCY_US 40000
+#define HEADER_LEN 4
+
+static long long now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 调用线程自己的CPU时间(用户态+内核态)
+static long long thread_cpu_us() {
+    rusage ru;
+    getrusage(RUSAGE_THREAD, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000LL + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+static void set_nonblocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// 桩音箱：一个线程用epoll把所有socket收空，只计数
+struct stub_sinks {
+    std::vector<int> fds;
+    std::atomic<long long> bytes;
+    std::atomic<bool> stop;
+    std::thread thread;
+
+    stub_sinks() : bytes(0), stop(false) {}
+
+    void start() {
+        thread = std::thread([this] {
+            int ep = epoll_create1(0);
+            for (size_t i = 0; i < fds.size(); i++) {
+                set_nonblocking(fds[i]);
+                epoll_event ev;
+                ev.events = EPOLLIN;
+                ev.data.fd = fds[i];
+                epoll_ctl(ep, EPOLL_CTL_ADD, fds[i], &ev);
+            }
+            static char buf[65536];
+            epoll_event events[64];
+            while (!stop) {
+                int n = epoll_wait(ep, events, 64, 10);
+                for (int i = 0; i < n; i++) {
+                    ssize_t len;
+                    while ((len = recv(events[i].data.fd, buf, sizeof(buf), 0)) > 0) {
+                        bytes += len;
+                    }
+                }
+            }
+            close(ep);
+        });
+    }
+
+    void finish(long long expect_bytes) {
+        // 等收完或者一段时间没有进展(UDP会丢)
+        long long last = -1;
+        while (bytes < expect_bytes && bytes != last) {
+            last = bytes;
+            usleep(50000);
+        }
+        stop = true;
+        thread.join();
+        for (size_t i = 0; i < fds.size(); i++) {
+            close(fds[i]);
+        }
+    }
+};
+
+static sockaddr_in loopback(int port) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+static int bound_port(int fd) {
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    return ntohs(addr.sin_port);
+}
+
+struct bench_result {
+    long long wall_us;
+    long long cpu_us;
+    long long syscalls;
+    long long sent_bytes;
+    long long received_bytes;
+    long long zerocopy_copied;
+};
+
+static frame_payload make_frame(int frame, int bytes) {
+    std::vector<unsigned char>* data = new std::vector<unsigned char>(bytes);
+    for (int i = 0; i < bytes; i++) {
+        (*data)[i] = (unsigned char)(frame * 31 + i);
+    }
+    return frame_payload(data);
+}
+
+static bench_result run_tcp(int streams, int frames, int frame_bytes, bool use_writev) {
+    bench_result r;
+    memset(&r, 0, sizeof(r));
+    transport_config config = {LATENCY_US, BITRATE, frame_bytes + HEADER_LEN, 1, 0};
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = loopback(0);
+    bind(listener, (sockaddr*)&addr, sizeof(addr));
+    listen(listener, streams);
+    addr = loopback(bound_port(listener));
+
+    stub_sinks sinks;
+    std::vector<TcpTransport> conns;
+    for (int i = 0; i < streams; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        conns.push_back(TcpTransport(fd, config));
+        conns.back().tune(BITRATE);
+        if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            perror("connect error");
+            exit(1);
+        }
+        sinks.fds.push_back(accept(listener, NULL, NULL));
+    }
+    close(listener);
+    sinks.start();
+
+    std::vector<unsigned char> copy(HEADER_LEN + frame_bytes);
+    long long start = now_us();
+    long long cpu = thread_cpu_us();
+    for (int f = 0; f < frames; f++) {
+        frame_payload payload = make_frame(f, frame_bytes);
+        unsigned char header[HEADER_LEN] = {(unsigned char)(f >> 24), (unsigned char)(f >> 16),
+                                            (unsigned char)(f >> 8), (unsigned char)f};
+        for (int s = 0; s < streams; s++) {
+            if (use_writev) {
+                conns[s].send(header, HEADER_LEN, payload->data(), frame_bytes);
+            } else {
+                memcpy(&copy[0], header, HEADER_LEN);
+                memcpy(&copy[HEADER_LEN], payload->data(), frame_bytes);
+                if (send(conns[s].fd(), &copy[0], copy.size(), 0) > 0) {
+                    r.sent_bytes += copy.size();
+                }
+                r.syscalls++;
+            }
+        }
+    }
+    r.cpu_us = thread_cpu_us() - cpu;
+    r.wall_us = now_us() - start;
+    for (int s = 0; s < streams; s++) {
+        r.syscalls += conns[s].stats().syscalls;
+        r.sent_bytes += conns[s].stats().bytes;
+    }
+    sinks.finish(r.sent_bytes);
+    r.received_bytes = sinks.bytes;
+    for (int s = 0; s < streams; s++) {
+        close(conns[s].fd());
+    }
+    return r;
+}
+
+static bench_result run_udp(int streams, int frames, int frame_bytes, int batch, bool zerocopy) {
+    bench_result r;
+    memset(&r, 0, sizeof(r));
+    // 回环测试里发送缓冲给大些，比较的是系统调用的开销而不是丢包
+    transport_config config = {LATENCY_US * 4, BITRATE * streams, frame_bytes + HEADER_LEN, batch,
+                               zerocopy ? 1 : 0};
+    UdpTransport transport(config);
+    if (transport.open() < 0) {
+        exit(1);
+    }
+
+    stub_sinks sinks;
+    for (int i = 0; i < streams; i++) {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr = loopback(0);
+        int rcvbuf = 1 << 20;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        bind(fd, (sockaddr*)&addr, sizeof(addr));
+        transport.add_destination(loopback(bound_port(fd)));
+        sinks.fds.push_back(fd);
+    }
+    sinks.start();
+
+    long long start = now_us();
+    long long cpu = thread_cpu_us();
+    for (int f = 0; f < frames; f++) {
+        frame_payload payload = make_frame(f, frame_bytes);
+        unsigned char header[HEADER_LEN] = {(unsigned char)(f >> 24), (unsigned char)(f >> 16),
+                                            (unsigned char)(f >> 8), (unsigned char)f};
+        for (int s = 0; s < streams; s++) {
+            transport.queue(s, header, HEADER_LEN, payload);
+        }
+        // 一个编码周期结束，排着的帧都发出去
+        transport.flush();
+        transport.reap();
+    }
+    while (transport.reap() > 0) {
+        usleep(1000);
+    }
+    r.cpu_us = thread_cpu_us() - cpu;
+    r.wall_us = now_us() - start;
+    r.syscalls = transport.stats().syscalls;
+    r.sent_bytes = transport.stats().bytes;
+    r.zerocopy_copied = transport.stats().zerocopy_copied;
+    sinks.finish(r.sent_bytes);
+    r.received_bytes = sinks.bytes;
+    return r;
+}
+
+static void print_result(const char* name, const bench_result& r, int streams, int frames) {
+    double audio_s = (double)frames * FRAME_US / 1000000;
+    printf("%-13s %8lld %10lld %12.0f %12.1f %9.1f%% %9lld\n", name, r.wall_us / 1000, r.syscalls,
+           r.syscalls / audio_s, (double)r.cpu_us / audio_s / streams,
+           r.sent_bytes ? 100.0 * r.received_bytes / r.sent_bytes : 0, r.zerocopy_copied);
+}
+
+int main(int argc, char** argv) {
+    int streams = argc > 1 ? atoi(argv[1]) : 64;
+    int frames = argc > 2 ? atoi(argv[2]) : 2000;
+    int frame_bytes = argc > 3 ? atoi(argv[3]) : BITRATE / 8 * FRAME_US / 1000000;
+
+    printf("%d streams, %d frames of %d+%d bytes each (%.0fs of audio), loopback\n", streams, frames,
+           HEADER_LEN, frame_bytes, (double)frames * FRAME_US / 1000000);
+    printf("tcp send buffer for %dms at %dbps: %d bytes\n", LATENCY_US / 1000, BITRATE,
+           transport_buffer_bytes(BITRATE, LATENCY_US, frame_bytes + HEADER_LEN));
+    printf("%-13s %8s %10s %12s %12s %10s %9s\n", "mode", "wall(ms)", "syscalls", "syscalls/s",
+           "cpu us/s/str", "received", "zc copied");
+    print_result("tcp send", run_tcp(streams, frames, frame_bytes, false), streams, frames);
+    print_result("tcp writev", run_tcp(streams, frames, frame_bytes, true), streams, frames);
+    print_result("udp 1/call", run_udp(streams, frames, frame_bytes, 1, false), streams, frames);
+    print_result("udp sendmmsg", run_udp(streams, frames, frame_bytes, TRANSPORT_MAX_BATCH, false), streams,
+                 frames);
+    print_result("udp zerocopy", run_udp(streams, frames, frame_bytes, TRANSPORT_MAX_BATCH, true), streams,
+                 frames);
+    return 0;
+}
@@ -0,0 +1,129 @@
+// 用模拟的编码耗时/链路轨迹驱动EncoderTuner，检查调节方向和回滞是否合理
+// 用法: ./tuner_sim             跑内置的几个场景
+//       ./tuner_sim trace.txt   回放轨迹文件，每行一帧:
+//                               encode_us send_queue_bytes jitter_us underruns sink_queue
+#include "encoder_tuner.h"
+
+#include <stdio.h>
+
+#define FRAME_US 20000
+
+struct trace_frame {
+    int encode_us;
+    int send_queue_bytes;
+    link_report report;
+};
+
+typedef trace_frame (*trace_fn)(int frame);
+
+// 正常情况：编码占帧长20%，链路空闲
+static trace_frame steady(int frame) {
+    (void)frame;
+    trace_frame t = {4000, 0, {2000, 0, 2}};
+    return t;
+}
+
+// 第5秒到第10秒主机负载高，编码耗时超过帧长的一半
+static trace_frame cpu_spike(int frame) {
+    trace_frame t = steady(frame);
+    if (frame >= 250 && frame < 500) {
+        t.encode_us = 14000;
+    }
+    return t;
+}
+
+// 第5秒到第15秒Wi-Fi变差：发送队列积压、抖动变大、板子欠载
+static trace_frame wifi_degraded(int frame) {
+    trace_frame t = steady(frame);
+    if (frame >= 250 && frame < 750) {
+        t.send_queue_bytes = 2000;
+        t.report.jitter_us = 30000;
+        t.report.underruns = (frame - 250) / 50;
+        t.report.sink_queue = 0;
+    } else if (frame >= 750) {
+        t.report.underruns = 10;
+    }
+    return t;
+}
+
+// 返回每一帧结束后的(cpu_level, link_level)中最大值，以及最后的级别
+static void run(trace_fn fn, int frames, int* max_cpu, int* max_link,
+                int* end_cpu, int* end_link) {
+    EncoderTuner tuner(FRAME_US);
+    encoder_settings settings;
+    *max_cpu = 0;
+    *max_link = 0;
+    for (int i = 0; i < frames; i++) {
+        trace_frame t = fn(i);
+        tuner.on_frame(t.encode_us, t.send_queue_bytes);
+        tuner.on_report(t.report);
+        if (tuner.poll(&settings)) {
+            printf("  frame %d: complexity %d bitrate %d cvbr %d bandwidth %d\n",
+                   i, settings.complexity, settings.bitrate_bps, settings.cvbr,
+                   settings.bandwidth);
+        }
+        if (tuner.cpu_level() > *max_cpu) *max_cpu = tuner.cpu_level();
+        if (tuner.link_level() > *max_link) *max_link = tuner.link_level();
+    }
+    *end_cpu = tuner.cpu_level();
+    *end_link = tuner.link_level();
+}
+
+static int replay(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror("open trace");
+        return 1;
+    }
+    EncoderTuner tuner(FRAME_US);
+    encoder_settings settings;
+    trace_frame t;
+    int i = 0;
+    while (fscanf(f, "%d %d %d %d %d", &t.encode_us, &t.send_queue_bytes,
+                  &t.report.jitter_us, &t.report.underruns,
+                  &t.report.sink_queue) == 5) {
+        tuner.on_frame(t.encode_us, t.send_queue_bytes);
+        tuner.on_report(t.report);
+        if (tuner.poll(&settings)) {
+            printf("frame %d: complexity %d bitrate %d cvbr %d bandwidth %d\n",
+                   i, settings.complexity, settings.bitrate_bps, settings.cvbr,
+                   settings.bandwidth);
+        }
+        i++;
+    }
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        return replay(argv[1]);
+    }
+
+    int fail = 0;
+    int max_cpu, max_link, end_cpu, end_link;
+
+    printf("steady:\n");
+    run(steady, 1500, &max_cpu, &max_link, &end_cpu, &end_link);
+    if (max_cpu != 0 || max_link != 0) {
+        printf("steady: tuner should not degrade\n");
+        fail = 1;
+    }
+
+    printf("cpu_spike:\n");
+    run(cpu_spike, 2000, &max_cpu, &max_link, &end_cpu, &end_link);
+    if (max_cpu == 0 || max_link != 0 || end_cpu != 0) {
+        printf("cpu_spike: expected complexity to drop and recover only\n");
+        fail = 1;
+    }
+
+    printf("wifi_degraded:\n");
+    run(wifi_degraded, 3000, &max_cpu, &max_link, &end_cpu, &end_link);
+    if (max_link == 0 || max_cpu != 0 || end_link != 0) {
+        printf("wifi_degraded: expected bitrate to drop and recover only\n");
+        fail = 1;
+    }
+
+    printf(fail ? "FAILED\n" : "All scenarios passed\n");
+    return fail;
+}
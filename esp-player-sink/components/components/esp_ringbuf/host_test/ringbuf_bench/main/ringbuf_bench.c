@@ -0,0 +1,242 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/ringbuf.h"
+
+#define ITEM_SIZE           64
+#define BUFFER_SIZE         4096
+#define SAME_TASK_ITEMS     200000
+#define TWO_TASK_ITEMS      200000
+#define BATCH_ITEMS         192000  //Multiple of every batch size
+#define BATCH_MAX           16
+
+typedef enum {
+    BENCH_NOSPLIT,
+    BENCH_BYTEBUF,
+    BENCH_SPSC,
+    BENCH_MAX,
+} bench_type_t;
+
+static const char *const bench_names[BENCH_MAX] = {"NOSPLIT", "BYTEBUF", "SPSC"};
+
+typedef struct {
+    bench_type_t type;
+    void *buffer;
+    int items;
+    SemaphoreHandle_t done;
+} bench_args_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *bench_create(bench_type_t type)
+{
+    switch (type) {
+    case BENCH_NOSPLIT:
+        return xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+    case BENCH_BYTEBUF:
+        return xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF);
+    default:
+        return xRingbufferCreateSPSC(BUFFER_SIZE);
+    }
+}
+
+static void bench_delete(bench_type_t type, void *buffer)
+{
+    if (type == BENCH_SPSC) {
+        vRingbufferSPSCDelete(buffer);
+    } else {
+        vRingbufferDelete(buffer);
+    }
+}
+
+static void bench_send(bench_type_t type, void *buffer, const uint8_t *item)
+{
+    BaseType_t ret;
+    if (type == BENCH_SPSC) {
+        ret = xRingbufferSPSCSend(buffer, item, ITEM_SIZE, portMAX_DELAY);
+    } else {
+        ret = xRingbufferSend(buffer, item, ITEM_SIZE, portMAX_DELAY);
+    }
+    assert(ret == pdTRUE);
+}
+
+static uint8_t bench_receive(bench_type_t type, void *buffer)
+{
+    size_t size;
+    uint8_t *item;
+    uint8_t first;
+    if (type == BENCH_SPSC) {
+        item = xRingbufferSPSCReceive(buffer, &size, portMAX_DELAY);
+        first = item[0];
+        vRingbufferSPSCReturnItem(buffer, item);
+    } else if (type == BENCH_BYTEBUF) {
+        //Data of a byte buffer may wrap around, so receive at most one item at a time
+        size_t total = 0;
+        first = 0;
+        while (total < ITEM_SIZE) {
+            item = xRingbufferReceiveUpTo(buffer, &size, portMAX_DELAY, ITEM_SIZE - total);
+            if (total == 0) {
+                first = item[0];
+            }
+            total += size;
+            vRingbufferReturnItem(buffer, item);
+        }
+    } else {
+        item = xRingbufferReceive(buffer, &size, portMAX_DELAY);
+        first = item[0];
+        vRingbufferReturnItem(buffer, item);
+    }
+    return first;
+}
+
+static uint64_t bench_same_task(bench_type_t type)
+{
+    uint8_t item[ITEM_SIZE];
+    void *buffer = bench_create(type);
+    assert(buffer != NULL);
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < SAME_TASK_ITEMS; i++) {
+        item[0] = (uint8_t)i;
+        bench_send(type, buffer, item);
+        if (bench_receive(type, buffer) != (uint8_t)i) {
+            printf("%s: item %d corrupted\n", bench_names[type], i);
+            abort();
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    bench_delete(type, buffer);
+    return elapsed / SAME_TASK_ITEMS;
+}
+
+static void producer_task(void *arg)
+{
+    bench_args_t *args = (bench_args_t *)arg;
+    uint8_t item[ITEM_SIZE];
+    memset(item, 0, sizeof(item));
+    for (int i = 0; i < args->items; i++) {
+        item[0] = (uint8_t)i;
+        bench_send(args->type, args->buffer, item);
+    }
+    xSemaphoreGive(args->done);
+    vTaskDelete(NULL);
+}
+
+static void consumer_task(void *arg)
+{
+    bench_args_t *args = (bench_args_t *)arg;
+    for (int i = 0; i < args->items; i++) {
+        if (bench_receive(args->type, args->buffer) != (uint8_t)i) {
+            printf("%s: item %d corrupted\n", bench_names[args->type], i);
+            abort();
+        }
+    }
+    xSemaphoreGive(args->done);
+    vTaskDelete(NULL);
+}
+
+static uint64_t bench_two_tasks(bench_type_t type)
+{
+    bench_args_t args = {
+        .type = type,
+        .buffer = bench_create(type),
+        .items = TWO_TASK_ITEMS,
+        .done = xSemaphoreCreateCounting(2, 0),
+    };
+    assert(args.buffer != NULL && args.done != NULL);
+
+    uint64_t start = now_ns();
+    xTaskCreate(consumer_task, "consumer", 4096, &args, 5, NULL);
+    xTaskCreate(producer_task, "producer", 4096, &args, 5, NULL);
+    xSemaphoreTake(args.done, portMAX_DELAY);
+    xSemaphoreTake(args.done, portMAX_DELAY);
+    uint64_t elapsed = now_ns() - start;
+
+    vTaskDelay(2);  //Allow idle to clean up
+    bench_delete(type, args.buffer);
+    vSemaphoreDelete(args.done);
+    return elapsed / TWO_TASK_ITEMS;
+}
+
+static uint64_t bench_batch(int batch, bool multiple)
+{
+    uint8_t item[ITEM_SIZE];
+    void *items[BATCH_MAX];
+    size_t sizes[BATCH_MAX];
+    RingbufHandle_t buffer = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+    assert(buffer != NULL);
+    memset(item, 0, sizeof(item));
+
+    //Only the receiving side is timed, the producer fills a whole batch up front
+    uint64_t elapsed = 0;
+    for (int i = 0; i < BATCH_ITEMS; i += batch) {
+        for (int j = 0; j < batch; j++) {
+            item[0] = (uint8_t)(i + j);
+            bench_send(BENCH_NOSPLIT, buffer, item);
+        }
+        uint64_t start = now_ns();
+        if (multiple) {
+            int received = 0;
+            while (received < batch) {
+                UBaseType_t count = xRingbufferReceiveMultiple(buffer, items, sizes, batch - received, portMAX_DELAY);
+                for (UBaseType_t j = 0; j < count; j++) {
+                    if (((uint8_t *)items[j])[0] != (uint8_t)(i + received + j) || sizes[j] != ITEM_SIZE) {
+                        printf("batch %d: item %d corrupted\n", batch, i + received + (int)j);
+                        abort();
+                    }
+                }
+                vRingbufferReturnMultiple(buffer, items, count);
+                received += count;
+            }
+        } else {
+            for (int j = 0; j < batch; j++) {
+                if (bench_receive(BENCH_NOSPLIT, buffer) != (uint8_t)(i + j)) {
+                    printf("batch %d: item %d corrupted\n", batch, i + j);
+                    abort();
+                }
+            }
+        }
+        elapsed += now_ns() - start;
+    }
+
+    vRingbufferDelete(buffer);
+    return elapsed / BATCH_ITEMS;
+}
+
+void app_main(void)
+{
+    printf("item size %d, %d items\n", ITEM_SIZE, TWO_TASK_ITEMS);
+    for (bench_type_t type = 0; type < BENCH_MAX; type++) {
+        uint64_t same = bench_same_task(type);
+        uint64_t two = bench_two_tasks(type);
+        printf("%-10s same task: %6llu ns/item   two tasks: %6llu ns/item\n",
+               bench_names[type], (unsigned long long)same, (unsigned long long)two);
+    }
+
+    printf("\nNOSPLIT receive side, %d items\n", BATCH_ITEMS);
+    static const int batches[] = {1, 4, BATCH_MAX};
+    for (int i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        uint64_t single = bench_batch(batches[i], false);
+        uint64_t multiple = bench_batch(batches[i], true);
+        printf("batch %-4d Receive: %6llu ns/item   ReceiveMultiple: %6llu ns/item\n",
+               batches[i], (unsigned long long)single, (unsigned long long)multiple);
+    }
+    exit(0);
+}
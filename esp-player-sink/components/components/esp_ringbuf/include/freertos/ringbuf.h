@@ -356,6 +356,32 @@ void *xRingbufferReceiveUpTo(RingbufHandle_t xRingbuffer,
  */
 void *xRingbufferReceiveUpToFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemSize, size_t xMaxSize);
 
+/**
+ * @brief   Retrieve multiple items from a no-split ring buffer
+ *
+ * Attempt to retrieve up to uxMaxItems items from the ring buffer. This function
+ * will block until at least one item is available or until it times out, then
+ * retrieves every item that is available (up to uxMaxItems) in a single critical
+ * section. This is cheaper than calling xRingbufferReceive() once per item when
+ * items arrive in bursts.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to retrieve the items from
+ * @param[out]  ppvItems        Array of at least uxMaxItems pointers, filled with pointers to the retrieved items
+ * @param[out]  pxItemSizes     Array of at least uxMaxItems sizes, filled with the length of the retrieved items
+ * @param[in]   uxMaxItems      Maximum number of items to retrieve
+ * @param[in]   xTicksToWait    Ticks to wait for items in the ring buffer.
+ *
+ * @note    The retrieved items must be returned with vRingbufferReturnMultiple() or vRingbufferReturnItem().
+ * @note    This function should only be called on no-split buffers
+ *
+ * @return  Number of items retrieved, 0 on timeout.
+ */
+UBaseType_t xRingbufferReceiveMultiple(RingbufHandle_t xRingbuffer,
+                                       void **ppvItems,
+                                       size_t *pxItemSizes,
+                                       UBaseType_t uxMaxItems,
+                                       TickType_t xTicksToWait);
+
 /**
  * @brief   Return a previously-retrieved item to the ring buffer
  *
@@ -378,6 +404,20 @@ void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem);
  */
 void vRingbufferReturnItemFromISR(RingbufHandle_t xRingbuffer, void *pvItem, BaseType_t *pxHigherPriorityTaskWoken);
 
+/**
+ * @brief   Return multiple previously-retrieved items to the ring buffer
+ *
+ * The items are returned in a single critical section, and tasks blocked on
+ * sending are only woken up once.
+ *
+ * @param[in]   xRingbuffer Ring buffer the items were retrieved from
+ * @param[in]   ppvItems    Array of items that were received earlier
+ * @param[in]   uxItems     Number of items in ppvItems
+ *
+ * @note    This function should not be called on byte buffers
+ */
+void vRingbufferReturnMultiple(RingbufHandle_t xRingbuffer, void **ppvItems, UBaseType_t uxItems);
+
 /**
  * @brief   Delete a ring buffer
  *
@@ -503,6 +543,184 @@ void vRingbufferGetInfo(RingbufHandle_t xRingbuffer,
  */
 void xRingbufferPrintInfo(RingbufHandle_t xRingbuffer);
 
+/* ---------------------- Single-producer/single-consumer ---------------------- */
+
+/**
+ * Type by which single-producer/single-consumer ring buffers are referenced. For
+ * example, a call to xRingbufferCreateSPSC() returns a RingbufSPSCHandle_t
+ * variable that can then be used as a parameter to xRingbufferSPSCSend(),
+ * xRingbufferSPSCReceive(), etc.
+ *
+ * An SPSC ring buffer stores items like a no-split buffer, but may only be used
+ * by one sending task (or ISR) and one receiving task (or ISR) at a time. In
+ * exchange, sending and receiving do not take a lock or a semaphore: the read and
+ * write offsets are atomics kept on separate cache lines, and a task only blocks
+ * (on its task notification) when the ring buffer is full or empty.
+ *
+ * @note A task blocked on an SPSC ring buffer waits on its task notification of
+ *       index CONFIG_RINGBUF_SPSC_NOTIFY_INDEX (1 by default), which requires
+ *       CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES >= 2. Notifications sent
+ *       to that index by anything else will cause spurious (but harmless) wake ups
+ *       and may be consumed by the ring buffer.
+ */
+typedef void * RingbufSPSCHandle_t;
+
+/**
+ * @brief       Create a single-producer/single-consumer ring buffer
+ *
+ * @param[in]   xBufferSize Size of the buffer in bytes. Each item requires a 4 byte
+ *              header and occupies a 32-bit aligned size of space.
+ *
+ * @note    xBufferSize will be rounded up to the nearest 32-bit aligned size. The
+ *          maximum item size is ((buffer_size/2)-header_size), as for no-split buffers.
+ *
+ * @return  A handle to the created ring buffer, or NULL in case of error.
+ */
+RingbufSPSCHandle_t xRingbufferCreateSPSC(size_t xBufferSize);
+
+/**
+ * @brief       Insert an item into an SPSC ring buffer
+ *
+ * The item is copied into the ring buffer. This function will block until enough
+ * free space is available or until it times out.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to insert the item into
+ * @param[in]   pvItem          Pointer to data to insert. NULL is allowed if xItemSize is 0.
+ * @param[in]   xItemSize       Size of data to insert.
+ * @param[in]   xTicksToWait    Ticks to wait for room in the ring buffer.
+ *
+ * @note    Must only be called from the producer.
+ *
+ * @return
+ *      - pdTRUE if succeeded
+ *      - pdFALSE on time-out or when the data is larger than the maximum permissible size of the buffer
+ */
+BaseType_t xRingbufferSPSCSend(RingbufSPSCHandle_t xRingbuffer,
+                               const void *pvItem,
+                               size_t xItemSize,
+                               TickType_t xTicksToWait);
+
+/**
+ * @brief       Insert an item into an SPSC ring buffer in an ISR
+ *
+ * @param[in]   xRingbuffer Ring buffer to insert the item into
+ * @param[in]   pvItem      Pointer to data to insert. NULL is allowed if xItemSize is 0.
+ * @param[in]   xItemSize   Size of data to insert.
+ * @param[out]  pxHigherPriorityTaskWoken   Value pointed to will be set to pdTRUE if the function woke up a higher priority task.
+ *
+ * @note    Must only be called from the producer.
+ *
+ * @return
+ *      - pdTRUE if succeeded
+ *      - pdFALSE when the ring buffer does not have space.
+ */
+BaseType_t xRingbufferSPSCSendFromISR(RingbufSPSCHandle_t xRingbuffer,
+                                      const void *pvItem,
+                                      size_t xItemSize,
+                                      BaseType_t *pxHigherPriorityTaskWoken);
+
+/**
+ * @brief Acquire memory from an SPSC ring buffer to be written to by an external
+ *        source and to be sent later.
+ *
+ * The item is not visible to the consumer until xRingbufferSPSCSendComplete() is
+ * called. Only one item may be acquired at a time.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to allocate the memory
+ * @param[out]  ppvItem         Double pointer to memory acquired (set to NULL if no memory were retrieved)
+ * @param[in]   xItemSize       Size of item to acquire.
+ * @param[in]   xTicksToWait    Ticks to wait for room in the ring buffer.
+ *
+ * @note    Must only be called from the producer.
+ *
+ * @return
+ *      - pdTRUE if succeeded
+ *      - pdFALSE on time-out or when the data is larger than the maximum permissible size of the buffer
+ */
+BaseType_t xRingbufferSPSCSendAcquire(RingbufSPSCHandle_t xRingbuffer, void **ppvItem, size_t xItemSize, TickType_t xTicksToWait);
+
+/**
+ * @brief       Send an item acquired with ``xRingbufferSPSCSendAcquire``
+ *
+ * @param[in]   xRingbuffer     Ring buffer to insert the item into
+ * @param[in]   pvItem          Pointer to the acquired item
+ *
+ * @return  pdTRUE
+ */
+BaseType_t xRingbufferSPSCSendComplete(RingbufSPSCHandle_t xRingbuffer, void *pvItem);
+
+/**
+ * @brief   Retrieve an item from an SPSC ring buffer
+ *
+ * Attempt to retrieve an item from the ring buffer. This function will block
+ * until an item is available or until it times out.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to retrieve the item from
+ * @param[out]  pxItemSize      Pointer to a variable to which the size of the retrieved item will be written.
+ * @param[in]   xTicksToWait    Ticks to wait for items in the ring buffer.
+ *
+ * @note    Must only be called from the consumer. A call to
+ *          vRingbufferSPSCReturnItem() is required after this to free the item
+ *          retrieved. Several items may be retrieved before being returned, but
+ *          they must be returned in the order they were retrieved.
+ *
+ * @return
+ *      - Pointer to the retrieved item on success; *pxItemSize filled with the length of the item.
+ *      - NULL on timeout, *pxItemSize is untouched in that case.
+ */
+void *xRingbufferSPSCReceive(RingbufSPSCHandle_t xRingbuffer, size_t *pxItemSize, TickType_t xTicksToWait);
+
+/**
+ * @brief   Retrieve an item from an SPSC ring buffer in an ISR
+ *
+ * @param[in]   xRingbuffer     Ring buffer to retrieve the item from
+ * @param[out]  pxItemSize      Pointer to a variable to which the size of the retrieved item will be written.
+ *
+ * @note    Must only be called from the consumer. A call to
+ *          vRingbufferSPSCReturnItemFromISR() is required after this to free the item retrieved.
+ *
+ * @return
+ *      - Pointer to the retrieved item on success; *pxItemSize filled with the length of the item.
+ *      - NULL when the ring buffer is empty, *pxItemSize is untouched in that case.
+ */
+void *xRingbufferSPSCReceiveFromISR(RingbufSPSCHandle_t xRingbuffer, size_t *pxItemSize);
+
+/**
+ * @brief   Return the oldest retrieved item to an SPSC ring buffer
+ *
+ * @param[in]   xRingbuffer Ring buffer the item was retrieved from
+ * @param[in]   pvItem      Item that was received earlier
+ */
+void vRingbufferSPSCReturnItem(RingbufSPSCHandle_t xRingbuffer, void *pvItem);
+
+/**
+ * @brief   Return the oldest retrieved item to an SPSC ring buffer from an ISR
+ *
+ * @param[in]   xRingbuffer Ring buffer the item was retrieved from
+ * @param[in]   pvItem      Item that was received earlier
+ * @param[out]  pxHigherPriorityTaskWoken   Value pointed to will be set to pdTRUE
+ *                                          if the function woke up a higher priority task.
+ */
+void vRingbufferSPSCReturnItemFromISR(RingbufSPSCHandle_t xRingbuffer, void *pvItem, BaseType_t *pxHigherPriorityTaskWoken);
+
+/**
+ * @brief   Get maximum size of an item that can be placed in an SPSC ring buffer
+ *
+ * @param[in]   xRingbuffer     Ring buffer to query
+ *
+ * @return  Maximum size, in bytes, of an item that can be placed in the ring buffer.
+ */
+size_t xRingbufferSPSCGetMaxItemSize(RingbufSPSCHandle_t xRingbuffer);
+
+/**
+ * @brief   Delete an SPSC ring buffer
+ *
+ * @param[in]   xRingbuffer     Ring buffer to delete
+ *
+ * @note    No task may be blocked on the ring buffer.
+ */
+void vRingbufferSPSCDelete(RingbufSPSCHandle_t xRingbuffer);
+
 #ifdef __cplusplus
 }
 #endif
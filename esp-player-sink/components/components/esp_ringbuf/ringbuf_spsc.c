@@ -0,0 +1,412 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+
+//32-bit alignment macros
+#define rbALIGN_MASK (0x03)
+#define rbALIGN_SIZE( xSize )       ( ( xSize + rbALIGN_MASK ) & ~rbALIGN_MASK )
+
+/*
+ * The fields written by the producer and the fields written by the consumer are
+ * kept at least this many bytes apart so they never share a cache line. 64 bytes
+ * covers the cache line size of all targets as well as Linux hosts.
+ */
+#define rbSPSC_CACHE_LINE           64
+
+#define rbSPSC_HEADER_SIZE          sizeof(uint32_t)    //Each item is prefixed with its length
+#define rbSPSC_WRAP_MARKER          UINT32_MAX          //Length of a header telling the reader that the next item is at the start of the storage
+#define rbSPSC_NOTIFY_INDEX         CONFIG_RINGBUF_SPSC_NOTIFY_INDEX
+
+/*
+ * Index 0 is shared with stream buffers, message buffers and the non indexed
+ * notification API, whose notifications would be consumed by the ring buffer.
+ */
+_Static_assert(configTASK_NOTIFICATION_ARRAY_ENTRIES >= 2, "SPSC ring buffers need CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES >= 2");
+_Static_assert(rbSPSC_NOTIFY_INDEX > 0 && rbSPSC_NOTIFY_INDEX < configTASK_NOTIFICATION_ARRAY_ENTRIES,
+               "CONFIG_RINGBUF_SPSC_NOTIFY_INDEX must be in 1 .. CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES - 1");
+
+typedef struct RingbufferSPSCDefinition {
+    //Set on creation, read only afterwards
+    uint8_t *pucHead;                           //Start of the storage area
+    size_t xSize;                               //Size of the storage area
+    size_t xMaxItemSize;                        //Maximum item size
+    uint8_t ucPad0[rbSPSC_CACHE_LINE];
+
+    //Producer side
+    atomic_size_t xWrite;                       //Offset where the next item will be written. Published to the consumer
+    size_t xFreeCache;                          //Last value of xFree seen by the producer
+    uint8_t *pucAcquired;                       //Item acquired with xRingbufferSPSCSendAcquire() but not sent yet
+    size_t xAcquiredNext;                       //Value of xWrite once the acquired item is sent
+    uint8_t ucPad1[rbSPSC_CACHE_LINE];
+
+    //Consumer side
+    atomic_size_t xFree;                        //Offset of the oldest item not returned yet. Published to the producer
+    size_t xWriteCache;                         //Last value of xWrite seen by the consumer
+    size_t xRead;                               //Offset of the next item to be received
+    uint8_t ucPad2[rbSPSC_CACHE_LINE];
+
+    //Only written when a task is about to block
+    _Atomic(TaskHandle_t) xSendWaiter;          //Producer blocked on a full ring buffer
+    _Atomic(TaskHandle_t) xRecvWaiter;          //Consumer blocked on an empty ring buffer
+} RingbufferSPSC_t;
+
+/* --------------------------- Static Definitions --------------------------- */
+
+/*
+ * Find room for xNeed bytes (header included). Returns the offset at which the
+ * item should be written (either xWrite or 0 if the item needs to wrap around),
+ * or SIZE_MAX if the item does not fit. xWrite == xFree means the ring buffer is
+ * empty, so the write offset may never catch up with the free offset.
+ */
+static inline size_t prvSPSCFindSpace(size_t xSize, size_t xWrite, size_t xFree, size_t xNeed)
+{
+    if (xWrite >= xFree) {
+        //Free space is [xWrite, xSize) followed by [0, xFree)
+        if (xNeed <= xSize - xWrite && (xWrite + xNeed < xSize || xFree != 0)) {
+            return xWrite;
+        }
+        return (xNeed < xFree) ? 0 : SIZE_MAX;
+    }
+    return (xNeed < xFree - xWrite) ? xWrite : SIZE_MAX;
+}
+
+/*
+ * Reserve space for an item without publishing it. Returns a pointer to the
+ * item's data, or NULL if the ring buffer does not have enough free space.
+ * Only called by the producer.
+ */
+static uint8_t *prvSPSCAcquire(RingbufferSPSC_t *pxRingbuffer, size_t xItemSize)
+{
+    size_t xNeed = rbALIGN_SIZE(xItemSize) + rbSPSC_HEADER_SIZE;
+    size_t xWrite = atomic_load_explicit(&pxRingbuffer->xWrite, memory_order_relaxed);
+    size_t xOffset = prvSPSCFindSpace(pxRingbuffer->xSize, xWrite, pxRingbuffer->xFreeCache, xNeed);
+    if (xOffset == SIZE_MAX) {
+        //Only touch the consumer's cache line when the cached copy is not enough
+        pxRingbuffer->xFreeCache = atomic_load_explicit(&pxRingbuffer->xFree, memory_order_acquire);
+        xOffset = prvSPSCFindSpace(pxRingbuffer->xSize, xWrite, pxRingbuffer->xFreeCache, xNeed);
+        if (xOffset == SIZE_MAX) {
+            return NULL;
+        }
+    }
+    if (xOffset != xWrite) {
+        //Not enough room before the end of the storage, the rest of it is skipped
+        *(uint32_t *)(pxRingbuffer->pucHead + xWrite) = rbSPSC_WRAP_MARKER;
+    }
+    *(uint32_t *)(pxRingbuffer->pucHead + xOffset) = (uint32_t)xItemSize;
+    pxRingbuffer->xAcquiredNext = (xOffset + xNeed == pxRingbuffer->xSize) ? 0 : xOffset + xNeed;
+    return pxRingbuffer->pucHead + xOffset + rbSPSC_HEADER_SIZE;
+}
+
+/*
+ * Wake up the task blocked on the other side of the ring buffer, if any. Must be
+ * called after publishing a new xWrite/xFree. The fence pairs with the one in
+ * prvSPSCPrepareWait(): either the waiting task sees the new offset when it
+ * checks again, or we see the waiting task here.
+ */
+static void prvSPSCWake(_Atomic(TaskHandle_t) *pxWaiter, BaseType_t xFromISR, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(pxWaiter, memory_order_relaxed) == NULL) {
+        return;
+    }
+    TaskHandle_t xTask = atomic_exchange_explicit(pxWaiter, NULL, memory_order_acq_rel);
+    if (xTask != NULL) {
+        if (xFromISR) {
+            vTaskNotifyGiveIndexedFromISR(xTask, rbSPSC_NOTIFY_INDEX, pxHigherPriorityTaskWoken);
+        } else {
+            xTaskNotifyGiveIndexed(xTask, rbSPSC_NOTIFY_INDEX);
+        }
+    }
+}
+
+//Register the calling task as waiting. The caller must check the ring buffer again before blocking
+static void prvSPSCPrepareWait(_Atomic(TaskHandle_t) *pxWaiter)
+{
+    atomic_store_explicit(pxWaiter, xTaskGetCurrentTaskHandle(), memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+/*
+ * Unregister the calling task. If the other side has already taken the task
+ * handle, its notification may still be on the way. Consume it so that it does
+ * not wake the task up the next time it blocks.
+ */
+static void prvSPSCFinishWait(_Atomic(TaskHandle_t) *pxWaiter, BaseType_t xNotified)
+{
+    if (atomic_exchange_explicit(pxWaiter, NULL, memory_order_acq_rel) == NULL && xNotified == pdFALSE) {
+        ulTaskNotifyTakeIndexed(rbSPSC_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+    }
+}
+
+//Acquire space for an item, blocking until there is enough free space or until timeout
+static uint8_t *prvSPSCAcquireBlocking(RingbufferSPSC_t *pxRingbuffer, size_t xItemSize, TickType_t xTicksToWait)
+{
+    uint8_t *pucItem = prvSPSCAcquire(pxRingbuffer, xItemSize);
+    TickType_t xTicksEnd = xTaskGetTickCount() + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    while (pucItem == NULL && xTicksRemaining != 0 && xTicksRemaining <= xTicksToWait) {
+        prvSPSCPrepareWait(&pxRingbuffer->xSendWaiter);
+        pucItem = prvSPSCAcquire(pxRingbuffer, xItemSize);
+        BaseType_t xNotified = pdFALSE;
+        if (pucItem == NULL) {
+            xNotified = (ulTaskNotifyTakeIndexed(rbSPSC_NOTIFY_INDEX, pdTRUE, xTicksRemaining) != 0) ? pdTRUE : pdFALSE;
+        }
+        prvSPSCFinishWait(&pxRingbuffer->xSendWaiter, xNotified);
+        if (pucItem == NULL) {
+            pucItem = prvSPSCAcquire(pxRingbuffer, xItemSize);
+        }
+        //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
+        if (xTicksToWait != portMAX_DELAY) {
+            xTicksRemaining = xTicksEnd - xTaskGetTickCount();
+        }
+    }
+    return pucItem;
+}
+
+//Publish the acquired item to the consumer
+static void prvSPSCPublish(RingbufferSPSC_t *pxRingbuffer, BaseType_t xFromISR, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    atomic_store_explicit(&pxRingbuffer->xWrite, pxRingbuffer->xAcquiredNext, memory_order_release);
+    prvSPSCWake(&pxRingbuffer->xRecvWaiter, xFromISR, pxHigherPriorityTaskWoken);
+}
+
+/*
+ * Retrieve the next item without blocking. Returns NULL if the ring buffer is
+ * empty. Only called by the consumer.
+ */
+static uint8_t *prvSPSCGetItem(RingbufferSPSC_t *pxRingbuffer, size_t *pxItemSize)
+{
+    size_t xRead = pxRingbuffer->xRead;
+    if (xRead == pxRingbuffer->xWriteCache) {
+        //Only touch the producer's cache line when the cached copy says there is nothing to read
+        pxRingbuffer->xWriteCache = atomic_load_explicit(&pxRingbuffer->xWrite, memory_order_acquire);
+        if (xRead == pxRingbuffer->xWriteCache) {
+            return NULL;
+        }
+    }
+    uint32_t ulLen = *(uint32_t *)(pxRingbuffer->pucHead + xRead);
+    if (ulLen == rbSPSC_WRAP_MARKER) {
+        //The producer always writes the item at the start before publishing the marker
+        xRead = 0;
+        ulLen = *(uint32_t *)pxRingbuffer->pucHead;
+    }
+    size_t xNext = xRead + rbSPSC_HEADER_SIZE + rbALIGN_SIZE(ulLen);
+    pxRingbuffer->xRead = (xNext == pxRingbuffer->xSize) ? 0 : xNext;
+    if (pxItemSize != NULL) {
+        *pxItemSize = ulLen;
+    }
+    return pxRingbuffer->pucHead + xRead + rbSPSC_HEADER_SIZE;
+}
+
+//Free the oldest item that was retrieved. Only called by the consumer
+static void prvSPSCReturnItem(RingbufferSPSC_t *pxRingbuffer, uint8_t *pucItem)
+{
+    size_t xFree = atomic_load_explicit(&pxRingbuffer->xFree, memory_order_relaxed);
+    uint32_t ulLen = *(uint32_t *)(pxRingbuffer->pucHead + xFree);
+    if (ulLen == rbSPSC_WRAP_MARKER) {
+        xFree = 0;
+        ulLen = *(uint32_t *)pxRingbuffer->pucHead;
+    }
+    //Items must be returned in the order they were received
+    configASSERT(pucItem == pxRingbuffer->pucHead + xFree + rbSPSC_HEADER_SIZE);
+    xFree += rbSPSC_HEADER_SIZE + rbALIGN_SIZE(ulLen);
+    atomic_store_explicit(&pxRingbuffer->xFree, (xFree == pxRingbuffer->xSize) ? 0 : xFree, memory_order_release);
+}
+
+static void prvInitializeNewRingbufferSPSC(size_t xBufferSize,
+                                           RingbufferSPSC_t *pxNewRingbuffer,
+                                           uint8_t *pucRingbufferStorage)
+{
+    pxNewRingbuffer->pucHead = pucRingbufferStorage;
+    pxNewRingbuffer->xSize = xBufferSize;
+    /*
+     * Worst case scenario is an empty buffer with the write offset just past the
+     * halfway point, where the item has to wrap around.
+     */
+    pxNewRingbuffer->xMaxItemSize = ((xBufferSize / 2) & ~rbALIGN_MASK) - rbSPSC_HEADER_SIZE;
+    atomic_init(&pxNewRingbuffer->xWrite, 0);
+    pxNewRingbuffer->xFreeCache = 0;
+    pxNewRingbuffer->pucAcquired = NULL;
+    pxNewRingbuffer->xAcquiredNext = 0;
+    atomic_init(&pxNewRingbuffer->xFree, 0);
+    pxNewRingbuffer->xWriteCache = 0;
+    pxNewRingbuffer->xRead = 0;
+    atomic_init(&pxNewRingbuffer->xSendWaiter, NULL);
+    atomic_init(&pxNewRingbuffer->xRecvWaiter, NULL);
+}
+
+/* --------------------------- Public Definitions --------------------------- */
+
+RingbufSPSCHandle_t xRingbufferCreateSPSC(size_t xBufferSize)
+{
+    configASSERT(xBufferSize >= 4 * rbSPSC_HEADER_SIZE);
+
+    xBufferSize = rbALIGN_SIZE(xBufferSize);
+    RingbufferSPSC_t *pxNewRingbuffer = calloc(1, sizeof(RingbufferSPSC_t));
+    uint8_t *pucRingbufferStorage = malloc(xBufferSize);
+    if (pxNewRingbuffer == NULL || pucRingbufferStorage == NULL) {
+        free(pxNewRingbuffer);
+        free(pucRingbufferStorage);
+        return NULL;
+    }
+    prvInitializeNewRingbufferSPSC(xBufferSize, pxNewRingbuffer, pucRingbufferStorage);
+    return (RingbufSPSCHandle_t)pxNewRingbuffer;
+}
+
+BaseType_t xRingbufferSPSCSend(RingbufSPSCHandle_t xRingbuffer,
+                               const void *pvItem,
+                               size_t xItemSize,
+                               TickType_t xTicksToWait)
+{
+    //Check arguments
+    RingbufferSPSC_t *pxRingbuffer = (RingbufferSPSC_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pvItem != NULL || xItemSize == 0);
+    configASSERT(pxRingbuffer->pucAcquired == NULL);
+    if (xItemSize > pxRingbuffer->xMaxItemSize) {
+        return pdFALSE;     //Data will never ever fit in the queue.
+    }
+
+    uint8_t *pucItem = prvSPSCAcquireBlocking(pxRingbuffer, xItemSize, xTicksToWait);
+    if (pucItem == NULL) {
+        return pdFALSE;
+    }
+    memcpy(pucItem, pvItem, xItemSize);
+    prvSPSCPublish(pxRingbuffer, pdFALSE, NULL);
+    return pdTRUE;
+}
+
+BaseType_t xRingbufferSPSCSendFromISR(RingbufSPSCHandle_t xRingbuffer,
+                                      const void *pvItem,
+                                      size_t xItemSize,
+                                      BaseType_t *pxHigherPriorityTaskWoken)
+{
+    //Check arguments
+    RingbufferSPSC_t *pxRingbuffer = (RingbufferSPSC_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pvItem != NULL || xItemSize == 0);
+    configASSERT(pxRingbuffer->pucAcquired == NULL);
+    if (xItemSize > pxRingbuffer->xMaxItemSize) {
+        return pdFALSE;     //Data will never ever fit in the queue.
+    }
+
+    uint8_t *pucItem = prvSPSCAcquire(pxRingbuffer, xItemSize);
+    if (pucItem == NULL) {
+        return pdFALSE;
+    }
+    memcpy(pucItem, pvItem, xItemSize);
+    prvSPSCPublish(pxRingbuffer, pdTRUE, pxHigherPriorityTaskWoken);
+    return pdTRUE;
+}
+
+BaseType_t xRingbufferSPSCSendAcquire(RingbufSPSCHandle_t xRingbuffer, void **ppvItem, size_t xItemSize, TickType_t xTicksToWait)
+{
+    //Check arguments
+    RingbufferSPSC_t *pxRingbuffer = (RingbufferSPSC_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(ppvItem != NULL);
+    configASSERT(pxRingbuffer->pucAcquired == NULL);
+
+    *ppvItem = NULL;
+    if (xItemSize > pxRingbuffer->xMaxItemSize) {
+        return pdFALSE;     //Data will never ever fit in the queue.
+    }
+    pxRingbuffer->pucAcquired = prvSPSCAcquireBlocking(pxRingbuffer, xItemSize, xTicksToWait);
+    *ppvItem = pxRingbuffer->pucAcquired;
+    return (*ppvItem != NULL) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xRingbufferSPSCSendComplete(RingbufSPSCHandle_t xRingbuffer, void *pvItem)
+{
+    //Check arguments
+    RingbufferSPSC_t *pxRingbuffer = (RingbufferSPSC_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pvItem != NULL && pvItem == pxRingbuffer->pucAcquired);
+
+    pxRingbuffer->pucAcquired = NULL;
+    prvSPSCPublish(pxRingbuffer, pdFALSE, NULL);
+    return pdTRUE;
+}
+
+void *xRingbufferSPSCReceive(RingbufSPSCHandle_t xRingbuffer, size_t *pxItemSize, TickType_t xTicksToWait)
+{
+    //Check arguments
+    RingbufferSPSC_t *pxRingbuffer = (RingbufferSPSC_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+
+    uint8_t *pucItem = prvSPSCGetItem(pxRingbuffer, pxItemSize);
+    TickType_t xTicksEnd = xTaskGetTickCount() + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    while (pucItem == NULL && xTicksRemaining != 0 && xTicksRemaining <= xTicksToWait) {
+        prvSPSCPrepareWait(&pxRingbuffer->xRecvWaiter);
+        pucItem = prvSPSCGetItem(pxRingbuffer, pxItemSize);
+        BaseType_t xNotified = pdFALSE;
+        if (pucItem == NULL) {
+            xNotified = (ulTaskNotifyTakeIndexed(rbSPSC_NOTIFY_INDEX, pdTRUE, xTicksRemaining) != 0) ? pdTRUE : pdFALSE;
+        }
+        prvSPSCFinishWait(&pxRingbuffer->xRecvWaiter, xNotified);
+        if (pucItem == NULL) {
+            pucItem = prvSPSCGetItem(pxRingbuffer, pxItemSize);
+        }
+        //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
+        if (xTicksToWait != portMAX_DELAY) {
+            xTicksRemaining = xTicksEnd - xTaskGetTickCount();
+        }
+    }
+    return pucItem;
+}
+
+void *xRingbufferSPSCReceiveFromISR(RingbufSPSCHandle_t xRingbuffer, size_t *pxItemSize)
+{
+    //Check arguments
+    RingbufferSPSC_t *pxRingbuffer = (RingbufferSPSC_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+
+    return prvSPSCGetItem(pxRingbuffer, pxItemSize);
+}
+
+void vRingbufferSPSCReturnItem(RingbufSPSCHandle_t xRingbuffer, void *pvItem)
+{
+    RingbufferSPSC_t *pxRingbuffer = (RingbufferSPSC_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pvItem != NULL);
+
+    prvSPSCReturnItem(pxRingbuffer, (uint8_t *)pvItem);
+    prvSPSCWake(&pxRingbuffer->xSendWaiter, pdFALSE, NULL);
+}
+
+void vRingbufferSPSCReturnItemFromISR(RingbufSPSCHandle_t xRingbuffer, void *pvItem, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    RingbufferSPSC_t *pxRingbuffer = (RingbufferSPSC_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pvItem != NULL);
+
+    prvSPSCReturnItem(pxRingbuffer, (uint8_t *)pvItem);
+    prvSPSCWake(&pxRingbuffer->xSendWaiter, pdTRUE, pxHigherPriorityTaskWoken);
+}
+
+size_t xRingbufferSPSCGetMaxItemSize(RingbufSPSCHandle_t xRingbuffer)
+{
+    RingbufferSPSC_t *pxRingbuffer = (RingbufferSPSC_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    return pxRingbuffer->xMaxItemSize;
+}
+
+void vRingbufferSPSCDelete(RingbufSPSCHandle_t xRingbuffer)
+{
+    RingbufferSPSC_t *pxRingbuffer = (RingbufferSPSC_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(atomic_load(&pxRingbuffer->xSendWaiter) == NULL && atomic_load(&pxRingbuffer->xRecvWaiter) == NULL);
+
+    free(pxRingbuffer->pucHead);
+    free(pxRingbuffer);
+}
@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -1019,6 +1020,204 @@ TEST_CASE("Test static ring buffer SMP", "[esp_ringbuf]")
 }
 #endif
 
+/* ------------------------ Test batch receive and return ----------------------
+ * The following test case fills a no-split buffer, then drains it in batches with
+ * xRingbufferReceiveMultiple() and vRingbufferReturnMultiple(). Items of
+ * alternating sizes are used so that the drained items wrap around the buffer.
+ */
+
+#define MULTIPLE_BATCH_SIZE     3
+
+TEST_CASE("Test no-split ring buffer receive multiple", "[esp_ringbuf]")
+{
+    RingbufHandle_t buffer = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+    TEST_ASSERT_MESSAGE(buffer != NULL, "Failed to create ring buffer");
+    void *items[MULTIPLE_BATCH_SIZE];
+    size_t sizes[MULTIPLE_BATCH_SIZE];
+    TEST_ASSERT_MESSAGE(xRingbufferReceiveMultiple(buffer, items, sizes, MULTIPLE_BATCH_SIZE, TIMEOUT_TICKS) == 0, "Received items from an empty buffer");
+
+    for (int iter = 0; iter < 8; iter++) {
+        //Fill the buffer
+        int sent = 0;
+        while (1) {
+            const uint8_t *item = (sent % 2) ? large_item : small_item;
+            size_t item_size = (sent % 2) ? LARGE_ITEM_SIZE : SMALL_ITEM_SIZE;
+            if (xRingbufferSend(buffer, item, item_size, 0) != pdTRUE) {
+                break;
+            }
+            sent++;
+        }
+        TEST_ASSERT_MESSAGE(sent > MULTIPLE_BATCH_SIZE, "Buffer too small for the test");
+
+        //Drain the buffer in batches
+        int received = 0;
+        while (received < sent) {
+            UBaseType_t count = xRingbufferReceiveMultiple(buffer, items, sizes, MULTIPLE_BATCH_SIZE, 0);
+            UBaseType_t expected = (sent - received < MULTIPLE_BATCH_SIZE) ? sent - received : MULTIPLE_BATCH_SIZE;
+            TEST_ASSERT_EQUAL_MESSAGE(expected, count, "Received an incorrect number of items");
+            for (int i = 0; i < count; i++) {
+                const uint8_t *expected_data = ((received + i) % 2) ? large_item : small_item;
+                size_t expected_size = ((received + i) % 2) ? LARGE_ITEM_SIZE : SMALL_ITEM_SIZE;
+                TEST_ASSERT_MESSAGE(sizes[i] == expected_size, "Item size is incorrect");
+                TEST_ASSERT_MESSAGE(memcmp(items[i], expected_data, expected_size) == 0, "Item data is corrupted");
+            }
+            vRingbufferReturnMultiple(buffer, items, count);
+            received += count;
+        }
+        TEST_ASSERT_MESSAGE(xRingbufferReceiveMultiple(buffer, items, sizes, MULTIPLE_BATCH_SIZE, 0) == 0, "Buffer should be empty");
+
+        //Shift the buffer position so that the next iteration wraps around differently
+        send_item_and_check(buffer, small_item, SMALL_ITEM_SIZE, TIMEOUT_TICKS, false);
+        receive_check_and_return_item_no_split(buffer, small_item, SMALL_ITEM_SIZE, TIMEOUT_TICKS, false);
+    }
+    vRingbufferDelete(buffer);
+}
+
+/* ------------------------- Test SPSC ring buffer -----------------------------
+ * The following test cases test the single-producer/single-consumer ring buffer.
+ * The first test case checks wrap around, buffer full and empty behavior from a
+ * single task. The second test case streams the continuous data from a sending
+ * task to a receiving task like the SMP test case above, alternating between
+ * xRingbufferSPSCSend() and xRingbufferSPSCSendAcquire(), and with the receiving
+ * task retrieving up to two items before returning them.
+ */
+
+TEST_CASE("Test SPSC ring buffer wrap around", "[esp_ringbuf]")
+{
+    RingbufSPSCHandle_t buffer = xRingbufferCreateSPSC(CONT_DATA_TEST_BUFF_LEN);
+    TEST_ASSERT_MESSAGE(buffer != NULL, "Failed to create ring buffer");
+    size_t max_item_size = xRingbufferSPSCGetMaxItemSize(buffer);
+    TEST_ASSERT_MESSAGE(xRingbufferSPSCSend(buffer, continuous_data, max_item_size + 1, 0) == pdFALSE, "Sent an item larger than the max item size");
+    TEST_ASSERT_MESSAGE(xRingbufferSPSCReceive(buffer, NULL, TIMEOUT_TICKS) == NULL, "Received an item from an empty buffer");
+
+    srand(SRAND_SEED);
+    size_t bytes_sent = 0;
+    size_t bytes_rec = 0;
+    for (int iter = 0; iter < 1000; iter++) {
+        //Send items of random length until the buffer is full
+        while (1) {
+            size_t item_size = rand() % (max_item_size + 1);
+            size_t offset = bytes_sent % CONT_DATA_LEN;
+            if (item_size > CONT_DATA_LEN - offset) {
+                item_size = CONT_DATA_LEN - offset;
+            }
+            if (xRingbufferSPSCSend(buffer, &continuous_data[offset], item_size, 0) != pdTRUE) {
+                break;
+            }
+            bytes_sent += item_size;
+        }
+        //Receive a random number of items, an empty buffer must always accept an item of max size
+        int items = rand() % 8;
+        size_t item_size;
+        char *item;
+        while ((items-- > 0 || iter % 16 == 0) && (item = (char *)xRingbufferSPSCReceive(buffer, &item_size, 0)) != NULL) {
+            for (int i = 0; i < item_size; i++) {
+                TEST_ASSERT_MESSAGE(item[i] == continuous_data[(bytes_rec + i) % CONT_DATA_LEN], "Received data is corrupted");
+            }
+            bytes_rec += item_size;
+            vRingbufferSPSCReturnItem(buffer, item);
+        }
+        if (iter % 16 == 0) {
+            char max_item[CONT_DATA_TEST_BUFF_LEN];
+            for (int i = 0; i < max_item_size; i++) {
+                max_item[i] = continuous_data[(bytes_sent + i) % CONT_DATA_LEN];
+            }
+            TEST_ASSERT_MESSAGE(bytes_rec == bytes_sent, "Buffer should be empty");
+            TEST_ASSERT_MESSAGE(xRingbufferSPSCSend(buffer, max_item, max_item_size, 0) == pdTRUE, "Failed to send an item of max size");
+            bytes_sent += max_item_size;
+        }
+    }
+    vRingbufferSPSCDelete(buffer);
+}
+
+static void spsc_send_task(void *args)
+{
+    RingbufSPSCHandle_t buffer = (RingbufSPSCHandle_t)args;
+    size_t max_item_size = xRingbufferSPSCGetMaxItemSize(buffer);
+    for (int iter = 0; iter < SMP_TEST_ITERATIONS; iter++) {
+        size_t bytes_sent = 0;
+        while (bytes_sent < CONT_DATA_LEN) {
+            size_t next_item_size = rand() % (max_item_size + 1);
+            if (next_item_size + bytes_sent > CONT_DATA_LEN) {
+                next_item_size = CONT_DATA_LEN - bytes_sent;
+            }
+            if (bytes_sent & 1) {
+                void *item;
+                TEST_ASSERT_MESSAGE(xRingbufferSPSCSendAcquire(buffer, &item, next_item_size, TIMEOUT_TICKS) == pdTRUE, "Failed to acquire an item");
+                memcpy(item, &continuous_data[bytes_sent], next_item_size);
+                TEST_ASSERT(xRingbufferSPSCSendComplete(buffer, item) == pdTRUE);
+            } else {
+                TEST_ASSERT_MESSAGE(xRingbufferSPSCSend(buffer, &continuous_data[bytes_sent], next_item_size, TIMEOUT_TICKS) == pdTRUE, "Failed to send an item");
+            }
+            bytes_sent += next_item_size;
+        }
+        xSemaphoreGive(tx_done);
+        xSemaphoreTake(rx_done, portMAX_DELAY);
+    }
+    vTaskDelete(NULL);
+}
+
+static void spsc_rec_task(void *args)
+{
+    RingbufSPSCHandle_t buffer = (RingbufSPSCHandle_t)args;
+    for (int iter = 0; iter < SMP_TEST_ITERATIONS; iter++) {
+        size_t bytes_rec = 0;
+        while (bytes_rec < CONT_DATA_LEN) {
+            size_t item_size, item_size2;
+            char *item_data, *item_data2;
+
+            //Receive an item, then a second one without blocking if available
+            item_data = (char *)xRingbufferSPSCReceive(buffer, &item_size, TIMEOUT_TICKS);
+            TEST_ASSERT_MESSAGE(item_data != NULL, "Failed to receive an item");
+            item_data2 = (char *)xRingbufferSPSCReceive(buffer, &item_size2, 0);
+
+            for (int i = 0; i < item_size; i++) {
+                TEST_ASSERT_MESSAGE(item_data[i] == continuous_data[bytes_rec + i], "Received data is corrupted");
+            }
+            bytes_rec += item_size;
+            if (item_data2 != NULL) {
+                for (int i = 0; i < item_size2; i++) {
+                    TEST_ASSERT_MESSAGE(item_data2[i] == continuous_data[bytes_rec + i], "Received data is corrupted");
+                }
+                bytes_rec += item_size2;
+            }
+            //Items are returned in the order they were received
+            vRingbufferSPSCReturnItem(buffer, item_data);
+            if (item_data2 != NULL) {
+                vRingbufferSPSCReturnItem(buffer, item_data2);
+            }
+        }
+        TEST_ASSERT_MESSAGE(bytes_rec == CONT_DATA_LEN, "Total length of received data is incorrect");
+        xSemaphoreGive(rx_done);
+        xSemaphoreTake(tx_done, portMAX_DELAY);
+    }
+    xSemaphoreGive(tasks_done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("Test SPSC ring buffer SMP", "[esp_ringbuf]")
+{
+    setup();
+    RingbufSPSCHandle_t buffer = xRingbufferCreateSPSC(CONT_DATA_TEST_BUFF_LEN);
+    TEST_ASSERT_MESSAGE(buffer != NULL, "Failed to create ring buffer");
+
+    for (int prior_mod = -1; prior_mod < 2; prior_mod++) {  //Test different relative priorities
+        //Test every permutation of core affinity
+        for (int send_core = 0; send_core < portNUM_PROCESSORS; send_core++) {
+            for (int rec_core = 0; rec_core < portNUM_PROCESSORS; rec_core ++) {
+                esp_rom_printf("SPSC, PM: %d, SC: %d, RC: %d\n", prior_mod, send_core, rec_core);
+                xTaskCreatePinnedToCore(spsc_send_task, "send tsk", 2048, (void *)buffer, 10 + prior_mod, NULL, send_core);
+                xTaskCreatePinnedToCore(spsc_rec_task, "rec tsk", 2048, (void *)buffer, 10, NULL, rec_core);
+                xSemaphoreTake(tasks_done, portMAX_DELAY);
+                vTaskDelay(5);  //Allow idle to clean up
+            }
+        }
+    }
+
+    vRingbufferSPSCDelete(buffer);
+    cleanup();
+}
+
 #if !CONFIG_RINGBUF_PLACE_FUNCTIONS_INTO_FLASH && !CONFIG_RINGBUF_PLACE_ISR_FUNCTIONS_INTO_FLASH
 /* -------------------------- Test ring buffer IRAM ------------------------- */
 
@@ -1038,6 +1237,21 @@ static IRAM_ATTR __attribute__((noinline)) bool iram_ringbuf_test(void)
     spi_flash_guard_get()->end(); // Re-enables flash cache
     vRingbufferDelete(handle);
 
+    RingbufSPSCHandle_t spsc_handle = xRingbufferCreateSPSC(CONT_DATA_TEST_BUFF_LEN);
+    result = result && (spsc_handle != NULL);
+    spi_flash_guard_get()->start(); // Disables flash cache
+
+    xRingbufferSPSCGetMaxItemSize(spsc_handle);
+    xRingbufferSPSCSendFromISR(spsc_handle, (void *)item, sizeof(item), NULL);
+    void *spsc_item = xRingbufferSPSCReceiveFromISR(spsc_handle, &item_size);
+    if (spsc_item != NULL) {
+        vRingbufferSPSCReturnItemFromISR(spsc_handle, spsc_item, NULL);
+    }
+
+    spi_flash_guard_get()->end(); // Re-enables flash cache
+    result = result && (spsc_item != NULL);
+    vRingbufferSPSCDelete(spsc_handle);
+
     return result;
 }
 
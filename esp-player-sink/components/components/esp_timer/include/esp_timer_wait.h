@@ -0,0 +1,177 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+/**
+ * @file esp_timer_wait.h
+ * @brief microsecond-precision timed waits for FreeRTOS tasks
+ *
+ * vTaskDelay() and the timeouts of the FreeRTOS queues are counted in ticks,
+ * so with CONFIG_FREERTOS_HZ=100 a task cannot wait for less than 10 ms, and
+ * every timeout is rounded to a multiple of 10 ms. A waiter lets a task block
+ * until an absolute esp_timer_get_time() deadline instead: a one-shot esp_timer
+ * is armed for the deadline and its callback wakes the task with a task
+ * notification, so the tick rate does not need to be raised.
+ *
+ * A waiter belongs to the task which created it. It uses the notification of
+ * that task at index ESP_TIMER_WAITER_NOTIFY_INDEX without modifying the
+ * notification value, so the value can still be used to pass bits to the task,
+ * see esp_timer_waiter_wait_bits_until. A task waiting on that index may however
+ * see a notification it did not expect, and should check the notification value
+ * rather than rely on being notified.
+ *
+ * Every wakeup at the end of a wait records its latency, i.e. the time between
+ * the deadline and the moment the task runs again, in a histogram which can be
+ * read with esp_timer_waiter_get_stats.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of buckets of the wakeup latency histogram
+ *
+ * Bucket 0 counts the wakeups with a latency under 1 us, bucket i counts the
+ * latencies from 2^(i-1) to 2^i - 1 us, and the last bucket also counts the
+ * wakeups which are later than that.
+ */
+#define ESP_TIMER_WAIT_LATENCY_BUCKETS  14
+
+/**
+ * @brief Task notification index used by the waiters, see CONFIG_ESP_TIMER_WAITER_NOTIFY_INDEX
+ */
+#define ESP_TIMER_WAITER_NOTIFY_INDEX   CONFIG_ESP_TIMER_WAITER_NOTIFY_INDEX
+
+/**
+ * @brief Opaque type representing a waiter
+ */
+typedef struct esp_timer_waiter* esp_timer_waiter_handle_t;
+
+/**
+ * @brief Waiter configuration passed to esp_timer_waiter_create
+ */
+typedef struct {
+    uint32_t spin_us;           //!< Busy-wait for the last spin_us microseconds before a deadline, trading CPU time for a lower latency. 0 to always block.
+    const char* name;           //!< Name of the esp_timer used by the waiter, used in esp_timer_dump function
+} esp_timer_waiter_config_t;
+
+/**
+ * @brief Wakeup latency statistics of a waiter
+ */
+typedef struct {
+    uint32_t wakeups;           //!< Number of waits which ended at their deadline
+    uint32_t max_latency_us;    //!< Longest latency
+    uint64_t total_latency_us;  //!< Sum of the latencies, to compute the average
+    uint32_t histogram[ESP_TIMER_WAIT_LATENCY_BUCKETS];  //!< Number of wakeups per latency bucket
+} esp_timer_waiter_stats_t;
+
+/**
+ * @brief Create a waiter for the calling task
+ *
+ * @param config Pointer to waiter configuration, or NULL to use the defaults (no busy-wait)
+ * @param out_handle Output, pointer to esp_timer_waiter_handle_t variable which
+ *                   will hold the created waiter handle.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if out_handle is NULL
+ *      - ESP_ERR_INVALID_STATE if esp_timer library is not initialized yet
+ *      - ESP_ERR_NO_MEM if memory allocation fails
+ */
+esp_err_t esp_timer_waiter_create(const esp_timer_waiter_config_t* config,
+                                  esp_timer_waiter_handle_t* out_handle);
+
+/**
+ * @brief Block the calling task until an absolute time
+ *
+ * Returns at once if the deadline has already passed. Notifications received by
+ * the task before the deadline do not end the wait.
+ *
+ * @param waiter waiter handle created by the calling task
+ * @param deadline_us time in microseconds, in the time base of esp_timer_get_time
+ *
+ * @return
+ *      - ESP_OK once the deadline is reached
+ *      - ESP_ERR_INVALID_ARG if the handle is invalid
+ *      - ESP_ERR_INVALID_STATE if the waiter was not created by the calling task
+ *      - other errors of esp_timer_start_once if the timer of the waiter could not be armed
+ */
+esp_err_t esp_timer_waiter_sleep_until(esp_timer_waiter_handle_t waiter, int64_t deadline_us);
+
+/**
+ * @brief Block the calling task for a number of microseconds
+ *
+ * Same as esp_timer_waiter_sleep_until(waiter, esp_timer_get_time() + delay_us).
+ * Periodic tasks should prefer esp_timer_waiter_sleep_until with a deadline
+ * advanced by the period, so that the latencies do not accumulate.
+ *
+ * @param waiter waiter handle created by the calling task
+ * @param delay_us delay in microseconds
+ *
+ * @return see esp_timer_waiter_sleep_until
+ */
+esp_err_t esp_timer_waiter_sleep(esp_timer_waiter_handle_t waiter, uint64_t delay_us);
+
+/**
+ * @brief Wait for notification bits, until an absolute time at most
+ *
+ * Other tasks or ISRs set the bits with
+ * xTaskNotifyIndexed(task, ESP_TIMER_WAITER_NOTIFY_INDEX, bits, eSetBits) or
+ * xTaskNotifyIndexedFromISR. This is the microsecond-precision equivalent of
+ * xTaskNotifyWait with a timeout.
+ *
+ * @param waiter waiter handle created by the calling task
+ * @param bits_to_wait bits of the notification value to wait for
+ * @param deadline_us time in microseconds, in the time base of esp_timer_get_time
+ * @param out_bits Output, optional, the bits of bits_to_wait which were set.
+ *                 These bits are cleared in the notification value, the others are left untouched.
+ *
+ * @return
+ *      - ESP_OK if at least one of the bits was set before the deadline
+ *      - ESP_ERR_TIMEOUT if none of the bits was set before the deadline
+ *      - ESP_ERR_INVALID_ARG if the handle is invalid or bits_to_wait is 0
+ *      - ESP_ERR_INVALID_STATE if the waiter was not created by the calling task
+ *      - other errors of esp_timer_start_once if the timer of the waiter could not be armed
+ */
+esp_err_t esp_timer_waiter_wait_bits_until(esp_timer_waiter_handle_t waiter, uint32_t bits_to_wait,
+                                           int64_t deadline_us, uint32_t* out_bits);
+
+/**
+ * @brief Get the wakeup latency statistics of a waiter
+ *
+ * Can be called from any task.
+ *
+ * @param waiter waiter handle
+ * @param out_stats Output, pointer to the structure to which the statistics will be written
+ * @param reset if true, the statistics are reset after being read
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the handle or out_stats is invalid
+ */
+esp_err_t esp_timer_waiter_get_stats(esp_timer_waiter_handle_t waiter, esp_timer_waiter_stats_t* out_stats, bool reset);
+
+/**
+ * @brief Delete a waiter
+ *
+ * @param waiter waiter handle, must not be waited on
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the handle is invalid
+ */
+esp_err_t esp_timer_waiter_delete(esp_timer_waiter_handle_t waiter);
+
+#ifdef __cplusplus
+}
+#endif
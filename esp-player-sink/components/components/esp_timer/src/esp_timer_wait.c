@@ -0,0 +1,240 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_timer_wait.h"
+#include "sdkconfig.h"
+
+/*
+ * The esp_timer callback only notifies the task with eNoAction, the time read
+ * after the task wakes up is what decides whether the deadline is reached. This
+ * keeps the waits correct when the task is notified for another reason, or when
+ * the callback of a timer stopped too late by esp_timer_waiter_wait_bits_until
+ * notifies the task during a later wait.
+ *
+ * The ISR dispatch method, when it is enabled, saves the switch to the
+ * esp_timer task between the alarm and the wakeup of the waiting task.
+ *
+ * The waits block on a notification index of their own, index 0 is used by
+ * stream buffers and message buffers.
+ */
+
+_Static_assert(ESP_TIMER_WAITER_NOTIFY_INDEX > 0 && ESP_TIMER_WAITER_NOTIFY_INDEX < configTASK_NOTIFICATION_ARRAY_ENTRIES,
+               "CONFIG_ESP_TIMER_WAITER_NOTIFY_INDEX must be in 1 .. CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES - 1");
+#ifdef CONFIG_RINGBUF_SPSC_NOTIFY_INDEX
+_Static_assert(ESP_TIMER_WAITER_NOTIFY_INDEX != CONFIG_RINGBUF_SPSC_NOTIFY_INDEX,
+               "esp_timer waiters and SPSC ring buffers must use different notification indexes");
+#endif
+
+struct esp_timer_waiter {
+    TaskHandle_t task;          // task which created the waiter, the only one allowed to wait on it
+    esp_timer_handle_t timer;   // one-shot timer armed for the deadline of the current wait
+    uint32_t spin_us;
+    portMUX_TYPE stats_lock;
+    esp_timer_waiter_stats_t stats;
+};
+
+static void IRAM_ATTR waiter_timer_cb(void* arg)
+{
+    esp_timer_waiter_handle_t waiter = (esp_timer_waiter_handle_t) arg;
+#ifdef CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    BaseType_t need_yield = pdFALSE;
+    xTaskNotifyIndexedFromISR(waiter->task, ESP_TIMER_WAITER_NOTIFY_INDEX, 0, eNoAction, &need_yield);
+    if (need_yield == pdTRUE) {
+        esp_timer_isr_dispatch_need_yield();
+    }
+#else
+    xTaskNotifyIndexed(waiter->task, ESP_TIMER_WAITER_NOTIFY_INDEX, 0, eNoAction);
+#endif
+}
+
+static void record_wakeup(esp_timer_waiter_handle_t waiter, int64_t deadline_us)
+{
+    int64_t late = esp_timer_get_time() - deadline_us;
+    uint32_t latency_us = (late < 0) ? 0 : (late > UINT32_MAX) ? UINT32_MAX : (uint32_t) late;
+    // bucket i holds the latencies with i significant bits
+    int bucket = (latency_us == 0) ? 0 : 32 - __builtin_clz(latency_us);
+    if (bucket >= ESP_TIMER_WAIT_LATENCY_BUCKETS) {
+        bucket = ESP_TIMER_WAIT_LATENCY_BUCKETS - 1;
+    }
+
+    portENTER_CRITICAL(&waiter->stats_lock);
+    waiter->stats.wakeups++;
+    waiter->stats.total_latency_us += latency_us;
+    if (latency_us > waiter->stats.max_latency_us) {
+        waiter->stats.max_latency_us = latency_us;
+    }
+    waiter->stats.histogram[bucket]++;
+    portEXIT_CRITICAL(&waiter->stats_lock);
+}
+
+static esp_err_t arm_timer(esp_timer_waiter_handle_t waiter, uint64_t timeout_us)
+{
+    // a notification may have ended the previous wait after its wake up time but before the alarm
+    // was dispatched, the timer is then still armed
+    esp_timer_stop(waiter->timer);
+    return esp_timer_start_once(waiter->timer, timeout_us);
+}
+
+static void spin_until(int64_t deadline_us)
+{
+    while (esp_timer_get_time() < deadline_us) {
+        ;
+    }
+}
+
+esp_err_t esp_timer_waiter_create(const esp_timer_waiter_config_t* config,
+                                  esp_timer_waiter_handle_t* out_handle)
+{
+    if (out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // the waiter is accessed from the timer ISR when the ISR dispatch method is used
+    esp_timer_waiter_handle_t waiter = (esp_timer_waiter_handle_t) heap_caps_calloc(1, sizeof(*waiter), MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+    if (waiter == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    waiter->task = xTaskGetCurrentTaskHandle();
+    waiter->spin_us = (config != NULL) ? config->spin_us : 0;
+    portMUX_INITIALIZE(&waiter->stats_lock);
+
+    esp_timer_create_args_t timer_args = {
+        .callback = &waiter_timer_cb,
+        .arg = waiter,
+#ifdef CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+        .dispatch_method = ESP_TIMER_ISR,
+#else
+        .dispatch_method = ESP_TIMER_TASK,
+#endif
+        .name = (config != NULL && config->name != NULL) ? config->name : "waiter",
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &waiter->timer);
+    if (err != ESP_OK) {
+        free(waiter);
+        return err;
+    }
+    *out_handle = waiter;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_waiter_sleep_until(esp_timer_waiter_handle_t waiter, int64_t deadline_us)
+{
+    if (waiter == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (waiter->task != xTaskGetCurrentTaskHandle()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const int64_t wake_us = deadline_us - waiter->spin_us;
+    int64_t now = esp_timer_get_time();
+    if (now >= deadline_us) {
+        return ESP_OK;
+    }
+    if (now < wake_us) {
+        esp_err_t err = arm_timer(waiter, wake_us - now);
+        if (err != ESP_OK) {
+            return err;
+        }
+        do {
+            xTaskNotifyWaitIndexed(ESP_TIMER_WAITER_NOTIFY_INDEX, 0, 0, NULL, portMAX_DELAY);
+        } while (esp_timer_get_time() < wake_us);
+    }
+    spin_until(deadline_us);
+    record_wakeup(waiter, deadline_us);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_waiter_sleep(esp_timer_waiter_handle_t waiter, uint64_t delay_us)
+{
+    return esp_timer_waiter_sleep_until(waiter, esp_timer_get_time() + delay_us);
+}
+
+esp_err_t esp_timer_waiter_wait_bits_until(esp_timer_waiter_handle_t waiter, uint32_t bits_to_wait,
+                                           int64_t deadline_us, uint32_t* out_bits)
+{
+    if (waiter == NULL || bits_to_wait == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (waiter->task != xTaskGetCurrentTaskHandle()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const int64_t wake_us = deadline_us - waiter->spin_us;
+    bool armed = false;
+    esp_err_t ret = ESP_ERR_TIMEOUT;
+    uint32_t bits;
+    while (true) {
+        // reads and clears the bits in one go, a bit set right after is seen on the next iteration
+        bits = ulTaskNotifyValueClearIndexed(NULL, ESP_TIMER_WAITER_NOTIFY_INDEX, bits_to_wait) & bits_to_wait;
+        if (bits != 0) {
+            ret = ESP_OK;
+            break;
+        }
+        int64_t now = esp_timer_get_time();
+        if (now >= deadline_us) {
+            break;
+        }
+        if (now >= wake_us) {
+            // close enough to the deadline to poll the bits without blocking
+            continue;
+        }
+        if (!armed) {
+            esp_err_t err = arm_timer(waiter, wake_us - now);
+            if (err != ESP_OK) {
+                ret = err;
+                break;
+            }
+            armed = true;
+        }
+        xTaskNotifyWaitIndexed(ESP_TIMER_WAITER_NOTIFY_INDEX, 0, 0, NULL, portMAX_DELAY);
+    }
+    if (armed) {
+        // fails if the timer has already expired, the notification it sends is then ignored by later waits
+        esp_timer_stop(waiter->timer);
+    }
+    if (ret == ESP_ERR_TIMEOUT) {
+        record_wakeup(waiter, deadline_us);
+    }
+    if (out_bits != NULL) {
+        *out_bits = bits;
+    }
+    return ret;
+}
+
+esp_err_t esp_timer_waiter_get_stats(esp_timer_waiter_handle_t waiter, esp_timer_waiter_stats_t* out_stats, bool reset)
+{
+    if (waiter == NULL || out_stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&waiter->stats_lock);
+    *out_stats = waiter->stats;
+    if (reset) {
+        memset(&waiter->stats, 0, sizeof(waiter->stats));
+    }
+    portEXIT_CRITICAL(&waiter->stats_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_waiter_delete(esp_timer_waiter_handle_t waiter)
+{
+    if (waiter == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer_stop(waiter->timer);
+    esp_err_t err = esp_timer_delete(waiter->timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    free(waiter);
+    return ESP_OK;
+}
@@ -0,0 +1,177 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "esp_timer.h"
+#include "esp_timer_wait.h"
+#include "unity.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "test_utils.h"
+#include "esp_bit_defs.h"
+#include "esp_rom_sys.h"
+
+#define SEC  (1000000)
+
+static void print_latency_histogram(const char* title, const esp_timer_waiter_stats_t* stats)
+{
+    printf("%s: %" PRIu32 " wakeups, average %" PRIu64 " us, max %" PRIu32 " us\n", title, stats->wakeups,
+           stats->wakeups ? stats->total_latency_us / stats->wakeups : 0, stats->max_latency_us);
+    for (int i = 0; i < ESP_TIMER_WAIT_LATENCY_BUCKETS; i++) {
+        if (stats->histogram[i] != 0) {
+            printf("  %5d us - %5d us: %" PRIu32 "\n", i ? 1 << (i - 1) : 0, (1 << i) - 1, stats->histogram[i]);
+        }
+    }
+}
+
+TEST_CASE("esp_timer waiter sleeps until a deadline between ticks", "[esp_timer]")
+{
+    esp_timer_waiter_handle_t waiter;
+    TEST_ESP_OK(esp_timer_waiter_create(NULL, &waiter));
+
+    // 2.5 ms frames, a quarter of a tick with CONFIG_FREERTOS_HZ=100
+    const int period_us = 2500;
+    const int periods = 200;
+    int64_t deadline = esp_timer_get_time();
+    for (int i = 0; i < periods; i++) {
+        deadline += period_us;
+        TEST_ESP_OK(esp_timer_waiter_sleep_until(waiter, deadline));
+        TEST_ASSERT_GREATER_OR_EQUAL(deadline, esp_timer_get_time());
+    }
+
+    esp_timer_waiter_stats_t stats;
+    TEST_ESP_OK(esp_timer_waiter_get_stats(waiter, &stats, true));
+    print_latency_histogram("sleep_until", &stats);
+    TEST_ASSERT_EQUAL(periods, stats.wakeups);
+#ifndef CONFIG_IDF_ENV_FPGA
+    TEST_ASSERT_LESS_THAN(200, stats.total_latency_us / stats.wakeups);
+#endif
+
+    // a deadline in the past returns at once and is not counted
+    TEST_ESP_OK(esp_timer_waiter_sleep_until(waiter, esp_timer_get_time() - 1));
+    TEST_ESP_OK(esp_timer_waiter_get_stats(waiter, &stats, false));
+    TEST_ASSERT_EQUAL(0, stats.wakeups);
+    TEST_ESP_OK(esp_timer_waiter_delete(waiter));
+}
+
+TEST_CASE("esp_timer waiter busy-waits the end of a sleep", "[esp_timer]")
+{
+    esp_timer_waiter_config_t config = {
+        .spin_us = 100,
+    };
+    esp_timer_waiter_handle_t waiter;
+    TEST_ESP_OK(esp_timer_waiter_create(&config, &waiter));
+    for (int i = 0; i < 100; i++) {
+        TEST_ESP_OK(esp_timer_waiter_sleep(waiter, 1000 + i));
+    }
+    esp_timer_waiter_stats_t stats;
+    TEST_ESP_OK(esp_timer_waiter_get_stats(waiter, &stats, true));
+    print_latency_histogram("sleep with 100 us spin", &stats);
+    TEST_ASSERT_EQUAL(100, stats.wakeups);
+#ifndef CONFIG_IDF_ENV_FPGA
+    TEST_ASSERT_LESS_THAN(20, stats.total_latency_us / stats.wakeups);
+#endif
+    TEST_ESP_OK(esp_timer_waiter_delete(waiter));
+}
+
+static void notify_bits_task(void* arg)
+{
+    TaskHandle_t waiting_task = (TaskHandle_t) arg;
+    vTaskDelay(1);
+    xTaskNotifyIndexed(waiting_task, ESP_TIMER_WAITER_NOTIFY_INDEX, BIT(3) | BIT(5), eSetBits);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("esp_timer waiter waits for notification bits until a deadline", "[esp_timer]")
+{
+    esp_timer_waiter_handle_t waiter;
+    uint32_t bits;
+    TEST_ESP_OK(esp_timer_waiter_create(NULL, &waiter));
+    ulTaskNotifyValueClearIndexed(NULL, ESP_TIMER_WAITER_NOTIFY_INDEX, UINT32_MAX);
+
+    // no bits set, the wait ends at the deadline
+    int64_t deadline = esp_timer_get_time() + 1500;
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, esp_timer_waiter_wait_bits_until(waiter, BIT(3), deadline, &bits));
+    TEST_ASSERT_GREATER_OR_EQUAL(deadline, esp_timer_get_time());
+    TEST_ASSERT_EQUAL(0, bits);
+
+    // the bits arrive before the deadline, only the awaited one is cleared
+    xTaskCreatePinnedToCore(notify_bits_task, "notify", 2048, xTaskGetCurrentTaskHandle(), UNITY_FREERTOS_PRIORITY + 1, NULL, 0);
+    int64_t start = esp_timer_get_time();
+    TEST_ESP_OK(esp_timer_waiter_wait_bits_until(waiter, BIT(3), start + 10 * SEC, &bits));
+    TEST_ASSERT_EQUAL(BIT(3), bits);
+    TEST_ASSERT_LESS_THAN(1 * SEC, esp_timer_get_time() - start);
+    TEST_ASSERT_EQUAL(BIT(5), ulTaskNotifyValueClearIndexed(NULL, ESP_TIMER_WAITER_NOTIFY_INDEX, UINT32_MAX));
+
+    // the timer stopped above must not end the next sleep early
+    deadline = esp_timer_get_time() + 3000;
+    TEST_ESP_OK(esp_timer_waiter_sleep_until(waiter, deadline));
+    TEST_ASSERT_GREATER_OR_EQUAL(deadline, esp_timer_get_time());
+
+    esp_timer_waiter_stats_t stats;
+    TEST_ESP_OK(esp_timer_waiter_get_stats(waiter, &stats, false));
+    TEST_ASSERT_EQUAL(2, stats.wakeups);
+    TEST_ESP_OK(esp_timer_waiter_delete(waiter));
+    vTaskDelay(2);  // allow idle to clean up
+}
+
+static volatile bool s_stop_notifying;
+
+static void stray_notify_task(void* arg)
+{
+    TaskHandle_t waiting_task = (TaskHandle_t) arg;
+    while (!s_stop_notifying) {
+        xTaskNotifyIndexed(waiting_task, ESP_TIMER_WAITER_NOTIFY_INDEX, 0, eNoAction);
+        esp_rom_delay_us(37);
+    }
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("esp_timer waiter keeps waiting through stray notifications", "[esp_timer]")
+{
+    esp_timer_waiter_handle_t waiter;
+    TEST_ESP_OK(esp_timer_waiter_create(NULL, &waiter));
+
+    // a notification between the wake up time and the alarm leaves the timer armed for the next wait,
+    // the notifying task runs whenever this one blocks
+    s_stop_notifying = false;
+    xTaskCreatePinnedToCore(stray_notify_task, "stray", 2048, xTaskGetCurrentTaskHandle(), UNITY_FREERTOS_PRIORITY - 1, NULL, xPortGetCoreID());
+    for (int i = 0; i < 500; i++) {
+        int64_t deadline = esp_timer_get_time() + 200 + i % 50;
+        TEST_ESP_OK(esp_timer_waiter_sleep_until(waiter, deadline));
+        TEST_ASSERT_GREATER_OR_EQUAL(deadline, esp_timer_get_time());
+        TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, esp_timer_waiter_wait_bits_until(waiter, BIT(0), esp_timer_get_time() + 150, NULL));
+    }
+    s_stop_notifying = true;
+    vTaskDelay(2);  // allow the notifying task to exit and idle to clean up
+    TEST_ESP_OK(esp_timer_waiter_delete(waiter));
+}
+
+TEST_CASE("esp_timer waiter wakeup latency compared to vTaskDelay", "[esp_timer]")
+{
+    esp_timer_waiter_handle_t waiter;
+    TEST_ESP_OK(esp_timer_waiter_create(NULL, &waiter));
+    esp_timer_waiter_stats_t stats;
+
+    // 2.5 ms requested, vTaskDelay can only wait for whole ticks, at least as long as requested
+    const int delay_us = 2500;
+    const TickType_t delay_ticks = (delay_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000);
+    int64_t total_tick_error = 0;
+    for (int i = 0; i < 50; i++) {
+        int64_t start = esp_timer_get_time();
+        vTaskDelay(delay_ticks);
+        total_tick_error += llabs(esp_timer_get_time() - start - delay_us);
+    }
+    for (int i = 0; i < 50; i++) {
+        TEST_ESP_OK(esp_timer_waiter_sleep(waiter, delay_us));
+    }
+    TEST_ESP_OK(esp_timer_waiter_get_stats(waiter, &stats, true));
+    print_latency_histogram("2.5 ms sleep", &stats);
+    printf("2.5 ms vTaskDelay(%u): average error %" PRId64 " us\n", (unsigned) delay_ticks, total_tick_error / 50);
+    TEST_ASSERT_LESS_THAN(total_tick_error / 50, stats.total_latency_us / stats.wakeups);
+    TEST_ESP_OK(esp_timer_waiter_delete(waiter));
+}
@@ -625,6 +625,167 @@ size_t xStreamBufferReceiveFromISR( StreamBufferHandle_t xStreamBuffer,
                                     size_t xBufferLengthBytes,
                                     BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
 
+/**
+ * @cond !DOC_EXCLUDE_HEADER_SECTION
+ * stream_buffer.h
+ *
+ * @code{c}
+ * size_t xStreamBufferReceiveAcquire( StreamBufferHandle_t xStreamBuffer,
+ *                                     uint8_t ** ppucData1,
+ *                                     size_t * pxLength1,
+ *                                     uint8_t ** ppucData2,
+ *                                     size_t * pxLength2,
+ *                                     size_t xMinimumBytes,
+ *                                     TickType_t xTicksToWait );
+ * @endcode
+ * @endcond
+ *
+ * Gets a view of the bytes available in a stream buffer without copying them
+ * out.  The bytes are stored in a circular buffer, so they are returned as at
+ * most two contiguous segments: the first one from the oldest byte up to the
+ * end of the storage area, the second one from the start of the storage area.
+ * The bytes stay in the stream buffer until vStreamBufferReceiveCommit() is
+ * called, which lets a reader parse a header before deciding how many bytes to
+ * consume, or hand a payload to a consumer in place.  A reader that has parsed
+ * a header can call it again with xMinimumBytes set to the length of the whole
+ * frame to block until the rest of the frame has arrived.
+ *
+ * Only the reader of the stream buffer may call this function, and the writer
+ * can keep sending while the view is held: it never overwrites bytes that have
+ * not been committed.  Must not be used on message buffers.
+ *
+ * @param xStreamBuffer The handle of the stream buffer being read.
+ *
+ * @param ppucData1 Used to return a pointer to the first segment.
+ *
+ * @param pxLength1 Used to return the length of the first segment.
+ *
+ * @param ppucData2 Used to return a pointer to the second segment, or NULL if
+ * the available bytes do not wrap around.
+ *
+ * @param pxLength2 Used to return the length of the second segment, or 0.
+ *
+ * @param xMinimumBytes The number of bytes to wait for, 0 is the same as 1.
+ * Must be less than the size of the stream buffer.  The writer only unblocks
+ * the reader once the trigger level is reached, so with a trigger level above
+ * xMinimumBytes the task waits for the trigger level.
+ *
+ * @param xTicksToWait The maximum amount of time the task should remain in the
+ * Blocked state to wait for xMinimumBytes bytes to be available.
+ *
+ * @return The total number of bytes in the view, *pxLength1 + *pxLength2.  Can
+ * be less than xMinimumBytes if xTicksToWait expired first.
+ *
+ * @cond !DOC_SINGLE_GROUP
+ * \defgroup xStreamBufferReceiveAcquire xStreamBufferReceiveAcquire
+ * @endcond
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReceiveAcquire( StreamBufferHandle_t xStreamBuffer,
+                                    uint8_t ** ppucData1,
+                                    size_t * pxLength1,
+                                    uint8_t ** ppucData2,
+                                    size_t * pxLength2,
+                                    size_t xMinimumBytes,
+                                    TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * @cond !DOC_EXCLUDE_HEADER_SECTION
+ * stream_buffer.h
+ *
+ * @code{c}
+ * void vStreamBufferReceiveCommit( StreamBufferHandle_t xStreamBuffer,
+ *                                  size_t xBytesConsumed );
+ * @endcode
+ * @endcond
+ *
+ * Removes bytes returned by xStreamBufferReceiveAcquire() from a stream
+ * buffer, and unblocks a task waiting to send if it is now able to.  Pointers
+ * returned by xStreamBufferReceiveAcquire() must not be used to access the
+ * committed bytes afterwards.
+ *
+ * @param xStreamBuffer The handle of the stream buffer being read.
+ *
+ * @param xBytesConsumed The number of bytes to remove, at most the total
+ * returned by the last call to xStreamBufferReceiveAcquire().  Can be less, in
+ * which case the remaining bytes are returned first by the next receive.
+ *
+ * @cond !DOC_SINGLE_GROUP
+ * \defgroup vStreamBufferReceiveCommit vStreamBufferReceiveCommit
+ * @endcond
+ * \ingroup StreamBufferManagement
+ */
+void vStreamBufferReceiveCommit( StreamBufferHandle_t xStreamBuffer,
+                                 size_t xBytesConsumed ) PRIVILEGED_FUNCTION;
+
+/**
+ * @cond !DOC_EXCLUDE_HEADER_SECTION
+ * stream_buffer.h
+ *
+ * @code{c}
+ * size_t xStreamBufferSendAcquire( StreamBufferHandle_t xStreamBuffer,
+ *                                  uint8_t ** ppucData,
+ *                                  TickType_t xTicksToWait );
+ * @endcode
+ * @endcond
+ *
+ * Gets the contiguous free space at the write position of a stream buffer, so
+ * that the writer can produce bytes directly into the stream buffer (for
+ * example by passing the pointer to recv()) instead of copying them in with
+ * xStreamBufferSend().  The bytes are made available to the reader by
+ * vStreamBufferSendCommit().
+ *
+ * Only the writer of the stream buffer may call this function.  The returned
+ * space ends at the end of the storage area even if more space is free at its
+ * start: once the first span is committed, the next call returns the space at
+ * the start.  Must not be used on message buffers.
+ *
+ * @param xStreamBuffer The handle of the stream buffer being written.
+ *
+ * @param ppucData Used to return a pointer to the free space.
+ *
+ * @param xTicksToWait The maximum amount of time the task should remain in the
+ * Blocked state to wait for free space if the stream buffer is full.
+ *
+ * @return The number of bytes that can be written at *ppucData, 0 if the stream
+ * buffer stayed full.
+ *
+ * @cond !DOC_SINGLE_GROUP
+ * \defgroup xStreamBufferSendAcquire xStreamBufferSendAcquire
+ * @endcond
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferSendAcquire( StreamBufferHandle_t xStreamBuffer,
+                                 uint8_t ** ppucData,
+                                 TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * @cond !DOC_EXCLUDE_HEADER_SECTION
+ * stream_buffer.h
+ *
+ * @code{c}
+ * void vStreamBufferSendCommit( StreamBufferHandle_t xStreamBuffer,
+ *                               size_t xBytesWritten );
+ * @endcode
+ * @endcond
+ *
+ * Makes bytes written to the space returned by xStreamBufferSendAcquire()
+ * available to the reader, and unblocks the reader if the stream buffer now
+ * contains at least as many bytes as its trigger level.
+ *
+ * @param xStreamBuffer The handle of the stream buffer being written.
+ *
+ * @param xBytesWritten The number of bytes written, at most the length
+ * returned by the last call to xStreamBufferSendAcquire().
+ *
+ * @cond !DOC_SINGLE_GROUP
+ * \defgroup vStreamBufferSendCommit vStreamBufferSendCommit
+ * @endcond
+ * \ingroup StreamBufferManagement
+ */
+void vStreamBufferSendCommit( StreamBufferHandle_t xStreamBuffer,
+                              size_t xBytesWritten ) PRIVILEGED_FUNCTION;
+
 /**
  * @cond !DOC_EXCLUDE_HEADER_SECTION
  * stream_buffer.h
@@ -1006,6 +1006,270 @@ size_t xStreamBufferReceiveFromISR( StreamBufferHandle_t xStreamBuffer,
 }
 /*-----------------------------------------------------------*/
 
+size_t xStreamBufferReceiveAcquire( StreamBufferHandle_t xStreamBuffer,
+                                    uint8_t ** ppucData1,
+                                    size_t * pxLength1,
+                                    uint8_t ** ppucData2,
+                                    size_t * pxLength2,
+                                    size_t xMinimumBytes,
+                                    TickType_t xTicksToWait )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+    size_t xBytesAvailable = 0, xTail, xFirstLength;
+    TimeOut_t xTimeOut;
+
+    configASSERT( pxStreamBuffer );
+    configASSERT( ppucData1 && pxLength1 && ppucData2 && pxLength2 );
+
+    /* A view of a message buffer would expose the message lengths. */
+    configASSERT( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) == ( uint8_t ) 0 );
+
+    /* At most xLength - 1 bytes fit in the buffer. */
+    configASSERT( xMinimumBytes < pxStreamBuffer->xLength );
+
+    if( xMinimumBytes == ( size_t ) 0 )
+    {
+        xMinimumBytes = ( size_t ) 1;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    if( xTicksToWait != ( TickType_t ) 0 )
+    {
+        vTaskSetTimeOutState( &xTimeOut );
+
+        do
+        {
+            /* Checking if there is enough data and clearing the notification
+             * state must be performed atomically. */
+            taskENTER_CRITICAL( &( pxStreamBuffer->xStreamBufferLock ) );
+            {
+                xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+
+                if( xBytesAvailable < xMinimumBytes )
+                {
+                    /* Clear notification state as going to wait for data. */
+                    ( void ) xTaskNotifyStateClear( NULL );
+
+                    /* Should only be one reader. */
+                    configASSERT( pxStreamBuffer->xTaskWaitingToReceive == NULL );
+                    pxStreamBuffer->xTaskWaitingToReceive = xTaskGetCurrentTaskHandle();
+                }
+                else
+                {
+                    taskEXIT_CRITICAL( &( pxStreamBuffer->xStreamBufferLock ) );
+                    break;
+                }
+            }
+            taskEXIT_CRITICAL( &( pxStreamBuffer->xStreamBufferLock ) );
+
+            /* The writer notifies on every send that reaches the trigger level,
+             * wait again until xMinimumBytes have arrived. */
+            traceBLOCKING_ON_STREAM_BUFFER_RECEIVE( xStreamBuffer );
+            ( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+            pxStreamBuffer->xTaskWaitingToReceive = NULL;
+        } while( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    /* Return whatever is there, also when the wait timed out with fewer than
+     * xMinimumBytes. */
+    xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+
+    /* The writer only moves xHead forward, so the bytes counted above stay in
+     * place until the reader moves xTail in vStreamBufferReceiveCommit(). */
+    xTail = pxStreamBuffer->xTail;
+    xFirstLength = configMIN( pxStreamBuffer->xLength - xTail, xBytesAvailable );
+    *ppucData1 = &( pxStreamBuffer->pucBuffer[ xTail ] );
+    *pxLength1 = xFirstLength;
+
+    if( xBytesAvailable > xFirstLength )
+    {
+        /* The bytes wrap around to the start of the buffer. */
+        *ppucData2 = pxStreamBuffer->pucBuffer;
+        *pxLength2 = xBytesAvailable - xFirstLength;
+    }
+    else
+    {
+        *ppucData2 = NULL;
+        *pxLength2 = 0;
+    }
+
+    if( xBytesAvailable == ( size_t ) 0 )
+    {
+        traceSTREAM_BUFFER_RECEIVE_FAILED( xStreamBuffer );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return xBytesAvailable;
+}
+/*-----------------------------------------------------------*/
+
+void vStreamBufferReceiveCommit( StreamBufferHandle_t xStreamBuffer,
+                                 size_t xBytesConsumed )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+    size_t xNextTail;
+
+    configASSERT( pxStreamBuffer );
+    configASSERT( xBytesConsumed <= prvBytesInBuffer( pxStreamBuffer ) );
+
+    if( xBytesConsumed > ( size_t ) 0 )
+    {
+        xNextTail = pxStreamBuffer->xTail + xBytesConsumed;
+
+        if( xNextTail >= pxStreamBuffer->xLength )
+        {
+            xNextTail -= pxStreamBuffer->xLength;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        pxStreamBuffer->xTail = xNextTail;
+
+        traceSTREAM_BUFFER_RECEIVE( xStreamBuffer, xBytesConsumed );
+
+        /* Was a task waiting for space in the buffer? */
+        sbRECEIVE_COMPLETED( pxStreamBuffer );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferSendAcquire( StreamBufferHandle_t xStreamBuffer,
+                                 uint8_t ** ppucData,
+                                 TickType_t xTicksToWait )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+    size_t xSpace = 0, xHead;
+    TimeOut_t xTimeOut;
+
+    configASSERT( pxStreamBuffer );
+    configASSERT( ppucData );
+    configASSERT( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) == ( uint8_t ) 0 );
+
+    if( xTicksToWait != ( TickType_t ) 0 )
+    {
+        vTaskSetTimeOutState( &xTimeOut );
+
+        do
+        {
+            /* Wait until at least one byte is free in the stream buffer. */
+            taskENTER_CRITICAL( &( pxStreamBuffer->xStreamBufferLock ) );
+            {
+                xSpace = xStreamBufferSpacesAvailable( pxStreamBuffer );
+
+                if( xSpace == ( size_t ) 0 )
+                {
+                    /* Clear notification state as going to wait for space. */
+                    ( void ) xTaskNotifyStateClear( NULL );
+
+                    /* Should only be one writer. */
+                    configASSERT( pxStreamBuffer->xTaskWaitingToSend == NULL );
+                    pxStreamBuffer->xTaskWaitingToSend = xTaskGetCurrentTaskHandle();
+                }
+                else
+                {
+                    taskEXIT_CRITICAL( &( pxStreamBuffer->xStreamBufferLock ) );
+                    break;
+                }
+            }
+            taskEXIT_CRITICAL( &( pxStreamBuffer->xStreamBufferLock ) );
+
+            traceBLOCKING_ON_STREAM_BUFFER_SEND( xStreamBuffer );
+            ( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+            pxStreamBuffer->xTaskWaitingToSend = NULL;
+        } while( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    if( xSpace == ( size_t ) 0 )
+    {
+        xSpace = xStreamBufferSpacesAvailable( pxStreamBuffer );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    /* Only the space up to the end of the buffer is contiguous.  xSpace already
+     * excludes the byte that must stay free in front of xTail. */
+    xHead = pxStreamBuffer->xHead;
+    *ppucData = &( pxStreamBuffer->pucBuffer[ xHead ] );
+
+    if( xSpace == ( size_t ) 0 )
+    {
+        traceSTREAM_BUFFER_SEND_FAILED( xStreamBuffer );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return configMIN( xSpace, pxStreamBuffer->xLength - xHead );
+}
+/*-----------------------------------------------------------*/
+
+void vStreamBufferSendCommit( StreamBufferHandle_t xStreamBuffer,
+                              size_t xBytesWritten )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+    size_t xNextHead;
+
+    configASSERT( pxStreamBuffer );
+    configASSERT( xBytesWritten <= xStreamBufferSpacesAvailable( pxStreamBuffer ) );
+    configASSERT( ( pxStreamBuffer->xHead + xBytesWritten ) <= pxStreamBuffer->xLength );
+
+    if( xBytesWritten > ( size_t ) 0 )
+    {
+        xNextHead = pxStreamBuffer->xHead + xBytesWritten;
+
+        if( xNextHead >= pxStreamBuffer->xLength )
+        {
+            xNextHead -= pxStreamBuffer->xLength;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        pxStreamBuffer->xHead = xNextHead;
+
+        traceSTREAM_BUFFER_SEND( xStreamBuffer, xBytesWritten );
+
+        /* Was a task waiting for the data? */
+        if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
+        {
+            sbSEND_COMPLETED( pxStreamBuffer );
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+/*-----------------------------------------------------------*/
+
 static size_t prvReadMessageFromBuffer( StreamBuffer_t * pxStreamBuffer,
                                         void * pvRxData,
                                         size_t xBufferLengthBytes,
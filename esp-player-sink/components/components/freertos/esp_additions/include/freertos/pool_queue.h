@@ -0,0 +1,214 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h" must appear in source files before "include pool_queue.h"
+#endif
+
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Type by which pool queues are referenced. For example, a call to xPoolQueueCreate()
+ * returns a PoolQueueHandle_t variable that can then be used as a parameter to
+ * xPoolQueueAcquire(), xPoolQueuePost(), etc.
+ *
+ * A pool queue passes fixed-size blocks from producers to a consumer without
+ * copying them. The blocks come from a pool that is allocated once when the
+ * pool queue is created. A producer acquires a free block, fills it and posts
+ * it along with the number of valid bytes. The consumer receives the block,
+ * processes it in place and releases it back to the pool. Posted blocks are
+ * received in FIFO order.
+ */
+typedef void * PoolQueueHandle_t;
+
+/**
+ * @brief Statistics of a pool queue
+ *
+ * @note An overflow is counted every time xPoolQueueAcquire() fails because all the blocks
+ *       of the pool are in use, i.e. the producer outran the consumer for longer than it
+ *       was willing to wait.
+ */
+typedef struct {
+    UBaseType_t uxBlockCount;       /**< Number of blocks in the pool */
+    UBaseType_t uxBlocksInUse;      /**< Number of blocks currently acquired or posted */
+    UBaseType_t uxMaxBlocksInUse;   /**< Largest number of blocks in use since creation or the last reset */
+    uint32_t ulAcquired;            /**< Number of blocks acquired since creation or the last reset */
+    uint32_t ulOverflows;           /**< Number of failed acquisitions since creation or the last reset */
+} PoolQueueStats_t;
+
+/**
+ * @brief Struct that is equivalent in size to the pool queue's data structure
+ *
+ * The contents of this struct are not meant to be used directly. This
+ * structure is meant to be used when creating a statically allocated pool
+ * queue where this struct is of the exact size required to store a pool
+ * queue's control data structure.
+ */
+#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+typedef struct xSTATIC_POOL_QUEUE {
+    //This must match the layout of PoolQueue_t
+    StaticQueue_t xDummy1[2];
+    uint8_t *pucDummy2[2];
+    size_t xDummy3;
+    PoolQueueStats_t xDummy4;
+    UBaseType_t uxDummy5;
+    BaseType_t xDummy6;
+    portMUX_TYPE muxDummy;
+    BaseType_t xDummy7;
+} StaticPoolQueue_t;
+#endif
+
+/**
+ * @brief   Size of a block as laid out in the pool
+ *
+ * @param[in]   xBlockSize  Requested block size
+ */
+#define poolqueueALIGNED_BLOCK_SIZE( xBlockSize )    ( ( ( xBlockSize ) + portBYTE_ALIGNMENT - 1 ) & ~( ( size_t ) portBYTE_ALIGNMENT - 1 ) )
+
+/**
+ * @brief   Size of the storage area required by xPoolQueueCreateStatic()
+ *
+ * The storage area holds the blocks followed by the storage of the queue that
+ * carries pointers to the posted blocks.
+ *
+ * @param[in]   uxBlockCount    Number of blocks in the pool
+ * @param[in]   xBlockSize      Size of each block in bytes
+ */
+#define poolqueueSTORAGE_SIZE( uxBlockCount, xBlockSize )    ( ( uxBlockCount ) * ( poolqueueALIGNED_BLOCK_SIZE( xBlockSize ) + sizeof( void * ) + sizeof( size_t ) ) )
+
+/**
+ * @brief       Create a pool queue
+ *
+ * @param[in]   uxBlockCount    Number of blocks in the pool
+ * @param[in]   xBlockSize      Size of each block in bytes. The size will be rounded up to portBYTE_ALIGNMENT.
+ *
+ * @note    The blocks and the control structure are allocated in a single heap allocation.
+ *
+ * @return  A handle to the created pool queue, or NULL in case of error.
+ */
+PoolQueueHandle_t xPoolQueueCreate(UBaseType_t uxBlockCount, size_t xBlockSize);
+
+#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+/**
+ * @brief       Create a pool queue using statically allocated memory
+ *
+ * @param[in]   uxBlockCount        Number of blocks in the pool
+ * @param[in]   xBlockSize          Size of each block in bytes. The size will be rounded up to portBYTE_ALIGNMENT.
+ * @param[in]   pucPoolStorage      Pointer to a storage area of at least poolqueueSTORAGE_SIZE(uxBlockCount, xBlockSize)
+ *                                  bytes, aligned to portBYTE_ALIGNMENT
+ * @param[in]   pxStaticPoolQueue   Pointed to a struct of type StaticPoolQueue_t which will be used to hold the pool
+ *                                  queue's data structure
+ *
+ * @return  A handle to the created pool queue
+ */
+PoolQueueHandle_t xPoolQueueCreateStatic(UBaseType_t uxBlockCount,
+                                         size_t xBlockSize,
+                                         uint8_t *pucPoolStorage,
+                                         StaticPoolQueue_t *pxStaticPoolQueue);
+#endif
+
+/**
+ * @brief   Acquire a free block from the pool
+ *
+ * @param[in]   xPoolQueue      Pool queue to acquire the block from
+ * @param[out]  ppvBlock        Pointer to the acquired block. The block must either be posted with
+ *                              xPoolQueuePost() or given back with xPoolQueueRelease().
+ * @param[in]   xTicksToWait    Ticks to wait for a block to become free
+ *
+ * @note    A failed acquisition is counted as an overflow in the statistics of the pool queue.
+ *
+ * @return
+ *      - pdTRUE if a block was acquired
+ *      - pdFALSE if all blocks remained in use until the timeout
+ */
+BaseType_t xPoolQueueAcquire(PoolQueueHandle_t xPoolQueue, void **ppvBlock, TickType_t xTicksToWait);
+
+/**
+ * @brief   Post an acquired block to the consumer
+ *
+ * Only the pointer to the block and its length are queued, the contents of the
+ * block are not copied. This function never blocks as there is room in the queue
+ * for every block of the pool.
+ *
+ * @param[in]   xPoolQueue  Pool queue the block was acquired from
+ * @param[in]   pvBlock     Block returned by xPoolQueueAcquire()
+ * @param[in]   xLength     Number of valid bytes in the block
+ *
+ * @return  pdTRUE
+ */
+BaseType_t xPoolQueuePost(PoolQueueHandle_t xPoolQueue, void *pvBlock, size_t xLength);
+
+/**
+ * @brief   Receive a posted block
+ *
+ * @param[in]   xPoolQueue      Pool queue to receive the block from
+ * @param[out]  pxLength        Pointer to a variable to which the number of valid bytes in the block will be written
+ * @param[in]   xTicksToWait    Ticks to wait for a block to be posted
+ *
+ * @return
+ *      - Pointer to the received block. The block must be released with xPoolQueueRelease() once processed.
+ *      - NULL on timeout
+ */
+void *pvPoolQueueReceive(PoolQueueHandle_t xPoolQueue, size_t *pxLength, TickType_t xTicksToWait);
+
+/**
+ * @brief   Release a block back to the pool
+ *
+ * @param[in]   xPoolQueue  Pool queue the block belongs to
+ * @param[in]   pvBlock     Block returned by pvPoolQueueReceive() or xPoolQueueAcquire()
+ *
+ * @return  pdTRUE
+ */
+BaseType_t xPoolQueueRelease(PoolQueueHandle_t xPoolQueue, void *pvBlock);
+
+/**
+ * @brief   Get the number of posted blocks that have not been received yet
+ *
+ * @param[in]   xPoolQueue  Pool queue to check
+ *
+ * @return  Number of posted blocks waiting to be received
+ */
+UBaseType_t uxPoolQueueMessagesWaiting(PoolQueueHandle_t xPoolQueue);
+
+/**
+ * @brief   Get the size of the blocks of a pool queue
+ *
+ * @param[in]   xPoolQueue  Pool queue to check
+ *
+ * @return  Size of each block in bytes, after rounding
+ */
+size_t xPoolQueueGetBlockSize(PoolQueueHandle_t xPoolQueue);
+
+/**
+ * @brief   Get the statistics of a pool queue
+ *
+ * @param[in]   xPoolQueue  Pool queue to check
+ * @param[out]  pxStats     Pointer to a structure to which the statistics will be written
+ * @param[in]   xReset      If pdTRUE, the maximum number of blocks in use, the acquisition count and the
+ *                          overflow count are reset after being read
+ */
+void vPoolQueueGetStats(PoolQueueHandle_t xPoolQueue, PoolQueueStats_t *pxStats, BaseType_t xReset);
+
+/**
+ * @brief   Delete a pool queue
+ *
+ * @param[in]   xPoolQueue  Pool queue to delete
+ *
+ * @note    This function will not deallocate any memory if the pool queue was created using
+ *          xPoolQueueCreateStatic(). Deallocation must be done manually be the user.
+ * @note    All blocks must have been released before the pool queue is deleted.
+ */
+void vPoolQueueDelete(PoolQueueHandle_t xPoolQueue);
+
+#ifdef __cplusplus
+}
+#endif
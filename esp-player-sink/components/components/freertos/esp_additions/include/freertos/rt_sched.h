@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h" must appear in source files before "include rt_sched.h"
+#endif
+
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Periodic real-time jobs on top of the fixed-priority FreeRTOS scheduler
+ *
+ * A job is a task that calls a job function once per period. Each call (a release)
+ * must complete within the relative deadline of the job. The jobs are given
+ * priorities from a band of FreeRTOS priorities reserved for them, so that the
+ * FreeRTOS scheduler runs the job the policy considers most urgent:
+ *
+ * - Rate monotonic: the priorities are static, jobs with shorter periods get higher priorities.
+ * - Earliest deadline first: the priorities are recomputed with vTaskPrioritySet() every time a
+ *   job is released or completes, the released job with the earliest absolute deadline gets the
+ *   highest priority.
+ *
+ * Tasks that are not jobs keep competing with the jobs through their own priority,
+ * e.g. placing the band above the priority of the lwIP task keeps network bursts from
+ * delaying the jobs. Time is counted in ticks.
+ *
+ * The priorities are updated with the scheduler of the calling core suspended, so
+ * jobs on that core never see a partial update. On a dual core target, jobs on the
+ * other core can run against a partial update for the duration of the update. Pin
+ * all jobs to the same core to get strict policy ordering between them.
+ */
+
+/**
+ * @brief Scheduling policy of the real-time jobs
+ */
+typedef enum {
+    eRtRateMonotonic = 0,       /**< Static priorities, shorter period first */
+    eRtEarliestDeadlineFirst,   /**< Dynamic priorities, earliest absolute deadline first */
+} eRtPolicy;
+
+/**
+ * Type by which real-time jobs are referenced
+ */
+typedef void * RtJobHandle_t;
+
+/**
+ * @brief Function called once per period by a real-time job
+ */
+typedef void (*RtJobFunction_t)(void *pvParameters);
+
+/**
+ * @brief Statistics of a real-time job
+ */
+typedef struct {
+    uint32_t ulReleases;            /**< Number of times the job function was called */
+    uint32_t ulDeadlineMisses;      /**< Number of releases that completed after their deadline */
+    uint32_t ulOverruns;            /**< Number of releases that started late because the previous one completed after their release time */
+    TickType_t xWorstResponse;      /**< Longest time between a release and its completion */
+} RtJobStats_t;
+
+/**
+ * @brief   Set the scheduling policy and the band of priorities used by the real-time jobs
+ *
+ * Must be called before the first job is created.
+ *
+ * @param[in]   ePolicy         Scheduling policy
+ * @param[in]   uxPriorityLow   Lowest priority given to a job
+ * @param[in]   uxPriorityHigh  Highest priority given to a job, must be less than configMAX_PRIORITIES
+ *
+ * @note    With N jobs, a band of at least N priorities lets every job get a distinct priority.
+ *          Jobs that do not fit share the lowest priority of the band.
+ *
+ * @return
+ *      - pdTRUE on success
+ *      - pdFALSE if the priorities are invalid or jobs already exist
+ */
+BaseType_t xRtSchedInit(eRtPolicy ePolicy, UBaseType_t uxPriorityLow, UBaseType_t uxPriorityHigh);
+
+/**
+ * @brief   Create a periodic real-time job
+ *
+ * @param[in]   pxJobFunction   Function called once per period
+ * @param[in]   pcName          Name of the task running the job
+ * @param[in]   ulStackDepth    Stack size of the task running the job
+ * @param[in]   pvParameters    Parameter passed to the job function
+ * @param[in]   xPeriod         Period of the job in ticks
+ * @param[in]   xDeadline       Deadline of each release relative to the release, in ticks. Must not exceed the period.
+ * @param[in]   xCoreID         Core the job is pinned to, or tskNO_AFFINITY
+ * @param[out]  pxJob           Handle of the created job
+ *
+ * @note    The first release happens as soon as the task runs.
+ *
+ * @return
+ *      - pdPASS if the job was created
+ *      - errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY otherwise
+ */
+BaseType_t xRtJobCreate(RtJobFunction_t pxJobFunction,
+                        const char *pcName,
+                        uint32_t ulStackDepth,
+                        void *pvParameters,
+                        TickType_t xPeriod,
+                        TickType_t xDeadline,
+                        BaseType_t xCoreID,
+                        RtJobHandle_t *pxJob);
+
+/**
+ * @brief   Delete a real-time job
+ *
+ * The job stops before its next release, and its task then deletes itself.
+ *
+ * @param[in]   xJob    Job to delete. The handle must not be used after this call.
+ */
+void vRtJobDelete(RtJobHandle_t xJob);
+
+/**
+ * @brief   Get the statistics of a real-time job
+ *
+ * @param[in]   xJob    Job to check
+ * @param[out]  pxStats Pointer to a structure to which the statistics will be written
+ * @param[in]   xReset  If pdTRUE, the statistics are reset after being read
+ */
+void vRtJobGetStats(RtJobHandle_t xJob, RtJobStats_t *pxStats, BaseType_t xReset);
+
+/**
+ * @brief   Get the handle of the task running a real-time job
+ *
+ * @param[in]   xJob    Job to check
+ *
+ * @return  Task handle
+ */
+TaskHandle_t xRtJobGetTaskHandle(RtJobHandle_t xJob);
+
+#ifdef __cplusplus
+}
+#endif
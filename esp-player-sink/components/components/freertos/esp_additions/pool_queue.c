@@ -0,0 +1,296 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/pool_queue.h"
+
+/*
+ * The free blocks of a pool queue are kept in a singly linked list, the link being
+ * stored in the first word of each free block. Acquiring and releasing a block is
+ * then a single critical section. The posted blocks are carried to the consumer by a
+ * FreeRTOS queue of pointers that has room for every block of the pool, so posting
+ * never blocks.
+ *
+ * A producer that finds the free list empty blocks on a binary semaphore that is only
+ * given when a block is released while producers are waiting, and only once until a
+ * waiter wakes up. As several releases then give the semaphore only once, a producer
+ * that wakes up and still sees free blocks and other waiting producers gives the
+ * semaphore again.
+ */
+
+typedef struct {
+    void *pvBlock;
+    size_t xLength;
+} PoolQueueItem_t;
+
+typedef struct PoolQueueDefinition {
+    StaticQueue_t xQueueBuffers[2];     //Control structures of the posted queue and of the free semaphore
+    uint8_t *pucPool;                   //Start of the first block
+    void *pvFreeList;                   //First free block, NULL if all blocks are in use
+    size_t xBlockSize;                  //Size of each block after alignment
+    PoolQueueStats_t xStats;
+    UBaseType_t uxWaiters;              //Number of producers waiting for a free block
+    BaseType_t xWakePending;            //The free semaphore was given and no waiter has woken up since
+    portMUX_TYPE mux;                   //Spinlock required for SMP
+    BaseType_t xStaticallyAllocated;
+} PoolQueue_t;
+
+#define pqPOSTED_QUEUE(pxPoolQueue)     ((QueueHandle_t)&(pxPoolQueue)->xQueueBuffers[0])
+#define pqFREE_SEM(pxPoolQueue)         ((SemaphoreHandle_t)&(pxPoolQueue)->xQueueBuffers[1])
+
+#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+_Static_assert(sizeof(StaticPoolQueue_t) == sizeof(PoolQueue_t), "StaticPoolQueue_t != PoolQueue_t");
+#endif
+
+// ------------------------------------------------ Static Declarations ------------------------------------------------
+
+static void prvInitializeNewPoolQueue(PoolQueue_t *pxPoolQueue,
+                                      UBaseType_t uxBlockCount,
+                                      size_t xBlockSize,
+                                      uint8_t *pucPoolStorage);
+
+static inline BaseType_t prvIsPoolBlock(PoolQueue_t *pxPoolQueue, void *pvBlock);
+
+static inline void *prvPopFreeBlock(PoolQueue_t *pxPoolQueue);
+
+// ------------------------------------------------ Static Definitions -------------------------------------------------
+
+static void prvInitializeNewPoolQueue(PoolQueue_t *pxPoolQueue,
+                                      UBaseType_t uxBlockCount,
+                                      size_t xBlockSize,
+                                      uint8_t *pucPoolStorage)
+{
+    //The posted queue storage comes after the last block
+    uint8_t *pucPostedStorage = pucPoolStorage + uxBlockCount * xBlockSize;
+
+    pxPoolQueue->pucPool = pucPoolStorage;
+    pxPoolQueue->xBlockSize = xBlockSize;
+    memset(&pxPoolQueue->xStats, 0, sizeof(pxPoolQueue->xStats));
+    pxPoolQueue->xStats.uxBlockCount = uxBlockCount;
+    pxPoolQueue->uxWaiters = 0;
+    pxPoolQueue->xWakePending = pdFALSE;
+    portMUX_INITIALIZE(&pxPoolQueue->mux);
+
+    QueueHandle_t xPosted = xQueueCreateStatic(uxBlockCount, sizeof(PoolQueueItem_t), pucPostedStorage, &pxPoolQueue->xQueueBuffers[0]);
+    SemaphoreHandle_t xFree = xSemaphoreCreateBinaryStatic(&pxPoolQueue->xQueueBuffers[1]);
+    configASSERT(xPosted == pqPOSTED_QUEUE(pxPoolQueue) && xFree == pqFREE_SEM(pxPoolQueue));
+    (void)xPosted;
+    (void)xFree;
+
+    //Every block starts out free, chain them in address order
+    pxPoolQueue->pvFreeList = NULL;
+    for (UBaseType_t i = uxBlockCount; i > 0; i--) {
+        void **ppvBlock = (void **)(pucPoolStorage + (i - 1) * xBlockSize);
+        *ppvBlock = pxPoolQueue->pvFreeList;
+        pxPoolQueue->pvFreeList = ppvBlock;
+    }
+}
+
+static inline BaseType_t prvIsPoolBlock(PoolQueue_t *pxPoolQueue, void *pvBlock)
+{
+    size_t xOffset = (uint8_t *)pvBlock - pxPoolQueue->pucPool;
+    return ((uint8_t *)pvBlock >= pxPoolQueue->pucPool &&
+            xOffset < pxPoolQueue->xStats.uxBlockCount * pxPoolQueue->xBlockSize &&
+            xOffset % pxPoolQueue->xBlockSize == 0) ? pdTRUE : pdFALSE;
+}
+
+static inline void *prvPopFreeBlock(PoolQueue_t *pxPoolQueue)
+{
+    //Must be called from a critical section
+    void **ppvBlock = (void **)pxPoolQueue->pvFreeList;
+    if (ppvBlock != NULL) {
+        pxPoolQueue->pvFreeList = *ppvBlock;
+        pxPoolQueue->xStats.uxBlocksInUse++;
+        pxPoolQueue->xStats.ulAcquired++;
+        if (pxPoolQueue->xStats.uxBlocksInUse > pxPoolQueue->xStats.uxMaxBlocksInUse) {
+            pxPoolQueue->xStats.uxMaxBlocksInUse = pxPoolQueue->xStats.uxBlocksInUse;
+        }
+    }
+    return ppvBlock;
+}
+
+// ------------------------------------------------ Public Functions ---------------------------------------------------
+
+PoolQueueHandle_t xPoolQueueCreate(UBaseType_t uxBlockCount, size_t xBlockSize)
+{
+    configASSERT(uxBlockCount > 0 && xBlockSize > 0);
+    xBlockSize = poolqueueALIGNED_BLOCK_SIZE(xBlockSize);
+
+    //Allocate the control structure and the storage area in one go, the storage area must stay aligned for the blocks
+    size_t xHeaderSize = poolqueueALIGNED_BLOCK_SIZE(sizeof(PoolQueue_t));
+    uint8_t *pucAlloc = malloc(xHeaderSize + poolqueueSTORAGE_SIZE(uxBlockCount, xBlockSize));
+    if (pucAlloc == NULL) {
+        return NULL;
+    }
+
+    PoolQueue_t *pxNewPoolQueue = (PoolQueue_t *)pucAlloc;
+    prvInitializeNewPoolQueue(pxNewPoolQueue, uxBlockCount, xBlockSize, pucAlloc + xHeaderSize);
+    pxNewPoolQueue->xStaticallyAllocated = pdFALSE;
+    return (PoolQueueHandle_t)pxNewPoolQueue;
+}
+
+#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+PoolQueueHandle_t xPoolQueueCreateStatic(UBaseType_t uxBlockCount,
+                                         size_t xBlockSize,
+                                         uint8_t *pucPoolStorage,
+                                         StaticPoolQueue_t *pxStaticPoolQueue)
+{
+    configASSERT(uxBlockCount > 0 && xBlockSize > 0);
+    configASSERT(pucPoolStorage != NULL && ((uintptr_t)pucPoolStorage & (portBYTE_ALIGNMENT - 1)) == 0);
+    configASSERT(pxStaticPoolQueue != NULL);
+
+    PoolQueue_t *pxNewPoolQueue = (PoolQueue_t *)pxStaticPoolQueue;
+    prvInitializeNewPoolQueue(pxNewPoolQueue, uxBlockCount, poolqueueALIGNED_BLOCK_SIZE(xBlockSize), pucPoolStorage);
+    pxNewPoolQueue->xStaticallyAllocated = pdTRUE;
+    return (PoolQueueHandle_t)pxNewPoolQueue;
+}
+#endif
+
+BaseType_t xPoolQueueAcquire(PoolQueueHandle_t xPoolQueue, void **ppvBlock, TickType_t xTicksToWait)
+{
+    PoolQueue_t *pxPoolQueue = (PoolQueue_t *)xPoolQueue;
+    configASSERT(pxPoolQueue && ppvBlock);
+
+    void *pvBlock;
+    BaseType_t xWakeNext = pdFALSE;
+    BaseType_t xWaited = pdFALSE;
+    TickType_t xTicksEnd = 0;
+    TickType_t xTicksRemaining = xTicksToWait;
+    portENTER_CRITICAL(&pxPoolQueue->mux);
+    while ((pvBlock = prvPopFreeBlock(pxPoolQueue)) == NULL && xTicksRemaining > 0 && xTicksRemaining <= xTicksToWait) {
+        //All blocks are in use, wait for one to be released
+        pxPoolQueue->uxWaiters++;
+        portEXIT_CRITICAL(&pxPoolQueue->mux);
+        if (xWaited == pdFALSE) {
+            //The tick count is only needed once the pool turned out to be exhausted
+            xTicksEnd = xTaskGetTickCount() + xTicksToWait;
+            xWaited = pdTRUE;
+        }
+        xSemaphoreTake(pqFREE_SEM(pxPoolQueue), xTicksRemaining);
+        if (xTicksToWait != portMAX_DELAY) {
+            xTicksRemaining = xTicksEnd - xTaskGetTickCount();  //Underflows once xTaskGetTickCount() > xTicksEnd
+        }
+        portENTER_CRITICAL(&pxPoolQueue->mux);
+        pxPoolQueue->uxWaiters--;
+        pxPoolQueue->xWakePending = pdFALSE;
+    }
+    if (pvBlock == NULL) {
+        pxPoolQueue->xStats.ulOverflows++;
+    } else if (pxPoolQueue->pvFreeList != NULL && pxPoolQueue->uxWaiters > 0 && pxPoolQueue->xWakePending == pdFALSE) {
+        pxPoolQueue->xWakePending = pdTRUE;
+        xWakeNext = pdTRUE;
+    }
+    portEXIT_CRITICAL(&pxPoolQueue->mux);
+
+    if (xWakeNext == pdTRUE) {
+        xSemaphoreGive(pqFREE_SEM(pxPoolQueue));    //Give semaphore back so other producers can acquire
+    }
+    *ppvBlock = pvBlock;
+    return (pvBlock != NULL) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xPoolQueuePost(PoolQueueHandle_t xPoolQueue, void *pvBlock, size_t xLength)
+{
+    PoolQueue_t *pxPoolQueue = (PoolQueue_t *)xPoolQueue;
+    configASSERT(pxPoolQueue);
+    configASSERT(prvIsPoolBlock(pxPoolQueue, pvBlock) == pdTRUE);
+    configASSERT(xLength <= pxPoolQueue->xBlockSize);
+
+    PoolQueueItem_t xItem = {
+        .pvBlock = pvBlock,
+        .xLength = xLength,
+    };
+    BaseType_t xReturn = xQueueSend(pqPOSTED_QUEUE(pxPoolQueue), &xItem, 0);
+    configASSERT(xReturn == pdTRUE);    //There is room for every block of the pool
+    return xReturn;
+}
+
+void *pvPoolQueueReceive(PoolQueueHandle_t xPoolQueue, size_t *pxLength, TickType_t xTicksToWait)
+{
+    PoolQueue_t *pxPoolQueue = (PoolQueue_t *)xPoolQueue;
+    configASSERT(pxPoolQueue);
+
+    PoolQueueItem_t xItem;
+    if (xQueueReceive(pqPOSTED_QUEUE(pxPoolQueue), &xItem, xTicksToWait) != pdTRUE) {
+        return NULL;
+    }
+    if (pxLength != NULL) {
+        *pxLength = xItem.xLength;
+    }
+    return xItem.pvBlock;
+}
+
+BaseType_t xPoolQueueRelease(PoolQueueHandle_t xPoolQueue, void *pvBlock)
+{
+    PoolQueue_t *pxPoolQueue = (PoolQueue_t *)xPoolQueue;
+    configASSERT(pxPoolQueue);
+    configASSERT(prvIsPoolBlock(pxPoolQueue, pvBlock) == pdTRUE);
+
+    BaseType_t xWake;
+    portENTER_CRITICAL(&pxPoolQueue->mux);
+    configASSERT(pxPoolQueue->xStats.uxBlocksInUse > 0);
+    pxPoolQueue->xStats.uxBlocksInUse--;
+    *(void **)pvBlock = pxPoolQueue->pvFreeList;
+    pxPoolQueue->pvFreeList = pvBlock;
+    if (pxPoolQueue->uxWaiters > 0 && pxPoolQueue->xWakePending == pdFALSE) {
+        pxPoolQueue->xWakePending = pdTRUE;
+        xWake = pdTRUE;
+    } else {
+        xWake = pdFALSE;
+    }
+    portEXIT_CRITICAL(&pxPoolQueue->mux);
+
+    if (xWake == pdTRUE) {
+        xSemaphoreGive(pqFREE_SEM(pxPoolQueue));
+    }
+    return pdTRUE;
+}
+
+UBaseType_t uxPoolQueueMessagesWaiting(PoolQueueHandle_t xPoolQueue)
+{
+    PoolQueue_t *pxPoolQueue = (PoolQueue_t *)xPoolQueue;
+    configASSERT(pxPoolQueue);
+    return uxQueueMessagesWaiting(pqPOSTED_QUEUE(pxPoolQueue));
+}
+
+size_t xPoolQueueGetBlockSize(PoolQueueHandle_t xPoolQueue)
+{
+    PoolQueue_t *pxPoolQueue = (PoolQueue_t *)xPoolQueue;
+    configASSERT(pxPoolQueue);
+    return pxPoolQueue->xBlockSize;
+}
+
+void vPoolQueueGetStats(PoolQueueHandle_t xPoolQueue, PoolQueueStats_t *pxStats, BaseType_t xReset)
+{
+    PoolQueue_t *pxPoolQueue = (PoolQueue_t *)xPoolQueue;
+    configASSERT(pxPoolQueue && pxStats);
+
+    portENTER_CRITICAL(&pxPoolQueue->mux);
+    *pxStats = pxPoolQueue->xStats;
+    if (xReset == pdTRUE) {
+        pxPoolQueue->xStats.uxMaxBlocksInUse = pxPoolQueue->xStats.uxBlocksInUse;
+        pxPoolQueue->xStats.ulAcquired = 0;
+        pxPoolQueue->xStats.ulOverflows = 0;
+    }
+    portEXIT_CRITICAL(&pxPoolQueue->mux);
+}
+
+void vPoolQueueDelete(PoolQueueHandle_t xPoolQueue)
+{
+    PoolQueue_t *pxPoolQueue = (PoolQueue_t *)xPoolQueue;
+    configASSERT(pxPoolQueue);
+    configASSERT(pxPoolQueue->xStats.uxBlocksInUse == 0);
+
+    vQueueDelete(pqPOSTED_QUEUE(pxPoolQueue));
+    vSemaphoreDelete(pqFREE_SEM(pxPoolQueue));
+    if (pxPoolQueue->xStaticallyAllocated == pdFALSE) {
+        free(pxPoolQueue);
+    }
+}
@@ -0,0 +1,255 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/rt_sched.h"
+
+/*
+ * All jobs are kept in a single list protected by a binary semaphore (a mutex would
+ * apply priority inheritance and fight with the priorities set here). The priorities
+ * are recomputed by the job that is being released or that completes, with the
+ * scheduler suspended so that a job raised above the caller only preempts it once
+ * all priorities are consistent.
+ *
+ * vTaskSuspendAll() only suspends the scheduler of the calling core. A job pinned
+ * to the other core (or unpinned and running there) takes each priority change as
+ * soon as vTaskPrioritySet() yields that core, so it can briefly run against a mix
+ * of old and new priorities. The list lock still serializes the recomputations, and
+ * the priorities are consistent again once the caller resumes the scheduler.
+ *
+ * The rank of a job is the number of jobs that are strictly more urgent than it,
+ * so jobs with the same period (rate monotonic) or the same absolute deadline
+ * (earliest deadline first) share a priority and are scheduled round robin.
+ */
+
+typedef struct RtJobDefinition {
+    struct RtJobDefinition *pxNext;
+    RtJobFunction_t pxJobFunction;
+    void *pvParameters;
+    TickType_t xPeriod;
+    TickType_t xDeadline;
+    TickType_t xAbsoluteDeadline;       //Deadline of the current release
+    TaskHandle_t xTask;
+    UBaseType_t uxPriority;             //Priority last given to the task
+    BaseType_t xActive;                 //Released and not completed yet
+    BaseType_t xDeleteRequested;
+    RtJobStats_t xStats;
+} RtJob_t;
+
+static eRtPolicy ePolicy = eRtRateMonotonic;
+static UBaseType_t uxPriorityLow = tskIDLE_PRIORITY + 1;
+static UBaseType_t uxPriorityHigh = configMAX_PRIORITIES - 1;
+static RtJob_t *pxJobList = NULL;
+static SemaphoreHandle_t xListLock = NULL;
+static StaticSemaphore_t xListLockBuffer;
+static portMUX_TYPE xInitLock = portMUX_INITIALIZER_UNLOCKED;
+
+// ------------------------------------------------ Static Declarations ------------------------------------------------
+
+static inline BaseType_t prvIsBefore(TickType_t xA, TickType_t xB);
+
+static BaseType_t prvIsMoreUrgent(const RtJob_t *pxA, const RtJob_t *pxB);
+
+static void prvAssignPriorities(void);
+
+static void prvRtJobTask(void *pvParameters);
+
+// ------------------------------------------------ Static Definitions -------------------------------------------------
+
+static inline BaseType_t prvIsBefore(TickType_t xA, TickType_t xB)
+{
+    //Tick counts wrap around, compare the distance between them instead
+    return (xA != xB && (TickType_t)(xA - xB) > (portMAX_DELAY >> 1)) ? pdTRUE : pdFALSE;
+}
+
+static BaseType_t prvIsMoreUrgent(const RtJob_t *pxA, const RtJob_t *pxB)
+{
+    if (ePolicy == eRtEarliestDeadlineFirst) {
+        //Jobs that are not released don't compete for the processor
+        return (pxA->xActive == pdTRUE && pxB->xActive == pdTRUE &&
+                prvIsBefore(pxA->xAbsoluteDeadline, pxB->xAbsoluteDeadline) == pdTRUE) ? pdTRUE : pdFALSE;
+    }
+    return (pxA->xPeriod < pxB->xPeriod ||
+            (pxA->xPeriod == pxB->xPeriod && pxA->xDeadline < pxB->xDeadline)) ? pdTRUE : pdFALSE;
+}
+
+static void prvAssignPriorities(void)
+{
+    //Must be called with the list lock taken. Only holds off preemption on this core, see above.
+    vTaskSuspendAll();
+    for (RtJob_t *pxJob = pxJobList; pxJob != NULL; pxJob = pxJob->pxNext) {
+        if (ePolicy == eRtEarliestDeadlineFirst && pxJob->xActive == pdFALSE) {
+            continue;   //Keeps its priority until its next release
+        }
+        UBaseType_t uxRank = 0;
+        for (RtJob_t *pxOther = pxJobList; pxOther != NULL; pxOther = pxOther->pxNext) {
+            if (pxOther != pxJob && prvIsMoreUrgent(pxOther, pxJob) == pdTRUE) {
+                uxRank++;
+            }
+        }
+        UBaseType_t uxPriority = (uxRank < uxPriorityHigh - uxPriorityLow) ? uxPriorityHigh - uxRank : uxPriorityLow;
+        if (uxPriority != pxJob->uxPriority) {
+            pxJob->uxPriority = uxPriority;
+            vTaskPrioritySet(pxJob->xTask, uxPriority);
+        }
+    }
+    xTaskResumeAll();
+}
+
+static void prvRtJobTask(void *pvParameters)
+{
+    RtJob_t *pxJob = (RtJob_t *)pvParameters;
+    TickType_t xLastRelease = xTaskGetTickCount();
+    BaseType_t xLate = pdFALSE;
+
+    for (;;) {
+        //Release
+        xSemaphoreTake(xListLock, portMAX_DELAY);
+        if (pxJob->xDeleteRequested == pdTRUE) {
+            break;
+        }
+        pxJob->xAbsoluteDeadline = xLastRelease + pxJob->xDeadline;
+        pxJob->xActive = pdTRUE;
+        pxJob->xStats.ulReleases++;
+        if (xLate == pdTRUE) {
+            pxJob->xStats.ulOverruns++;
+        }
+        prvAssignPriorities();
+        xSemaphoreGive(xListLock);
+
+        pxJob->pxJobFunction(pxJob->pvParameters);
+
+        //Completion
+        TickType_t xResponse = xTaskGetTickCount() - xLastRelease;
+        xSemaphoreTake(xListLock, portMAX_DELAY);
+        pxJob->xActive = pdFALSE;
+        if (xResponse > pxJob->xDeadline) {
+            pxJob->xStats.ulDeadlineMisses++;
+        }
+        if (xResponse > pxJob->xStats.xWorstResponse) {
+            pxJob->xStats.xWorstResponse = xResponse;
+        }
+        if (ePolicy == eRtEarliestDeadlineFirst) {
+            prvAssignPriorities();
+        }
+        xSemaphoreGive(xListLock);
+
+        //If the next release time has already passed, the release is not skipped but starts late
+        xLate = (xTaskDelayUntil(&xLastRelease, pxJob->xPeriod) == pdFALSE) ? pdTRUE : pdFALSE;
+    }
+
+    //Remove the job from the list. The lock is still taken from the release.
+    RtJob_t **ppxLink = &pxJobList;
+    while (*ppxLink != pxJob) {
+        ppxLink = &(*ppxLink)->pxNext;
+    }
+    *ppxLink = pxJob->pxNext;
+    xSemaphoreGive(xListLock);
+    free(pxJob);
+    vTaskDelete(NULL);
+}
+
+// ------------------------------------------------ Public Functions ---------------------------------------------------
+
+BaseType_t xRtSchedInit(eRtPolicy ePolicyToUse, UBaseType_t uxLow, UBaseType_t uxHigh)
+{
+    if (uxLow <= tskIDLE_PRIORITY || uxHigh >= configMAX_PRIORITIES || uxLow > uxHigh ||
+            (ePolicyToUse != eRtRateMonotonic && ePolicyToUse != eRtEarliestDeadlineFirst)) {
+        return pdFALSE;
+    }
+
+    BaseType_t xReturn = pdFALSE;
+    portENTER_CRITICAL(&xInitLock);
+    if (pxJobList == NULL) {
+        ePolicy = ePolicyToUse;
+        uxPriorityLow = uxLow;
+        uxPriorityHigh = uxHigh;
+        xReturn = pdTRUE;
+    }
+    portEXIT_CRITICAL(&xInitLock);
+
+    if (xReturn == pdTRUE && xListLock == NULL) {
+        xListLock = xSemaphoreCreateBinaryStatic(&xListLockBuffer);
+        xSemaphoreGive(xListLock);
+    }
+    return xReturn;
+}
+
+BaseType_t xRtJobCreate(RtJobFunction_t pxJobFunction,
+                        const char *pcName,
+                        uint32_t ulStackDepth,
+                        void *pvParameters,
+                        TickType_t xPeriod,
+                        TickType_t xDeadline,
+                        BaseType_t xCoreID,
+                        RtJobHandle_t *pxJob)
+{
+    configASSERT(pxJobFunction != NULL && pxJob != NULL);
+    configASSERT(xPeriod > 0 && xDeadline > 0 && xDeadline <= xPeriod);
+    configASSERT(xListLock != NULL);    //xRtSchedInit() must be called first
+
+    RtJob_t *pxNewJob = calloc(1, sizeof(RtJob_t));
+    if (pxNewJob == NULL) {
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    }
+    pxNewJob->pxJobFunction = pxJobFunction;
+    pxNewJob->pvParameters = pvParameters;
+    pxNewJob->xPeriod = xPeriod;
+    pxNewJob->xDeadline = xDeadline;
+    pxNewJob->xActive = pdFALSE;
+    pxNewJob->xDeleteRequested = pdFALSE;
+    pxNewJob->uxPriority = uxPriorityHigh;
+
+    //The task is linked in before it can run, its first release assigns the priorities
+    xSemaphoreTake(xListLock, portMAX_DELAY);
+    BaseType_t xReturn = xTaskCreatePinnedToCore(prvRtJobTask, pcName, ulStackDepth, pxNewJob, uxPriorityHigh, &pxNewJob->xTask, xCoreID);
+    if (xReturn == pdPASS) {
+        pxNewJob->pxNext = pxJobList;
+        pxJobList = pxNewJob;
+    }
+    xSemaphoreGive(xListLock);
+
+    if (xReturn != pdPASS) {
+        free(pxNewJob);
+        return xReturn;
+    }
+    *pxJob = (RtJobHandle_t)pxNewJob;
+    return pdPASS;
+}
+
+void vRtJobDelete(RtJobHandle_t xJob)
+{
+    RtJob_t *pxJob = (RtJob_t *)xJob;
+    configASSERT(pxJob);
+
+    xSemaphoreTake(xListLock, portMAX_DELAY);
+    pxJob->xDeleteRequested = pdTRUE;
+    xSemaphoreGive(xListLock);
+}
+
+void vRtJobGetStats(RtJobHandle_t xJob, RtJobStats_t *pxStats, BaseType_t xReset)
+{
+    RtJob_t *pxJob = (RtJob_t *)xJob;
+    configASSERT(pxJob && pxStats);
+
+    xSemaphoreTake(xListLock, portMAX_DELAY);
+    *pxStats = pxJob->xStats;
+    if (xReset == pdTRUE) {
+        memset(&pxJob->xStats, 0, sizeof(pxJob->xStats));
+    }
+    xSemaphoreGive(xListLock);
+}
+
+TaskHandle_t xRtJobGetTaskHandle(RtJobHandle_t xJob)
+{
+    RtJob_t *pxJob = (RtJob_t *)xJob;
+    configASSERT(pxJob);
+    return pxJob->xTask;
+}
@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/rt_sched.h"
+
+/*
+ * Two periodic jobs with a total utilization of 90%, above the 83% bound under which
+ * rate monotonic scheduling is guaranteed to meet all deadlines:
+ *
+ *  - "short": 20 ms of work every 50 ms
+ *  - "long":  35 ms of work every 70 ms
+ *
+ * Under rate monotonic scheduling "short" always preempts "long", which then misses
+ * its deadline whenever both are released together. Earliest deadline first meets
+ * every deadline. A CPU hog runs below the priority band of the jobs all along, like
+ * a network task would, and must not make any difference.
+ */
+
+#define RUN_MS              3500    //10 hyperperiods of 350 ms
+#define PRIORITY_LOW        3
+#define PRIORITY_HIGH       5
+#define HOG_PRIORITY        2
+
+typedef struct {
+    const char *name;
+    uint32_t work_ms;
+    uint32_t period_ms;
+} job_desc_t;
+
+static const job_desc_t jobs[] = {
+    {"short", 20, 50},
+    {"long", 35, 70},
+};
+
+#define NUM_JOBS    (sizeof(jobs) / sizeof(jobs[0]))
+
+static volatile uint32_t loops_per_ms;
+static volatile uint32_t sink;
+
+static void burn(uint32_t loops)
+{
+    for (uint32_t i = 0; i < loops; i++) {
+        sink += i;
+    }
+}
+
+static void calibrate(void)
+{
+    //Burning CPU time, not waiting for ticks, so that a preempted job takes longer to complete
+    uint32_t loops = 1000;
+    TickType_t elapsed;
+    do {
+        loops *= 2;
+        TickType_t start = xTaskGetTickCount();
+        burn(loops);
+        elapsed = xTaskGetTickCount() - start;
+    } while (elapsed < pdMS_TO_TICKS(200));
+    loops_per_ms = loops / (elapsed * portTICK_PERIOD_MS);
+}
+
+static void job_function(void *arg)
+{
+    const job_desc_t *desc = (const job_desc_t *)arg;
+    burn(desc->work_ms * loops_per_ms);
+}
+
+static void hog_task(void *arg)
+{
+    for (;;) {
+        burn(loops_per_ms);
+    }
+}
+
+static void run(eRtPolicy policy, const char *policy_name)
+{
+    RtJobHandle_t handles[NUM_JOBS];
+    TaskHandle_t hog;
+
+    if (xRtSchedInit(policy, PRIORITY_LOW, PRIORITY_HIGH) != pdTRUE) {
+        printf("xRtSchedInit failed\n");
+        abort();
+    }
+    xTaskCreate(hog_task, "hog", 4096, NULL, HOG_PRIORITY, &hog);
+    for (int i = 0; i < NUM_JOBS; i++) {
+        BaseType_t ret = xRtJobCreate(job_function, jobs[i].name, 4096, (void *)&jobs[i],
+                                      pdMS_TO_TICKS(jobs[i].period_ms), pdMS_TO_TICKS(jobs[i].period_ms),
+                                      tskNO_AFFINITY, &handles[i]);
+        if (ret != pdPASS) {
+            printf("xRtJobCreate failed\n");
+            abort();
+        }
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(RUN_MS));
+
+    printf("%s\n", policy_name);
+    for (int i = 0; i < NUM_JOBS; i++) {
+        RtJobStats_t stats;
+        vRtJobGetStats(handles[i], &stats, pdFALSE);
+        printf("  %-6s releases %4u  deadline misses %4u  overruns %4u  worst response %3u ms (deadline %u ms)\n",
+               jobs[i].name, (unsigned)stats.ulReleases, (unsigned)stats.ulDeadlineMisses, (unsigned)stats.ulOverruns,
+               (unsigned)(stats.xWorstResponse * portTICK_PERIOD_MS), (unsigned)jobs[i].period_ms);
+        vRtJobDelete(handles[i]);
+    }
+    vTaskDelete(hog);
+    vTaskDelay(pdMS_TO_TICKS(2 * 70));  //Let the jobs reach their next release and delete themselves
+}
+
+void app_main(void)
+{
+    //Stay above the hog and the jobs to collect the results on time
+    vTaskPrioritySet(NULL, PRIORITY_HIGH + 1);
+    calibrate();
+    printf("%u loops per ms\n", (unsigned)loops_per_ms);
+    run(eRtRateMonotonic, "rate monotonic");
+    run(eRtEarliestDeadlineFirst, "earliest deadline first");
+    exit(0);
+}
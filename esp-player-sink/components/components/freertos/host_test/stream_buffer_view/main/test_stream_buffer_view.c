@@ -0,0 +1,265 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Linux host test of the zero-copy stream buffer functions
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define BUFFER_SIZE     16
+
+static StreamBufferHandle_t sb;
+
+// Copy the bytes of a view into a flat array
+static size_t copy_view(uint8_t *dst, const uint8_t *data1, size_t len1, const uint8_t *data2, size_t len2)
+{
+    memcpy(dst, data1, len1);
+    if (len2 > 0) {
+        memcpy(dst + len1, data2, len2);
+    }
+    return len1 + len2;
+}
+
+// Get a byte of a view by its index, as if the two segments were contiguous
+static uint8_t view_byte(const uint8_t *data1, size_t len1, const uint8_t *data2, size_t index)
+{
+    return index < len1 ? data1[index] : data2[index - len1];
+}
+
+TEST_GROUP(stream_buffer_view);
+
+TEST_SETUP(stream_buffer_view)
+{
+    sb = xStreamBufferCreate(BUFFER_SIZE, 1);
+    TEST_ASSERT_NOT_NULL(sb);
+}
+
+TEST_TEAR_DOWN(stream_buffer_view)
+{
+    vStreamBufferDelete(sb);
+}
+
+TEST(stream_buffer_view, empty_buffer_has_empty_view)
+{
+    uint8_t *data1, *data2;
+    size_t len1, len2;
+    TEST_ASSERT_EQUAL(0, xStreamBufferReceiveAcquire(sb, &data1, &len1, &data2, &len2, 0, 0));
+    TEST_ASSERT_EQUAL(0, len1);
+    TEST_ASSERT_NULL(data2);
+    TEST_ASSERT_EQUAL(0, len2);
+    // Times out when nothing is sent
+    TEST_ASSERT_EQUAL(0, xStreamBufferReceiveAcquire(sb, &data1, &len1, &data2, &len2, 0, 2));
+    vStreamBufferReceiveCommit(sb, 0);
+}
+
+TEST(stream_buffer_view, partial_commit_keeps_remaining_bytes)
+{
+    const uint8_t sent[] = "0123456789";
+    uint8_t *data1, *data2;
+    size_t len1, len2;
+    TEST_ASSERT_EQUAL(10, xStreamBufferSend(sb, sent, 10, 0));
+
+    TEST_ASSERT_EQUAL(10, xStreamBufferReceiveAcquire(sb, &data1, &len1, &data2, &len2, 0, 0));
+    TEST_ASSERT_EQUAL(10, len1);
+    TEST_ASSERT_NULL(data2);
+    TEST_ASSERT_EQUAL_MEMORY(sent, data1, 10);
+
+    // Consume a 4 byte "header" only, the rest must be returned again
+    vStreamBufferReceiveCommit(sb, 4);
+    TEST_ASSERT_EQUAL(6, xStreamBufferBytesAvailable(sb));
+    TEST_ASSERT_EQUAL(6, xStreamBufferReceiveAcquire(sb, &data1, &len1, &data2, &len2, 0, 0));
+    TEST_ASSERT_EQUAL_MEMORY(sent + 4, data1, 6);
+
+    // The view and a normal receive see the same bytes
+    uint8_t received[6];
+    TEST_ASSERT_EQUAL(6, xStreamBufferReceive(sb, received, sizeof(received), 0));
+    TEST_ASSERT_EQUAL_MEMORY(sent + 4, received, 6);
+    TEST_ASSERT_TRUE(xStreamBufferIsEmpty(sb));
+}
+
+TEST(stream_buffer_view, minimum_bytes_times_out_with_partial_view)
+{
+    uint8_t *data1, *data2;
+    size_t len1, len2;
+    TEST_ASSERT_EQUAL(3, xStreamBufferSend(sb, "abc", 3, 0));
+
+    // Enough bytes, returns at once
+    TEST_ASSERT_EQUAL(3, xStreamBufferReceiveAcquire(sb, &data1, &len1, &data2, &len2, 3, portMAX_DELAY));
+    // Not enough, waits for the timeout and returns what is there
+    TickType_t start = xTaskGetTickCount();
+    TEST_ASSERT_EQUAL(3, xStreamBufferReceiveAcquire(sb, &data1, &len1, &data2, &len2, 5, 5));
+    TEST_ASSERT_GREATER_OR_EQUAL(5, xTaskGetTickCount() - start);
+    TEST_ASSERT_EQUAL_MEMORY("abc", data1, 3);
+    vStreamBufferReceiveCommit(sb, 3);
+}
+
+TEST(stream_buffer_view, view_wraps_around_in_two_segments)
+{
+    uint8_t sent[BUFFER_SIZE], flat[BUFFER_SIZE];
+    uint8_t *data1, *data2;
+    size_t len1, len2;
+
+    // Move the read and write positions close to the end of the storage area
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+        sent[i] = i;
+    }
+    TEST_ASSERT_EQUAL(12, xStreamBufferSend(sb, sent, 12, 0));
+    TEST_ASSERT_EQUAL(12, xStreamBufferReceive(sb, flat, 12, 0));
+
+    TEST_ASSERT_EQUAL(10, xStreamBufferSend(sb, sent, 10, 0));
+    TEST_ASSERT_EQUAL(10, xStreamBufferReceiveAcquire(sb, &data1, &len1, &data2, &len2, 0, 0));
+    TEST_ASSERT_GREATER_THAN(0, len1);
+    TEST_ASSERT_NOT_NULL(data2);
+    TEST_ASSERT_EQUAL(10, len1 + len2);
+    TEST_ASSERT_EQUAL(10, copy_view(flat, data1, len1, data2, len2));
+    TEST_ASSERT_EQUAL_MEMORY(sent, flat, 10);
+
+    // Committing the first segment leaves the second one as a single segment
+    vStreamBufferReceiveCommit(sb, len1);
+    size_t remaining = len2;
+    TEST_ASSERT_EQUAL(remaining, xStreamBufferReceiveAcquire(sb, &data1, &len1, &data2, &len2, 0, 0));
+    TEST_ASSERT_NULL(data2);
+    TEST_ASSERT_EQUAL_MEMORY(sent + 10 - remaining, data1, remaining);
+    vStreamBufferReceiveCommit(sb, remaining);
+    TEST_ASSERT_TRUE(xStreamBufferIsEmpty(sb));
+}
+
+TEST(stream_buffer_view, write_in_place)
+{
+    uint8_t *space;
+    uint8_t received[BUFFER_SIZE];
+
+    // Empty buffer at the start of the storage area, all the space is contiguous
+    TEST_ASSERT_EQUAL(BUFFER_SIZE, xStreamBufferSendAcquire(sb, &space, 0));
+    memcpy(space, "abcdef", 6);
+    vStreamBufferSendCommit(sb, 6);
+    TEST_ASSERT_EQUAL(6, xStreamBufferBytesAvailable(sb));
+    TEST_ASSERT_EQUAL(6, xStreamBufferReceive(sb, received, sizeof(received), 0));
+    TEST_ASSERT_EQUAL_MEMORY("abcdef", received, 6);
+
+    // The contiguous space stops at the end of the storage area, the rest is returned once it is committed
+    size_t first = xStreamBufferSendAcquire(sb, &space, 0);
+    TEST_ASSERT_GREATER_THAN(0, first);
+    TEST_ASSERT_LESS_THAN(BUFFER_SIZE, first);
+    memset(space, 'x', first);
+    vStreamBufferSendCommit(sb, first);
+    size_t second = xStreamBufferSendAcquire(sb, &space, 0);
+    TEST_ASSERT_EQUAL(BUFFER_SIZE - first, second);
+    memset(space, 'y', second);
+    vStreamBufferSendCommit(sb, second);
+
+    // Full
+    TEST_ASSERT_TRUE(xStreamBufferIsFull(sb));
+    TEST_ASSERT_EQUAL(0, xStreamBufferSendAcquire(sb, &space, 2));
+    TEST_ASSERT_EQUAL(BUFFER_SIZE, xStreamBufferReceive(sb, received, sizeof(received), 0));
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+        TEST_ASSERT_EQUAL(i < first ? 'x' : 'y', received[i]);
+    }
+}
+
+/*
+ * A writer task produces frames of a 2 byte little endian length followed by
+ * the payload, where every payload byte is the frame number. It writes them in
+ * place in pieces of varying sizes. The reader parses the frames in place, which
+ * requires waiting for more bytes when a header or a payload is incomplete, and
+ * handling headers and payloads split across the two segments of a view.
+ */
+#define STREAM_FRAMES       500
+#define STREAM_BUFFER_SIZE  61      // Not a multiple of anything the writer uses
+#define MAX_PAYLOAD         40
+
+static SemaphoreHandle_t writer_done;
+
+static size_t frame_payload_length(int frame)
+{
+    return 1 + (frame * 7) % MAX_PAYLOAD;
+}
+
+static void frame_writer_task(void *arg)
+{
+    StreamBufferHandle_t stream = (StreamBufferHandle_t)arg;
+    uint8_t frame[2 + MAX_PAYLOAD];
+    int piece = 1;
+
+    for (int i = 0; i < STREAM_FRAMES; i++) {
+        size_t len = frame_payload_length(i);
+        frame[0] = len & 0xFF;
+        frame[1] = len >> 8;
+        memset(frame + 2, (uint8_t)i, len);
+
+        size_t offset = 0;
+        while (offset < 2 + len) {
+            uint8_t *space;
+            size_t avail = xStreamBufferSendAcquire(stream, &space, portMAX_DELAY);
+            size_t n = MIN(MIN(avail, 2 + len - offset), (size_t)piece);
+            memcpy(space, frame + offset, n);
+            vStreamBufferSendCommit(stream, n);
+            offset += n;
+            piece = piece % 13 + 1;
+        }
+    }
+    xSemaphoreGive(writer_done);
+    vTaskDelete(NULL);
+}
+
+TEST(stream_buffer_view, parse_frames_in_place)
+{
+    StreamBufferHandle_t stream = xStreamBufferCreate(STREAM_BUFFER_SIZE, 1);
+    TEST_ASSERT_NOT_NULL(stream);
+    writer_done = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(writer_done);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(frame_writer_task, "writer", configMINIMAL_STACK_SIZE * 4, stream, uxTaskPriorityGet(NULL), NULL));
+
+    int split_frames = 0;
+    for (int i = 0; i < STREAM_FRAMES; i++) {
+        uint8_t *data1, *data2;
+        size_t len1, len2;
+        size_t expected = frame_payload_length(i);
+
+        // Block for the header, then for the rest of the frame, the writer may still be writing it
+        TEST_ASSERT_GREATER_OR_EQUAL(2, xStreamBufferReceiveAcquire(stream, &data1, &len1, &data2, &len2, 2, portMAX_DELAY));
+        size_t len = view_byte(data1, len1, data2, 0) | view_byte(data1, len1, data2, 1) << 8;
+        TEST_ASSERT_EQUAL(expected, len);
+        TEST_ASSERT_GREATER_OR_EQUAL(2 + len, xStreamBufferReceiveAcquire(stream, &data1, &len1, &data2, &len2, 2 + len, portMAX_DELAY));
+
+        // Check the payload where it is, in one or two pieces
+        for (size_t j = 2; j < 2 + len; j++) {
+            TEST_ASSERT_EQUAL((uint8_t)i, view_byte(data1, len1, data2, j));
+        }
+        if (len1 < 2 + len) {
+            split_frames++;
+        }
+        vStreamBufferReceiveCommit(stream, 2 + len);
+    }
+
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(writer_done, portMAX_DELAY));
+    TEST_ASSERT_TRUE(xStreamBufferIsEmpty(stream));
+    TEST_ASSERT_GREATER_THAN(0, split_frames);
+    vStreamBufferDelete(stream);
+    vSemaphoreDelete(writer_done);
+}
+
+TEST_GROUP_RUNNER(stream_buffer_view)
+{
+    RUN_TEST_CASE(stream_buffer_view, empty_buffer_has_empty_view);
+    RUN_TEST_CASE(stream_buffer_view, partial_commit_keeps_remaining_bytes);
+    RUN_TEST_CASE(stream_buffer_view, minimum_bytes_times_out_with_partial_view);
+    RUN_TEST_CASE(stream_buffer_view, view_wraps_around_in_two_segments);
+    RUN_TEST_CASE(stream_buffer_view, write_in_place);
+    RUN_TEST_CASE(stream_buffer_view, parse_frames_in_place);
+}
+
+void app_main(void)
+{
+    UNITY_MAIN(stream_buffer_view);
+}
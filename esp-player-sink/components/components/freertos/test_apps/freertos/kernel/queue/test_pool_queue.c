@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Test the pool queue (freertos/pool_queue.h)
+ *
+ * 1) Test acquiring, posting, receiving and releasing blocks from a single task, including
+ *    the overflow accounting when the pool is exhausted. The test is run on a dynamically
+ *    and a statically allocated pool queue.
+ * 2) Test streaming blocks from a producer task to a consumer task on every core combination.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/pool_queue.h"
+#include "unity.h"
+#include "test_utils.h"
+
+#define POOL_BLOCK_COUNT    4
+#define POOL_BLOCK_SIZE     450     //Rounded up to portBYTE_ALIGNMENT by the pool queue
+
+static void test_pool_queue_single_task(PoolQueueHandle_t pool)
+{
+    void *blocks[POOL_BLOCK_COUNT];
+    void *extra;
+    PoolQueueStats_t stats;
+
+    TEST_ASSERT_GREATER_OR_EQUAL(POOL_BLOCK_SIZE, xPoolQueueGetBlockSize(pool));
+    TEST_ASSERT_EQUAL(NULL, pvPoolQueueReceive(pool, NULL, 0));
+
+    //Exhaust the pool, the next acquisition must fail and be counted as an overflow
+    for (int i = 0; i < POOL_BLOCK_COUNT; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xPoolQueueAcquire(pool, &blocks[i], 0));
+        TEST_ASSERT_EQUAL(0, (uintptr_t)blocks[i] & (portBYTE_ALIGNMENT - 1));
+        memset(blocks[i], i, POOL_BLOCK_SIZE);
+    }
+    TEST_ASSERT_EQUAL(pdFALSE, xPoolQueueAcquire(pool, &extra, 1));
+    vPoolQueueGetStats(pool, &stats, pdFALSE);
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, stats.uxBlockCount);
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, stats.uxBlocksInUse);
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, stats.uxMaxBlocksInUse);
+    TEST_ASSERT_EQUAL(1, stats.ulOverflows);
+
+    //Post the blocks with different lengths, they must be received in order and without being copied
+    for (int i = 0; i < POOL_BLOCK_COUNT; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xPoolQueuePost(pool, blocks[i], POOL_BLOCK_SIZE - i));
+    }
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, uxPoolQueueMessagesWaiting(pool));
+    for (int i = 0; i < POOL_BLOCK_COUNT; i++) {
+        size_t len;
+        uint8_t *block = pvPoolQueueReceive(pool, &len, 0);
+        TEST_ASSERT_EQUAL_PTR(blocks[i], block);
+        TEST_ASSERT_EQUAL(POOL_BLOCK_SIZE - i, len);
+        TEST_ASSERT_EACH_EQUAL_UINT8(i, block, len);
+        TEST_ASSERT_EQUAL(pdTRUE, xPoolQueueRelease(pool, block));
+    }
+
+    //Resetting the statistics must keep the count of blocks in use
+    vPoolQueueGetStats(pool, &stats, pdTRUE);
+    TEST_ASSERT_EQUAL(0, stats.uxBlocksInUse);
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, stats.ulAcquired);
+    TEST_ASSERT_EQUAL(pdTRUE, xPoolQueueAcquire(pool, &extra, 0));
+    vPoolQueueGetStats(pool, &stats, pdTRUE);
+    TEST_ASSERT_EQUAL(1, stats.uxBlocksInUse);
+    TEST_ASSERT_EQUAL(1, stats.uxMaxBlocksInUse);
+    TEST_ASSERT_EQUAL(1, stats.ulAcquired);
+    TEST_ASSERT_EQUAL(0, stats.ulOverflows);
+    //A block can be given back without being posted
+    TEST_ASSERT_EQUAL(pdTRUE, xPoolQueueRelease(pool, extra));
+}
+
+TEST_CASE("Test pool queue", "[freertos]")
+{
+    PoolQueueHandle_t pool = xPoolQueueCreate(POOL_BLOCK_COUNT, POOL_BLOCK_SIZE);
+    TEST_ASSERT_NOT_EQUAL(NULL, pool);
+    test_pool_queue_single_task(pool);
+    vPoolQueueDelete(pool);
+}
+
+TEST_CASE("Test static pool queue", "[freertos]")
+{
+    static uint8_t storage[poolqueueSTORAGE_SIZE(POOL_BLOCK_COUNT, POOL_BLOCK_SIZE)] __attribute__((aligned(portBYTE_ALIGNMENT)));
+    static StaticPoolQueue_t pool_buffer;
+    PoolQueueHandle_t pool = xPoolQueueCreateStatic(POOL_BLOCK_COUNT, POOL_BLOCK_SIZE, storage, &pool_buffer);
+    TEST_ASSERT_EQUAL_PTR(&pool_buffer, pool);
+    test_pool_queue_single_task(pool);
+    vPoolQueueDelete(pool);
+}
+
+/* ---------------------------- Test pool queue streaming ----------------------------
+ * A producer task fills every block with its sequence number and posts it. A consumer
+ * task checks and releases the blocks. The pool is small compared to the number of
+ * blocks streamed, so both tasks block on the pool queue many times.
+ */
+#define STREAM_BLOCKS       1000
+
+static SemaphoreHandle_t stream_done;
+
+static void pool_producer_task(void *arg)
+{
+    PoolQueueHandle_t pool = (PoolQueueHandle_t)arg;
+    for (int i = 0; i < STREAM_BLOCKS; i++) {
+        void *block;
+        TEST_ASSERT_EQUAL(pdTRUE, xPoolQueueAcquire(pool, &block, portMAX_DELAY));
+        size_t len = 1 + i % POOL_BLOCK_SIZE;
+        memset(block, (uint8_t)i, len);
+        xPoolQueuePost(pool, block, len);
+    }
+    xSemaphoreGive(stream_done);
+    vTaskDelete(NULL);
+}
+
+static void pool_consumer_task(void *arg)
+{
+    PoolQueueHandle_t pool = (PoolQueueHandle_t)arg;
+    for (int i = 0; i < STREAM_BLOCKS; i++) {
+        size_t len;
+        uint8_t *block = pvPoolQueueReceive(pool, &len, portMAX_DELAY);
+        TEST_ASSERT_NOT_EQUAL(NULL, block);
+        TEST_ASSERT_EQUAL(1 + i % POOL_BLOCK_SIZE, len);
+        TEST_ASSERT_EACH_EQUAL_UINT8((uint8_t)i, block, len);
+        xPoolQueueRelease(pool, block);
+    }
+    xSemaphoreGive(stream_done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("Test pool queue streaming", "[freertos]")
+{
+    stream_done = xSemaphoreCreateCounting(2, 0);
+    TEST_ASSERT_NOT_EQUAL(NULL, stream_done);
+    PoolQueueHandle_t pool = xPoolQueueCreate(POOL_BLOCK_COUNT, POOL_BLOCK_SIZE);
+    TEST_ASSERT_NOT_EQUAL(NULL, pool);
+
+    for (int producer_core = 0; producer_core < portNUM_PROCESSORS; producer_core++) {
+        for (int consumer_core = 0; consumer_core < portNUM_PROCESSORS; consumer_core++) {
+            xTaskCreatePinnedToCore(pool_consumer_task, "consumer", 2048, pool, UNITY_FREERTOS_PRIORITY + 1, NULL, consumer_core);
+            xTaskCreatePinnedToCore(pool_producer_task, "producer", 2048, pool, UNITY_FREERTOS_PRIORITY + 1, NULL, producer_core);
+            xSemaphoreTake(stream_done, portMAX_DELAY);
+            xSemaphoreTake(stream_done, portMAX_DELAY);
+            vTaskDelay(5);  //Allow idle to clean up
+        }
+    }
+
+    PoolQueueStats_t stats;
+    vPoolQueueGetStats(pool, &stats, pdFALSE);
+    TEST_ASSERT_EQUAL(0, stats.uxBlocksInUse);
+    TEST_ASSERT_EQUAL(portNUM_PROCESSORS * portNUM_PROCESSORS * STREAM_BLOCKS, stats.ulAcquired);
+    TEST_ASSERT_EQUAL(0, stats.ulOverflows);
+
+    vPoolQueueDelete(pool);
+    vSemaphoreDelete(stream_done);
+}
@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Test the periodic real-time jobs (freertos/rt_sched.h)
+ *
+ * 1) Rate monotonic: the job with the shorter period gets the higher priority of the band,
+ *    and a job whose work exceeds its deadline has its misses counted.
+ * 2) Earliest deadline first: two jobs that cannot both meet their deadlines under rate
+ *    monotonic scheduling meet all of them.
+ */
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/rt_sched.h"
+#include "unity.h"
+#include "test_utils.h"
+
+#define TEST_PRIORITY_LOW   (UNITY_FREERTOS_PRIORITY + 1)
+#define TEST_PRIORITY_HIGH  (UNITY_FREERTOS_PRIORITY + 3)
+#define TEST_PERIOD_SHORT   pdMS_TO_TICKS(50)
+#define TEST_PERIOD_LONG    pdMS_TO_TICKS(100)
+
+static volatile uint32_t loops_per_tick;
+static volatile uint32_t burn_sink;
+
+static void burn(uint32_t loops)
+{
+    for (uint32_t i = 0; i < loops; i++) {
+        burn_sink += i;
+    }
+}
+
+static void calibrate(void)
+{
+    //Jobs burn CPU time rather than wait for ticks, so that a preempted job takes longer to complete
+    uint32_t loops = 1000;
+    TickType_t elapsed;
+    do {
+        loops *= 2;
+        TickType_t start = xTaskGetTickCount();
+        burn(loops);
+        elapsed = xTaskGetTickCount() - start;
+    } while (elapsed < pdMS_TO_TICKS(100));
+    loops_per_tick = loops / elapsed;
+}
+
+static void busy_job(void *arg)
+{
+    burn((TickType_t)(uintptr_t)arg * loops_per_tick);
+}
+
+static void idle_job(void *arg)
+{
+}
+
+TEST_CASE("Test rate monotonic jobs", "[freertos]")
+{
+    RtJobHandle_t short_job;
+    RtJobHandle_t long_job;
+    RtJobStats_t stats;
+
+    //Give the test task a higher priority than the jobs so it can check them
+    vTaskPrioritySet(NULL, TEST_PRIORITY_HIGH + 1);
+    calibrate();
+    TEST_ASSERT_EQUAL(pdTRUE, xRtSchedInit(eRtRateMonotonic, TEST_PRIORITY_LOW, TEST_PRIORITY_HIGH));
+    TEST_ASSERT_EQUAL(pdPASS, xRtJobCreate(idle_job, "long", 2048, NULL, TEST_PERIOD_LONG, TEST_PERIOD_LONG, 0, &long_job));
+    //The short job works for longer than its deadline
+    TEST_ASSERT_EQUAL(pdPASS, xRtJobCreate(busy_job, "short", 2048, (void *)(uintptr_t)(TEST_PERIOD_SHORT * 3 / 5),
+                                           TEST_PERIOD_SHORT, TEST_PERIOD_SHORT / 2, 0, &short_job));
+    TEST_ASSERT_EQUAL(pdFALSE, xRtSchedInit(eRtEarliestDeadlineFirst, TEST_PRIORITY_LOW, TEST_PRIORITY_HIGH));
+
+    vTaskDelay(4 * TEST_PERIOD_LONG + 1);
+    TEST_ASSERT_EQUAL(TEST_PRIORITY_HIGH, uxTaskPriorityGet(xRtJobGetTaskHandle(short_job)));
+    TEST_ASSERT_EQUAL(TEST_PRIORITY_HIGH - 1, uxTaskPriorityGet(xRtJobGetTaskHandle(long_job)));
+
+    vRtJobGetStats(short_job, &stats, pdTRUE);
+    TEST_ASSERT_UINT32_WITHIN(1, 8, stats.ulReleases);
+    TEST_ASSERT_UINT32_WITHIN(1, stats.ulReleases, stats.ulDeadlineMisses);     //The last release may not have completed yet
+    TEST_ASSERT_GREATER_THAN(TEST_PERIOD_SHORT / 2, stats.xWorstResponse);
+    vRtJobGetStats(long_job, &stats, pdTRUE);
+    TEST_ASSERT_UINT32_WITHIN(1, 4, stats.ulReleases);
+    TEST_ASSERT_EQUAL(0, stats.ulDeadlineMisses);
+
+    vRtJobDelete(short_job);
+    vRtJobDelete(long_job);
+    vTaskDelay(2 * TEST_PERIOD_LONG);   //Allow the jobs to delete themselves
+    vTaskPrioritySet(NULL, UNITY_FREERTOS_PRIORITY);
+}
+
+TEST_CASE("Test earliest deadline first jobs", "[freertos]")
+{
+    RtJobHandle_t short_job;
+    RtJobHandle_t long_job;
+    RtJobStats_t stats;
+
+    vTaskPrioritySet(NULL, TEST_PRIORITY_HIGH + 1);
+    calibrate();
+    TEST_ASSERT_EQUAL(pdTRUE, xRtSchedInit(eRtEarliestDeadlineFirst, TEST_PRIORITY_LOW, TEST_PRIORITY_HIGH));
+    /* 40% + 50% utilization. Under rate monotonic scheduling the long job would be preempted
+     * by the short one when released together and complete after 20 + 50 + 20 > 70 ms. */
+    TEST_ASSERT_EQUAL(pdPASS, xRtJobCreate(busy_job, "short", 2048, (void *)(uintptr_t)pdMS_TO_TICKS(20),
+                                           pdMS_TO_TICKS(50), pdMS_TO_TICKS(50), 0, &short_job));
+    TEST_ASSERT_EQUAL(pdPASS, xRtJobCreate(busy_job, "long", 2048, (void *)(uintptr_t)pdMS_TO_TICKS(35),
+                                           pdMS_TO_TICKS(70), pdMS_TO_TICKS(70), 0, &long_job));
+
+    vTaskDelay(pdMS_TO_TICKS(700));
+    vRtJobGetStats(short_job, &stats, pdFALSE);
+    TEST_ASSERT_GREATER_THAN(10, stats.ulReleases);
+    TEST_ASSERT_EQUAL(0, stats.ulDeadlineMisses);
+    vRtJobGetStats(long_job, &stats, pdFALSE);
+    TEST_ASSERT_GREATER_THAN(7, stats.ulReleases);
+    TEST_ASSERT_EQUAL(0, stats.ulDeadlineMisses);
+
+    vRtJobDelete(short_job);
+    vRtJobDelete(long_job);
+    vTaskDelay(pdMS_TO_TICKS(2 * 70));
+    vTaskPrioritySet(NULL, UNITY_FREERTOS_PRIORITY);
+}
@@ -0,0 +1,140 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/pool_queue.h"
+#include "esp_cpu.h"
+#include "unity.h"
+#include "test_utils.h"
+
+/*
+ * Compare the throughput of a copy queue with a pool queue. A producer task fills
+ * each item as if it was receiving it from the network, then hands it to a consumer
+ * task that reads the first byte of the item. With the copy queue, the item is
+ * copied into the queue storage by xQueueSend() and out of it by xQueueReceive().
+ * With the pool queue, the producer fills the block in place and only a pointer
+ * crosses the queue.
+ */
+
+#define THROUGHPUT_ITEMS        1000
+#define THROUGHPUT_DEPTH        10
+#define THROUGHPUT_MAX_SIZE     2048
+
+typedef struct {
+    QueueHandle_t queue;
+    PoolQueueHandle_t pool;
+    size_t item_size;
+    SemaphoreHandle_t done;
+    uint32_t checksum;
+} throughput_context_t;
+
+static void copy_producer_task(void *arg)
+{
+    throughput_context_t *context = (throughput_context_t *)arg;
+    static uint8_t item[THROUGHPUT_MAX_SIZE];
+    for (int i = 0; i < THROUGHPUT_ITEMS; i++) {
+        memset(item, (uint8_t)i, context->item_size);
+        xQueueSend(context->queue, item, portMAX_DELAY);
+    }
+    xSemaphoreGive(context->done);
+    vTaskDelete(NULL);
+}
+
+static void copy_consumer_task(void *arg)
+{
+    throughput_context_t *context = (throughput_context_t *)arg;
+    static uint8_t item[THROUGHPUT_MAX_SIZE];
+    for (int i = 0; i < THROUGHPUT_ITEMS; i++) {
+        xQueueReceive(context->queue, item, portMAX_DELAY);
+        context->checksum += item[0];
+    }
+    xSemaphoreGive(context->done);
+    vTaskDelete(NULL);
+}
+
+static void pool_producer_task(void *arg)
+{
+    throughput_context_t *context = (throughput_context_t *)arg;
+    for (int i = 0; i < THROUGHPUT_ITEMS; i++) {
+        void *block;
+        xPoolQueueAcquire(context->pool, &block, portMAX_DELAY);
+        memset(block, (uint8_t)i, context->item_size);
+        xPoolQueuePost(context->pool, block, context->item_size);
+    }
+    xSemaphoreGive(context->done);
+    vTaskDelete(NULL);
+}
+
+static void pool_consumer_task(void *arg)
+{
+    throughput_context_t *context = (throughput_context_t *)arg;
+    for (int i = 0; i < THROUGHPUT_ITEMS; i++) {
+        size_t len;
+        uint8_t *block = pvPoolQueueReceive(context->pool, &len, portMAX_DELAY);
+        context->checksum += block[0];
+        xPoolQueueRelease(context->pool, block);
+    }
+    xSemaphoreGive(context->done);
+    vTaskDelete(NULL);
+}
+
+static uint32_t run_throughput(throughput_context_t *context, TaskFunction_t producer, TaskFunction_t consumer)
+{
+    context->checksum = 0;
+    uint32_t start = esp_cpu_get_cycle_count();
+#if !CONFIG_FREERTOS_UNICORE
+    xTaskCreatePinnedToCore(consumer, "consumer", 4096, context, UNITY_FREERTOS_PRIORITY + 1, NULL, 1);
+#else
+    xTaskCreatePinnedToCore(consumer, "consumer", 4096, context, UNITY_FREERTOS_PRIORITY + 1, NULL, 0);
+#endif
+    xTaskCreatePinnedToCore(producer, "producer", 4096, context, UNITY_FREERTOS_PRIORITY + 1, NULL, 0);
+    xSemaphoreTake(context->done, portMAX_DELAY);
+    xSemaphoreTake(context->done, portMAX_DELAY);
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+
+    //Sum of (uint8_t)i over all items
+    uint32_t expected = 0;
+    for (int i = 0; i < THROUGHPUT_ITEMS; i++) {
+        expected += (uint8_t)i;
+    }
+    TEST_ASSERT_EQUAL(expected, context->checksum);
+    vTaskDelay(5);  //Allow idle to clean up
+    return cycles / THROUGHPUT_ITEMS;
+}
+
+TEST_CASE("pool queue throughput test", "[freertos]")
+{
+    static const size_t item_sizes[] = {64, 256, 450, 1024, 2048};
+    throughput_context_t context = {
+        .done = xSemaphoreCreateCounting(2, 0),
+    };
+    TEST_ASSERT_NOT_EQUAL(NULL, context.done);
+
+    for (int i = 0; i < sizeof(item_sizes) / sizeof(item_sizes[0]); i++) {
+        context.item_size = item_sizes[i];
+        context.queue = xQueueCreate(THROUGHPUT_DEPTH, item_sizes[i]);
+        context.pool = xPoolQueueCreate(THROUGHPUT_DEPTH, item_sizes[i]);
+        TEST_ASSERT_NOT_EQUAL(NULL, context.queue);
+        TEST_ASSERT_NOT_EQUAL(NULL, context.pool);
+
+        uint32_t copy_cycles = run_throughput(&context, copy_producer_task, copy_consumer_task);
+        uint32_t pool_cycles = run_throughput(&context, pool_producer_task, pool_consumer_task);
+        printf("item size %4d: copy queue %6d cycles/item, pool queue %6d cycles/item\n",
+               item_sizes[i], copy_cycles, pool_cycles);
+
+        PoolQueueStats_t stats;
+        vPoolQueueGetStats(context.pool, &stats, pdFALSE);
+        TEST_ASSERT_EQUAL(0, stats.ulOverflows);
+        vQueueDelete(context.queue);
+        vPoolQueueDelete(context.pool);
+    }
+    vSemaphoreDelete(context.done);
+}
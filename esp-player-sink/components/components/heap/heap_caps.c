@@ -14,6 +14,14 @@
 #include "esp_log.h"
 #include "heap_private.h"
 #include "esp_system.h"
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE
+#include "esp_cpu.h"
+#include "multi_heap_cache.h"
+#endif
+#ifdef CONFIG_HEAP_PROFILING
+#include "esp_cpu.h"
+#include "multi_heap_profile.h"
+#endif
 
 
 /* Forward declaration for base function, put in IRAM.
@@ -21,6 +29,11 @@
 static void *heap_caps_realloc_base( void *ptr, size_t size, uint32_t caps );
 static void *heap_caps_calloc_base( size_t n, size_t size, uint32_t caps );
 static void *heap_caps_malloc_base( size_t size, uint32_t caps );
+#ifdef CONFIG_HEAP_PROFILING
+static void *heap_caps_malloc_unprofiled( size_t size, uint32_t caps );
+#else
+#define heap_caps_malloc_unprofiled heap_caps_malloc_base
+#endif
 
 /*
 This file, combined with a region allocator that supports multiple heaps, solves the problem that the ESP32 has RAM
@@ -33,6 +46,31 @@ possible. This should optimize the amount of RAM accessible to the code without
 
 static esp_alloc_failed_hook_t alloc_failed_callback;
 
+#ifdef CONFIG_HEAP_USE_HOOKS
+#define CALL_HOOK(hook, ...) {      \
+    if (hook != NULL) {             \
+        hook(__VA_ARGS__);          \
+    }                               \
+}
+#else
+#define CALL_HOOK(hook, ...) {}
+#endif
+
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE
+/* Caps of every block in the size class cache. Requests asking for no other caps can be served from the cache,
+   and only blocks from heaps having all of these caps are put in it. */
+#define HEAP_CACHE_CAPS (MALLOC_CAP_8BIT | MALLOC_CAP_32BIT | MALLOC_CAP_INTERNAL | MALLOC_CAP_DEFAULT)
+
+static size_t heap_cache_refill(size_t size, void **ptrs, size_t count);
+static void heap_cache_flush(void **ptrs, size_t count);
+
+static heap_cache_t s_heap_cache = HEAP_CACHE_INITIALIZER(heap_cache_refill, heap_cache_flush);
+#endif
+
+#ifdef CONFIG_HEAP_PROFILING
+static heap_profile_t s_heap_profile = HEAP_PROFILE_INITIALIZER(HEAP_PROFILE_INTERVAL);
+#endif
+
 /*
   This takes a memory chunk in a region that can be addressed as both DRAM as well as IRAM. It will convert it to
   IRAM in such a way that it can be later freed. It assumes both the address as well as the length to be word-aligned.
@@ -88,7 +126,7 @@ bool heap_caps_match(const heap_t *heap, uint32_t caps)
 This function should not be called directly as it does not
 check for failure / call heap_caps_alloc_failed()
 */
-IRAM_ATTR static void *heap_caps_malloc_base( size_t size, uint32_t caps)
+IRAM_ATTR static void *heap_caps_malloc_unprofiled( size_t size, uint32_t caps)
 {
     void *ret = NULL;
 
@@ -120,6 +158,31 @@ IRAM_ATTR static void *heap_caps_malloc_base( size_t size, uint32_t caps)
         size = (size + 3) & (~3); // int overflow checked above
     }
 
+#ifdef CONFIG_HEAP_AUDIO_ARENA
+    if (caps & MALLOC_CAP_AUDIO) {
+        //Only the audio arena has this cap. There's no fallback to the heaps, callers that want one
+        //can use heap_caps_malloc_prefer().
+        if ((caps & ~(AUDIO_ARENA_CAPS | MALLOC_CAP_DEFAULT)) != 0) {
+            return NULL;
+        }
+        ret = multi_heap_arena_malloc(audio_arena.arena, size);
+        if (ret != NULL) {
+            CALL_HOOK(esp_heap_trace_alloc_hook, ret, size, caps);
+        }
+        return ret;
+    }
+#endif
+
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE
+    if ((caps & ~HEAP_CACHE_CAPS) == 0) {
+        ret = heap_cache_malloc(&s_heap_cache, esp_cpu_get_core_id(), size);
+        if (ret != NULL) {
+            CALL_HOOK(esp_heap_trace_alloc_hook, ret, size, caps);
+            return ret;
+        }
+    }
+#endif
+
     for (int prio = 0; prio < SOC_MEMORY_TYPE_NO_PRIOS; prio++) {
         //Iterate over heaps and check capabilities at this priority
         heap_t *heap;
@@ -139,12 +202,14 @@ IRAM_ATTR static void *heap_caps_malloc_base( size_t size, uint32_t caps)
                         ret = multi_heap_malloc(heap->heap, size + 4);  // int overflow checked above
 
                         if (ret != NULL) {
+                            CALL_HOOK(esp_heap_trace_alloc_hook, ret, size + 4, caps);
                             return dram_alloc_to_iram_addr(ret, size + 4);  // int overflow checked above
                         }
                     } else {
                         //Just try to alloc, nothing special.
                         ret = multi_heap_malloc(heap->heap, size);
                         if (ret != NULL) {
+                            CALL_HOOK(esp_heap_trace_alloc_hook, ret, size, caps);
                             return ret;
                         }
                     }
@@ -153,10 +218,70 @@ IRAM_ATTR static void *heap_caps_malloc_base( size_t size, uint32_t caps)
         }
     }
 
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE
+    //The free blocks held in the caches of the cores may be what's missing, return them to the heaps and retry.
+    if (heap_cache_flush_all(&s_heap_cache) > 0) {
+        return heap_caps_malloc_unprofiled(size, caps);
+    }
+#endif
+
     //Nothing usable found.
     return NULL;
 }
 
+#ifdef CONFIG_HEAP_PROFILING
+/* Architecture-specific return value of __builtin_return_address which
+ * should be interpreted as an invalid address, see heap_trace.inc
+ */
+#ifdef __XTENSA__
+#define PROFILE_INVALID_PC  0x40000000
+#else
+#define PROFILE_INVALID_PC  0x00000000
+#endif
+
+// Frames 0 and 1 return into heap_profile_sample() and heap_caps_malloc_base(), start with whoever called the latter
+#define PROFILE_FRAME(N) do {                                           \
+        if (HEAP_PROFILE_DEPTH == N) {                                  \
+            return;                                                     \
+        }                                                               \
+        callers[N] = __builtin_return_address(N + 2);                   \
+        if (!esp_ptr_executable(callers[N])                             \
+            || callers[N] == (void *) PROFILE_INVALID_PC) {             \
+            callers[N] = NULL;                                          \
+            return;                                                     \
+        }                                                               \
+    } while(0)
+
+IRAM_ATTR static __attribute__((noinline)) void heap_profile_get_callers(void **callers)
+{
+    PROFILE_FRAME(0);
+    PROFILE_FRAME(1);
+    PROFILE_FRAME(2);
+    PROFILE_FRAME(3);
+    PROFILE_FRAME(4);
+    PROFILE_FRAME(5);
+    PROFILE_FRAME(6);
+    PROFILE_FRAME(7);
+}
+
+/* Kept out of line so that allocations which are not sampled do not pay for the stack frame */
+IRAM_ATTR static __attribute__((noinline)) void heap_profile_sample(void *ptr, size_t size)
+{
+    void *callers[HEAP_PROFILE_DEPTH] = { 0 };
+    heap_profile_get_callers(callers);
+    heap_profile_record_alloc(&s_heap_profile, ptr, size, callers);
+}
+
+IRAM_ATTR static void *heap_caps_malloc_base( size_t size, uint32_t caps)
+{
+    void *ret = heap_caps_malloc_unprofiled(size, caps);
+    if (ret != NULL && heap_profile_tick(&s_heap_profile, esp_cpu_get_core_id())) {
+        heap_profile_sample(ret, size);
+    }
+    return ret;
+}
+#endif
+
 
 /*
 Routine to allocate a bit of memory with certain capabilities. caps is a bitfield of MALLOC_CAP_* bits.
@@ -334,12 +459,128 @@ IRAM_ATTR static heap_t *find_containing_heap(void *ptr )
     return NULL;
 }
 
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE
+/* Refill a size class of the cache, trying the heaps in the same order as heap_caps_malloc_base() */
+IRAM_ATTR static size_t heap_cache_refill(size_t size, void **ptrs, size_t count)
+{
+    size_t n = 0;
+    for (int prio = 0; prio < SOC_MEMORY_TYPE_NO_PRIOS && n < count; prio++) {
+        heap_t *heap;
+        SLIST_FOREACH(heap, &registered_heaps, next) {
+            if ((heap->caps[prio] & HEAP_CACHE_CAPS) != 0 && heap_caps_match(heap, HEAP_CACHE_CAPS)) {
+                n += multi_heap_malloc_batch(heap->heap, size, ptrs + n, count - n);
+                if (n == count) {
+                    break;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+/* Return cached blocks to their heaps, one batch per run of blocks from the same heap */
+IRAM_ATTR static void heap_cache_flush(void **ptrs, size_t count)
+{
+    size_t start = 0;
+    while (start < count) {
+        heap_t *heap = find_containing_heap(ptrs[start]);
+        assert(heap != NULL && "cached block is outside heap areas");
+        size_t end = start + 1;
+        while (end < count && (intptr_t)ptrs[end] >= heap->start && (intptr_t)ptrs[end] < heap->end) {
+            end++;
+        }
+        multi_heap_free_batch(heap->heap, ptrs + start, end - start);
+        start = end;
+    }
+}
+
+void heap_caps_cache_flush(void)
+{
+    heap_cache_flush_all(&s_heap_cache);
+}
+
+void heap_caps_cache_get_stats(multi_heap_cache_stats_t *stats)
+{
+    heap_cache_get_stats(&s_heap_cache, stats);
+}
+#endif
+
+#ifdef CONFIG_HEAP_AUDIO_ARENA
+void heap_caps_audio_session_begin(void)
+{
+    if (audio_arena.arena != NULL) {
+        multi_heap_arena_session_begin(audio_arena.arena);
+    }
+}
+
+size_t heap_caps_audio_session_end(void)
+{
+    if (audio_arena.arena == NULL) {
+        return 0;
+    }
+    return multi_heap_arena_session_end(audio_arena.arena);
+}
+
+void heap_caps_audio_get_info(multi_heap_arena_info_t *info)
+{
+    multi_heap_arena_get_info(audio_arena.arena, info);
+}
+#endif
+
+#ifdef CONFIG_HEAP_PROFILING
+size_t heap_caps_profile_snapshot(multi_heap_profile_site_t *sites, size_t max_sites, multi_heap_profile_stats_t *stats)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < HEAP_PROFILE_SITES && count < max_sites; i++) {
+        if (heap_profile_get_site(&s_heap_profile, i, &sites[count])) {
+            count++;
+        }
+    }
+    if (stats != NULL) {
+        heap_profile_get_stats(&s_heap_profile, stats);
+    }
+    return count;
+}
+
+void heap_caps_profile_dump(void)
+{
+    multi_heap_profile_stats_t stats;
+    multi_heap_profile_site_t site;
+
+    heap_profile_get_stats(&s_heap_profile, &stats);
+    printf("heap profile: interval %u, depth %u, %u samples, %u sites, %u live, %u dropped sites, %u dropped live\n",
+           stats.interval, stats.depth, stats.samples, stats.sites, stats.live_blocks,
+           stats.dropped_sites, stats.dropped_live);
+    //Sites are copied one at a time so that the lock is not held while printing
+    for (size_t i = 0; i < HEAP_PROFILE_SITES; i++) {
+        if (!heap_profile_get_site(&s_heap_profile, i, &site)) {
+            continue;
+        }
+        printf("HP %u %llu %u %llu", site.alloc_count, site.alloc_bytes, site.live_count, site.live_bytes);
+        for (int j = 0; j < HEAP_PROFILE_DEPTH && site.callers[j] != NULL; j++) {
+            printf("%c%p", j == 0 ? ' ' : ':', site.callers[j]);
+        }
+        printf("\n");
+    }
+}
+
+void heap_caps_profile_reset(void)
+{
+    heap_profile_reset(&s_heap_profile);
+}
+#endif
+
 IRAM_ATTR void heap_caps_free( void *ptr)
 {
     if (ptr == NULL) {
         return;
     }
 
+#ifdef CONFIG_HEAP_PROFILING
+    heap_profile_record_free(&s_heap_profile, ptr);
+#endif
+
     if (esp_ptr_in_diram_iram(ptr)) {
         //Memory allocated here is actually allocated in the DRAM alias region and
         //cannot be de-allocated as usual. dram_alloc_to_iram_addr stores a pointer to
@@ -348,9 +589,26 @@ IRAM_ATTR void heap_caps_free( void *ptr)
         ptr = (void *)dramAddrPtr[-1];
     }
 
+#ifdef CONFIG_HEAP_AUDIO_ARENA
+    if (heap_caps_in_audio_arena(ptr)) {
+        multi_heap_arena_free(audio_arena.arena, ptr);
+        CALL_HOOK(esp_heap_trace_free_hook, ptr);
+        return;
+    }
+#endif
+
     heap_t *heap = find_containing_heap(ptr);
     assert(heap != NULL && "free() target pointer is outside heap areas");
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE
+    if ((get_all_caps(heap) & HEAP_CACHE_CAPS) == HEAP_CACHE_CAPS
+            && heap_cache_free(&s_heap_cache, esp_cpu_get_core_id(), ptr, multi_heap_get_allocated_size(heap->heap, ptr))) {
+        CALL_HOOK(esp_heap_trace_free_hook, ptr);
+        return;
+    }
+#endif
     multi_heap_free(heap->heap, ptr);
+
+    CALL_HOOK(esp_heap_trace_free_hook, ptr);
 }
 
 /*
@@ -376,6 +634,22 @@ IRAM_ATTR static void *heap_caps_realloc_base( void *ptr, size_t size, uint32_t
         return NULL;
     }
 
+#ifdef CONFIG_HEAP_AUDIO_ARENA
+    if (heap_caps_in_audio_arena(ptr)) {
+        //Arena blocks never grow in place, keep the block if its size class still fits
+        size_t old_size = multi_heap_arena_get_allocated_size(audio_arena.arena, ptr);
+        if (size <= old_size && (caps & ~(AUDIO_ARENA_CAPS | MALLOC_CAP_DEFAULT)) == 0) {
+            return ptr;
+        }
+        void *new_p = heap_caps_malloc_base(size, caps);
+        if (new_p != NULL) {
+            memcpy(new_p, ptr, MIN(size, old_size));
+            heap_caps_free(ptr);
+        }
+        return new_p;
+    }
+#endif
+
     //The pointer to memory may be aliased, we need to
     //recover the corresponding address before to manage a new allocation:
     if(esp_ptr_in_diram_iram((void *)ptr)) {
@@ -404,6 +678,14 @@ IRAM_ATTR static void *heap_caps_realloc_base( void *ptr, size_t size, uint32_t
         // (which will resize the block if it can)
         void *r = multi_heap_realloc(heap->heap, ptr, size);
         if (r != NULL) {
+#ifdef CONFIG_HEAP_PROFILING
+            //Count the resized block as a new allocation, like the malloc/copy/free path below does
+            heap_profile_record_free(&s_heap_profile, ptr);
+            if (heap_profile_tick(&s_heap_profile, esp_cpu_get_core_id())) {
+                heap_profile_sample(r, size);
+            }
+#endif
+            CALL_HOOK(esp_heap_trace_alloc_hook, r, size, caps);
             return r;
         }
     }
@@ -609,6 +891,11 @@ void heap_caps_dump_all(void)
 
 size_t heap_caps_get_allocated_size( void *ptr )
 {
+#ifdef CONFIG_HEAP_AUDIO_ARENA
+    if (heap_caps_in_audio_arena(ptr)) {
+        return multi_heap_arena_get_allocated_size(audio_arena.arena, ptr);
+    }
+#endif
     heap_t *heap = find_containing_heap(ptr);
     assert(heap);
     size_t size = multi_heap_get_allocated_size(heap->heap, ptr);
@@ -654,6 +941,7 @@ IRAM_ATTR void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t
                     //Just try to alloc, nothing special.
                     ret = multi_heap_aligned_alloc(heap->heap, size, alignment);
                     if (ret != NULL) {
+                        CALL_HOOK(esp_heap_trace_alloc_hook, ret, size, caps);
                         return ret;
                     }
                 }
@@ -19,6 +19,40 @@ static const char *TAG = "heap_init";
 /* Linked-list of registered heaps */
 struct registered_heap_ll registered_heaps;
 
+#ifdef CONFIG_HEAP_AUDIO_ARENA
+heap_arena_t audio_arena;
+
+#define AUDIO_ARENA_REGION_CAPS (AUDIO_ARENA_CAPS & ~MALLOC_CAP_AUDIO)
+
+/* Take the audio arena from the end of the first internal DMA capable region that stays at least
+   as big as the arena once it is cut off, the rest of the region becomes a normal heap */
+static void carve_audio_arena(heap_t *heap, const soc_memory_type_desc_t *type)
+{
+    uint32_t all_caps = 0;
+    for (int prio = 0; prio < SOC_MEMORY_TYPE_NO_PRIOS; prio++) {
+        all_caps |= type->caps[prio];
+    }
+    if (audio_arena.arena != NULL || type->startup_stack || (all_caps & AUDIO_ARENA_REGION_CAPS) != AUDIO_ARENA_REGION_CAPS
+            || heap->end - heap->start < 2 * CONFIG_HEAP_AUDIO_ARENA_SIZE) {
+        return;
+    }
+
+    intptr_t start = (heap->end - CONFIG_HEAP_AUDIO_ARENA_SIZE) & ~3;
+    audio_arena.arena = multi_heap_arena_register((void *)start, heap->end - start);
+    if (audio_arena.arena == NULL) {
+        return;
+    }
+    audio_arena.start = start;
+    audio_arena.end = heap->end;
+    MULTI_HEAP_LOCK_INIT(&audio_arena.arena_mux);
+    multi_heap_arena_set_lock(audio_arena.arena, &audio_arena.arena_mux);
+    heap->end = start;
+    ESP_EARLY_LOGI(TAG, "Audio arena at %08X len %08X (%d KiB)",
+                   audio_arena.start, audio_arena.end - audio_arena.start,
+                   (audio_arena.end - audio_arena.start) / 1024);
+}
+#endif
+
 static void register_heap(heap_t *region)
 {
     size_t heap_size = region->end - region->start;
@@ -102,6 +136,9 @@ void heap_caps_init(void)
         heap->start = region->start;
         heap->end = region->start + region->size;
         MULTI_HEAP_LOCK_INIT(&heap->heap_mux);
+#ifdef CONFIG_HEAP_AUDIO_ARENA
+        carve_audio_arena(heap, type);
+#endif
         if (type->startup_stack) {
             /* Will be registered when OS scheduler starts */
             heap->heap = NULL;
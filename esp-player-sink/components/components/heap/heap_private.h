@@ -40,6 +40,32 @@ typedef struct heap_t_ {
 */
 extern SLIST_HEAD(registered_heap_ll, heap_t_) registered_heaps;
 
+#ifdef CONFIG_HEAP_AUDIO_ARENA
+#include "multi_heap_arena.h"
+
+/* Region carved out of internal DMA capable RAM at boot for MALLOC_CAP_AUDIO allocations.
+
+   It is not in registered_heaps, so plain allocations never land in it and the audio
+   engine always finds the arena in the state its last session left it.
+*/
+typedef struct {
+    intptr_t start;
+    intptr_t end;
+    multi_heap_lock_t arena_mux;
+    multi_heap_arena_handle_t arena;
+} heap_arena_t;
+
+extern heap_arena_t audio_arena;
+
+/* Caps of the audio arena memory: MALLOC_CAP_AUDIO, and the caps the region it is carved from must have */
+#define AUDIO_ARENA_CAPS (MALLOC_CAP_AUDIO | MALLOC_CAP_8BIT | MALLOC_CAP_32BIT | MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)
+
+inline static IRAM_ATTR bool heap_caps_in_audio_arena(const void *ptr)
+{
+    return audio_arena.arena != NULL && (intptr_t)ptr >= audio_arena.start && (intptr_t)ptr < audio_arena.end;
+}
+#endif
+
 bool heap_caps_match(const heap_t *heap, uint32_t caps);
 
 /* return all possible capabilities (across all priorities) for a given heap */
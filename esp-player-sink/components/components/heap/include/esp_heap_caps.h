@@ -35,6 +35,7 @@ extern "C" {
 #define MALLOC_CAP_IRAM_8BIT        (1<<13) ///< Memory must be in IRAM and allow unaligned access
 #define MALLOC_CAP_RETENTION        (1<<14) ///< Memory must be able to accessed by retention DMA
 #define MALLOC_CAP_RTCRAM           (1<<15) ///< Memory must be in RTC fast memory
+#define MALLOC_CAP_AUDIO            (1<<16) ///< Memory must be in the audio session arena (CONFIG_HEAP_AUDIO_ARENA)
 
 #define MALLOC_CAP_INVALID          (1<<31) ///< Memory can't be used / list end marker
 
@@ -53,6 +54,26 @@ typedef void (*esp_alloc_failed_hook_t) (size_t size, uint32_t caps, const char
  */
 esp_err_t heap_caps_register_failed_alloc_callback(esp_alloc_failed_hook_t callback);
 
+#ifdef CONFIG_HEAP_USE_HOOKS
+/**
+ * @brief callback called after every allocation
+ * @param ptr the allocated memory
+ * @param size in bytes of the allocation
+ * @param caps Bitwise OR of MALLOC_CAP_* flags indicating the type of memory allocated.
+ * @note this hook is called on the same thread as the allocation, which may be within a low level operation.
+ * You should refrain from doing heavy work, logging, flash writes, or any locking.
+ */
+__attribute__((weak)) void esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps);
+
+/**
+ * @brief callback called after every free
+ * @param ptr the memory that was freed
+ * @note this hook is called on the same thread as the allocation, which may be within a low level operation.
+ * You should refrain from doing heavy work, logging, flash writes, or any locking.
+ */
+__attribute__((weak)) void esp_heap_trace_free_hook(void* ptr);
+#endif
+
 /**
  * @brief Allocate a chunk of memory which has the given capabilities
  *
@@ -395,6 +416,88 @@ void heap_caps_dump_all(void);
  */
 size_t heap_caps_get_allocated_size( void *ptr );
 
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE
+/**
+ * @brief Return all blocks held in the per-core size class caches to their heaps
+ *
+ * Cached blocks count as allocated. Call this before heap_caps_get_free_size(),
+ * heap_caps_get_largest_free_block() or heap_caps_get_info() to get figures comparable
+ * to a build without CONFIG_HEAP_SIZE_CLASS_CACHE.
+ *
+ * Allocations flush the caches by themselves when the heaps run out of memory.
+ */
+void heap_caps_cache_flush(void);
+
+/**
+ * @brief Get the statistics of the per-core size class caches, summed over all cores
+ *
+ * @param stats Pointer to a structure which will be filled with the statistics.
+ */
+void heap_caps_cache_get_stats(multi_heap_cache_stats_t *stats);
+#endif
+
+#ifdef CONFIG_HEAP_AUDIO_ARENA
+/**
+ * @brief Start an audio session
+ *
+ * MALLOC_CAP_AUDIO allocations made from now on belong to the session and are all
+ * released by heap_caps_audio_session_end(). Allocations made outside a session
+ * stay until they are freed. Sessions do not nest.
+ */
+void heap_caps_audio_session_begin(void);
+
+/**
+ * @brief End the audio session, releasing every MALLOC_CAP_AUDIO block allocated since it began
+ *
+ * Freeing the blocks beforehand is allowed but not needed. The arena is back to the
+ * state it had when the session began, so the next session can allocate the same
+ * blocks again however the previous one freed them.
+ *
+ * @return Number of session blocks that were still allocated. They must not be used anymore.
+ */
+size_t heap_caps_audio_session_end(void);
+
+/**
+ * @brief Get the usage and fragmentation figures of the audio arena
+ *
+ * @param info Pointer to a structure which will be filled with the figures, all zero if there is no arena.
+ */
+void heap_caps_audio_get_info(multi_heap_arena_info_t *info);
+#endif
+
+#ifdef CONFIG_HEAP_PROFILING
+/**
+ * @brief Copy the call sites of the sampling allocation profiler
+ *
+ * Counts are of sampled allocations, about one in stats->interval. Sites are in no
+ * particular order.
+ *
+ * @param sites Array receiving the call sites.
+ * @param max_sites Number of entries in sites.
+ * @param stats Pointer to a structure which will be filled with the profiler state, may be NULL.
+ *
+ * @return Number of call sites copied to sites.
+ */
+size_t heap_caps_profile_snapshot(multi_heap_profile_site_t *sites, size_t max_sites, multi_heap_profile_stats_t *stats);
+
+/**
+ * @brief Print the allocation profile to stdout
+ *
+ * One "heap profile:" header line, then one line per call site:
+ * "HP <allocs> <bytes> <live allocs> <live bytes> <caller>:<caller>...", with the sampled
+ * counts and the return addresses innermost first. audiostream-host/heap_profile reads
+ * this output, scales the counts by the interval and symbolizes the callers.
+ */
+void heap_caps_profile_dump(void);
+
+/**
+ * @brief Clear all call sites and live samples of the allocation profiler
+ *
+ * Blocks sampled before the reset are no longer tracked when they are freed.
+ */
+void heap_caps_profile_reset(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
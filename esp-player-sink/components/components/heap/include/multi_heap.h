@@ -60,6 +60,29 @@ void __attribute__((deprecated)) multi_heap_aligned_free(multi_heap_handle_t hea
  */
 void multi_heap_free(multi_heap_handle_t heap, void *p);
 
+/** @brief malloc() several buffers of the same size in a given heap
+ *
+ * Equivalent to calling multi_heap_malloc() count times, but the heap lock is only taken once.
+ *
+ * @param heap Handle to a registered heap.
+ * @param size Size of each buffer.
+ * @param ptrs Array receiving the pointers to the new buffers.
+ * @param count Number of buffers to allocate.
+ *
+ * @return Number of buffers allocated, less than count if the heap ran out of memory.
+ */
+size_t multi_heap_malloc_batch(multi_heap_handle_t heap, size_t size, void **ptrs, size_t count);
+
+/** @brief free() several buffers in a given heap
+ *
+ * Equivalent to calling multi_heap_free() on each pointer, but the heap lock is only taken once.
+ *
+ * @param heap Handle to a registered heap.
+ * @param ptrs Pointers previously returned from multi_heap_malloc() or multi_heap_malloc_batch() for the same heap.
+ * @param count Number of pointers in ptrs.
+ */
+void multi_heap_free_batch(multi_heap_handle_t heap, void **ptrs, size_t count);
+
 /** @brief realloc() a buffer in a given heap.
  *
  * Semantics are the same as standard realloc(), only the argument 'p' must be NULL or have been allocated in the specified heap.
@@ -179,6 +202,57 @@ typedef struct {
  */
 void multi_heap_get_info(multi_heap_handle_t heap, multi_heap_info_t *info);
 
+/** @brief Statistics of the per-core small block cache, see heap_caps_cache_get_stats() */
+typedef struct {
+    size_t alloc_hits;            ///<  Allocations served from the cache.
+    size_t alloc_misses;          ///<  Allocations that found their size class empty and refilled it from the heap.
+    size_t refilled_blocks;       ///<  Blocks taken from the heap by refills.
+    size_t free_hits;             ///<  Frees kept in the cache.
+    size_t free_overflows;        ///<  Frees passed to the heap because the cache was over its byte limit.
+    size_t flushed_blocks;        ///<  Blocks returned to the heap from full size classes or by a flush.
+    size_t cached_bytes;          ///<  Bytes currently held in the cache, not included in the heap free size.
+} multi_heap_cache_stats_t;
+
+/** @brief Usage and fragmentation of a session arena, see heap_caps_audio_get_info() */
+typedef struct {
+    size_t total_bytes;           ///<  Bytes available for blocks, excluding the arena control structure.
+    size_t allocated_bytes;       ///<  Bytes in allocated blocks, including block headers and size class rounding.
+    size_t allocated_blocks;      ///<  Number of allocated blocks.
+    size_t free_list_bytes;       ///<  Freed blocks below the top, only reusable by allocations of their size class.
+    size_t largest_free_block;    ///<  Space above the top, the largest block that can still be allocated.
+    size_t session_bytes;         ///<  Bytes above the session start, released when the session ends.
+    size_t peak_bytes;            ///<  Highest top of the arena since it was registered.
+    size_t sessions;              ///<  Number of sessions ended.
+    size_t leaked_blocks;         ///<  Blocks still allocated when their session ended, over all sessions.
+    size_t failed_allocs;         ///<  Allocations that did not fit.
+} multi_heap_arena_info_t;
+
+/** @brief Maximum number of callers kept per call site by the allocation profiler */
+#define MULTI_HEAP_PROFILE_MAX_DEPTH 8
+
+/** @brief Counters of one call site of the sampling allocation profiler, see heap_caps_profile_snapshot()
+ *
+ * Counts are of sampled allocations only, multiply by the sampling interval to estimate the totals.
+ */
+typedef struct {
+    void *callers[MULTI_HEAP_PROFILE_MAX_DEPTH]; ///<  Return addresses of the allocation, innermost first, unused ones NULL.
+    size_t alloc_count;           ///<  Sampled allocations made from this site.
+    size_t live_count;            ///<  Sampled allocations from this site not freed yet.
+    uint64_t alloc_bytes;         ///<  Bytes requested by the sampled allocations.
+    uint64_t live_bytes;          ///<  Bytes requested by the sampled allocations not freed yet.
+} multi_heap_profile_site_t;
+
+/** @brief State of the sampling allocation profiler */
+typedef struct {
+    size_t interval;              ///<  Mean number of allocations per sample.
+    size_t depth;                 ///<  Callers recorded per call site.
+    size_t samples;               ///<  Allocations sampled since the last reset.
+    size_t sites;                 ///<  Call sites in use.
+    size_t live_blocks;           ///<  Sampled allocations not freed yet.
+    size_t dropped_sites;         ///<  Samples lost because the call site table was full.
+    size_t dropped_live;          ///<  Samples whose free will not be seen because the live table was full.
+} multi_heap_profile_stats_t;
+
 #ifdef __cplusplus
 }
 #endif
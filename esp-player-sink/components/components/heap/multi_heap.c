@@ -40,6 +40,12 @@ void multi_heap_aligned_free(multi_heap_handle_t heap, void *p)
 void multi_heap_free(multi_heap_handle_t heap, void *p)
     __attribute__((alias("multi_heap_free_impl")));
 
+size_t multi_heap_malloc_batch(multi_heap_handle_t heap, size_t size, void **ptrs, size_t count)
+    __attribute__((alias("multi_heap_malloc_batch_impl")));
+
+void multi_heap_free_batch(multi_heap_handle_t heap, void **ptrs, size_t count)
+    __attribute__((alias("multi_heap_free_batch_impl")));
+
 void *multi_heap_realloc(multi_heap_handle_t heap, void *p, size_t size)
     __attribute__((alias("multi_heap_realloc_impl")));
 
@@ -103,6 +109,28 @@ void multi_heap_in_rom_init(void)
     multi_heap_os_funcs_init(&multi_heap_os_funcs);
 }
 
+#ifndef MULTI_HEAP_POISONING
+/* The ROM implementation has no batch functions, fall back to one call per buffer */
+size_t multi_heap_malloc_batch(multi_heap_handle_t heap, size_t size, void **ptrs, size_t count)
+{
+    size_t n;
+    for (n = 0; n < count; n++) {
+        ptrs[n] = multi_heap_malloc(heap, size);
+        if (ptrs[n] == NULL) {
+            break;
+        }
+    }
+    return n;
+}
+
+void multi_heap_free_batch(multi_heap_handle_t heap, void **ptrs, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        multi_heap_free(heap, ptrs[i]);
+    }
+}
+#endif
+
 #else // CONFIG_HEAP_TLSF_USE_ROM_IMPL
 
 /* Return true if this block is free. */
@@ -139,6 +167,19 @@ size_t multi_heap_get_allocated_size_impl(multi_heap_handle_t heap, void *p)
     return tlsf_block_size(p);
 }
 
+/* Smallest leftover a split may leave, by heap size, see bench_multi_heap_tlsf.c. Larger heaps
+   do not split off leftovers too small to be reused, which only fragment the free memory. The
+   number of second level lists is left to TLSF, which already adapts it to the pool size. */
+static size_t multi_heap_split_size_min(size_t size)
+{
+    if (size <= 16 * 1024) {
+        return 0;
+    } else if (size <= 256 * 1024) {
+        return 28;
+    }
+    return 60;
+}
+
 multi_heap_handle_t multi_heap_register_impl(void *start_ptr, size_t size)
 {
     assert(start_ptr);
@@ -153,7 +194,12 @@ multi_heap_handle_t multi_heap_register_impl(void *start_ptr, size_t size)
     /* Do not specify any maximum size for the allocations so that the default configuration is used */
     const size_t max_bytes = 0;
 
-    result->heap_data = tlsf_create_with_pool(start_ptr + sizeof(heap_t), size, max_bytes);
+    const tlsf_config_t config = {
+        .sl_index_count_log2 = 0,
+        .split_size_min = multi_heap_split_size_min(size),
+    };
+
+    result->heap_data = tlsf_create_with_pool_config(start_ptr + sizeof(heap_t), size, max_bytes, &config);
     if(!result->heap_data) {
         return NULL;
     }
@@ -245,6 +291,50 @@ void multi_heap_free_impl(multi_heap_handle_t heap, void *p)
     multi_heap_internal_unlock(heap);
 }
 
+size_t multi_heap_malloc_batch_impl(multi_heap_handle_t heap, size_t size, void **ptrs, size_t count)
+{
+    if (size == 0 || heap == NULL) {
+        return 0;
+    }
+
+    size_t n;
+    multi_heap_internal_lock(heap);
+    for (n = 0; n < count; n++) {
+        void *result = tlsf_malloc(heap->heap_data, size);
+        if (result == NULL) {
+            break;
+        }
+        heap->free_bytes -= tlsf_block_size(result);
+        heap->free_bytes -= tlsf_alloc_overhead();
+        ptrs[n] = result;
+    }
+    if (heap->free_bytes < heap->minimum_free_bytes) {
+        heap->minimum_free_bytes = heap->free_bytes;
+    }
+    multi_heap_internal_unlock(heap);
+
+    return n;
+}
+
+void multi_heap_free_batch_impl(multi_heap_handle_t heap, void **ptrs, size_t count)
+{
+    if (heap == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        assert_valid_block(heap, block_from_ptr(ptrs[i]));
+    }
+
+    multi_heap_internal_lock(heap);
+    for (size_t i = 0; i < count; i++) {
+        heap->free_bytes += tlsf_block_size(ptrs[i]);
+        heap->free_bytes += tlsf_alloc_overhead();
+        tlsf_free(heap->heap_data, ptrs[i]);
+    }
+    multi_heap_internal_unlock(heap);
+}
+
 void *multi_heap_realloc_impl(multi_heap_handle_t heap, void *p, size_t size)
 {
     assert(heap != NULL);
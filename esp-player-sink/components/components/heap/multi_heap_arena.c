@@ -0,0 +1,263 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "multi_heap_arena.h"
+#include "multi_heap_platform.h"
+
+/* Note: Keep platform-specific parts in multi_heap_platform.h, this source
+   file should depend on libc only */
+
+/* Each block is preceded by a header holding its usable size, bit 0 is set while it is on a free list */
+typedef struct {
+    size_t size;
+} arena_block_t;
+
+#define ARENA_ALIGN sizeof(arena_block_t)
+#define ARENA_ALIGN_UP(X) (((X) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+#define BLOCK_FREE 1
+
+/* Size classes step by 1.5x or 2x, larger requests get a block of their exact size */
+static const uint16_t s_class_size[] = {
+    16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768,
+    1024, 1536, 2048, 3072, 4096, 6144, 8192, 12288, 16384,
+};
+
+#define ARENA_CLASSES ((int)(sizeof(s_class_size) / sizeof(s_class_size[0])))
+#define ARENA_LARGE ARENA_CLASSES
+
+/* A large free block is reused for a request of at least 3/4 of its size, it is never split */
+#define LARGE_FIT(BLOCK_SIZE, SIZE) ((SIZE) <= (BLOCK_SIZE) && (BLOCK_SIZE) - (SIZE) <= (BLOCK_SIZE) / 4)
+
+/* Blocks below the session mark and blocks above it are kept apart, so that session_end() can
+   drop the second set without looking at it and a session never reuses a persistent block */
+typedef struct {
+    void *free_lists[ARENA_CLASSES + 1];    /* last one holds large blocks */
+    size_t free_bytes;
+    size_t allocated_bytes;
+    size_t allocated_blocks;
+} arena_set_t;
+
+enum { SET_PERSISTENT, SET_SESSION };
+
+struct multi_heap_arena {
+    void *lock;
+    uint8_t *base;
+    uint8_t *top;
+    uint8_t *end;
+    uint8_t *mark;                          /* top when the session began, NULL outside a session */
+    arena_set_t sets[2];
+    size_t peak_bytes;
+    size_t sessions;
+    size_t leaked_blocks;
+    size_t failed_allocs;
+};
+
+static inline arena_block_t *block_from_ptr(void *p)
+{
+    return (arena_block_t *)p - 1;
+}
+
+static inline size_t block_size(const arena_block_t *block)
+{
+    return block->size & ~(size_t)BLOCK_FREE;
+}
+
+static inline void **block_next(arena_block_t *block)
+{
+    return (void **)(block + 1);
+}
+
+static int size_class(size_t size)
+{
+    for (int class = 0; class < ARENA_CLASSES; class++) {
+        if (size <= s_class_size[class]) {
+            return class;
+        }
+    }
+    return ARENA_LARGE;
+}
+
+static inline int block_set(multi_heap_arena_handle_t arena, arena_block_t *block)
+{
+    return (arena->mark != NULL && (uint8_t *)block >= arena->mark) ? SET_SESSION : SET_PERSISTENT;
+}
+
+multi_heap_arena_handle_t multi_heap_arena_register(void *start, size_t size)
+{
+    uintptr_t first = ARENA_ALIGN_UP((uintptr_t)start);
+    uintptr_t end = ((uintptr_t)start + size) & ~(ARENA_ALIGN - 1);
+    uintptr_t base = ARENA_ALIGN_UP(first + sizeof(struct multi_heap_arena));
+
+    if (start == NULL || end < base || end - base < sizeof(arena_block_t) + s_class_size[0]) {
+        return NULL;
+    }
+
+    multi_heap_arena_handle_t arena = (multi_heap_arena_handle_t)first;
+    memset(arena, 0, sizeof(*arena));
+    arena->base = (uint8_t *)base;
+    arena->top = arena->base;
+    arena->end = (uint8_t *)end;
+    return arena;
+}
+
+void multi_heap_arena_set_lock(multi_heap_arena_handle_t arena, void *lock)
+{
+    arena->lock = lock;
+}
+
+static void *pop_free_block(arena_set_t *set, int class, size_t size)
+{
+    void **prev = &set->free_lists[class];
+    for (arena_block_t *block = *prev; block != NULL; block = *prev) {
+        if (class != ARENA_LARGE || LARGE_FIT(block_size(block), size)) {
+            *prev = *block_next(block);
+            block->size &= ~(size_t)BLOCK_FREE;
+            set->free_bytes -= sizeof(arena_block_t) + block->size;
+            return block;
+        }
+        prev = block_next(block);
+    }
+    return NULL;
+}
+
+void *multi_heap_arena_malloc(multi_heap_arena_handle_t arena, size_t size)
+{
+    if (arena == NULL || size == 0 || size > SIZE_MAX / 2) {
+        return NULL;
+    }
+
+    int class = size_class(size);
+    size_t bsize = (class == ARENA_LARGE) ? ARENA_ALIGN_UP(size) : s_class_size[class];
+    arena_block_t *block;
+
+    MULTI_HEAP_LOCK(arena->lock);
+    arena_set_t *set = &arena->sets[arena->mark != NULL ? SET_SESSION : SET_PERSISTENT];
+    block = pop_free_block(set, class, size);
+    if (block == NULL && (size_t)(arena->end - arena->top) >= sizeof(arena_block_t) + bsize) {
+        block = (arena_block_t *)arena->top;
+        block->size = bsize;
+        arena->top += sizeof(arena_block_t) + bsize;
+        if ((size_t)(arena->top - arena->base) > arena->peak_bytes) {
+            arena->peak_bytes = arena->top - arena->base;
+        }
+    }
+    /* Out of space at the top, a free block of a larger class is better than failing. It keeps its
+       size and goes back to its own class when freed. */
+    for (int larger = class + 1; block == NULL && larger < ARENA_CLASSES; larger++) {
+        block = pop_free_block(set, larger, size);
+    }
+    if (block == NULL) {
+        arena->failed_allocs++;
+    }
+    if (block != NULL) {
+        set->allocated_bytes += sizeof(arena_block_t) + block->size;
+        set->allocated_blocks++;
+    }
+    MULTI_HEAP_UNLOCK(arena->lock);
+
+    return block != NULL ? block + 1 : NULL;
+}
+
+void multi_heap_arena_free(multi_heap_arena_handle_t arena, void *p)
+{
+    if (p == NULL) {
+        return;
+    }
+
+    arena_block_t *block = block_from_ptr(p);
+
+    MULTI_HEAP_LOCK(arena->lock);
+    MULTI_HEAP_ASSERT((uint8_t *)block >= arena->base && (uint8_t *)p < arena->top, p);
+    MULTI_HEAP_ASSERT((block->size & BLOCK_FREE) == 0, p); // double free
+    uint8_t *block_end = (uint8_t *)p + block->size;
+    MULTI_HEAP_ASSERT(block_end <= arena->top, p);
+
+    int set_index = block_set(arena, block);
+    arena_set_t *set = &arena->sets[set_index];
+    set->allocated_bytes -= sizeof(arena_block_t) + block->size;
+    set->allocated_blocks--;
+
+    /* The top never goes below the session mark, the space under it is not the session's to give back */
+    uint8_t *floor = arena->mark != NULL ? arena->mark : arena->base;
+    if (block_end == arena->top && (uint8_t *)block >= floor) {
+        arena->top = (uint8_t *)block;
+    } else {
+        int class = size_class(block->size);
+        *block_next(block) = set->free_lists[class];
+        set->free_lists[class] = block;
+        block->size |= BLOCK_FREE;
+        set->free_bytes += sizeof(arena_block_t) + block_size(block);
+    }
+    MULTI_HEAP_UNLOCK(arena->lock);
+}
+
+size_t multi_heap_arena_get_allocated_size(multi_heap_arena_handle_t arena, void *p)
+{
+    (void)arena;
+    return block_size(block_from_ptr(p));
+}
+
+void multi_heap_arena_session_begin(multi_heap_arena_handle_t arena)
+{
+    MULTI_HEAP_LOCK(arena->lock);
+    /* Sessions do not nest, a second begin keeps the first mark */
+    if (arena->mark == NULL) {
+        arena->mark = arena->top;
+    }
+    MULTI_HEAP_UNLOCK(arena->lock);
+}
+
+size_t multi_heap_arena_session_end(multi_heap_arena_handle_t arena)
+{
+    size_t leaked = 0;
+
+    MULTI_HEAP_LOCK(arena->lock);
+    if (arena->mark != NULL) {
+        leaked = arena->sets[SET_SESSION].allocated_blocks;
+        arena->leaked_blocks += leaked;
+        arena->sessions++;
+        arena->top = arena->mark;
+        arena->mark = NULL;
+        memset(&arena->sets[SET_SESSION], 0, sizeof(arena_set_t));
+    }
+    MULTI_HEAP_UNLOCK(arena->lock);
+
+    return leaked;
+}
+
+void multi_heap_arena_get_info(multi_heap_arena_handle_t arena, multi_heap_arena_info_t *info)
+{
+    memset(info, 0, sizeof(*info));
+    if (arena == NULL) {
+        return;
+    }
+
+    MULTI_HEAP_LOCK(arena->lock);
+    for (int i = 0; i < 2; i++) {
+        info->allocated_bytes += arena->sets[i].allocated_bytes;
+        info->allocated_blocks += arena->sets[i].allocated_blocks;
+        info->free_list_bytes += arena->sets[i].free_bytes;
+    }
+    info->total_bytes = arena->end - arena->base;
+    /* Requests of up to the largest class are rounded up to their class, the largest one that fits
+       above the top is the largest class size that does */
+    size_t above_top = arena->end - arena->top;
+    size_t largest = above_top > sizeof(arena_block_t) ? above_top - sizeof(arena_block_t) : 0;
+    if (largest <= s_class_size[ARENA_CLASSES - 1]) {
+        int class = size_class(largest);
+        largest = s_class_size[class] == largest ? largest : (class > 0 ? s_class_size[class - 1] : 0);
+    }
+    info->largest_free_block = largest;
+    info->session_bytes = arena->mark != NULL ? arena->top - arena->mark : 0;
+    info->peak_bytes = arena->peak_bytes;
+    info->sessions = arena->sessions;
+    info->leaked_blocks = arena->leaked_blocks;
+    info->failed_allocs = arena->failed_allocs;
+    MULTI_HEAP_UNLOCK(arena->lock);
+}
@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "multi_heap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bump/slab arena for memory whose lifetime follows a session, such as the audio engine of a connection.
+
+   Allocations are taken from the top of the arena. Freed blocks go on a free list per size class, and
+   later allocations of the same class reuse them. A block freed at the top lowers the top instead.
+   Blocks never split or merge, so a long run of sessions cannot fragment the arena.
+
+   multi_heap_arena_session_end() drops everything allocated since multi_heap_arena_session_begin() in
+   one step. Blocks allocated outside a session stay until they are freed.
+*/
+
+/** @brief Opaque handle to a registered arena */
+typedef struct multi_heap_arena *multi_heap_arena_handle_t;
+
+/* Register an arena in the memory region, the control structure is placed at its start.
+   Returns NULL if the region is too small. */
+multi_heap_arena_handle_t multi_heap_arena_register(void *start, size_t size);
+
+/* Same meaning as multi_heap_set_lock() */
+void multi_heap_arena_set_lock(multi_heap_arena_handle_t arena, void *lock);
+
+void *multi_heap_arena_malloc(multi_heap_arena_handle_t arena, size_t size);
+void multi_heap_arena_free(multi_heap_arena_handle_t arena, void *p);
+
+/* Usable size of an allocated block, the request rounded up to its size class */
+size_t multi_heap_arena_get_allocated_size(multi_heap_arena_handle_t arena, void *p);
+
+/* Start a session, blocks allocated from now on are released by multi_heap_arena_session_end() */
+void multi_heap_arena_session_begin(multi_heap_arena_handle_t arena);
+
+/* End the session, releasing all blocks allocated since it began.
+
+   Returns the number of those blocks that were still allocated, they must not be used anymore.
+*/
+size_t multi_heap_arena_session_end(multi_heap_arena_handle_t arena);
+
+void multi_heap_arena_get_info(multi_heap_arena_handle_t arena, multi_heap_arena_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,145 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "multi_heap_cache.h"
+
+/* Note: Keep platform-specific parts in multi_heap_platform.h, this source
+   file should depend on libc only */
+
+/* Size classes step by 1.5x or 2x, so rounding a request up to its class wastes less than a third */
+static const uint16_t s_class_size[HEAP_CACHE_CLASSES] = { 32, 48, 64, 96, 128, 192, 256, 384, 512 };
+
+#define NO_CLASS 0xff
+
+/* Smallest class that holds a request, indexed by (size - 1) / 16 */
+static const uint8_t s_class_fit[HEAP_CACHE_MAX_SIZE / 16] = {
+    0, 0, 1, 2, 3, 3, 4, 4,
+    5, 5, 5, 5, 6, 6, 6, 6,
+    7, 7, 7, 7, 7, 7, 7, 7,
+    8, 8, 8, 8, 8, 8, 8, 8,
+};
+
+/* Largest class a free block can serve, indexed by block size / 16 */
+static const uint8_t s_class_floor[HEAP_CACHE_MAX_SIZE / 16 + 1] = {
+    NO_CLASS, NO_CLASS, 0, 1, 2, 2, 3, 3,
+    4, 4, 4, 4, 5, 5, 5, 5,
+    6, 6, 6, 6, 6, 6, 6, 6,
+    7, 7, 7, 7, 7, 7, 7, 7,
+    8,
+};
+
+_Static_assert(HEAP_CACHE_BATCH > 0 && HEAP_CACHE_BATCH < HEAP_CACHE_DEPTH, "size class depth must be at least 2");
+
+void *heap_cache_malloc(heap_cache_t *cache, int core, size_t size)
+{
+    if (size <= HEAP_CACHE_MIN_SIZE || size > HEAP_CACHE_MAX_SIZE) {
+        return NULL;
+    }
+
+    int class = s_class_fit[(size - 1) / 16];
+    size_t class_size = s_class_size[class];
+    heap_cache_core_t *c = &cache->cores[core];
+    heap_cache_class_t *k = &c->classes[class];
+    void *result = NULL;
+
+    MULTI_HEAP_LOCK(&c->lock);
+    if (k->count > 0) {
+        c->stats.alloc_hits++;
+    } else {
+        /* Keep within the byte limit, one block is always refilled since it is handed out right away */
+        size_t batch = c->bytes < HEAP_CACHE_CORE_BYTES ? (HEAP_CACHE_CORE_BYTES - c->bytes) / class_size : 0;
+        batch = batch < 1 ? 1 : (batch > HEAP_CACHE_BATCH ? HEAP_CACHE_BATCH : batch);
+        k->count = cache->refill(class_size, k->blocks, batch);
+        c->bytes += k->count * class_size;
+        c->stats.alloc_misses++;
+        c->stats.refilled_blocks += k->count;
+    }
+    if (k->count > 0) {
+        result = k->blocks[--k->count];
+        c->bytes -= class_size;
+    }
+    MULTI_HEAP_UNLOCK(&c->lock);
+
+    return result;
+}
+
+bool heap_cache_free(heap_cache_t *cache, int core, void *p, size_t block_size)
+{
+    if (block_size / 16 >= sizeof(s_class_floor)) {
+        return false;
+    }
+    int class = s_class_floor[block_size / 16];
+    if (class == NO_CLASS) {
+        return false;
+    }
+
+    size_t class_size = s_class_size[class];
+    heap_cache_core_t *c = &cache->cores[core];
+    heap_cache_class_t *k = &c->classes[class];
+    bool cached = false;
+
+    MULTI_HEAP_LOCK(&c->lock);
+    if (k->count == HEAP_CACHE_DEPTH) {
+        /* Flush the oldest half, the blocks freed last are the most likely to still be in the data cache */
+        cache->flush(k->blocks, HEAP_CACHE_BATCH);
+        memmove(k->blocks, k->blocks + HEAP_CACHE_BATCH, (HEAP_CACHE_DEPTH - HEAP_CACHE_BATCH) * sizeof(void *));
+        k->count -= HEAP_CACHE_BATCH;
+        c->bytes -= HEAP_CACHE_BATCH * class_size;
+        c->stats.flushed_blocks += HEAP_CACHE_BATCH;
+    }
+    if (c->bytes + class_size <= HEAP_CACHE_CORE_BYTES) {
+        k->blocks[k->count++] = p;
+        c->bytes += class_size;
+        c->stats.free_hits++;
+        cached = true;
+    } else {
+        c->stats.free_overflows++;
+    }
+    MULTI_HEAP_UNLOCK(&c->lock);
+
+    return cached;
+}
+
+size_t heap_cache_flush_all(heap_cache_t *cache)
+{
+    size_t flushed = 0;
+    for (int core = 0; core < HEAP_CACHE_CORES; core++) {
+        heap_cache_core_t *c = &cache->cores[core];
+        MULTI_HEAP_LOCK(&c->lock);
+        for (int class = 0; class < HEAP_CACHE_CLASSES; class++) {
+            heap_cache_class_t *k = &c->classes[class];
+            if (k->count > 0) {
+                cache->flush(k->blocks, k->count);
+                c->stats.flushed_blocks += k->count;
+                flushed += k->count;
+                k->count = 0;
+            }
+        }
+        c->bytes = 0;
+        MULTI_HEAP_UNLOCK(&c->lock);
+    }
+    return flushed;
+}
+
+void heap_cache_get_stats(heap_cache_t *cache, multi_heap_cache_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    for (int core = 0; core < HEAP_CACHE_CORES; core++) {
+        heap_cache_core_t *c = &cache->cores[core];
+        MULTI_HEAP_LOCK(&c->lock);
+        stats->alloc_hits += c->stats.alloc_hits;
+        stats->alloc_misses += c->stats.alloc_misses;
+        stats->refilled_blocks += c->stats.refilled_blocks;
+        stats->free_hits += c->stats.free_hits;
+        stats->free_overflows += c->stats.free_overflows;
+        stats->flushed_blocks += c->stats.flushed_blocks;
+        stats->cached_bytes += c->bytes;
+        MULTI_HEAP_UNLOCK(&c->lock);
+    }
+}
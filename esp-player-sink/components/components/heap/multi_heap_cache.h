@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "multi_heap.h"
+#include "multi_heap_platform.h"
+#include "multi_heap_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-core cache of free small blocks in front of the heaps.
+
+   Every multi_heap_malloc()/multi_heap_free() takes the heap's spinlock, which both cores
+   share. The cache keeps a short stack of free blocks per size class and per core, so most
+   small allocations and frees only touch the current core's cache. Empty size classes are
+   refilled, and full ones flushed, a batch of blocks at a time with a single heap lock.
+
+   Each core's cache has its own lock. It is only contended when another core flushes all
+   caches (heap_cache_flush_all()), the normal path never takes another core's lock.
+*/
+
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE_DEPTH
+#define HEAP_CACHE_DEPTH CONFIG_HEAP_SIZE_CLASS_CACHE_DEPTH
+#else
+#define HEAP_CACHE_DEPTH 8
+#endif
+
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE_CORE_BYTES
+#define HEAP_CACHE_CORE_BYTES CONFIG_HEAP_SIZE_CLASS_CACHE_CORE_BYTES
+#else
+#define HEAP_CACHE_CORE_BYTES 4096
+#endif
+
+#ifndef HEAP_CACHE_CORES
+#ifdef MULTI_HEAP_FREERTOS
+#define HEAP_CACHE_CORES portNUM_PROCESSORS
+#else
+#define HEAP_CACHE_CORES 4
+#endif
+#endif
+
+/* Blocks moved to/from the heap at once when a size class runs empty or full */
+#define HEAP_CACHE_BATCH (HEAP_CACHE_DEPTH / 2)
+
+/* Requests of HEAP_CACHE_MIN_SIZE or less go straight to the heap, they would waste most of a 32 byte block */
+#define HEAP_CACHE_MIN_SIZE 16
+#define HEAP_CACHE_MAX_SIZE 512
+#define HEAP_CACHE_CLASSES 9
+
+/* Allocate count blocks of size bytes from the heaps, returns how many were allocated */
+typedef size_t (*heap_cache_refill_t)(size_t size, void **ptrs, size_t count);
+/* Return count blocks to the heaps they came from */
+typedef void (*heap_cache_flush_t)(void **ptrs, size_t count);
+
+typedef struct {
+    void *blocks[HEAP_CACHE_DEPTH];
+    size_t count;
+} heap_cache_class_t;
+
+typedef struct {
+    multi_heap_lock_t lock;
+    size_t bytes;
+    heap_cache_class_t classes[HEAP_CACHE_CLASSES];
+    multi_heap_cache_stats_t stats;
+} heap_cache_core_t;
+
+typedef struct {
+    heap_cache_core_t cores[HEAP_CACHE_CORES];
+    heap_cache_refill_t refill;
+    heap_cache_flush_t flush;
+} heap_cache_t;
+
+#define HEAP_CACHE_INITIALIZER(REFILL, FLUSH) {                                                     \
+        .cores = { [0 ... HEAP_CACHE_CORES - 1] = { .lock = MULTI_HEAP_LOCK_STATIC_INITIALIZER } }, \
+        .refill = (REFILL),                                                                         \
+        .flush = (FLUSH),                                                                           \
+    }
+
+/* Take a block of at least size bytes from core's cache, refilling the size class if it is empty.
+
+   Returns NULL if size is not cached or the refill failed, the caller then allocates from the heaps as usual.
+*/
+void *heap_cache_malloc(heap_cache_t *cache, int core, size_t size);
+
+/* Put a block of block_size usable bytes (multi_heap_get_allocated_size()) in core's cache.
+
+   Returns false if the block was not cached, the caller must then free it to its heap.
+*/
+bool heap_cache_free(heap_cache_t *cache, int core, void *p, size_t block_size);
+
+/* Return the blocks cached by all cores to the heaps, returns the number of blocks flushed */
+size_t heap_cache_flush_all(heap_cache_t *cache);
+
+/* Sum the statistics of all cores */
+void heap_cache_get_stats(heap_cache_t *cache, multi_heap_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -41,6 +41,8 @@ void *multi_heap_aligned_alloc_impl(multi_heap_handle_t heap, size_t size, size_
 void *multi_heap_aligned_alloc_impl_offs(multi_heap_handle_t heap, size_t size, size_t alignment, size_t offset);
 
 void multi_heap_free_impl(multi_heap_handle_t heap, void *p);
+size_t multi_heap_malloc_batch_impl(multi_heap_handle_t heap, size_t size, void **ptrs, size_t count);
+void multi_heap_free_batch_impl(multi_heap_handle_t heap, void **ptrs, size_t count);
 void *multi_heap_realloc_impl(multi_heap_handle_t heap, void *p, size_t size);
 multi_heap_handle_t multi_heap_register_impl(void *start, size_t size);
 void multi_heap_get_info_impl(multi_heap_handle_t heap, multi_heap_info_t *info);
@@ -81,11 +81,42 @@ inline static void multi_heap_assert(bool condition, const char *format, int lin
 
 #define MULTI_HEAP_PRINTF printf
 #define MULTI_HEAP_STDERR_PRINTF(MSG, ...) fprintf(stderr, MSG, __VA_ARGS__)
+
+#ifdef MULTI_HEAP_PTHREAD
+/* Host benchmarks running several threads on one heap, pthread mutexes stand in for the portmux spinlocks */
+#include <pthread.h>
+
+typedef pthread_mutex_t multi_heap_lock_t;
+
+#define MULTI_HEAP_LOCK(PLOCK) do {                         \
+        if((PLOCK) != NULL) {                               \
+            pthread_mutex_lock((PLOCK));                    \
+        }                                                   \
+    } while(0)
+
+#define MULTI_HEAP_UNLOCK(PLOCK) do {                       \
+        if ((PLOCK) != NULL) {                              \
+            pthread_mutex_unlock((PLOCK));                  \
+        }                                                   \
+    } while(0)
+
+#define MULTI_HEAP_LOCK_INIT(PLOCK) do {                    \
+        pthread_mutex_init((PLOCK), NULL);                  \
+    } while(0)
+
+#define MULTI_HEAP_LOCK_STATIC_INITIALIZER  PTHREAD_MUTEX_INITIALIZER
+
+#else // MULTI_HEAP_PTHREAD
+
+typedef int multi_heap_lock_t;
+
 #define MULTI_HEAP_LOCK(PLOCK)  (void) (PLOCK)
 #define MULTI_HEAP_UNLOCK(PLOCK)  (void) (PLOCK)
 #define MULTI_HEAP_LOCK_INIT(PLOCK)  (void) (PLOCK)
 #define MULTI_HEAP_LOCK_STATIC_INITIALIZER  0
 
+#endif // MULTI_HEAP_PTHREAD
+
 #define MULTI_HEAP_ASSERT(CONDITION, ADDRESS) assert((CONDITION) && "Heap corrupt")
 
 #define MULTI_HEAP_BLOCK_OWNER
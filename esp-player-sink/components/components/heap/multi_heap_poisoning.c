@@ -279,6 +279,29 @@ void multi_heap_free(multi_heap_handle_t heap, void *p)
     multi_heap_internal_unlock(heap);
 }
 
+size_t multi_heap_malloc_batch(multi_heap_handle_t heap, size_t size, void **ptrs, size_t count)
+{
+    size_t n;
+    multi_heap_internal_lock(heap);
+    for (n = 0; n < count; n++) {
+        ptrs[n] = multi_heap_malloc(heap, size);
+        if (ptrs[n] == NULL) {
+            break;
+        }
+    }
+    multi_heap_internal_unlock(heap);
+    return n;
+}
+
+void multi_heap_free_batch(multi_heap_handle_t heap, void **ptrs, size_t count)
+{
+    multi_heap_internal_lock(heap);
+    for (size_t i = 0; i < count; i++) {
+        multi_heap_free(heap, ptrs[i]);
+    }
+    multi_heap_internal_unlock(heap);
+}
+
 void multi_heap_aligned_free(multi_heap_handle_t heap, void *p)
 {
     multi_heap_free(heap, p);
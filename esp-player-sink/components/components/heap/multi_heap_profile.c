@@ -0,0 +1,179 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "multi_heap_profile.h"
+
+/* Note: Keep platform-specific parts in multi_heap_platform.h, this source
+   file should depend on libc only */
+
+_Static_assert(HEAP_PROFILE_DEPTH >= 1 && HEAP_PROFILE_DEPTH <= MULTI_HEAP_PROFILE_MAX_DEPTH, "bad profile depth");
+_Static_assert(HEAP_PROFILE_LIVE <= UINT16_MAX && HEAP_PROFILE_SITES <= UINT16_MAX, "profile tables too large");
+
+/* Live entry of a sample that was freed. Lookups go on past it, inserts reuse it. */
+#define LIVE_FREED ((void *)1)
+
+static inline uint32_t hash_word(uint32_t h, uintptr_t word)
+{
+    return (h ^ (uint32_t)word) * 2654435761u;
+}
+
+/* The low bits of the product only depend on the low bits of the words, fold the high ones in */
+static inline uint32_t hash_finish(uint32_t h)
+{
+    return h ^ (h >> 15);
+}
+
+static inline size_t live_index(void *p)
+{
+    /* the low bits of block addresses are always the same */
+    return hash_finish(hash_word(0, (uintptr_t)p >> 3)) % HEAP_PROFILE_LIVE;
+}
+
+static int find_site(heap_profile_t *prof, void *const *callers)
+{
+    uint32_t h = 0;
+    for (int i = 0; i < HEAP_PROFILE_DEPTH; i++) {
+        h = hash_word(h, (uintptr_t)callers[i]);
+    }
+    h = hash_finish(h);
+
+    for (int probe = 0; probe < HEAP_PROFILE_PROBES; probe++) {
+        size_t index = (h + probe) % HEAP_PROFILE_SITES;
+        multi_heap_profile_site_t *site = &prof->sites[index];
+        if (site->alloc_count == 0) {
+            memset(site, 0, sizeof(*site));
+            memcpy(site->callers, callers, HEAP_PROFILE_DEPTH * sizeof(void *));
+            prof->sites_used++;
+            return index;
+        }
+        if (memcmp(site->callers, callers, HEAP_PROFILE_DEPTH * sizeof(void *)) == 0) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+void heap_profile_record_alloc(heap_profile_t *prof, void *p, size_t size, void *const *callers)
+{
+    if (p == NULL) {
+        return;
+    }
+
+    MULTI_HEAP_LOCK(&prof->lock);
+    prof->samples++;
+    int index = find_site(prof, callers);
+    if (index < 0) {
+        prof->dropped_sites++;
+        MULTI_HEAP_UNLOCK(&prof->lock);
+        return;
+    }
+
+    multi_heap_profile_site_t *site = &prof->sites[index];
+    site->alloc_count++;
+    site->alloc_bytes += size;
+
+    size_t start = live_index(p);
+    heap_profile_live_t *slot = NULL;
+    for (int probe = 0; probe < HEAP_PROFILE_PROBES; probe++) {
+        heap_profile_live_t *entry = &prof->live[(start + probe) % HEAP_PROFILE_LIVE];
+        if (entry->ptr == NULL || entry->ptr == LIVE_FREED) {
+            slot = entry;
+            break;
+        }
+    }
+    if (slot != NULL) {
+        slot->size = size;
+        slot->site = index;
+        slot->ptr = p;  // set last, heap_profile_record_free() reads it without the lock
+        prof->live_blocks++;
+        site->live_count++;
+        site->live_bytes += size;
+    } else {
+        prof->dropped_live++;
+    }
+    MULTI_HEAP_UNLOCK(&prof->lock);
+}
+
+void heap_profile_record_free(heap_profile_t *prof, void *p)
+{
+    if (prof->live_blocks == 0) {
+        return;
+    }
+
+    /* Only the thread freeing p can remove its entry, and p cannot be sampled again before it is
+       freed, so a match found without the lock stays valid. Entries never move. */
+    size_t start = live_index(p);
+    heap_profile_live_t *entry = NULL;
+    for (int probe = 0; probe < HEAP_PROFILE_PROBES; probe++) {
+        heap_profile_live_t *e = &prof->live[(start + probe) % HEAP_PROFILE_LIVE];
+        void *e_ptr = *(void *volatile *)&e->ptr;
+        if (e_ptr == p) {
+            entry = e;
+            break;
+        }
+        if (e_ptr == NULL) {
+            return;
+        }
+    }
+    if (entry == NULL) {
+        return;
+    }
+
+    MULTI_HEAP_LOCK(&prof->lock);
+    if (entry->ptr == p) {  // heap_profile_reset() may have run in between
+        multi_heap_profile_site_t *site = &prof->sites[entry->site];
+        site->live_count--;
+        site->live_bytes -= entry->size;
+        entry->ptr = LIVE_FREED;
+        prof->live_blocks--;
+    }
+    MULTI_HEAP_UNLOCK(&prof->lock);
+}
+
+bool heap_profile_get_site(heap_profile_t *prof, size_t index, multi_heap_profile_site_t *site)
+{
+    bool used = false;
+
+    if (index >= HEAP_PROFILE_SITES) {
+        return false;
+    }
+    MULTI_HEAP_LOCK(&prof->lock);
+    if (prof->sites[index].alloc_count != 0) {
+        *site = prof->sites[index];
+        used = true;
+    }
+    MULTI_HEAP_UNLOCK(&prof->lock);
+    return used;
+}
+
+void heap_profile_get_stats(heap_profile_t *prof, multi_heap_profile_stats_t *stats)
+{
+    MULTI_HEAP_LOCK(&prof->lock);
+    stats->interval = prof->interval;
+    stats->depth = HEAP_PROFILE_DEPTH;
+    stats->samples = prof->samples;
+    stats->sites = prof->sites_used;
+    stats->live_blocks = prof->live_blocks;
+    stats->dropped_sites = prof->dropped_sites;
+    stats->dropped_live = prof->dropped_live;
+    MULTI_HEAP_UNLOCK(&prof->lock);
+}
+
+void heap_profile_reset(heap_profile_t *prof)
+{
+    MULTI_HEAP_LOCK(&prof->lock);
+    memset(prof->sites, 0, sizeof(prof->sites));
+    memset(prof->live, 0, sizeof(prof->live));
+    prof->live_blocks = 0;
+    prof->sites_used = 0;
+    prof->samples = 0;
+    prof->dropped_sites = 0;
+    prof->dropped_live = 0;
+    MULTI_HEAP_UNLOCK(&prof->lock);
+}
@@ -0,0 +1,129 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "multi_heap.h"
+#include "multi_heap_platform.h"
+#include "multi_heap_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sampling allocation profiler.
+
+   Every core counts its allocations down from a random value around HEAP_PROFILE_INTERVAL.
+   Allocations that do not reach zero cost a decrement. The one that does is recorded: its
+   callers select a call site, whose counters are updated in place, and the block is kept in
+   a table of live samples until it is freed. Each sample stands for about HEAP_PROFILE_INTERVAL
+   allocations of its site.
+
+   Memory is fixed at build time. When the site or live tables are full, samples are dropped
+   and counted in the statistics rather than evicting older data.
+
+   Frees take the lock only if the block was sampled. Checking this reads a few table entries
+   without the lock, and the entry is checked again under the lock.
+*/
+
+#ifdef CONFIG_HEAP_PROFILING_INTERVAL
+#define HEAP_PROFILE_INTERVAL CONFIG_HEAP_PROFILING_INTERVAL
+#else
+#define HEAP_PROFILE_INTERVAL 64
+#endif
+
+#ifdef CONFIG_HEAP_PROFILING_DEPTH
+#define HEAP_PROFILE_DEPTH CONFIG_HEAP_PROFILING_DEPTH
+#else
+#define HEAP_PROFILE_DEPTH 4
+#endif
+
+#ifdef CONFIG_HEAP_PROFILING_SITES
+#define HEAP_PROFILE_SITES CONFIG_HEAP_PROFILING_SITES
+#else
+#define HEAP_PROFILE_SITES 64
+#endif
+
+/* Sampled blocks that can be live at once */
+#define HEAP_PROFILE_LIVE (HEAP_PROFILE_SITES * 4)
+
+/* Table entries looked at before a site or a live sample counts as not found */
+#define HEAP_PROFILE_PROBES 8
+
+#ifndef HEAP_PROFILE_CORES
+#ifdef MULTI_HEAP_FREERTOS
+#define HEAP_PROFILE_CORES portNUM_PROCESSORS
+#else
+#define HEAP_PROFILE_CORES 4
+#endif
+#endif
+
+typedef struct {
+    uint32_t countdown;
+    uint32_t rng;
+} heap_profile_core_t;
+
+typedef struct {
+    void *ptr;
+    uint32_t size;
+    uint16_t site;
+} heap_profile_live_t;
+
+typedef struct {
+    multi_heap_lock_t lock;
+    uint32_t interval;
+    heap_profile_core_t cores[HEAP_PROFILE_CORES];
+    multi_heap_profile_site_t sites[HEAP_PROFILE_SITES];
+    heap_profile_live_t live[HEAP_PROFILE_LIVE];
+    volatile size_t live_blocks;
+    size_t sites_used;
+    size_t samples;
+    size_t dropped_sites;
+    size_t dropped_live;
+} heap_profile_t;
+
+#define HEAP_PROFILE_INITIALIZER(INTERVAL) {                                                               \
+        .lock = MULTI_HEAP_LOCK_STATIC_INITIALIZER,                                                         \
+        .interval = (INTERVAL),                                                                             \
+        .cores = { [0 ... HEAP_PROFILE_CORES - 1] = { .countdown = (INTERVAL), .rng = 0x9e3779b9 } },       \
+    }
+
+/* Count an allocation on core, returns true if it is to be sampled with heap_profile_record_alloc() */
+static inline bool heap_profile_tick(heap_profile_t *prof, int core)
+{
+    heap_profile_core_t *c = &prof->cores[core];
+    if (--c->countdown != 0) {
+        return false;
+    }
+    /* xorshift32, the next interval is uniform in [interval / 2, interval * 3 / 2) so that periodic
+       allocation patterns cannot line up with it */
+    c->rng ^= c->rng << 13;
+    c->rng ^= c->rng >> 17;
+    c->rng ^= c->rng << 5;
+    c->countdown = (prof->interval + 1) / 2 + c->rng % prof->interval;
+    return true;
+}
+
+/* Record a sampled allocation of size bytes at p. callers holds HEAP_PROFILE_DEPTH return addresses,
+   innermost first, unused ones NULL. */
+void heap_profile_record_alloc(heap_profile_t *prof, void *p, size_t size, void *const *callers);
+
+/* Called for every block freed, updates the live counters of its site if the block was sampled */
+void heap_profile_record_free(heap_profile_t *prof, void *p);
+
+/* Copy the site at index (0 <= index < HEAP_PROFILE_SITES) to site, returns false if it is unused */
+bool heap_profile_get_site(heap_profile_t *prof, size_t index, multi_heap_profile_site_t *site);
+
+void heap_profile_get_stats(heap_profile_t *prof, multi_heap_profile_stats_t *stats);
+
+/* Forget all sites and live samples. Blocks sampled before are not counted when freed. */
+void heap_profile_reset(heap_profile_t *prof);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,195 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Reconnect churn benchmark for the audio session arena (multi_heap_arena.c,
+ * CONFIG_HEAP_AUDIO_ARENA).
+ *
+ * Every reconnect allocates the audio engine again: the Opus decoder state,
+ * the packet pool and a few small control blocks, and frees them when the
+ * connection drops. In between, Wi-Fi and lwIP keep allocating and freeing
+ * blocks of 32..1600 bytes, and each connection leaves a few of them behind
+ * for a while (pcbs in TIME_WAIT, cached ARP/DHCP state).
+ *
+ * "shared" puts the audio objects in the same heap as the background traffic,
+ * "arena" gives them an arena carved out of the same memory, with a session
+ * per connection. The report shows how the largest free block of the general
+ * heap evolves and how many reconnects could not allocate the audio engine.
+ *
+ * Built by "make bench", run with "./bench_multi_heap_arena".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "multi_heap.h"
+#include "multi_heap_arena.h"
+
+#define MEMORY_SIZE     (144 * 1024)
+#define ARENA_SIZE      (48 * 1024)
+#define RECONNECTS      2000
+#define BACKGROUND      48      /* live background blocks */
+#define LINGER          6       /* background blocks each connection leaves behind */
+#define LINGER_CONNS    4       /* connections they outlive */
+#define STEPS_PER_CONN  200     /* background allocations while a connection is up */
+
+/* Audio engine of one connection, see esp-player-sink/main/audio_mem.c */
+static const size_t s_audio_objects[] = {
+    26 * 1024,          /* Opus decoder */
+    10 * 1500 + 64,     /* packet pool */
+    512, 256, 96, 96,   /* queue, timers, control blocks */
+};
+#define AUDIO_OBJECTS (sizeof(s_audio_objects) / sizeof(s_audio_objects[0]))
+
+typedef struct {
+    multi_heap_handle_t heap;
+    multi_heap_arena_handle_t arena;
+    void *background[BACKGROUND];
+    void *linger[LINGER_CONNS][LINGER];
+    unsigned seed;
+    unsigned long failed_connects;
+    unsigned long failed_background;
+    size_t min_largest;
+    size_t largest_sum;
+} run_t;
+
+static size_t background_size(unsigned *seed)
+{
+    return 32 + rand_r(seed) % 1569;
+}
+
+static void *audio_malloc(run_t *r, size_t size)
+{
+    return r->arena ? multi_heap_arena_malloc(r->arena, size) : multi_heap_malloc(r->heap, size);
+}
+
+static void audio_free(run_t *r, void *p)
+{
+    if (r->arena) {
+        multi_heap_arena_free(r->arena, p);
+    } else {
+        multi_heap_free(r->heap, p);
+    }
+}
+
+static void background_step(run_t *r)
+{
+    int slot = rand_r(&r->seed) % BACKGROUND;
+    multi_heap_free(r->heap, r->background[slot]);
+    r->background[slot] = multi_heap_malloc(r->heap, background_size(&r->seed));
+    if (r->background[slot] == NULL) {
+        r->failed_background++;
+    }
+}
+
+static void connection(run_t *r, int n)
+{
+    void *audio[AUDIO_OBJECTS] = { 0 };
+    bool ok = true;
+
+    if (r->arena) {
+        multi_heap_arena_session_begin(r->arena);
+    }
+    /* the engine comes up while the Wi-Fi stack is busy too */
+    for (size_t i = 0; i < AUDIO_OBJECTS; i++) {
+        audio[i] = audio_malloc(r, s_audio_objects[i]);
+        ok = ok && audio[i] != NULL;
+        background_step(r);
+    }
+    if (!ok) {
+        r->failed_connects++;
+    }
+    for (int i = 0; i < STEPS_PER_CONN; i++) {
+        background_step(r);
+    }
+
+    /* blocks left behind by this connection replace those of an older one */
+    void **linger = r->linger[n % LINGER_CONNS];
+    for (int i = 0; i < LINGER; i++) {
+        multi_heap_free(r->heap, linger[i]);
+        linger[i] = multi_heap_malloc(r->heap, background_size(&r->seed));
+    }
+
+    /* teardown frees in creation order, the arena gets everything back from the session end anyway */
+    for (size_t i = 0; i < AUDIO_OBJECTS; i++) {
+        if (audio[i] != NULL) {
+            audio_free(r, audio[i]);
+        }
+    }
+    if (r->arena) {
+        multi_heap_arena_session_end(r->arena);
+    }
+}
+
+static void run(bool use_arena)
+{
+    uint8_t *mem = malloc(MEMORY_SIZE);
+    run_t r = { .seed = 4321, .min_largest = SIZE_MAX };
+
+    if (use_arena) {
+        r.arena = multi_heap_arena_register(mem + MEMORY_SIZE - ARENA_SIZE, ARENA_SIZE);
+        r.heap = multi_heap_register(mem, MEMORY_SIZE - ARENA_SIZE);
+    } else {
+        r.heap = multi_heap_register(mem, MEMORY_SIZE);
+    }
+    for (int i = 0; i < BACKGROUND; i++) {
+        r.background[i] = multi_heap_malloc(r.heap, background_size(&r.seed));
+    }
+
+    size_t largest_first = 0;
+    for (int n = 0; n < RECONNECTS; n++) {
+        connection(&r, n);
+        multi_heap_info_t info;
+        multi_heap_get_info(r.heap, &info);
+        if (n == 0) {
+            largest_first = info.largest_free_block;
+        }
+        r.largest_sum += info.largest_free_block;
+        if (info.largest_free_block < r.min_largest) {
+            r.min_largest = info.largest_free_block;
+        }
+    }
+
+    multi_heap_info_t info;
+    multi_heap_get_info(r.heap, &info);
+    printf("  %-6s heap %6zu B free, largest block %6zu B after the first reconnect, %6zu B average, "
+           "%6zu B minimum, fragmentation %3zu%% at the end\n",
+           use_arena ? "arena" : "shared", info.total_free_bytes, largest_first, r.largest_sum / RECONNECTS,
+           r.min_largest, 100 - info.largest_free_block * 100 / info.total_free_bytes);
+    printf("         %lu/%d reconnects could not allocate the audio engine, %lu background allocations failed\n",
+           r.failed_connects, RECONNECTS, r.failed_background);
+    if (use_arena) {
+        multi_heap_arena_info_t ainfo;
+        multi_heap_arena_get_info(r.arena, &ainfo);
+        printf("         arena %zu B, peak %zu B, %zu sessions, %zu blocks still allocated at session end, "
+               "%zu failed allocations\n",
+               ainfo.total_bytes, ainfo.peak_bytes, ainfo.sessions, ainfo.leaked_blocks, ainfo.failed_allocs);
+        if (ainfo.allocated_blocks != 0 || ainfo.largest_free_block == 0) {
+            fprintf(stderr, "arena not empty after the last session\n");
+            exit(1);
+        }
+        /* the point of the arena: every reconnect gets its audio engine back */
+        if (r.failed_connects != 0) {
+            fprintf(stderr, "%lu reconnects could not allocate the audio engine from the arena\n", r.failed_connects);
+            exit(1);
+        }
+    }
+    if (!multi_heap_check(r.heap, true)) {
+        fprintf(stderr, "heap corrupted\n");
+        exit(1);
+    }
+    free(mem);
+}
+
+int main(void)
+{
+    printf("%d reconnects, %d KB of memory, %d KB arena, %d live background blocks, %d lingering per connection\n",
+           RECONNECTS, MEMORY_SIZE / 1024, ARENA_SIZE / 1024, BACKGROUND, LINGER);
+    run(false);
+    run(true);
+    return 0;
+}
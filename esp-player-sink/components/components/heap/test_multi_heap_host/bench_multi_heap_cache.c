@@ -0,0 +1,197 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Multi-threaded small allocation benchmark for the per-core size class cache
+ * (multi_heap_cache.c, CONFIG_HEAP_SIZE_CLASS_CACHE).
+ *
+ * Every thread stands in for one core and keeps a window of live blocks of
+ * 17..512 bytes, replacing a random one on each step, like pbufs and audio
+ * packets coming and going. The same workload runs directly on the heap, with
+ * every malloc/free taking the shared heap lock, and through the cache.
+ *
+ * The first and last byte of each block are tagged by its thread and checked
+ * before it is freed, and the heap must be back to its initial free size and
+ * pass multi_heap_check() once the cache is flushed.
+ *
+ * Built by "make bench" without the Catch test framework, run with
+ * "./bench_multi_heap_cache".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include "multi_heap.h"
+#include "multi_heap_cache.h"
+
+#define HEAP_SIZE       (256 * 1024)
+#define WINDOW          64
+#define STEPS           2000000
+#define MAX_THREADS     HEAP_CACHE_CORES
+
+static multi_heap_handle_t s_heap;
+static multi_heap_lock_t s_heap_lock = MULTI_HEAP_LOCK_STATIC_INITIALIZER;
+
+static size_t refill(size_t size, void **ptrs, size_t count)
+{
+    return multi_heap_malloc_batch(s_heap, size, ptrs, count);
+}
+
+static void flush(void **ptrs, size_t count)
+{
+    multi_heap_free_batch(s_heap, ptrs, count);
+}
+
+static heap_cache_t s_cache = HEAP_CACHE_INITIALIZER(refill, flush);
+
+typedef struct {
+    int core;
+    int cached;
+    unsigned seed;
+    unsigned long failures;
+} worker_t;
+
+/* Mostly small control blocks, some packet sized ones */
+static size_t random_size(unsigned *seed)
+{
+    unsigned r = rand_r(seed);
+    if (r % 4 == 0) {
+        return 256 + r / 4 % 257;
+    }
+    return 17 + r / 4 % 112;
+}
+
+static void tag_block(uint8_t *p, size_t size, uint8_t tag)
+{
+    p[0] = tag;
+    p[size - 1] = tag;
+}
+
+static void check_block(const uint8_t *p, size_t size, uint8_t tag)
+{
+    if (p[0] != tag || p[size - 1] != tag) {
+        fprintf(stderr, "block %p of %zu bytes overwritten by another thread\n", p, size);
+        abort();
+    }
+}
+
+static void *bench_malloc(worker_t *w, size_t size)
+{
+    if (w->cached) {
+        void *p = heap_cache_malloc(&s_cache, w->core, size);
+        if (p != NULL) {
+            return p;
+        }
+    }
+    return multi_heap_malloc(s_heap, size);
+}
+
+static void bench_free(worker_t *w, void *p)
+{
+    if (w->cached && heap_cache_free(&s_cache, w->core, p, multi_heap_get_allocated_size(s_heap, p))) {
+        return;
+    }
+    multi_heap_free(s_heap, p);
+}
+
+static void *worker(void *arg)
+{
+    worker_t *w = arg;
+    void *live[WINDOW] = { 0 };
+    size_t sizes[WINDOW] = { 0 };
+    uint8_t tag = 0x40 + w->core;
+
+    for (int i = 0; i < STEPS; i++) {
+        int slot = rand_r(&w->seed) % WINDOW;
+        if (live[slot] != NULL) {
+            check_block(live[slot], sizes[slot], tag);
+            bench_free(w, live[slot]);
+        }
+        sizes[slot] = random_size(&w->seed);
+        live[slot] = bench_malloc(w, sizes[slot]);
+        if (live[slot] == NULL) {
+            w->failures++;
+            continue;
+        }
+        tag_block(live[slot], sizes[slot], tag);
+    }
+    for (int slot = 0; slot < WINDOW; slot++) {
+        if (live[slot] != NULL) {
+            check_block(live[slot], sizes[slot], tag);
+            bench_free(w, live[slot]);
+        }
+    }
+    return NULL;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run(int threads, int cached)
+{
+    pthread_t tid[MAX_THREADS];
+    worker_t workers[MAX_THREADS];
+    size_t free_before = multi_heap_free_size(s_heap);
+
+    double t0 = now_s();
+    for (int i = 0; i < threads; i++) {
+        workers[i] = (worker_t) { .core = i, .cached = cached, .seed = 1234 + i };
+        pthread_create(&tid[i], NULL, worker, &workers[i]);
+    }
+    unsigned long failures = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tid[i], NULL);
+        failures += workers[i].failures;
+    }
+    double elapsed = now_s() - t0;
+
+    multi_heap_cache_stats_t stats;
+    heap_cache_get_stats(&s_cache, &stats);
+    size_t cached_bytes = stats.cached_bytes;
+    heap_cache_flush_all(&s_cache);
+    if (multi_heap_free_size(s_heap) != free_before || !multi_heap_check(s_heap, true)) {
+        fprintf(stderr, "heap not back to its initial state: %zu free, was %zu\n",
+                multi_heap_free_size(s_heap), free_before);
+        exit(1);
+    }
+
+    printf("  %d thread%s %-6s %7.1f ns/op", threads, threads > 1 ? "s" : " ", cached ? "cache" : "direct",
+           elapsed * 1e9 / (2.0 * STEPS * threads));
+    if (cached) {
+        size_t allocs = stats.alloc_hits + stats.alloc_misses;
+        printf("  hit rate %5.1f%%  %6zu refills  %6zu free overflows  %7zu blocks flushed  %4zu bytes cached at exit",
+               allocs ? 100.0 * stats.alloc_hits / allocs : 0.0, stats.alloc_misses, stats.free_overflows,
+               stats.flushed_blocks, cached_bytes);
+    }
+    if (failures) {
+        printf("  %lu failed allocations", failures);
+    }
+    printf("\n");
+    s_cache = (heap_cache_t) HEAP_CACHE_INITIALIZER(refill, flush);
+}
+
+int main(void)
+{
+    void *mem = malloc(HEAP_SIZE);
+    s_heap = multi_heap_register(mem, HEAP_SIZE);
+    multi_heap_set_lock(s_heap, &s_heap_lock);
+
+    printf("%d steps per thread (one free + one malloc), %d live blocks, depth %d, batch %d, %d bytes per core\n",
+           STEPS, WINDOW, HEAP_CACHE_DEPTH, HEAP_CACHE_BATCH, HEAP_CACHE_CORE_BYTES);
+    for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        run(threads, 0);
+        run(threads, 1);
+    }
+    free(mem);
+    return 0;
+}
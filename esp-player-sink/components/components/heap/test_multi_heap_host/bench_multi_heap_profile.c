@@ -0,0 +1,192 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Overhead benchmark of the sampling allocation profiler (multi_heap_profile.c,
+ * CONFIG_HEAP_PROFILING).
+ *
+ * A malloc/free mix over 24 call sites runs on one TLSF heap, the same way
+ * heap_caps_malloc()/heap_caps_free() drive the profiler: a tick per
+ * allocation, heap_profile_record_alloc() for the sampled ones and
+ * heap_profile_record_free() for every free. The first run has no profiler,
+ * the others sample at decreasing intervals. A sample records the call site of
+ * the allocation, which stands for the backtrace the firmware captures.
+ *
+ * For each interval the report shows the cost per malloc/free pair and how far
+ * the estimated bytes per call site (sampled bytes times the interval) are from
+ * the real ones, for the sites making at least 1% of the allocations.
+ *
+ * Built by "make bench", run with "./bench_multi_heap_profile".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "multi_heap.h"
+#include "multi_heap_profile.h"
+
+#define MEMORY_SIZE     (256 * 1024)
+#define SLOTS           64
+#define SITES           24
+#define OPERATIONS      2000000
+
+typedef struct {
+    void *callers[HEAP_PROFILE_DEPTH];
+    size_t min_size;
+    size_t max_size;
+    unsigned weight;            /* relative allocation frequency */
+} bench_site_t;
+
+static bench_site_t s_sites[SITES];
+static unsigned s_total_weight;
+
+static void init_sites(void)
+{
+    unsigned seed = 99;
+    for (int i = 0; i < SITES; i++) {
+        bench_site_t *site = &s_sites[i];
+        /* callers as the firmware would see them: a few allocator frames shared by all sites, then the caller */
+        site->callers[0] = (void *)0x40081000;
+        for (int d = 1; d < HEAP_PROFILE_DEPTH; d++) {
+            site->callers[d] = (void *)(uintptr_t)(0x400d0000 + i * 0x100 + d * 4);
+        }
+        site->min_size = 16 + rand_r(&seed) % 256;
+        site->max_size = site->min_size + rand_r(&seed) % 1024;
+        /* a few hot sites and a long tail, like lwIP pbufs against one-off task stacks */
+        site->weight = i < 4 ? 200 : 1 + rand_r(&seed) % 20;
+        s_total_weight += site->weight;
+    }
+}
+
+static int pick_site(unsigned *seed)
+{
+    unsigned w = rand_r(seed) % s_total_weight;
+    for (int i = 0; i < SITES; i++) {
+        if (w < s_sites[i].weight) {
+            return i;
+        }
+        w -= s_sites[i].weight;
+    }
+    return SITES - 1;
+}
+
+static uint64_t sampled_bytes(heap_profile_t *prof, int bench_site)
+{
+    multi_heap_profile_site_t site;
+    for (size_t i = 0; i < HEAP_PROFILE_SITES; i++) {
+        if (heap_profile_get_site(prof, i, &site)
+                && memcmp(site.callers, s_sites[bench_site].callers, sizeof(s_sites[bench_site].callers)) == 0) {
+            return site.alloc_bytes;
+        }
+    }
+    return 0;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* interval 0 runs without the profiler */
+static void run(heap_profile_t *prof, uint32_t interval)
+{
+    uint8_t *mem = malloc(MEMORY_SIZE);
+    multi_heap_handle_t heap = multi_heap_register(mem, MEMORY_SIZE);
+    void *slots[SLOTS] = { 0 };
+    uint64_t real_count[SITES] = { 0 };
+    uint64_t real_bytes[SITES] = { 0 };
+    unsigned seed = 1234;
+
+    memset(prof, 0, sizeof(*prof));
+    prof->interval = interval;
+    prof->cores[0].countdown = interval;
+    prof->cores[0].rng = 0x9e3779b9;
+
+    /* the random numbers of the workload are drawn up front, so that only the heap and the profiler are timed */
+    uint16_t *ops = malloc(OPERATIONS * 2 * sizeof(uint16_t));
+    for (int i = 0; i < OPERATIONS; i++) {
+        int site = pick_site(&seed);
+        bench_site_t *s = &s_sites[site];
+        ops[i * 2] = site;
+        ops[i * 2 + 1] = s->min_size + rand_r(&seed) % (s->max_size - s->min_size + 1);
+    }
+
+    double start = now_ns();
+    for (int i = 0; i < OPERATIONS; i++) {
+        int slot = i % SLOTS;
+        int site = ops[i * 2];
+        size_t size = ops[i * 2 + 1];
+
+        if (slots[slot] != NULL) {
+            if (interval != 0) {
+                heap_profile_record_free(prof, slots[slot]);
+            }
+            multi_heap_free(heap, slots[slot]);
+        }
+        slots[slot] = multi_heap_malloc(heap, size);
+        if (interval != 0 && slots[slot] != NULL && heap_profile_tick(prof, 0)) {
+            heap_profile_record_alloc(prof, slots[slot], size, s_sites[site].callers);
+        }
+        real_count[site]++;
+        real_bytes[site] += size;
+    }
+    double ns = (now_ns() - start) / OPERATIONS;
+
+    if (interval == 0) {
+        printf("  %-12s %6.1f ns per malloc/free\n", "no profiler", ns);
+    } else {
+        multi_heap_profile_stats_t stats;
+        heap_profile_get_stats(prof, &stats);
+
+        /* worst relative error of the estimated bytes over the sites making at least 1% of the allocations */
+        double worst = 0;
+        for (int i = 0; i < SITES; i++) {
+            if (real_count[i] * 100 < OPERATIONS) {
+                continue;
+            }
+            double error = ((double)sampled_bytes(prof, i) * interval - real_bytes[i]) / real_bytes[i];
+            error = error < 0 ? -error : error;
+            worst = error > worst ? error : worst;
+        }
+        char name[24];
+        snprintf(name, sizeof(name), "interval %u", (unsigned)interval);
+        printf("  %-12s %6.1f ns per malloc/free, %7zu samples, %2zu sites, worst site estimate off by %5.1f%%\n",
+               name, ns, stats.samples, stats.sites, worst * 100);
+        if (stats.dropped_sites != 0 || stats.dropped_live != 0) {
+            printf("               %zu samples dropped (site table full), %zu frees not tracked (live table full)\n",
+                   stats.dropped_sites, stats.dropped_live);
+        }
+    }
+
+    for (int i = 0; i < SLOTS; i++) {
+        multi_heap_free(heap, slots[i]);
+    }
+    if (!multi_heap_check(heap, true)) {
+        fprintf(stderr, "heap corrupted\n");
+        exit(1);
+    }
+    free(ops);
+    free(mem);
+}
+
+int main(void)
+{
+    static const uint32_t intervals[] = { 0, 1024, 256, 64, 16, 1 };
+    heap_profile_t *prof = malloc(sizeof(heap_profile_t));
+
+    init_sites();
+    printf("%d malloc/free pairs over %d call sites, %d live blocks, %d KB heap, depth %d\n",
+           OPERATIONS, SITES, SLOTS, MEMORY_SIZE / 1024, HEAP_PROFILE_DEPTH);
+    for (size_t i = 0; i < sizeof(intervals) / sizeof(intervals[0]); i++) {
+        run(prof, intervals[i]);
+    }
+    free(prof);
+    return 0;
+}
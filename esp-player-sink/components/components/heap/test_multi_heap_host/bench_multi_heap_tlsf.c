@@ -0,0 +1,217 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Benchmark of the per-heap TLSF tuning (tlsf_config_t) and of aligned
+ * allocation.
+ *
+ * "config" runs the same malloc/free churn, sizes of 16..1600 bytes spread
+ * evenly on a log scale, on heaps of several sizes, for each number of second
+ * level lists and minimum split size. For each it reports the memory taken by
+ * the TLSF control structure, the time per malloc/free pair, the bytes each
+ * live block costs on top of its request (header and rounding), failed
+ * allocations, and the fragmentation of the free memory (the share not in the
+ * largest free block) averaged over the run.
+ *
+ * "aligned" mixes the same churn with multi_heap_aligned_alloc() calls for
+ * DMA descriptors and buffers (16..64 byte alignment, 128..4092 bytes) on a
+ * heap set up by multi_heap_register(). It reports the time per aligned
+ * allocation, how many bytes they take beyond the request, failures and the
+ * fragmentation. bench_multi_heap_tlsf_nosearch is the same program with the
+ * aligned free block search of tlsf_memalign_offs() turned off, for comparison.
+ *
+ * Built by "make bench", run with "./bench_multi_heap_tlsf [config|aligned]".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "multi_heap.h"
+#include "tlsf.h"
+
+#define OPERATIONS      400000
+#define CHECK_EVERY     1000    /* operations between two fragmentation samples, not timed */
+#define MAX_SLOTS       512
+
+#ifndef TLSF_ALIGNED_SEARCH_LISTS
+#define SEARCH_NAME "aligned search"
+#else
+#define SEARCH_NAME "no aligned search"
+#endif
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* 16..1600 bytes, evenly spread on a log scale like Wi-Fi/lwIP traffic */
+static size_t churn_size(unsigned *seed)
+{
+    return (size_t)(16 * exp(log(100) * (rand_r(seed) % 10000) / 10000.0));
+}
+
+typedef struct {
+    size_t free_bytes;
+    size_t largest;
+} walk_t;
+
+static void walk_free(void *ptr, size_t size, int used, void *user)
+{
+    walk_t *w = (walk_t *)user;
+    (void)ptr;
+    if (!used) {
+        w->free_bytes += size;
+        w->largest = size > w->largest ? size : w->largest;
+    }
+}
+
+static double tlsf_fragmentation(tlsf_t tlsf)
+{
+    walk_t w = { 0 };
+    tlsf_walk_pool(tlsf_get_pool(tlsf), walk_free, &w);
+    return w.free_bytes ? 1.0 - (double)w.largest / w.free_bytes : 0;
+}
+
+static void run_config(size_t heap_size, unsigned sl_log2, size_t split_min)
+{
+    uint8_t *mem = malloc(heap_size);
+    tlsf_config_t config = { .sl_index_count_log2 = sl_log2, .split_size_min = split_min };
+    tlsf_t tlsf = tlsf_create_with_pool_config(mem, heap_size, 0, &config);
+    void *slots[MAX_SLOTS] = { 0 };
+    size_t requested[MAX_SLOTS] = { 0 };
+    /* the live blocks take about half of the heap */
+    int nslots = heap_size / 700 < MAX_SLOTS ? heap_size / 700 : MAX_SLOTS;
+    unsigned seed = 777;
+    unsigned long failed = 0;
+    double ns = 0, frag_sum = 0;
+    int frag_samples = 0;
+
+    for (int done = 0; done < OPERATIONS; done += CHECK_EVERY) {
+        double start = now_ns();
+        for (int i = 0; i < CHECK_EVERY; i++) {
+            int slot = rand_r(&seed) % nslots;
+            size_t size = churn_size(&seed);
+            tlsf_free(tlsf, slots[slot]);
+            slots[slot] = tlsf_malloc(tlsf, size);
+            requested[slot] = size;
+            failed += slots[slot] == NULL;
+        }
+        ns += now_ns() - start;
+        frag_sum += tlsf_fragmentation(tlsf);
+        frag_samples++;
+    }
+
+    size_t overhead = 0, live = 0;
+    for (int i = 0; i < nslots; i++) {
+        if (slots[i] != NULL) {
+            overhead += tlsf_block_size(slots[i]) + tlsf_alloc_overhead() - requested[i];
+            live++;
+        }
+    }
+    if (tlsf_check(tlsf) != 0) {
+        fprintf(stderr, "heap corrupted\n");
+        exit(1);
+    }
+    printf("  %4zu KB  sl %u (%2u lists)  split min %2zu  control %5zu B  %6.1f ns  %5.1f B/block  "
+           "%5lu failed  fragmentation %4.1f%%\n",
+           heap_size / 1024, sl_log2, 1u << sl_log2, split_min ? split_min : tlsf_block_size_min(),
+           tlsf_size(tlsf), ns / OPERATIONS, live ? (double)overhead / live : 0, failed,
+           100 * frag_sum / frag_samples);
+    free(mem);
+}
+
+static void run_aligned(void)
+{
+    const size_t heap_size = 128 * 1024;
+    const int nslots = 160;
+    uint8_t *mem = malloc(heap_size);
+    multi_heap_handle_t heap = multi_heap_register(mem, heap_size);
+    void *slots[MAX_SLOTS] = { 0 };
+    size_t requested[MAX_SLOTS] = { 0 };
+    bool aligned[MAX_SLOTS] = { 0 };
+    unsigned seed = 4242;
+    unsigned long aligned_allocs = 0, aligned_failed = 0, malloc_failed = 0;
+    double aligned_ns = 0, frag_sum = 0;
+    int frag_samples = 0;
+    size_t aligned_overhead = 0, aligned_live = 0;
+
+    for (int done = 0; done < OPERATIONS; done += CHECK_EVERY) {
+        for (int i = 0; i < CHECK_EVERY; i++) {
+            int slot = rand_r(&seed) % nslots;
+            multi_heap_free(heap, slots[slot]);
+            /* one in four allocations is a DMA descriptor or buffer */
+            aligned[slot] = rand_r(&seed) % 4 == 0;
+            if (aligned[slot]) {
+                size_t alignment = 16 << (rand_r(&seed) % 3);
+                size_t size = 128 + (rand_r(&seed) % 3965 & ~3);
+                double start = now_ns();
+                slots[slot] = multi_heap_aligned_alloc(heap, size, alignment);
+                aligned_ns += now_ns() - start;
+                aligned_allocs++;
+                requested[slot] = size;
+                if (slots[slot] == NULL) {
+                    aligned_failed++;
+                } else if ((uintptr_t)slots[slot] % alignment != 0) {
+                    fprintf(stderr, "%p not aligned to %zu\n", slots[slot], alignment);
+                    exit(1);
+                }
+            } else {
+                requested[slot] = churn_size(&seed);
+                slots[slot] = multi_heap_malloc(heap, requested[slot]);
+                malloc_failed += slots[slot] == NULL;
+            }
+        }
+        multi_heap_info_t info;
+        multi_heap_get_info(heap, &info);
+        frag_sum += 1.0 - (double)info.largest_free_block / info.total_free_bytes;
+        frag_samples++;
+    }
+
+    for (int i = 0; i < nslots; i++) {
+        if (slots[i] != NULL && aligned[i]) {
+            aligned_overhead += multi_heap_get_allocated_size(heap, slots[i]) - requested[i];
+            aligned_live++;
+        }
+    }
+    if (!multi_heap_check(heap, true)) {
+        fprintf(stderr, "heap corrupted\n");
+        exit(1);
+    }
+    printf("  %-18s %6.1f ns per aligned alloc, %6.1f B beyond the request, %lu/%lu aligned and %lu other "
+           "allocations failed, fragmentation %4.1f%%\n",
+           SEARCH_NAME, aligned_ns / aligned_allocs, aligned_live ? (double)aligned_overhead / aligned_live : 0,
+           aligned_failed, aligned_allocs, malloc_failed, 100 * frag_sum / frag_samples);
+    free(mem);
+}
+
+int main(int argc, char **argv)
+{
+    static const size_t heap_sizes[] = { 12 * 1024, 48 * 1024, 128 * 1024, 300 * 1024 };
+    static const size_t split_mins[] = { 0, 28, 60 };
+    bool config = argc < 2 || strcmp(argv[1], "config") == 0;
+    bool aligned = argc < 2 || strcmp(argv[1], "aligned") == 0;
+
+    if (config) {
+        printf("config: %d malloc/free pairs, live blocks take half of the heap\n", OPERATIONS);
+        for (size_t h = 0; h < sizeof(heap_sizes) / sizeof(heap_sizes[0]); h++) {
+            for (unsigned sl = 3; sl <= 5; sl++) {
+                for (size_t s = 0; s < sizeof(split_mins) / sizeof(split_mins[0]); s++) {
+                    run_config(heap_sizes[h], sl, split_mins[s]);
+                }
+            }
+        }
+    }
+    if (aligned) {
+        printf("aligned: %d allocations on a 128 KB heap, one in four aligned to 16..64 bytes\n", OPERATIONS);
+        run_aligned();
+    }
+    return 0;
+}
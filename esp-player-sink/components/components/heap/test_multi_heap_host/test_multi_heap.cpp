@@ -1,5 +1,8 @@
 #include "catch.hpp"
 #include "multi_heap.h"
+#include "../multi_heap_cache.h"
+#include "../multi_heap_arena.h"
+#include "../multi_heap_profile.h"
 
 #include "../multi_heap_config.h"
 #include "../tlsf/tlsf.h"
@@ -615,3 +618,441 @@ TEST_CASE("multi_heap poisoning detection", "[multi_heap]")
         REQUIRE(is_heap_ok == true);
     }
 }
+
+TEST_CASE("multi_heap malloc/free batch", "[multi_heap]")
+{
+    uint8_t small_heap[4 * 1024];
+    multi_heap_handle_t heap = multi_heap_register(small_heap, sizeof(small_heap));
+    size_t free_before = multi_heap_free_size(heap);
+    void *p[64];
+
+    /* 64 blocks of 100 bytes don't fit, the batch stops when the heap runs out */
+    size_t n = multi_heap_malloc_batch(heap, 100, p, 64);
+    REQUIRE( n > 0 );
+    REQUIRE( n < 64 );
+    REQUIRE( multi_heap_malloc(heap, 100) == NULL );
+    for (size_t i = 0; i < n; i++) {
+        REQUIRE( multi_heap_get_allocated_size(heap, p[i]) >= 100 );
+        memset(p[i], i, 100);
+    }
+    REQUIRE( multi_heap_check(heap, true) );
+
+    multi_heap_free_batch(heap, p, n);
+    REQUIRE( multi_heap_free_size(heap) == free_before );
+    REQUIRE( multi_heap_check(heap, true) );
+}
+
+/* The size class cache is only used with heap poisoning disabled (CONFIG_HEAP_SIZE_CLASS_CACHE depends on it),
+   poisoned blocks report their allocated size including the canaries */
+#ifndef MULTI_HEAP_POISONING
+static multi_heap_handle_t cache_heap;
+
+static size_t cache_refill(size_t size, void **ptrs, size_t count)
+{
+    return multi_heap_malloc_batch(cache_heap, size, ptrs, count);
+}
+
+static void cache_flush(void **ptrs, size_t count)
+{
+    multi_heap_free_batch(cache_heap, ptrs, count);
+}
+
+static bool cache_free(heap_cache_t *cache, int core, void *p)
+{
+    return heap_cache_free(cache, core, p, multi_heap_get_allocated_size(cache_heap, p));
+}
+
+TEST_CASE("multi_heap size class cache", "[multi_heap]")
+{
+    uint8_t small_heap[16 * 1024];
+    cache_heap = multi_heap_register(small_heap, sizeof(small_heap));
+    size_t free_before = multi_heap_free_size(cache_heap);
+    multi_heap_cache_stats_t stats;
+
+    heap_cache_t cache;
+    memset(&cache, 0, sizeof(cache));
+    cache.refill = cache_refill;
+    cache.flush = cache_flush;
+
+    /* sizes outside the size classes are not cached */
+    REQUIRE( heap_cache_malloc(&cache, 0, HEAP_CACHE_MIN_SIZE) == NULL );
+    REQUIRE( heap_cache_malloc(&cache, 0, HEAP_CACHE_MAX_SIZE + 1) == NULL );
+
+    /* the first allocation refills a batch of the 128 byte class, the next one is a hit */
+    void *a = heap_cache_malloc(&cache, 0, 100);
+    REQUIRE( a != NULL );
+    REQUIRE( multi_heap_get_allocated_size(cache_heap, a) >= 128 );
+    void *b = heap_cache_malloc(&cache, 0, 128);
+    REQUIRE( b != NULL );
+    REQUIRE( b != a );
+    heap_cache_get_stats(&cache, &stats);
+    REQUIRE( stats.alloc_misses == 1 );
+    REQUIRE( stats.alloc_hits == 1 );
+    REQUIRE( stats.refilled_blocks == HEAP_CACHE_BATCH );
+    REQUIRE( stats.cached_bytes == (HEAP_CACHE_BATCH - 2) * 128 );
+
+    /* freed blocks come back last in first out, from the cache of the core that freed them */
+    REQUIRE( cache_free(&cache, 1, a) );
+    REQUIRE( heap_cache_malloc(&cache, 1, 120) == a );
+    REQUIRE( cache_free(&cache, 0, a) );
+    REQUIRE( heap_cache_malloc(&cache, 0, 97) == a );
+
+    /* blocks smaller than the smallest class go to the heap */
+    void *tiny = multi_heap_malloc(cache_heap, 8);
+    REQUIRE( !cache_free(&cache, 0, tiny) );
+    multi_heap_free(cache_heap, tiny);
+
+    /* a full size class flushes its oldest half to the heap */
+    void *p[HEAP_CACHE_DEPTH + 1];
+    REQUIRE( multi_heap_malloc_batch(cache_heap, 32, p, HEAP_CACHE_DEPTH + 1) == HEAP_CACHE_DEPTH + 1 );
+    for (int i = 0; i < HEAP_CACHE_DEPTH + 1; i++) {
+        REQUIRE( cache_free(&cache, 2, p[i]) );
+    }
+    heap_cache_get_stats(&cache, &stats);
+    REQUIRE( stats.flushed_blocks == HEAP_CACHE_BATCH );
+    REQUIRE( heap_cache_malloc(&cache, 2, 32) == p[HEAP_CACHE_DEPTH] );
+
+    /* a core over its byte limit passes frees to the heap */
+    const int big_blocks = HEAP_CACHE_CORE_BYTES / HEAP_CACHE_MAX_SIZE;
+    void *big[big_blocks];
+    REQUIRE( multi_heap_malloc_batch(cache_heap, HEAP_CACHE_MAX_SIZE, big, big_blocks) == (size_t)big_blocks );
+    for (int i = 0; i < big_blocks; i++) {
+        REQUIRE( cache_free(&cache, 3, big[i]) );
+    }
+    void *c = multi_heap_malloc(cache_heap, 64);
+    REQUIRE( !cache_free(&cache, 3, c) );
+    multi_heap_free(cache_heap, c);
+    heap_cache_get_stats(&cache, &stats);
+    REQUIRE( stats.free_overflows == 1 );
+
+    /* everything is back in the heap once the cache is flushed */
+    REQUIRE( cache_free(&cache, 0, a) );
+    REQUIRE( cache_free(&cache, 0, b) );
+    REQUIRE( cache_free(&cache, 2, p[HEAP_CACHE_DEPTH]) );
+    REQUIRE( heap_cache_flush_all(&cache) > 0 );
+    heap_cache_get_stats(&cache, &stats);
+    REQUIRE( stats.cached_bytes == 0 );
+    REQUIRE( multi_heap_free_size(cache_heap) == free_before );
+    REQUIRE( multi_heap_check(cache_heap, true) );
+}
+#endif
+
+TEST_CASE("multi_heap arena", "[multi_heap]")
+{
+    uint8_t arena_mem[8 * 1024] __attribute__((aligned(8)));
+    REQUIRE( multi_heap_arena_register(arena_mem, 32) == NULL );
+    multi_heap_arena_handle_t arena = multi_heap_arena_register(arena_mem, sizeof(arena_mem));
+    REQUIRE( arena != NULL );
+    multi_heap_arena_info_t info;
+    multi_heap_arena_get_info(arena, &info);
+    const size_t empty_largest = info.largest_free_block;
+    REQUIRE( empty_largest == 6144 );
+
+    REQUIRE( multi_heap_arena_malloc(arena, 0) == NULL );
+
+    /* requests are rounded up to their size class */
+    void *a = multi_heap_arena_malloc(arena, 100);
+    void *b = multi_heap_arena_malloc(arena, 20);
+    REQUIRE( a != NULL );
+    REQUIRE( b != NULL );
+    REQUIRE( ((uintptr_t)a & (sizeof(void *) - 1)) == 0 );
+    REQUIRE( multi_heap_arena_get_allocated_size(arena, a) == 128 );
+    REQUIRE( multi_heap_arena_get_allocated_size(arena, b) == 24 );
+    memset(a, 0xaa, 100);
+    memset(b, 0xbb, 20);
+
+    /* a block below the top goes on its class free list and comes back for a request of the same class */
+    multi_heap_arena_free(arena, a);
+    multi_heap_arena_get_info(arena, &info);
+    REQUIRE( info.free_list_bytes > 128 );
+    REQUIRE( multi_heap_arena_malloc(arena, 97) == a );
+    void *c = multi_heap_arena_malloc(arena, 200);
+    REQUIRE( c != a );
+
+    /* freeing the top block lowers the top, the space is reused by any size class */
+    void *top = multi_heap_arena_malloc(arena, 1000);
+    multi_heap_arena_free(arena, top);
+    multi_heap_arena_get_info(arena, &info);
+    REQUIRE( info.free_list_bytes == 0 );
+    REQUIRE( multi_heap_arena_malloc(arena, 600) == top );
+    multi_heap_arena_free(arena, top);
+
+    /* a session releases everything allocated since it began, freed or not */
+    multi_heap_arena_get_info(arena, &info);
+    size_t largest = info.largest_free_block;
+    size_t blocks = info.allocated_blocks;
+    multi_heap_arena_session_begin(arena);
+    void *s1 = multi_heap_arena_malloc(arena, 3000);
+    void *s2 = multi_heap_arena_malloc(arena, 64);
+    void *s3 = multi_heap_arena_malloc(arena, 64);
+    REQUIRE( s1 != NULL );
+    REQUIRE( s2 != NULL );
+    REQUIRE( s3 != NULL );
+    /* a session never reuses a persistent free block, it would outlive the session */
+    multi_heap_arena_free(arena, b);
+    REQUIRE( multi_heap_arena_malloc(arena, 20) != b );
+    multi_heap_arena_free(arena, s2);
+    multi_heap_arena_get_info(arena, &info);
+    REQUIRE( info.session_bytes > 3000 );
+    REQUIRE( multi_heap_arena_session_end(arena) == 3 );
+    multi_heap_arena_get_info(arena, &info);
+    REQUIRE( info.largest_free_block == largest );
+    REQUIRE( info.allocated_blocks == blocks - 1 );
+    REQUIRE( info.session_bytes == 0 );
+    REQUIRE( info.sessions == 1 );
+    REQUIRE( info.leaked_blocks == 3 );
+
+    /* the persistent free block is still there outside the session */
+    REQUIRE( multi_heap_arena_malloc(arena, 24) == b );
+
+    /* allocations fail cleanly once the arena is full */
+    REQUIRE( multi_heap_arena_malloc(arena, sizeof(arena_mem)) == NULL );
+    multi_heap_arena_get_info(arena, &info);
+    REQUIRE( info.failed_allocs == 1 );
+
+    /* with the top used up, a request falls back to a free block of a larger class */
+    while (info.largest_free_block > 0) {
+        REQUIRE( multi_heap_arena_malloc(arena, info.largest_free_block) != NULL );
+        multi_heap_arena_get_info(arena, &info);
+    }
+    multi_heap_arena_free(arena, c);
+    REQUIRE( multi_heap_arena_malloc(arena, 100) == c );
+    REQUIRE( multi_heap_arena_get_allocated_size(arena, c) == 256 );
+    REQUIRE( multi_heap_arena_malloc(arena, 100) == NULL );
+}
+
+/* Reconnects allocate the decoder and packet buffers again and again, in between a session frees its
+   blocks in random order. The arena must give the same space back to every session. Random sizes strand
+   blocks on the free lists of their size classes, a session of this test peaks around 64KB. */
+TEST_CASE("multi_heap arena reconnect churn", "[multi_heap]")
+{
+    const size_t arena_size = 96 * 1024;
+    uint8_t *arena_mem = (uint8_t *) __malloc__(arena_size);
+    multi_heap_arena_handle_t arena = multi_heap_arena_register(arena_mem, arena_size);
+    REQUIRE( arena != NULL );
+
+    /* blocks allocated before the first session stay across all of them */
+    void *persistent = multi_heap_arena_malloc(arena, 2000);
+    REQUIRE( persistent != NULL );
+    multi_heap_arena_info_t info;
+    multi_heap_arena_get_info(arena, &info);
+    const size_t start_largest = info.largest_free_block;
+
+    const int NUM_POINTERS = 16;
+    for (int session = 0; session < 500; session++) {
+        multi_heap_arena_session_begin(arena);
+        uint8_t *decoder = (uint8_t *) multi_heap_arena_malloc(arena, 26 * 1024);
+        REQUIRE( decoder != NULL );
+        memset(decoder, session, 26 * 1024);
+
+        void *p[NUM_POINTERS] = { 0 };
+        size_t s[NUM_POINTERS] = { 0 };
+        for (int i = 0; i < 400; i++) {
+            int n = rand() % NUM_POINTERS;
+            if (p[n] != NULL) {
+                REQUIRE( ((uint8_t *)p[n])[0] == (uint8_t)n );
+                REQUIRE( ((uint8_t *)p[n])[s[n] - 1] == (uint8_t)n );
+                multi_heap_arena_free(arena, p[n]);
+            }
+            s[n] = (rand() % 1500) + 1;
+            p[n] = multi_heap_arena_malloc(arena, s[n]);
+            REQUIRE( p[n] != NULL );
+            memset(p[n], n, s[n]);
+        }
+        /* the decoder was not overwritten by any packet buffer */
+        REQUIRE( decoder[0] == (uint8_t)session );
+        REQUIRE( decoder[26 * 1024 - 1] == (uint8_t)session );
+
+        /* only some of the blocks are freed, the session end takes care of the rest */
+        for (int n = 0; n < NUM_POINTERS; n += 2) {
+            multi_heap_arena_free(arena, p[n]);
+        }
+        multi_heap_arena_session_end(arena);
+
+        multi_heap_arena_get_info(arena, &info);
+        REQUIRE( info.largest_free_block == start_largest );
+        REQUIRE( info.allocated_blocks == 1 );
+        REQUIRE( info.free_list_bytes == 0 );
+    }
+    REQUIRE( info.failed_allocs == 0 );
+    REQUIRE( info.sessions == 500 );
+
+    multi_heap_arena_free(arena, persistent);
+    multi_heap_arena_get_info(arena, &info);
+    REQUIRE( info.allocated_bytes == 0 );
+    __free__(arena_mem);
+}
+
+static bool profile_find_site(heap_profile_t *prof, void *const *callers, multi_heap_profile_site_t *site)
+{
+    for (size_t i = 0; i < HEAP_PROFILE_SITES; i++) {
+        if (heap_profile_get_site(prof, i, site)
+                && memcmp(site->callers, callers, HEAP_PROFILE_DEPTH * sizeof(void *)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST_CASE("multi_heap sampling profiler", "[multi_heap]")
+{
+    heap_profile_t *prof = (heap_profile_t *)__malloc__(sizeof(heap_profile_t));
+    memset(prof, 0, sizeof(*prof));
+    prof->interval = 1;
+    for (int i = 0; i < HEAP_PROFILE_CORES; i++) {
+        prof->cores[i].countdown = 1;
+    }
+    multi_heap_profile_stats_t stats;
+    multi_heap_profile_site_t site;
+
+    /* blocks are only used as addresses, the profiler never touches their memory */
+    static uint8_t blocks[(HEAP_PROFILE_LIVE + 16) * 16];
+    void *site_a[HEAP_PROFILE_DEPTH] = { (void *)0x400d1000, (void *)0x400d2000 };
+    void *site_b[HEAP_PROFILE_DEPTH] = { (void *)0x400d1000, (void *)0x400d3000 };
+
+    /* an interval of 1 samples every allocation */
+    for (int i = 0; i < 3; i++) {
+        REQUIRE( heap_profile_tick(prof, 0) );
+        heap_profile_record_alloc(prof, blocks + i * 16, 100 * (i + 1), site_a);
+    }
+    REQUIRE( heap_profile_tick(prof, 1) );
+    heap_profile_record_alloc(prof, blocks + 3 * 16, 50, site_b);
+
+    heap_profile_get_stats(prof, &stats);
+    REQUIRE( stats.samples == 4 );
+    REQUIRE( stats.sites == 2 );
+    REQUIRE( stats.live_blocks == 4 );
+    REQUIRE( stats.depth == HEAP_PROFILE_DEPTH );
+
+    REQUIRE( profile_find_site(prof, site_a, &site) );
+    REQUIRE( site.alloc_count == 3 );
+    REQUIRE( site.alloc_bytes == 600 );
+    REQUIRE( site.live_count == 3 );
+
+    /* freeing a sampled block updates the live counters of its site only, other frees are ignored */
+    heap_profile_record_free(prof, blocks + 16);
+    heap_profile_record_free(prof, blocks + 16);
+    heap_profile_record_free(prof, blocks + 8 * 16);
+    REQUIRE( profile_find_site(prof, site_a, &site) );
+    REQUIRE( site.alloc_count == 3 );
+    REQUIRE( site.live_count == 2 );
+    REQUIRE( site.live_bytes == 400 );
+    REQUIRE( profile_find_site(prof, site_b, &site) );
+    REQUIRE( site.live_count == 1 );
+
+    /* a freed entry is reused by the next sample */
+    heap_profile_record_alloc(prof, blocks + 16, 24, site_b);
+    heap_profile_record_free(prof, blocks + 3 * 16);
+    heap_profile_get_stats(prof, &stats);
+    REQUIRE( stats.live_blocks == 3 );
+    REQUIRE( profile_find_site(prof, site_b, &site) );
+    REQUIRE( site.alloc_count == 2 );
+    REQUIRE( site.live_count == 1 );
+    REQUIRE( site.live_bytes == 24 );
+
+    /* full tables drop samples instead of evicting what was recorded */
+    for (uintptr_t i = 0; i < HEAP_PROFILE_SITES + 16; i++) {
+        void *callers[HEAP_PROFILE_DEPTH] = { (void *)(0x400e0000 + i * 4) };
+        heap_profile_record_alloc(prof, blocks + 4 * 16, 8, callers);
+        heap_profile_record_free(prof, blocks + 4 * 16);
+    }
+    for (int i = 4; i < HEAP_PROFILE_LIVE + 16; i++) {
+        heap_profile_record_alloc(prof, blocks + i * 16, 16, site_a);
+    }
+    heap_profile_get_stats(prof, &stats);
+    REQUIRE( stats.sites + stats.dropped_sites == 2 + HEAP_PROFILE_SITES + 16 );
+    REQUIRE( stats.dropped_sites > 0 );
+    REQUIRE( stats.dropped_live > 0 );
+    REQUIRE( stats.live_blocks <= HEAP_PROFILE_LIVE );
+    REQUIRE( profile_find_site(prof, site_a, &site) );
+    REQUIRE( site.live_count == stats.live_blocks - 1 );
+
+    heap_profile_reset(prof);
+    heap_profile_get_stats(prof, &stats);
+    REQUIRE( stats.samples == 0 );
+    REQUIRE( stats.sites == 0 );
+    REQUIRE( stats.live_blocks == 0 );
+    REQUIRE( !profile_find_site(prof, site_a, &site) );
+    heap_profile_record_free(prof, blocks);
+
+    /* the sampling interval varies around its mean */
+    prof->interval = 16;
+    prof->cores[0].countdown = 16;
+    prof->cores[0].rng = 0x9e3779b9;
+    int sampled = 0;
+    for (int i = 0; i < 16000; i++) {
+        sampled += heap_profile_tick(prof, 0);
+    }
+    REQUIRE( sampled > 900 );
+    REQUIRE( sampled < 1100 );
+
+    __free__(prof);
+}
+
+TEST_CASE("multi_heap TLSF configuration and aligned search", "[multi_heap]")
+{
+    static uint8_t mem[16 * 1024];
+    tlsf_config_t config = { .sl_index_count_log2 = 6, .split_size_min = 0 };
+    REQUIRE( tlsf_create_with_pool_config(mem, sizeof(mem), 0, &config) == NULL );
+
+    /* a leftover smaller than the minimum split size stays in the allocated block */
+    for (size_t split_min = 0; split_min <= 64; split_min += 64) {
+        config.sl_index_count_log2 = 3;
+        config.split_size_min = split_min;
+        tlsf_t tlsf = tlsf_create_with_pool_config(mem, sizeof(mem), 0, &config);
+        REQUIRE( tlsf != NULL );
+        void *a = tlsf_malloc(tlsf, 200);
+        void *guard = tlsf_malloc(tlsf, 200);
+        REQUIRE( tlsf_block_size(a) == 200 );
+        tlsf_free(tlsf, a);
+        void *b = tlsf_malloc(tlsf, 168);
+        REQUIRE( b == a );
+        REQUIRE( tlsf_block_size(b) == (split_min ? 200 : 168) );
+        tlsf_free(tlsf, b);
+        tlsf_free(tlsf, guard);
+#ifndef MULTI_HEAP_POISONING_SLOW
+        /* with comprehensive poisoning, tlsf_check() expects free blocks filled by multi_heap, which
+           tlsf_free() does not do */
+        REQUIRE( tlsf_check(tlsf) == 0 );
+#endif
+    }
+
+    multi_heap_handle_t heap = multi_heap_register(mem, sizeof(mem));
+
+    /* a free block already aligned is taken as is, without over-allocating and splitting */
+    void *a = multi_heap_aligned_alloc(heap, 256, 64);
+    void *guard = multi_heap_malloc(heap, 32);
+    REQUIRE( ((intptr_t)a & 63) == 0 );
+    multi_heap_free(heap, a);
+    void *b = multi_heap_aligned_alloc(heap, 256, 64);
+    REQUIRE( b == a );
+    multi_heap_free(heap, b);
+    multi_heap_free(heap, guard);
+
+    /* mixed aligned and plain allocations keep the heap consistent */
+    void *slots[32] = { 0 };
+    unsigned seed = 47;
+    for (int i = 0; i < 4000; i++) {
+        int slot = rand_r(&seed) % 32;
+        multi_heap_free(heap, slots[slot]);
+        size_t size = 16 + rand_r(&seed) % 400;
+        if (rand_r(&seed) % 2) {
+            size_t alignment = 8 << (rand_r(&seed) % 4);
+            slots[slot] = multi_heap_aligned_alloc(heap, size, alignment);
+            if (slots[slot] != NULL) {
+                REQUIRE( ((intptr_t)slots[slot] & (alignment - 1)) == 0 );
+            }
+        } else {
+            slots[slot] = multi_heap_malloc(heap, size);
+        }
+        if (slots[slot] != NULL) {
+            REQUIRE( multi_heap_get_allocated_size(heap, slots[slot]) >= size );
+            memset(slots[slot], 0xA5, size);
+        }
+    }
+    REQUIRE( multi_heap_check(heap, true) );
+    for (int i = 0; i < 32; i++) {
+        multi_heap_free(heap, slots[i]);
+    }
+    REQUIRE( multi_heap_check(heap, true) );
+}
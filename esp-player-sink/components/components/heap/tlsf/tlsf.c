@@ -388,9 +388,10 @@ static inline __attribute__((always_inline)) void block_insert(control_t* contro
 	insert_free_block(control, block, fl, sl);
 }
 
-static inline __attribute__((always_inline)) int block_can_split(block_header_t* block, size_t size)
+/* Splitting off the first `size` bytes leaves a free block of at least `remain_min` bytes. */
+static inline __attribute__((always_inline)) int block_can_split(block_header_t* block, size_t size, size_t remain_min)
 {
-	return block_size(block) >= sizeof(block_header_t) + size;
+	return block_size(block) >= size + block_header_overhead + remain_min;
 }
 
 /* Split a block into two, the second of which is free. */
@@ -494,7 +495,7 @@ static inline __attribute__((always_inline)) block_header_t* block_merge_next(co
 static inline __attribute__((always_inline)) void block_trim_free(control_t* control, block_header_t* block, size_t size)
 {
 	tlsf_assert(block_is_free(block) && "block must be free");
-	if (block_can_split(block, size))
+	if (block_can_split(block, size, control->split_size_min))
 	{
 		block_header_t* remaining_block = block_split(block, size);
 		block_link_next(block);
@@ -507,7 +508,7 @@ static inline __attribute__((always_inline)) void block_trim_free(control_t* con
 static inline __attribute__((always_inline)) void block_trim_used(control_t* control, block_header_t* block, size_t size)
 {
 	tlsf_assert(!block_is_free(block) && "block must be used");
-	if (block_can_split(block, size))
+	if (block_can_split(block, size, control->split_size_min))
 	{
 		/* If the next block is free, we must coalesce. */
 		block_header_t* remaining_block = block_split(block, size);
@@ -521,7 +522,8 @@ static inline __attribute__((always_inline)) void block_trim_used(control_t* con
 static inline __attribute__((always_inline)) block_header_t* block_trim_free_leading(control_t* control, block_header_t* block, size_t size)
 {
 	block_header_t* remaining_block = block;
-	if (block_can_split(block, size))
+	/* The leading block must always be split off, or the returned block would not be aligned. */
+	if (block_can_split(block, size, block_size_min))
 	{
 		/* We want to split `block` in two: the first block will be freed and the
 		 * second block will be returned. */
@@ -570,6 +572,68 @@ static inline __attribute__((always_inline)) block_header_t* block_locate_free(c
 	return block;
 }
 
+/*
+** Bounds of the search for a free block that is already suitably aligned,
+** so that memalign stays O(1): the heads of this many non-empty free lists,
+** and this many blocks in each. 0 lists disables the search.
+*/
+#ifndef TLSF_ALIGNED_SEARCH_LISTS
+#define TLSF_ALIGNED_SEARCH_LISTS 4
+#endif
+#define TLSF_ALIGNED_SEARCH_BLOCKS 4
+
+/*
+** Find a free block of at least `size` bytes in which the byte at
+** `off_adjust` lands on `align` with no gap, or with a gap large enough to
+** be split off as a free block, without asking for `align` more bytes like
+** the general memalign path does. Sets `*gap` to the bytes to trim off the
+** front. Returns NULL if none of the blocks looked at fits.
+*/
+static block_header_t* block_locate_free_aligned(control_t* control, size_t size, size_t align, size_t off_adjust, size_t* gap)
+{
+	int fl = 0, sl = 0;
+
+	mapping_search(control, size, &fl, &sl);
+	for (int list = 0; list < TLSF_ALIGNED_SEARCH_LISTS; list++)
+	{
+		if (fl >= control->fl_index_count || sl >= control->sl_index_count)
+		{
+			break;
+		}
+		block_header_t* block = search_suitable_block(control, &fl, &sl);
+		if (!block)
+		{
+			break;
+		}
+
+		for (int n = 0; n < TLSF_ALIGNED_SEARCH_BLOCKS && block != &control->block_null; n++, block = block->next_free)
+		{
+			const tlsfptr_t data = tlsf_cast(tlsfptr_t, block_to_ptr(block)) + off_adjust;
+			size_t g = (align - (data & (align - 1))) & (align - 1);
+			if (g && g < sizeof(block_header_t))
+			{
+				/* Too small to be a free block of its own, move to the next aligned address. */
+				g += align_up(sizeof(block_header_t) - g, align);
+			}
+			if (block_size(block) >= size + g
+				&& (!g || block_can_split(block, g, block_size_min)))
+			{
+				remove_free_block(control, block, fl, sl);
+				*gap = g;
+				return block;
+			}
+		}
+
+		/* Next list up. */
+		if (++sl == control->sl_index_count)
+		{
+			sl = 0;
+			++fl;
+		}
+	}
+	return NULL;
+}
+
 static inline __attribute__((always_inline)) void* block_prepare_used(control_t* control, block_header_t* block, size_t size)
 {
 	void* p = 0;
@@ -584,7 +648,7 @@ static inline __attribute__((always_inline)) void* block_prepare_used(control_t*
 }
 
 /* Clear structure and point all empty lists at the null block. */
-static control_t* control_construct(control_t* control, size_t bytes)
+static control_t* control_construct(control_t* control, size_t bytes, const tlsf_config_t* config)
 {
 	// check that the requested size can at least hold the control_t. This will allow us 
 	// to fill in the field of control_t necessary to determine the final size of 
@@ -598,11 +662,25 @@ static control_t* control_construct(control_t* control, size_t bytes)
 	/* Find the closest power of two for first layer */
 	control->fl_index_max = 32 - __builtin_clz(bytes);
 
-	/* Adapt second layer to the pool */
-	if (bytes <= 16 * 1024) control->sl_index_count_log2 = 3;
+	/* Adapt second layer to the pool, unless configured */
+	if (config && config->sl_index_count_log2)
+	{
+		if (config->sl_index_count_log2 > 5)
+		{
+			return NULL;
+		}
+		control->sl_index_count_log2 = config->sl_index_count_log2;
+	}
+	else if (bytes <= 16 * 1024) control->sl_index_count_log2 = 3;
 	else if (bytes <= 256 * 1024) control->sl_index_count_log2 = 4;
 	else control->sl_index_count_log2 = 5;
 
+	control->split_size_min = block_size_min;
+	if (config && config->split_size_min > block_size_min)
+	{
+		control->split_size_min = align_up(config->split_size_min, ALIGN_SIZE);
+	}
+
 	control->fl_index_shift = (control->sl_index_count_log2 + ALIGN_SIZE_LOG2);
 	control->sl_index_count = 1 << control->sl_index_count_log2;
 	control->fl_index_count = control->fl_index_max - control->fl_index_shift + 1;
@@ -952,6 +1030,11 @@ int test_ffs_fls()
 #endif
 
 tlsf_t tlsf_create(void* mem, size_t max_bytes)
+{
+	return tlsf_create_with_config(mem, max_bytes, NULL);
+}
+
+tlsf_t tlsf_create_with_config(void* mem, size_t max_bytes, const tlsf_config_t* config)
 {
 #if _DEBUG
 	if (test_ffs_fls())
@@ -972,13 +1055,18 @@ tlsf_t tlsf_create(void* mem, size_t max_bytes)
 		return NULL;
 	}
 
-	control_t* control_ptr = control_construct(tlsf_cast(control_t*, mem), max_bytes);
+	control_t* control_ptr = control_construct(tlsf_cast(control_t*, mem), max_bytes, config);
 	return tlsf_cast(tlsf_t, control_ptr);
 }
 
 tlsf_t tlsf_create_with_pool(void* mem, size_t pool_bytes, size_t max_bytes)
 {
-	tlsf_t tlsf = tlsf_create(mem, max_bytes ? max_bytes : pool_bytes);
+	return tlsf_create_with_pool_config(mem, pool_bytes, max_bytes, NULL);
+}
+
+tlsf_t tlsf_create_with_pool_config(void* mem, size_t pool_bytes, size_t max_bytes, const tlsf_config_t* config)
+{
+	tlsf_t tlsf = tlsf_create_with_config(mem, max_bytes ? max_bytes : pool_bytes, config);
 	if (tlsf != NULL)
 	{
 		tlsf_add_pool(tlsf, (char*)mem + tlsf_size(tlsf), pool_bytes - tlsf_size(tlsf));
@@ -1058,6 +1146,26 @@ void* tlsf_memalign_offs(tlsf_t tlsf, size_t align, size_t size, size_t data_off
 	*/
 	const size_t aligned_size = (adjust && align > ALIGN_SIZE) ? size_with_gap : adjust;
 
+	/*
+	** Most of the time a free block of the requested size is aligned already,
+	** or leaves a gap that can be split off. Taking it avoids picking a block
+	** `align` bytes larger and splitting its tail off again, and still
+	** succeeds when no such larger block exists.
+	*/
+	if (adjust && align > ALIGN_SIZE)
+	{
+		size_t gap = 0;
+		block_header_t* block = block_locate_free_aligned(control, adjust, align, off_adjust, &gap);
+		if (block)
+		{
+			if (gap)
+			{
+				block = block_trim_free_leading(control, block, gap);
+			}
+			return block_prepare_used(control, block, adjust);
+		}
+	}
+
 	block_header_t* block = block_locate_free(control, aligned_size);
 
 	/* This can't be a static assert. */
@@ -19,9 +19,22 @@ extern "C" {
 typedef void* tlsf_t;
 typedef void* pool_t;
 
+/* Per-instance tuning, zero fields keep the defaults. */
+typedef struct tlsf_config_t
+{
+	/* log2 of the number of second level lists per first level, 1 to 5.
+	** Default: 3 up to 16 KiB, 4 up to 256 KiB, 5 above. */
+	unsigned int sl_index_count_log2;
+	/* Smallest free block a split may leave, at least tlsf_block_size_min().
+	** Default: tlsf_block_size_min(). */
+	size_t split_size_min;
+} tlsf_config_t;
+
 /* Create/destroy a memory pool. */
 tlsf_t tlsf_create(void* mem, size_t max_bytes);
 tlsf_t tlsf_create_with_pool(void* mem, size_t pool_bytes, size_t max_bytes);
+tlsf_t tlsf_create_with_config(void* mem, size_t max_bytes, const tlsf_config_t* config);
+tlsf_t tlsf_create_with_pool_config(void* mem, size_t pool_bytes, size_t max_bytes, const tlsf_config_t* config);
 void tlsf_destroy(tlsf_t tlsf);
 pool_t tlsf_get_pool(tlsf_t tlsf);
 
@@ -114,6 +114,11 @@ typedef struct control_t
 	 */
     size_t size;
 
+	/* Smallest free block left over when an allocation is carved out of
+	 * a larger one. Smaller leftovers stay in the allocated block.
+	 */
+    size_t split_size_min;
+
     /* Bitmaps for free lists. */
     unsigned int fl_bitmap;
     unsigned int *sl_bitmap;
@@ -10,7 +10,7 @@
  * \#define LWIP_CHKSUM your_checksum_routine
  *
  * Or you can select from the implementations below by defining
- * LWIP_CHKSUM_ALGORITHM to 1, 2 or 3.
+ * LWIP_CHKSUM_ALGORITHM to 1, 2, 3 or 4.
  */
 
 /*
@@ -255,6 +255,100 @@ lwip_standard_chksum(const void *dataptr, int len)
 }
 #endif
 
+#if (LWIP_CHKSUM_ALGORITHM == 4) || (LWIP_CHKSUM_COPY_ALGORITHM == 2)
+#if !LWIP_HAVE_INT64
+#error "LWIP_CHKSUM_ALGORITHM 4 and LWIP_CHKSUM_COPY_ALGORITHM 2 need 64-bit integers"
+#endif
+/** Fold a 64-bit sum of 16-bit or 32-bit words to 16 bits */
+static u16_t
+lwip_chksum_fold64(u64_t sum)
+{
+  u32_t sum32;
+
+  sum = (sum >> 32) + (sum & 0xffffffffUL);
+  sum = (sum >> 32) + (sum & 0xffffffffUL);
+  sum32 = (u32_t)sum;
+  sum32 = FOLD_U32T(sum32);
+  sum32 = FOLD_U32T(sum32);
+  return (u16_t)sum32;
+}
+#endif
+
+#if (LWIP_CHKSUM_ALGORITHM == 4) /* Alternative version #4 */
+/**
+ * Word-at-a-time checksum: the inner loop adds four aligned 32-bit words per
+ * iteration into a 64-bit accumulator, so it needs no carry handling (the
+ * accumulator can not overflow for any u16_t length). The head is aligned
+ * like in version #3, an odd start address is corrected by swapping the
+ * result.
+ *
+ * @param dataptr points to start of data to be summed at any boundary
+ * @param len length of data to be summed
+ * @return host order (!) lwip checksum (non-inverted Internet sum)
+ */
+u16_t
+lwip_standard_chksum(const void *dataptr, int len)
+{
+  const u8_t *pb = (const u8_t *)dataptr;
+  const u16_t *ps;
+  const u32_t *pl;
+  u16_t t = 0;
+  u64_t sum = 0;
+  u16_t sum16;
+  /* starts at odd byte address? */
+  int odd = ((mem_ptr_t)pb & 1);
+
+  if (odd && len > 0) {
+    ((u8_t *)&t)[1] = *pb++;
+    len--;
+  }
+
+  ps = (const u16_t *)(const void *)pb;
+
+  if (((mem_ptr_t)ps & 3) && len > 1) {
+    sum += *ps++;
+    len -= 2;
+  }
+
+  pl = (const u32_t *)(const void *)ps;
+
+  while (len > 15) {
+    sum += pl[0];
+    sum += pl[1];
+    sum += pl[2];
+    sum += pl[3];
+    pl += 4;
+    len -= 16;
+  }
+
+  while (len > 3) {
+    sum += *pl++;
+    len -= 4;
+  }
+
+  ps = (const u16_t *)(const void *)pl;
+
+  /* 16-bit aligned word remaining? */
+  if (len > 1) {
+    sum += *ps++;
+    len -= 2;
+  }
+
+  /* dangling tail byte remaining? */
+  if (len > 0) {
+    ((u8_t *)&t)[0] = *(const u8_t *)ps;
+  }
+
+  sum += t;
+
+  sum16 = lwip_chksum_fold64(sum);
+  if (odd) {
+    sum16 = (u16_t)SWAP_BYTES_IN_WORD(sum16);
+  }
+  return sum16;
+}
+#endif
+
 /** Parts of the pseudo checksum which are common to IPv4 and IPv6 */
 static u16_t
 inet_cksum_pseudo_base(struct pbuf *p, u8_t proto, u16_t proto_len, u32_t acc)
@@ -606,3 +700,118 @@ lwip_chksum_copy(void *dst, const void *src, u16_t len)
   return LWIP_CHKSUM(dst, len);
 }
 #endif /* (LWIP_CHKSUM_COPY_ALGORITHM == 1) */
+
+#if (LWIP_CHKSUM_COPY_ALGORITHM == 2) /* Version #2 */
+/** Copy and checksum in a single pass, so the data is only loaded once.
+ * The bulk is loaded from src 32 bits at a time (four words per iteration)
+ * and stored 32 bits at a time when dst has the same alignment, or as two
+ * 16-bit halves when dst is 2 bytes off (the usual case for pbuf payloads
+ * behind the protocol headers). An odd offset between src and dst falls
+ * back to version #1.
+ */
+u16_t
+lwip_chksum_copy(void *dst, const void *src, u16_t len)
+{
+  const u8_t *sb = (const u8_t *)src;
+  u8_t *db = (u8_t *)dst;
+  const u32_t *sl;
+  u64_t sum = 0;
+  u32_t head = 0;
+  u32_t w0, w1, w2, w3;
+  u16_t t;
+  u16_t sum16;
+  int n = len;
+  int k = 0;
+
+  if (((mem_ptr_t)sb ^ (mem_ptr_t)db) & 1) {
+    MEMCPY(dst, src, len);
+    return LWIP_CHKSUM(dst, len);
+  }
+
+  /* copy single bytes until src is aligned, they are summed in their
+     position relative to the start of the buffer */
+  while (((mem_ptr_t)sb & 3) && n > 0) {
+    t = 0;
+    ((u8_t *)&t)[k & 1] = *db++ = *sb++;
+    head += t;
+    k++;
+    n--;
+  }
+
+  sl = (const u32_t *)(const void *)sb;
+  if (((mem_ptr_t)db & 3) == 0) {
+    u32_t *dl = (u32_t *)(void *)db;
+    while (n > 15) {
+      w0 = sl[0];
+      w1 = sl[1];
+      w2 = sl[2];
+      w3 = sl[3];
+      dl[0] = w0;
+      dl[1] = w1;
+      dl[2] = w2;
+      dl[3] = w3;
+      sum += w0;
+      sum += w1;
+      sum += w2;
+      sum += w3;
+      sl += 4;
+      dl += 4;
+      n -= 16;
+    }
+    while (n > 3) {
+      w0 = *sl++;
+      *dl++ = w0;
+      sum += w0;
+      n -= 4;
+    }
+    db = (u8_t *)dl;
+  } else {
+    u16_t *ds = (u16_t *)(void *)db;
+    while (n > 7) {
+      w0 = sl[0];
+      w1 = sl[1];
+#if BYTE_ORDER == LITTLE_ENDIAN
+      ds[0] = (u16_t)w0;
+      ds[1] = (u16_t)(w0 >> 16);
+      ds[2] = (u16_t)w1;
+      ds[3] = (u16_t)(w1 >> 16);
+#else
+      ds[0] = (u16_t)(w0 >> 16);
+      ds[1] = (u16_t)w0;
+      ds[2] = (u16_t)(w1 >> 16);
+      ds[3] = (u16_t)w1;
+#endif
+      sum += w0;
+      sum += w1;
+      sl += 2;
+      ds += 4;
+      n -= 8;
+    }
+    db = (u8_t *)ds;
+  }
+  sb = (const u8_t *)sl;
+
+  /* up to 7 bytes left, summed like in version #2 */
+  while (n > 1) {
+    t = 0;
+    ((u8_t *)&t)[0] = db[0] = sb[0];
+    ((u8_t *)&t)[1] = db[1] = sb[1];
+    sum += t;
+    sb += 2;
+    db += 2;
+    n -= 2;
+  }
+  if (n > 0) {
+    t = 0;
+    ((u8_t *)&t)[0] = *db = *sb;
+    sum += t;
+  }
+
+  /* the bulk was summed starting at byte k, swap it back if k is odd */
+  sum16 = lwip_chksum_fold64(sum);
+  if (k & 1) {
+    sum16 = (u16_t)SWAP_BYTES_IN_WORD(sum16);
+  }
+  return lwip_chksum_fold64((u64_t)head + sum16);
+}
+#endif /* (LWIP_CHKSUM_COPY_ALGORITHM == 2) */
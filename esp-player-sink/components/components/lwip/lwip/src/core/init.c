@@ -291,6 +291,11 @@ PACK_STRUCT_END
 #ifdef LWIP_HOOK_MEMP_AVAILABLE
 #error "LWIP_HOOK_MEMP_AVAILABLE doesn't make sense with MEMP_MEM_MALLOC"
 #endif
+#if MEMP_MEM_MALLOC_HYBRID && MEMP_OVERFLOW_CHECK
+#error "MEMP_MEM_MALLOC_HYBRID and MEMP_OVERFLOW_CHECK cannot be enabled at the same time"
+#endif
+#elif MEMP_MEM_MALLOC_HYBRID
+#error "MEMP_MEM_MALLOC_HYBRID needs MEMP_MEM_MALLOC"
 #endif /* MEMP_MEM_MALLOC */
 
 /* TCP sanity checks */
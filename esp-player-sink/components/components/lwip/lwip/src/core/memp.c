@@ -75,7 +75,11 @@
 #include "lwip/ip6_frag.h"
 #include "lwip/mld6.h"
 
+#if MEMP_MEM_MALLOC_HYBRID
+#define LWIP_MEMPOOL(name,num,size,desc) LWIP_MEMPOOL_DECLARE_HYBRID(name,MEMP_HYBRID_NUM(MEMP_ ## name),size,desc)
+#else
 #define LWIP_MEMPOOL(name,num,size,desc) LWIP_MEMPOOL_DECLARE(name,num,size,desc)
+#endif
 #include "lwip/priv/memp_std.h"
 
 const struct memp_desc *const memp_pools[MEMP_MAX] = {
@@ -174,7 +178,7 @@ memp_overflow_check_all(void)
 void
 memp_init_pool(const struct memp_desc *desc)
 {
-#if MEMP_MEM_MALLOC
+#if MEMP_MEM_MALLOC && !MEMP_MEM_MALLOC_HYBRID
   LWIP_UNUSED_ARG(desc);
 #else
   int i;
@@ -207,7 +211,7 @@ memp_init_pool(const struct memp_desc *desc)
 #if MEMP_STATS
   desc->stats->avail = desc->num;
 #endif /* MEMP_STATS */
-#endif /* !MEMP_MEM_MALLOC */
+#endif /* !MEMP_MEM_MALLOC || MEMP_MEM_MALLOC_HYBRID */
 
 #if MEMP_STATS && (defined(LWIP_DEBUG) || LWIP_STATS_DISPLAY)
   desc->stats->name  = desc->desc;
@@ -250,7 +254,23 @@ do_memp_malloc_pool_fn(const struct memp_desc *desc, const char *file, const int
   struct memp *memp;
   SYS_ARCH_DECL_PROTECT(old_level);
 
-#if MEMP_MEM_MALLOC
+#if MEMP_MEM_MALLOC_HYBRID
+  SYS_ARCH_PROTECT(old_level);
+  memp = *desc->tab;
+  if (memp != NULL) {
+    *desc->tab = memp->next;
+  } else {
+    /* all static elements are in use (or the pool has none), use the heap */
+    SYS_ARCH_UNPROTECT(old_level);
+    memp = (struct memp *)mem_malloc(MEMP_SIZE + MEMP_ALIGN_SIZE(desc->size));
+    SYS_ARCH_PROTECT(old_level);
+#if MEMP_STATS
+    if (memp != NULL) {
+      desc->stats->heap++;
+    }
+#endif
+  }
+#elif MEMP_MEM_MALLOC
   memp = (struct memp *)mem_malloc(MEMP_SIZE + MEMP_ALIGN_SIZE(desc->size));
   SYS_ARCH_PROTECT(old_level);
 #else /* MEMP_MEM_MALLOC */
@@ -355,6 +375,18 @@ memp_malloc_fn(memp_t type, const char *file, const int line)
   return memp;
 }
 
+#if MEMP_MEM_MALLOC_HYBRID
+/** Check whether an element comes from the static elements of a pool or from the heap */
+static int
+memp_hybrid_is_static(const struct memp_desc *desc, struct memp *memp)
+{
+  u8_t *start = (u8_t *)LWIP_MEM_ALIGN(desc->base);
+  u8_t *end = start + (size_t)desc->num * (MEMP_SIZE + MEMP_ALIGN_SIZE(desc->size));
+
+  return (desc->num > 0) && ((u8_t *)memp >= start) && ((u8_t *)memp < end);
+}
+#endif /* MEMP_MEM_MALLOC_HYBRID */
+
 static void
 do_memp_free_pool(const struct memp_desc *desc, void *mem)
 {
@@ -377,7 +409,16 @@ do_memp_free_pool(const struct memp_desc *desc, void *mem)
   desc->stats->used--;
 #endif
 
-#if MEMP_MEM_MALLOC
+#if MEMP_MEM_MALLOC_HYBRID
+  if (memp_hybrid_is_static(desc, memp)) {
+    memp->next = *desc->tab;
+    *desc->tab = memp;
+    SYS_ARCH_UNPROTECT(old_level);
+  } else {
+    SYS_ARCH_UNPROTECT(old_level);
+    mem_free(memp);
+  }
+#elif MEMP_MEM_MALLOC
   LWIP_UNUSED_ARG(desc);
   SYS_ARCH_UNPROTECT(old_level);
   mem_free(memp);
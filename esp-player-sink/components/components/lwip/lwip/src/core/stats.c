@@ -117,6 +117,9 @@ stats_display_memp(struct stats_mem *mem, int idx)
 {
   if (idx < MEMP_MAX) {
     stats_display_mem(mem, mem->name);
+#if MEMP_MEM_MALLOC_HYBRID
+    LWIP_PLATFORM_DIAG(("\theap: %"STAT_COUNTER_F"\n", mem->heap));
+#endif /* MEMP_MEM_MALLOC_HYBRID */
   }
 }
 #endif /* MEMP_STATS */
@@ -271,6 +271,26 @@
 #define MEMP_MEM_MALLOC                 0
 #endif
 
+/**
+ * MEMP_MEM_MALLOC_HYBRID==1: With MEMP_MEM_MALLOC, keep MEMP_HYBRID_NUM(type)
+ * statically allocated elements for the internal pools (memp_std.h) and only
+ * use mem_malloc/mem_free once they are all in use. Pools allocated many times
+ * per second then stay off the heap in the common case, while the heap still
+ * absorbs bursts. Private pools always use the heap.
+ */
+#if !defined MEMP_MEM_MALLOC_HYBRID || defined __DOXYGEN__
+#define MEMP_MEM_MALLOC_HYBRID          0
+#endif
+
+/**
+ * MEMP_HYBRID_NUM(type): Number of static elements of the internal pool 'type'
+ * (a memp_t value such as MEMP_TCP_SEG) with MEMP_MEM_MALLOC_HYBRID. Pools
+ * with 0 static elements use the heap only.
+ */
+#if !defined MEMP_HYBRID_NUM || defined __DOXYGEN__
+#define MEMP_HYBRID_NUM(type)           0
+#endif
+
 /**
  * MEMP_MEM_INIT==1: Force use of memset to initialize pool memory.
  * Useful if pool are moved in uninitialized section of memory. This will ensure
@@ -2200,7 +2220,7 @@
  * MEMP_STATS==1: Enable memp.c pool stats.
  */
 #if !defined MEMP_STATS || defined __DOXYGEN__
-#define MEMP_STATS                      (MEMP_MEM_MALLOC == 0)
+#define MEMP_STATS                      ((MEMP_MEM_MALLOC == 0) || MEMP_MEM_MALLOC_HYBRID)
 #endif
 
 /**
@@ -65,7 +65,7 @@ extern "C" {
 
 #endif /* MEMP_OVERFLOW_CHECK */
 
-#if !MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK
+#if !MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK || MEMP_MEM_MALLOC_HYBRID
 struct memp {
   struct memp *next;
 #if MEMP_OVERFLOW_CHECK
@@ -73,7 +73,7 @@ struct memp {
   int line;
 #endif /* MEMP_OVERFLOW_CHECK */
 };
-#endif /* !MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK */
+#endif /* !MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK || MEMP_MEM_MALLOC_HYBRID */
 
 #if MEM_USE_POOLS && MEMP_USE_CUSTOM_POOLS
 /* Use a helper type to get the start and end of the user "memory pools" for mem_malloc */
@@ -118,8 +118,8 @@ struct memp_desc {
   /** Element size */
   u16_t size;
 
-#if !MEMP_MEM_MALLOC
-  /** Number of elements */
+#if !MEMP_MEM_MALLOC || MEMP_MEM_MALLOC_HYBRID
+  /** Number of elements (static elements with MEMP_MEM_MALLOC_HYBRID) */
   u16_t num;
 
   /** Base address */
@@ -127,7 +127,7 @@ struct memp_desc {
 
   /** First free element of each pool. Elements form a linked list. */
   struct memp **tab;
-#endif /* MEMP_MEM_MALLOC */
+#endif /* !MEMP_MEM_MALLOC || MEMP_MEM_MALLOC_HYBRID */
 };
 
 #if defined(LWIP_DEBUG) || MEMP_OVERFLOW_CHECK || LWIP_STATS_DISPLAY
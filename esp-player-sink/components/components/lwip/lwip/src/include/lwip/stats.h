@@ -104,6 +104,10 @@ struct stats_mem {
   mem_size_t used;
   mem_size_t max;
   STAT_COUNTER illegal;
+#if MEMP_MEM_MALLOC_HYBRID
+  /** Elements allocated from the heap because no static element was free */
+  STAT_COUNTER heap;
+#endif /* MEMP_MEM_MALLOC_HYBRID */
 };
 
 /** System element stats */
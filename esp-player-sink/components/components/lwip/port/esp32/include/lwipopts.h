@@ -90,6 +90,20 @@ extern "C" {
 */
 #define MEMP_MEM_MALLOC                 1
 
+/**
+ * MEMP_MEM_MALLOC_HYBRID==1: Keep MEMP_HYBRID_NUM(type) static elements for
+ * the pools allocated for every packet, the heap is only used once they are
+ * all in use.
+ */
+#ifdef CONFIG_LWIP_MEMP_HYBRID_POOLS
+#define MEMP_MEM_MALLOC_HYBRID          1
+#define MEMP_HYBRID_NUM(type)           ((type) == MEMP_PBUF_POOL ? CONFIG_LWIP_MEMP_HYBRID_PBUF_POOL_NUM : \
+                                         (type) == MEMP_TCP_SEG ? CONFIG_LWIP_MEMP_HYBRID_TCP_SEG_NUM : \
+                                         (type) == MEMP_NETBUF ? CONFIG_LWIP_MEMP_HYBRID_NETBUF_NUM : 0)
+#else
+#define MEMP_MEM_MALLOC_HYBRID          0
+#endif
+
 /**
  * MEM_ALIGNMENT: should be set to the alignment of the CPU
  *    4 byte alignment -> #define MEM_ALIGNMENT 4
@@ -1103,6 +1117,25 @@ static inline uint32_t timeout_from_offered(uint32_t lease, uint32_t min)
 #define CHECKSUM_CHECK_ICMP             0
 #endif
 
+/**
+ * LWIP_CHKSUM_ALGORITHM==4: Sum 32-bit words, four per loop iteration,
+ * instead of the 16-bit words of the default version #2.
+ */
+#ifdef CONFIG_LWIP_CHKSUM_WORD_AT_A_TIME
+#define LWIP_CHKSUM_ALGORITHM           4
+#endif
+
+/**
+ * LWIP_CHECKSUM_ON_COPY==1: Calculate checksum when copying data from
+ * application buffers to pbufs, with the single pass copy routine.
+ */
+#ifdef CONFIG_LWIP_CHECKSUM_ON_COPY
+#define LWIP_CHECKSUM_ON_COPY           1
+#define LWIP_CHKSUM_COPY_ALGORITHM      2
+#else
+#define LWIP_CHECKSUM_ON_COPY           0
+#endif
+
 /*
    ---------------------------------------
    ---------- IPv6 options ---------------
@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LWIP_BENCH_ARCH_CC_H
+#define LWIP_BENCH_ARCH_CC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define LWIP_ERRNO_STDINCLUDE   1
+#define LWIP_TIMEVAL_PRIVATE    0
+
+#define LWIP_RAND()             ((u32_t)rand())
+
+#define LWIP_PLATFORM_DIAG(x)   do { printf x; } while (0)
+#define LWIP_PLATFORM_ASSERT(x) do { fprintf(stderr, "Assertion \"%s\" failed at line %d in %s\n", \
+                                     x, __LINE__, __FILE__); abort(); } while (0)
+
+#endif /* LWIP_BENCH_ARCH_CC_H */
@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LWIP_BENCH_ARCH_SYS_ARCH_H
+#define LWIP_BENCH_ARCH_SYS_ARCH_H
+
+#include <pthread.h>
+
+/* pthread based port, the critical regions are protected by a mutex like in the ESP32 port */
+
+typedef struct sys_sem *sys_sem_t;
+typedef struct sys_mutex *sys_mutex_t;
+typedef struct sys_mbox *sys_mbox_t;
+typedef pthread_t sys_thread_t;
+typedef int sys_prot_t;
+
+#define sys_sem_valid(sem)          (((sem) != NULL) && (*(sem) != NULL))
+#define sys_sem_set_invalid(sem)    do { if ((sem) != NULL) { *(sem) = NULL; } } while (0)
+#define sys_mutex_valid(mutex)      (((mutex) != NULL) && (*(mutex) != NULL))
+#define sys_mutex_set_invalid(mutex) do { if ((mutex) != NULL) { *(mutex) = NULL; } } while (0)
+#define sys_mbox_valid(mbox)        (((mbox) != NULL) && (*(mbox) != NULL))
+#define sys_mbox_set_invalid(mbox)  do { if ((mbox) != NULL) { *(mbox) = NULL; } } while (0)
+
+#endif /* LWIP_BENCH_ARCH_SYS_ARCH_H */
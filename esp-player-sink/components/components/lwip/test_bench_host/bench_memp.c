@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measures memp_malloc() latency for the pools allocated on every packet
+ * (TCP segments, netbufs, pool pbufs) while another thread churns the heap
+ * the way the Wi-Fi driver does. Built twice, once with MEMP_MEM_MALLOC only
+ * and once with MEMP_MEM_MALLOC_HYBRID, see the Makefile.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lwip/init.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+
+#define ROUNDS          200000
+#define TCP_SEG_BURST   12      /* about one send window of segments */
+#define NETBUF_BURST    4
+#define PBUF_POOL_BURST 2
+#define CHURN_SLOTS     256
+
+static volatile bool s_stop;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Random sized malloc/free, like the RX buffers and management frames of the driver */
+static void *churn_task(void *arg)
+{
+    void *slots[CHURN_SLOTS] = { 0 };
+    unsigned seed = 1;
+    while (!s_stop) {
+        int i = rand_r(&seed) % CHURN_SLOTS;
+        free(slots[i]);
+        slots[i] = malloc(64 + rand_r(&seed) % 1600);
+    }
+    for (int i = 0; i < CHURN_SLOTS; i++) {
+        free(slots[i]);
+    }
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void run(const char *name, memp_t type, int burst)
+{
+    uint32_t *lat = malloc(sizeof(uint32_t) * ROUNDS * burst);
+    void *elems[TCP_SEG_BURST];
+    uint64_t total = 0;
+    size_t n = 0;
+
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < burst; i++) {
+            uint64_t t0 = now_ns();
+            elems[i] = memp_malloc(type);
+            uint64_t dt = now_ns() - t0;
+            if (elems[i] == NULL) {
+                fprintf(stderr, "%s: out of memory\n", name);
+                exit(1);
+            }
+            /* touch the element like the stack does when filling it in */
+            memset(elems[i], 0, 16);
+            lat[n++] = (uint32_t)dt;
+            total += dt;
+        }
+        for (int i = burst - 1; i >= 0; i--) {
+            memp_free(type, elems[i]);
+        }
+    }
+    qsort(lat, n, sizeof(lat[0]), cmp_u32);
+    printf("  %-10s %8.1f ns avg  %6u ns p50  %6u ns p99  %6u ns p99.9  %8u ns max",
+           name, (double)total / n, lat[n / 2], lat[n * 99 / 100], lat[n * 999 / 1000], lat[n - 1]);
+#if MEMP_STATS && MEMP_MEM_MALLOC_HYBRID
+    printf("  (max used %u, from heap %lu)", (unsigned)lwip_stats.memp[type]->max, (unsigned long)lwip_stats.memp[type]->heap);
+#endif
+    printf("\n");
+    free(lat);
+}
+
+int main(void)
+{
+    pthread_t churn;
+
+    lwip_init();
+    printf("memp_malloc latency, %s, %d rounds, heap churn thread running\n",
+           MEMP_MEM_MALLOC_HYBRID ? "MEMP_MEM_MALLOC_HYBRID" : "MEMP_MEM_MALLOC", ROUNDS);
+    pthread_create(&churn, NULL, churn_task, NULL);
+    run("TCP_SEG", MEMP_TCP_SEG, TCP_SEG_BURST);
+    run("NETBUF", MEMP_NETBUF, NETBUF_BURST);
+    run("PBUF_POOL", MEMP_PBUF_POOL, PBUF_POOL_BURST);
+    s_stop = true;
+    pthread_join(churn, NULL);
+    return 0;
+}
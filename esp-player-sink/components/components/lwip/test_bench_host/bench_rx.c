@@ -0,0 +1,328 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Compares the per-packet cost of the two esp-player-sink receive paths over
+ * the lwIP loopback netif:
+ *
+ * - socket: a receive thread recv()s every packet into a pool block, posts it
+ *   to the decode thread and send()s the 10 byte link report
+ * - raw: tcp_recv() callbacks in the tcpip thread chain the pbufs of a packet,
+ *   post the pbuf chain itself to the decode thread and tcp_write() the
+ *   report; the decode thread frees the pbufs
+ *
+ * The client is the same in both modes: an lwIP socket sending one packet
+ * behind its 2 byte length and waiting for the report, like the host does.
+ * Both modes split the stream on that length, so each must decode exactly
+ * PACKETS packets.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lwip/init.h"
+#include "lwip/sockets.h"
+#include "lwip/sys.h"
+#include "lwip/tcp.h"
+#include "lwip/tcpip.h"
+
+#define PACKETS         20000
+#define QUEUE_LEN       10      /* AUDIO_RX_QUEUE_LEN / PACKET_POOL_BLOCKS */
+#define MAX_PACKET      1500    /* MAX_AGGREGATE_PACKET */
+#define REPORT_LEN      10
+#define HEADER_LEN      2       /* PACKET_HEADER_LEN */
+#define PORT_BASE       1028
+
+typedef enum {
+    MODE_SOCKET,
+    MODE_RAW,
+} rx_mode_t;
+
+static sys_mbox_t s_decode_q;   /* packets waiting for the decode thread */
+static sys_mbox_t s_free_q;     /* socket mode: free pool blocks */
+static sys_sem_t s_ready;
+static volatile unsigned s_checksum;
+static volatile unsigned s_linearized;
+static volatile unsigned s_delivered;   /* packets handed to the decode thread */
+
+typedef struct {
+    int len;
+    unsigned char data[MAX_PACKET];
+} block_t;
+
+static uint64_t now_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Stands in for opus_decode(), reads every byte of the packet once */
+static void consume(const unsigned char *data, int len)
+{
+    unsigned sum = 0;
+    for (int i = 0; i < len; i++) {
+        sum += data[i];
+    }
+    s_checksum += sum;
+}
+
+static int packet_length(const unsigned char *header)
+{
+    return (header[0] << 8) | header[1];
+}
+
+/* ---- socket mode, like do_decode()/do_decode2() ---- */
+
+/* lwIP does not implement MSG_WAITALL */
+static int recv_all(int sock, unsigned char *buf, int len)
+{
+    int got = 0;
+    while (got < len) {
+        int n = lwip_recv(sock, buf + got, len - got, 0);
+        if (n <= 0) {
+            return n;
+        }
+        got += n;
+    }
+    return got;
+}
+
+static void socket_server(void *arg)
+{
+    int port = (int)(intptr_t)arg;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = lwip_htons(port) };
+    char report[REPORT_LEN] = "ok";
+    int listen_sock = lwip_socket(AF_INET, SOCK_STREAM, 0);
+
+    addr.sin_addr.s_addr = lwip_htonl(INADDR_ANY);
+    lwip_bind(listen_sock, (struct sockaddr *)&addr, sizeof(addr));
+    lwip_listen(listen_sock, 1);
+    sys_sem_signal(&s_ready);
+    int sock = lwip_accept(listen_sock, NULL, NULL);
+    while (1) {
+        block_t *b;
+        unsigned char header[HEADER_LEN];
+        sys_arch_mbox_fetch(&s_free_q, (void **)&b, 0);
+        b->len = recv_all(sock, header, HEADER_LEN);
+        if (b->len > 0) {
+            int len = packet_length(header);
+            b->len = len > 0 && len <= MAX_PACKET ? recv_all(sock, b->data, len) : -1;
+        }
+        if (b->len <= 0) {
+            sys_mbox_post(&s_free_q, b);
+            break;
+        }
+        sys_mbox_post(&s_decode_q, b);
+        lwip_send(sock, report, REPORT_LEN, 0);
+    }
+    lwip_close(sock);
+    lwip_close(listen_sock);
+    sys_mbox_post(&s_decode_q, NULL);
+}
+
+static void socket_decode(void *arg)
+{
+    block_t *b;
+    while (1) {
+        sys_arch_mbox_fetch(&s_decode_q, (void **)&b, 0);
+        if (b == NULL) {
+            break;
+        }
+        consume(b->data, b->len);
+        s_delivered++;
+        sys_mbox_post(&s_free_q, b);
+    }
+    sys_sem_signal(&s_ready);
+}
+
+/* ---- raw mode, like audio_rx_raw.c ---- */
+
+static struct pbuf *s_partial;
+static unsigned char s_linear[MAX_PACKET];
+
+static err_t raw_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    static const char report[REPORT_LEN] = "ok";
+    if (p == NULL) {
+        tcp_recv(pcb, NULL);
+        tcp_close(pcb);
+        sys_mbox_post(&s_decode_q, NULL);
+        return ERR_OK;
+    }
+    tcp_recved(pcb, p->tot_len);
+    if (s_partial == NULL) {
+        s_partial = p;
+    } else {
+        pbuf_cat(s_partial, p);
+    }
+    while (s_partial != NULL && s_partial->tot_len >= HEADER_LEN) {
+        unsigned char header[HEADER_LEN];
+        pbuf_copy_partial(s_partial, header, HEADER_LEN, 0);
+        int len = packet_length(header);
+        if (len == 0 || len > MAX_PACKET) {
+            fprintf(stderr, "bad packet length %d\n", len);
+            exit(1);
+        }
+        if (s_partial->tot_len < HEADER_LEN + len) {
+            break;
+        }
+        struct pbuf *packet;
+        if (s_partial->tot_len == HEADER_LEN + len) {
+            packet = pbuf_free_header(s_partial, HEADER_LEN);
+            s_partial = NULL;
+        } else {
+            /* the start of the next packet came in the same segment */
+            packet = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+            pbuf_copy_partial(s_partial, packet->payload, len, HEADER_LEN);
+            s_partial = pbuf_free_header(s_partial, HEADER_LEN + len);
+        }
+        /* the sink holds the packet without a report when the decode queue
+           is full, blocking the tcpip thread is close enough here and
+           matches the socket path waiting for a free pool block */
+        sys_mbox_post(&s_decode_q, packet);
+        tcp_write(pcb, report, REPORT_LEN, TCP_WRITE_FLAG_COPY);
+        tcp_output(pcb);
+    }
+    return ERR_OK;
+}
+
+static err_t raw_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+    tcp_recv(newpcb, raw_recv);
+    return ERR_OK;
+}
+
+static void raw_setup(void *arg)
+{
+    struct tcp_pcb *pcb = tcp_new();
+    tcp_bind(pcb, IP_ADDR_ANY, (u16_t)(intptr_t)arg);
+    pcb = tcp_listen_with_backlog(pcb, 1);
+    tcp_accept(pcb, raw_accept);
+    sys_sem_signal(&s_ready);
+}
+
+static void raw_decode(void *arg)
+{
+    struct pbuf *p;
+    while (1) {
+        sys_arch_mbox_fetch(&s_decode_q, (void **)&p, 0);
+        if (p == NULL) {
+            break;
+        }
+        if (p->len == p->tot_len) {
+            consume(p->payload, p->len);
+        } else {
+            pbuf_copy_partial(p, s_linear, p->tot_len, 0);
+            consume(s_linear, p->tot_len);
+            s_linearized++;
+        }
+        s_delivered++;
+        pbuf_free(p);
+    }
+    sys_sem_signal(&s_ready);
+}
+
+/* ---- client, like the host ---- */
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void run(rx_mode_t mode, int packet_len, int port)
+{
+    static block_t blocks[QUEUE_LEN];
+    static uint32_t rtt[PACKETS];
+    unsigned char packet[HEADER_LEN + MAX_PACKET];
+    char report[30];
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = lwip_htons(port) };
+
+    sys_mbox_new(&s_decode_q, QUEUE_LEN);
+    sys_mbox_new(&s_free_q, QUEUE_LEN);
+    s_linearized = 0;
+    s_delivered = 0;
+    if (mode == MODE_SOCKET) {
+        for (int i = 0; i < QUEUE_LEN; i++) {
+            sys_mbox_post(&s_free_q, &blocks[i]);
+        }
+        sys_thread_new("server", socket_server, (void *)(intptr_t)port, 0, 0);
+        sys_thread_new("decode", socket_decode, NULL, 0, 0);
+    } else {
+        tcpip_callback(raw_setup, (void *)(intptr_t)port);
+        sys_thread_new("decode", raw_decode, NULL, 0, 0);
+    }
+    sys_arch_sem_wait(&s_ready, 0);
+
+    packet[0] = (unsigned char)(packet_len >> 8);
+    packet[1] = (unsigned char)(packet_len & 0xff);
+    for (int i = 0; i < packet_len; i++) {
+        packet[HEADER_LEN + i] = (unsigned char)rand();
+    }
+    addr.sin_addr.s_addr = lwip_htonl(INADDR_LOOPBACK);
+    int sock = lwip_socket(AF_INET, SOCK_STREAM, 0);
+    if (lwip_connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "connect failed\n");
+        exit(1);
+    }
+
+    uint64_t cpu0 = now_ns(CLOCK_PROCESS_CPUTIME_ID);
+    uint64_t wall0 = now_ns(CLOCK_MONOTONIC);
+    for (int i = 0; i < PACKETS; i++) {
+        uint64_t t0 = now_ns(CLOCK_MONOTONIC);
+        lwip_send(sock, packet, HEADER_LEN + packet_len, 0);
+        /* one recv() of whatever reports are there, the same as the host */
+        if (lwip_recv(sock, report, sizeof(report), 0) <= 0) {
+            fprintf(stderr, "recv failed\n");
+            exit(1);
+        }
+        rtt[i] = (uint32_t)(now_ns(CLOCK_MONOTONIC) - t0);
+    }
+    uint64_t wall = now_ns(CLOCK_MONOTONIC) - wall0;
+    uint64_t cpu = now_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu0;
+    lwip_close(sock);
+    sys_arch_sem_wait(&s_ready, 0);
+    sys_mbox_free(&s_free_q);
+    sys_mbox_free(&s_decode_q);
+
+    qsort(rtt, PACKETS, sizeof(rtt[0]), cmp_u32);
+    printf("  %-6s %4d B  %8.0f packets/s  %6.2f us cpu/packet  rtt p50 %5.1f us  p99 %5.1f us",
+           mode == MODE_SOCKET ? "socket" : "raw", packet_len, PACKETS * 1e9 / wall, cpu / 1e3 / PACKETS,
+           rtt[PACKETS / 2] / 1e3, rtt[PACKETS * 99 / 100] / 1e3);
+    printf("  %u decoded", s_delivered);
+    if (mode == MODE_RAW) {
+        printf(", %u linearized", s_linearized);
+    }
+    printf("\n");
+    if (s_delivered != PACKETS) {
+        fprintf(stderr, "decoded %u packets, sent %d\n", s_delivered, PACKETS);
+        exit(1);
+    }
+}
+
+static void tcpip_ready(void *arg)
+{
+    sys_sem_signal(&s_ready);
+}
+
+int main(void)
+{
+    static const int sizes[] = { 200, 1000, 1500 };
+    int port = PORT_BASE;
+
+    sys_sem_new(&s_ready, 0);
+    tcpip_init(tcpip_ready, NULL);
+    sys_arch_sem_wait(&s_ready, 0);
+
+    printf("stop-and-wait receive over the loopback netif, %d packets per run\n", PACKETS);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        run(MODE_SOCKET, sizes[i], port++);
+        run(MODE_RAW, sizes[i], port++);
+    }
+    return 0;
+}
@@ -0,0 +1,263 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Per-packet latency of the esp-player-sink TCP session with and without the
+ * session setup of main/audio_rx_raw.c, over the lwIP loopback netif:
+ *
+ * - default: lwIP defaults on both sides, the client keeps Nagle on
+ * - tuned: the client sets TCP_NODELAY (like TcpTransport on the host), the
+ *   sink disables Nagle, sizes its receive window from the playout target
+ *   and acks segments which do not complete a packet right away
+ *
+ * The sink side is the raw receive path of bench_rx, which splits packets on
+ * their 2 byte length. The client sends up to `credits` packets without a
+ * report, 1 is the stop-and-wait protocol of the host, 2 lets a report and
+ * the next packet cross. The latency is from send() to the matching report.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lwip/init.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/sockets.h"
+#include "lwip/sys.h"
+#include "lwip/tcp.h"
+#include "lwip/tcpip.h"
+
+#define PACKETS         200
+#define QUEUE_LEN       10      /* AUDIO_RX_QUEUE_LEN */
+#define MAX_PACKET      1500    /* MAX_AGGREGATE_PACKET */
+#define REPORT_LEN      10
+#define HEADER_LEN      2       /* PACKET_HEADER_LEN */
+#define MAX_CREDITS     4
+#define PORT_BASE       1028
+/* PLAYOUT_TARGET_MS and NOMINAL_BITRATE of audio_rx_raw.c */
+#define PLAYOUT_TARGET_MS 80
+#define NOMINAL_BITRATE 120000
+
+static sys_mbox_t s_decode_q;
+static sys_sem_t s_ready;
+static volatile unsigned s_checksum;
+static volatile unsigned s_quickacks;
+static int s_tuned;
+static struct pbuf *s_partial;
+static tcpwnd_size_t s_shrink;  /* rx_recved() of audio_rx_raw.c */
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* ---- sink, the raw receive path of audio_rx_raw.c ---- */
+
+static tcpwnd_size_t window_for(uint32_t bitrate_bps)
+{
+    uint32_t wnd = (uint32_t)((uint64_t)bitrate_bps * PLAYOUT_TARGET_MS / 8000);
+    uint32_t min = MAX_PACKET > 2 * TCP_MSS ? MAX_PACKET : 2 * TCP_MSS;
+    if (wnd < min) {
+        wnd = min;
+    }
+    if (wnd > TCP_WND) {
+        wnd = TCP_WND;
+    }
+    return (tcpwnd_size_t)wnd;
+}
+
+static err_t sink_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    static const char report[REPORT_LEN] = "ok";
+    if (p == NULL) {
+        tcp_recv(pcb, NULL);
+        tcp_close(pcb);
+        sys_mbox_post(&s_decode_q, NULL);
+        return ERR_OK;
+    }
+    /* shrink the window as data arrives rather than below what is already announced */
+    tcpwnd_size_t keep = s_shrink < p->tot_len ? s_shrink : p->tot_len;
+    s_shrink -= keep;
+    if (p->tot_len > keep) {
+        tcp_recved(pcb, p->tot_len - keep);
+    }
+    if (s_partial == NULL) {
+        s_partial = p;
+    } else {
+        pbuf_cat(s_partial, p);
+    }
+    int reports = 0;
+    while (s_partial != NULL && s_partial->tot_len >= HEADER_LEN) {
+        unsigned char header[HEADER_LEN];
+        pbuf_copy_partial(s_partial, header, HEADER_LEN, 0);
+        int len = (header[0] << 8) | header[1];
+        if (len == 0 || len > MAX_PACKET) {
+            fprintf(stderr, "bad packet length %d\n", len);
+            exit(1);
+        }
+        if (s_partial->tot_len < HEADER_LEN + len) {
+            break;
+        }
+        struct pbuf *packet;
+        if (s_partial->tot_len == HEADER_LEN + len) {
+            packet = pbuf_free_header(s_partial, HEADER_LEN);
+            s_partial = NULL;
+        } else {
+            /* the start of the next packet came in the same segment */
+            packet = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+            pbuf_copy_partial(s_partial, packet->payload, len, HEADER_LEN);
+            s_partial = pbuf_free_header(s_partial, HEADER_LEN + len);
+        }
+        sys_mbox_post(&s_decode_q, packet);
+        tcp_write(pcb, report, REPORT_LEN, TCP_WRITE_FLAG_COPY);
+        tcp_output(pcb);
+        reports++;
+    }
+    if (reports == 0 && s_tuned) {
+        tcp_ack_now(pcb);
+        s_quickacks++;
+    }
+    return ERR_OK;
+}
+
+static err_t sink_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+    if (s_tuned) {
+        tcp_nagle_disable(newpcb);
+        s_shrink = TCP_WND - window_for(NOMINAL_BITRATE);
+    }
+    tcp_recv(newpcb, sink_recv);
+    return ERR_OK;
+}
+
+static void sink_setup(void *arg)
+{
+    struct tcp_pcb *pcb = tcp_new();
+    tcp_bind(pcb, IP_ADDR_ANY, (u16_t)(intptr_t)arg);
+    pcb = tcp_listen_with_backlog(pcb, 1);
+    tcp_accept(pcb, sink_accept);
+    sys_sem_signal(&s_ready);
+}
+
+static void sink_decode(void *arg)
+{
+    struct pbuf *p;
+    while (1) {
+        sys_arch_mbox_fetch(&s_decode_q, (void **)&p, 0);
+        if (p == NULL) {
+            break;
+        }
+        s_checksum += p->tot_len;
+        pbuf_free(p);
+    }
+    sys_sem_signal(&s_ready);
+}
+
+/* ---- client, like the host ---- */
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void run(int tuned, int credits, int packet_len, int port)
+{
+    static uint32_t latency[PACKETS];
+    uint64_t sent[MAX_CREDITS];
+    unsigned char packet[HEADER_LEN + MAX_PACKET];
+    char report[REPORT_LEN * MAX_CREDITS];
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = lwip_htons(port) };
+
+    s_tuned = tuned;
+    s_shrink = 0;
+    s_quickacks = 0;
+    s_checksum = 0;
+    sys_mbox_new(&s_decode_q, QUEUE_LEN);
+    tcpip_callback(sink_setup, (void *)(intptr_t)port);
+    sys_thread_new("decode", sink_decode, NULL, 0, 0);
+    sys_arch_sem_wait(&s_ready, 0);
+
+    memset(packet, 0x5a, sizeof(packet));
+    packet[0] = (unsigned char)(packet_len >> 8);
+    packet[1] = (unsigned char)(packet_len & 0xff);
+    addr.sin_addr.s_addr = lwip_htonl(INADDR_LOOPBACK);
+    int sock = lwip_socket(AF_INET, SOCK_STREAM, 0);
+    if (tuned) {
+        int one = 1;
+        lwip_setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    if (lwip_connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "connect failed\n");
+        exit(1);
+    }
+
+    /* sent[] is a ring of the send times of the packets waiting for a report */
+    int next = 0, done = 0, received = 0;
+    uint64_t wall0 = now_ns();
+    while (done < PACKETS) {
+        while (next < PACKETS && next - done < credits) {
+            sent[next % MAX_CREDITS] = now_ns();
+            lwip_send(sock, packet, HEADER_LEN + packet_len, 0);
+            next++;
+        }
+        int len = lwip_recv(sock, report, sizeof(report), 0);
+        if (len <= 0) {
+            fprintf(stderr, "recv failed\n");
+            exit(1);
+        }
+        uint64_t now = now_ns();
+        for (received += len; received >= REPORT_LEN; received -= REPORT_LEN) {
+            latency[done] = (uint32_t)(now - sent[done % MAX_CREDITS]);
+            done++;
+        }
+    }
+    uint64_t wall = now_ns() - wall0;
+    lwip_close(sock);
+    sys_arch_sem_wait(&s_ready, 0);
+    sys_mbox_free(&s_decode_q);
+    if (s_checksum != (unsigned)PACKETS * packet_len) {
+        fprintf(stderr, "sink decoded %u bytes, sent %d\n", s_checksum, PACKETS * packet_len);
+        exit(1);
+    }
+
+    uint64_t sum = 0;
+    for (int i = 0; i < PACKETS; i++) {
+        sum += latency[i];
+    }
+    qsort(latency, PACKETS, sizeof(latency[0]), cmp_u32);
+    printf("  %-7s %d  %4d B  %8.0f packets/s  latency avg %8.1f us  p50 %8.1f us  p99 %8.1f us  %4u quick acks\n",
+           tuned ? "tuned" : "default", credits, packet_len, PACKETS * 1e9 / wall, sum / 1e3 / PACKETS,
+           latency[PACKETS / 2] / 1e3, latency[PACKETS * 99 / 100] / 1e3, s_quickacks);
+}
+
+static void tcpip_ready(void *arg)
+{
+    sys_sem_signal(&s_ready);
+}
+
+int main(void)
+{
+    static const int sizes[] = { 200, 1000, 1500 };
+    int port = PORT_BASE;
+
+    sys_sem_new(&s_ready, 0);
+    tcpip_init(tcpip_ready, NULL);
+    sys_arch_sem_wait(&s_ready, 0);
+
+    printf("TCP_WND %d, TCP_MSS %d, tuned receive window %d, %d packets per run\n", TCP_WND, TCP_MSS,
+           window_for(NOMINAL_BITRATE), PACKETS);
+    printf("  mode    credits  size\n");
+    for (int credits = 1; credits <= 2; credits++) {
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            run(0, credits, sizes[i], port++);
+            run(1, credits, sizes[i], port++);
+        }
+    }
+    return 0;
+}
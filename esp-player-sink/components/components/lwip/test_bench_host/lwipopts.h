@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LWIP_BENCH_LWIPOPTS_H
+#define LWIP_BENCH_LWIPOPTS_H
+
+/*
+ * Host benchmark options, the memory, TCP and mailbox settings mirror the
+ * esp-player-sink sdkconfig so the numbers are comparable with the target.
+ */
+
+#define NO_SYS                          0
+#define SYS_LIGHTWEIGHT_PROT            1
+#define LWIP_TCPIP_CORE_LOCKING         0
+#define LWIP_SOCKET                     1
+#define LWIP_NETCONN                    1
+#define LWIP_COMPAT_SOCKETS             0
+#define LWIP_POSIX_SOCKETS_IO_NAMES     0
+#define LWIP_TIMEVAL_PRIVATE            0
+
+#define LWIP_NETIF_LOOPBACK             1
+#define LWIP_HAVE_LOOPIF                1
+#define LWIP_LOOPBACK_MAX_PBUFS         0
+
+#define MEM_LIBC_MALLOC                 1
+#define MEMP_MEM_MALLOC                 1
+#define MEM_ALIGNMENT                   8
+
+#ifdef BENCH_HYBRID
+#define MEMP_MEM_MALLOC_HYBRID          1
+#define MEMP_HYBRID_NUM(type)           ((type) == MEMP_PBUF_POOL ? 0 : \
+                                         (type) == MEMP_TCP_SEG ? 16 : \
+                                         (type) == MEMP_NETBUF ? 8 : 0)
+#else
+#define MEMP_MEM_MALLOC_HYBRID          0
+#endif
+
+#define TCP_MSS                         1440
+#define TCP_SND_BUF                     5744
+#ifndef TCP_WND
+#define TCP_WND                         5744
+#endif
+#define TCP_SND_QUEUELEN                ((4 * (TCP_SND_BUF) + (TCP_MSS - 1)) / (TCP_MSS))
+#define TCP_QUEUE_OOSEQ                 1
+#define MEMP_NUM_TCP_PCB                16
+#define MEMP_NUM_UDP_PCB                16
+#define MEMP_NUM_NETCONN                16
+
+#define TCPIP_MBOX_SIZE                 32
+#define DEFAULT_TCP_RECVMBOX_SIZE       6
+#define DEFAULT_UDP_RECVMBOX_SIZE       6
+#define DEFAULT_ACCEPTMBOX_SIZE         6
+#define DEFAULT_RAW_RECVMBOX_SIZE       6
+#define TCPIP_THREAD_STACKSIZE          0
+#define TCPIP_THREAD_PRIO               0
+
+#define LWIP_IPV4                       1
+#define LWIP_IPV6                       0
+#define LWIP_ARP                        0
+#define LWIP_ETHERNET                   0
+#define LWIP_DHCP                       0
+#define LWIP_DNS                        0
+#define LWIP_IGMP                       0
+
+/* the checksum routines of the sink sdkconfig plus the copy routine, bench_chksum overrides them */
+#ifndef LWIP_CHKSUM_ALGORITHM
+#define LWIP_CHKSUM_ALGORITHM           4
+#endif
+#define LWIP_CHECKSUM_ON_COPY           1
+#ifndef LWIP_CHKSUM_COPY_ALGORITHM
+#define LWIP_CHKSUM_COPY_ALGORITHM      2
+#endif
+
+#define LWIP_STATS                      1
+#define LWIP_STATS_DISPLAY              1
+#define LWIP_STATS_LARGE                1
+
+#endif /* LWIP_BENCH_LWIPOPTS_H */
@@ -0,0 +1,291 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "lwip/opt.h"
+#include "lwip/err.h"
+#include "lwip/sys.h"
+
+struct sys_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned count;
+};
+
+struct sys_mutex {
+    pthread_mutex_t lock;
+};
+
+struct sys_mbox {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    int size;
+    int head;
+    int count;
+    void *msgs[];
+};
+
+struct thread_start {
+    lwip_thread_fn fn;
+    void *arg;
+};
+
+static pthread_mutex_t s_protect = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Wait on a condition variable for at most timeout_ms (0 waits forever), returns false on timeout
+static bool cond_wait_ms(pthread_cond_t *cond, pthread_mutex_t *lock, u32_t timeout_ms)
+{
+    if (timeout_ms == 0) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return pthread_cond_timedwait(cond, lock, &ts) != ETIMEDOUT;
+}
+
+void sys_init(void)
+{
+}
+
+u32_t sys_now(void)
+{
+    return (u32_t)now_ms();
+}
+
+sys_prot_t sys_arch_protect(void)
+{
+    pthread_mutex_lock(&s_protect);
+    return 1;
+}
+
+void sys_arch_unprotect(sys_prot_t pval)
+{
+    LWIP_UNUSED_ARG(pval);
+    pthread_mutex_unlock(&s_protect);
+}
+
+err_t sys_sem_new(sys_sem_t *sem, u8_t count)
+{
+    struct sys_sem *s = calloc(1, sizeof(*s));
+    if (s == NULL) {
+        return ERR_MEM;
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    s->count = count;
+    *sem = s;
+    return ERR_OK;
+}
+
+void sys_sem_free(sys_sem_t *sem)
+{
+    pthread_cond_destroy(&(*sem)->cond);
+    pthread_mutex_destroy(&(*sem)->lock);
+    free(*sem);
+    *sem = NULL;
+}
+
+void sys_sem_signal(sys_sem_t *sem)
+{
+    struct sys_sem *s = *sem;
+    pthread_mutex_lock(&s->lock);
+    s->count++;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+}
+
+u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout)
+{
+    struct sys_sem *s = *sem;
+    uint64_t start = now_ms();
+    pthread_mutex_lock(&s->lock);
+    while (s->count == 0) {
+        if (!cond_wait_ms(&s->cond, &s->lock, timeout)) {
+            pthread_mutex_unlock(&s->lock);
+            return SYS_ARCH_TIMEOUT;
+        }
+    }
+    s->count--;
+    pthread_mutex_unlock(&s->lock);
+    return (u32_t)(now_ms() - start);
+}
+
+err_t sys_mutex_new(sys_mutex_t *mutex)
+{
+    struct sys_mutex *m = calloc(1, sizeof(*m));
+    if (m == NULL) {
+        return ERR_MEM;
+    }
+    pthread_mutex_init(&m->lock, NULL);
+    *mutex = m;
+    return ERR_OK;
+}
+
+void sys_mutex_free(sys_mutex_t *mutex)
+{
+    pthread_mutex_destroy(&(*mutex)->lock);
+    free(*mutex);
+    *mutex = NULL;
+}
+
+void sys_mutex_lock(sys_mutex_t *mutex)
+{
+    pthread_mutex_lock(&(*mutex)->lock);
+}
+
+void sys_mutex_unlock(sys_mutex_t *mutex)
+{
+    pthread_mutex_unlock(&(*mutex)->lock);
+}
+
+err_t sys_mbox_new(sys_mbox_t *mbox, int size)
+{
+    if (size <= 0) {
+        size = 32;
+    }
+    struct sys_mbox *m = calloc(1, sizeof(*m) + size * sizeof(void *));
+    if (m == NULL) {
+        return ERR_MEM;
+    }
+    pthread_mutex_init(&m->lock, NULL);
+    pthread_cond_init(&m->not_empty, NULL);
+    pthread_cond_init(&m->not_full, NULL);
+    m->size = size;
+    *mbox = m;
+    return ERR_OK;
+}
+
+void sys_mbox_free(sys_mbox_t *mbox)
+{
+    struct sys_mbox *m = *mbox;
+    pthread_cond_destroy(&m->not_full);
+    pthread_cond_destroy(&m->not_empty);
+    pthread_mutex_destroy(&m->lock);
+    free(m);
+    *mbox = NULL;
+}
+
+static void mbox_put_locked(struct sys_mbox *m, void *msg)
+{
+    m->msgs[(m->head + m->count) % m->size] = msg;
+    m->count++;
+    pthread_cond_signal(&m->not_empty);
+}
+
+void sys_mbox_post(sys_mbox_t *mbox, void *msg)
+{
+    struct sys_mbox *m = *mbox;
+    pthread_mutex_lock(&m->lock);
+    while (m->count == m->size) {
+        pthread_cond_wait(&m->not_full, &m->lock);
+    }
+    mbox_put_locked(m, msg);
+    pthread_mutex_unlock(&m->lock);
+}
+
+err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg)
+{
+    struct sys_mbox *m = *mbox;
+    err_t err = ERR_MEM;
+    pthread_mutex_lock(&m->lock);
+    if (m->count < m->size) {
+        mbox_put_locked(m, msg);
+        err = ERR_OK;
+    }
+    pthread_mutex_unlock(&m->lock);
+    return err;
+}
+
+err_t sys_mbox_trypost_fromisr(sys_mbox_t *mbox, void *msg)
+{
+    return sys_mbox_trypost(mbox, msg);
+}
+
+static void *mbox_get_locked(struct sys_mbox *m)
+{
+    void *msg = m->msgs[m->head];
+    m->head = (m->head + 1) % m->size;
+    m->count--;
+    pthread_cond_signal(&m->not_full);
+    return msg;
+}
+
+u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout)
+{
+    struct sys_mbox *m = *mbox;
+    uint64_t start = now_ms();
+    pthread_mutex_lock(&m->lock);
+    while (m->count == 0) {
+        if (!cond_wait_ms(&m->not_empty, &m->lock, timeout)) {
+            pthread_mutex_unlock(&m->lock);
+            return SYS_ARCH_TIMEOUT;
+        }
+    }
+    void *got = mbox_get_locked(m);
+    pthread_mutex_unlock(&m->lock);
+    if (msg != NULL) {
+        *msg = got;
+    }
+    return (u32_t)(now_ms() - start);
+}
+
+u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg)
+{
+    struct sys_mbox *m = *mbox;
+    pthread_mutex_lock(&m->lock);
+    if (m->count == 0) {
+        pthread_mutex_unlock(&m->lock);
+        return SYS_MBOX_EMPTY;
+    }
+    void *got = mbox_get_locked(m);
+    pthread_mutex_unlock(&m->lock);
+    if (msg != NULL) {
+        *msg = got;
+    }
+    return 0;
+}
+
+static void *thread_start(void *arg)
+{
+    struct thread_start start = *(struct thread_start *)arg;
+    free(arg);
+    start.fn(start.arg);
+    return NULL;
+}
+
+sys_thread_t sys_thread_new(const char *name, lwip_thread_fn thread, void *arg, int stacksize, int prio)
+{
+    LWIP_UNUSED_ARG(name);
+    LWIP_UNUSED_ARG(stacksize);
+    LWIP_UNUSED_ARG(prio);
+    pthread_t tid;
+    struct thread_start *start = malloc(sizeof(*start));
+    LWIP_ASSERT("out of memory", start != NULL);
+    start->fn = thread;
+    start->arg = arg;
+    int ret = pthread_create(&tid, NULL, thread_start, start);
+    LWIP_ASSERT("pthread_create failed", ret == 0);
+    pthread_detach(tid);
+    return tid;
+}
@@ -22,6 +22,9 @@
 /* Enable bitstream changes from draft-ietf-codec-opus-update */
 /* #undef ENABLE_UPDATE_DRAFT */
 
+/* Use FFT kernels specialized for the static 48 kHz fixed-point modes */
+#define ENABLE_STATIC_FFT 1
+
 /* Debug fixed-point implementation */
 /* #undef FIXED_DEBUG */
 
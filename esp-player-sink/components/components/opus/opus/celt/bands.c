@@ -1057,7 +1057,7 @@ static unsigned quant_partition(struct band_ctx *ctx, celt_norm *X,
          {
             cm = alg_quant(X, N, K, spread, B, ec, gain, ctx->resynth, ctx->arch);
          } else {
-            cm = alg_unquant(X, N, K, spread, B, ec, gain);
+            cm = alg_unquant(X, N, K, spread, B, ec, gain, ctx->arch);
          }
       } else {
          /* If there's no pulse, fill the band anyway */
@@ -306,6 +306,70 @@ void dump_header(FILE *file, CELTMode **modes, int nb_modes)
    }
 }
 
+#ifdef FIXED_POINT
+/* Dumps the twiddles of every non-trivial FFT stage in the order in which the
+   butterflies consume them, so that the specialized kernels in
+   kiss_fft_static.c can read them sequentially rather than with a stride of
+   fstride<<shift into the full twiddle table. */
+void dump_static_fft(FILE *file, CELTMode **modes, int nb_modes)
+{
+   int i, j, k, L, q, n;
+   fprintf(file, "/* The contents of this file was automatically generated by dump_modes.c\n");
+   fprintf(file, "   with arguments:");
+   for (i=0;i<nb_modes;i++)
+   {
+      CELTMode *mode = modes[i];
+      fprintf(file, " %d %d",mode->Fs,mode->shortMdctSize*mode->nbShortMdcts);
+   }
+   fprintf(file, "\n   It contains the per-stage sequential FFT twiddles used by kiss_fft_static.c. */\n");
+   fprintf(file, "#include \"kiss_fft.h\"\n");
+   fprintf(file, "\n");
+
+   for (i=0;i<nb_modes;i++)
+   {
+      CELTMode *mode = modes[i];
+      for (k=0;k<=mode->mdct.maxshift;k++)
+      {
+         const kiss_fft_state *st = mode->mdct.kfft[k];
+         int fstride[MAXFACTORS];
+         int shift = st->shift>0 ? st->shift : 0;
+         fstride[0] = 1;
+         L=0;
+         do {
+            fstride[L+1] = fstride[L]*st->factors[2*L];
+            L++;
+         } while (st->factors[2*L-1]!=1);
+         for (j=0;j<L;j++)
+         {
+            int p = st->factors[2*j];
+            int m = st->factors[2*j+1];
+            int stride = fstride[j]<<shift;
+            /* Radix-2 and the degenerate m==1 radix-4 use constant twiddles. */
+            if (p==2 || m==1)
+               continue;
+            fprintf(file, "#ifndef FFT_SEQ_TWIDDLES%d_%d\n", st->nfft, j);
+            fprintf(file, "#define FFT_SEQ_TWIDDLES%d_%d\n", st->nfft, j);
+            fprintf(file, "static const kiss_twiddle_cpx fft_seq_twiddles%d_%d[%d] = {\n",
+                  st->nfft, j, (p-1)*m);
+            n = 0;
+            for (q=0;q<m;q++)
+            {
+               int r;
+               for (r=1;r<p;r++)
+               {
+                  const kiss_twiddle_cpx *tw = &st->twiddles[r*q*stride];
+                  fprintf (file, "{" WORD16 ", " WORD16 "},%c", tw->r, tw->i, (++n)%4==0?'\n':' ');
+               }
+            }
+            fprintf (file, "};\n");
+            fprintf(file, "#endif\n");
+            fprintf(file, "\n");
+         }
+      }
+   }
+}
+#endif
+
 #ifdef FIXED_POINT
 #define BASENAME "static_modes_fixed"
 #else
@@ -343,6 +407,11 @@ int main(int argc, char **argv)
 #endif
    dump_modes(file, m, nb);
    fclose(file);
+#ifdef FIXED_POINT
+   file = fopen("static_fft_fixed.h", "w");
+   dump_static_fft(file, m, nb);
+   fclose(file);
+#endif
 #ifdef OVERRIDE_FFT
    dump_modes_arch_finalize();
 #endif
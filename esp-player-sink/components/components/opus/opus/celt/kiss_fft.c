@@ -518,7 +518,7 @@ void opus_fft_free(const kiss_fft_state *cfg, int arch)
 
 #endif /* CUSTOM_MODES */
 
-void opus_fft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout)
+void opus_fft_impl_c(const kiss_fft_state *st,kiss_fft_cpx *fout)
 {
     int m2, m;
     int p;
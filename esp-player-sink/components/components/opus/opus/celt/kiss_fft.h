@@ -100,6 +100,10 @@ typedef struct kiss_fft_state{
 #include "arm/fft_arm.h"
 #endif
 
+#if defined(ENABLE_STATIC_FFT)
+#include "kiss_fft_static.h"
+#endif
+
 /*typedef struct kiss_fft_state* kiss_fft_cfg;*/
 
 /**
@@ -142,9 +146,13 @@ kiss_fft_state *opus_fft_alloc(int nfft,void * mem,size_t * lenmem, int arch);
 void opus_fft_c(const kiss_fft_state *cfg,const kiss_fft_cpx *fin,kiss_fft_cpx *fout);
 void opus_ifft_c(const kiss_fft_state *cfg,const kiss_fft_cpx *fin,kiss_fft_cpx *fout);
 
-void opus_fft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout);
+void opus_fft_impl_c(const kiss_fft_state *st,kiss_fft_cpx *fout);
 void opus_ifft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout);
 
+#if !defined(OVERRIDE_OPUS_FFT_IMPL)
+#define opus_fft_impl(_st, _fout) opus_fft_impl_c(_st, _fout)
+#endif
+
 void opus_fft_free(const kiss_fft_state *cfg, int arch);
 
 
@@ -0,0 +1,310 @@
+/* Copyright (c) 2023 Xiph.Org Foundation */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Specialized FFT for the static 48 kHz/960 fixed-point mode. The stage
+   sequence of each of the four MDCT sizes is known at compile time, so the
+   butterflies are called with constant radix, length and stride, and the
+   twiddles of each stage are read from per-stage tables laid out in
+   consumption order (see static_fft_fixed.h) rather than with a stride of
+   fstride<<shift into the 480-entry table. The arithmetic is identical to
+   kiss_fft.c, so the output is bit-exact with opus_fft_impl_c(). */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "kiss_fft.h"
+
+#if defined(ENABLE_STATIC_FFT) && defined(FIXED_POINT) && !defined(CUSTOM_MODES)
+
+#include "_kiss_fft_guts.h"
+#include "arch.h"
+#include "static_fft_fixed.h"
+
+/* Radix-2 stage following the degenerate radix-4, so m==4. */
+static OPUS_INLINE void kf_bfly2_m4(kiss_fft_cpx * OPUS_RESTRICT Fout, int N)
+{
+   int i;
+   const opus_val16 tw = QCONST16(0.7071067812f, 15);
+   for (i=0;i<N;i++)
+   {
+      kiss_fft_cpx t;
+      kiss_fft_cpx * OPUS_RESTRICT Fout2 = Fout + 4;
+      t = Fout2[0];
+      C_SUB( Fout2[0] ,  Fout[0] , t );
+      C_ADDTO( Fout[0] ,  t );
+
+      t.r = S_MUL(ADD32_ovflw(Fout2[1].r, Fout2[1].i), tw);
+      t.i = S_MUL(SUB32_ovflw(Fout2[1].i, Fout2[1].r), tw);
+      C_SUB( Fout2[1] ,  Fout[1] , t );
+      C_ADDTO( Fout[1] ,  t );
+
+      t.r = Fout2[2].i;
+      t.i = -Fout2[2].r;
+      C_SUB( Fout2[2] ,  Fout[2] , t );
+      C_ADDTO( Fout[2] ,  t );
+
+      t.r = S_MUL(SUB32_ovflw(Fout2[3].i, Fout2[3].r), tw);
+      t.i = S_MUL(NEG32_ovflw(ADD32_ovflw(Fout2[3].i, Fout2[3].r)), tw);
+      C_SUB( Fout2[3] ,  Fout[3] , t );
+      C_ADDTO( Fout[3] ,  t );
+      Fout += 8;
+   }
+}
+
+/* First (innermost) radix-4 stage, where all the twiddles are 1. */
+static OPUS_INLINE void kf_bfly4_m1(kiss_fft_cpx * OPUS_RESTRICT Fout, int N)
+{
+   int i;
+   for (i=0;i<N;i++)
+   {
+      kiss_fft_cpx scratch0, scratch1;
+
+      C_SUB( scratch0 , *Fout, Fout[2] );
+      C_ADDTO(*Fout, Fout[2]);
+      C_ADD( scratch1 , Fout[1] , Fout[3] );
+      C_SUB( Fout[2], *Fout, scratch1 );
+      C_ADDTO( *Fout , scratch1 );
+      C_SUB( scratch1 , Fout[1] , Fout[3] );
+
+      Fout[1].r = ADD32_ovflw(scratch0.r, scratch1.i);
+      Fout[1].i = SUB32_ovflw(scratch0.i, scratch1.r);
+      Fout[3].r = SUB32_ovflw(scratch0.r, scratch1.i);
+      Fout[3].i = ADD32_ovflw(scratch0.i, scratch1.r);
+      Fout+=4;
+   }
+}
+
+/* One radix-4 butterfly; tw holds {w^j, w^2j, w^3j} back to back. */
+static OPUS_INLINE void kf_bfly4_one(kiss_fft_cpx * OPUS_RESTRICT Fout,
+      const kiss_twiddle_cpx * OPUS_RESTRICT tw, int m)
+{
+   kiss_fft_cpx scratch[6];
+   C_MUL(scratch[0],Fout[m] , tw[0] );
+   C_MUL(scratch[1],Fout[2*m] , tw[1] );
+   C_MUL(scratch[2],Fout[3*m] , tw[2] );
+
+   C_SUB( scratch[5] , *Fout, scratch[1] );
+   C_ADDTO(*Fout, scratch[1]);
+   C_ADD( scratch[3] , scratch[0] , scratch[2] );
+   C_SUB( scratch[4] , scratch[0] , scratch[2] );
+   C_SUB( Fout[2*m], *Fout, scratch[3] );
+   C_ADDTO( *Fout , scratch[3] );
+
+   Fout[m].r = ADD32_ovflw(scratch[5].r, scratch[4].i);
+   Fout[m].i = SUB32_ovflw(scratch[5].i, scratch[4].r);
+   Fout[3*m].r = SUB32_ovflw(scratch[5].r, scratch[4].i);
+   Fout[3*m].i = ADD32_ovflw(scratch[5].i, scratch[4].r);
+}
+
+static OPUS_INLINE void kf_bfly4_seq(kiss_fft_cpx * OPUS_RESTRICT Fout,
+      const kiss_twiddle_cpx * OPUS_RESTRICT tw, int m, int N, int mm)
+{
+   int i, j;
+   for (i=0;i<N;i++)
+   {
+      kiss_fft_cpx * OPUS_RESTRICT F = Fout + i*mm;
+      const kiss_twiddle_cpx * OPUS_RESTRICT t = tw;
+      /* m is a multiple of 4 for all the static sizes. */
+      for (j=0;j<m;j+=4)
+      {
+         kf_bfly4_one(F, t, m);
+         kf_bfly4_one(F+1, t+3, m);
+         kf_bfly4_one(F+2, t+6, m);
+         kf_bfly4_one(F+3, t+9, m);
+         F += 4;
+         t += 12;
+      }
+   }
+}
+
+/* One radix-3 butterfly; tw holds {w^j, w^2j} back to back. */
+static OPUS_INLINE void kf_bfly3_one(kiss_fft_cpx * OPUS_RESTRICT Fout,
+      const kiss_twiddle_cpx * OPUS_RESTRICT tw, int m)
+{
+   kiss_fft_cpx scratch[4];
+   const opus_val16 epi3_i = -28378;
+
+   C_MUL(scratch[1],Fout[m] , tw[0]);
+   C_MUL(scratch[2],Fout[2*m] , tw[1]);
+
+   C_ADD(scratch[3],scratch[1],scratch[2]);
+   C_SUB(scratch[0],scratch[1],scratch[2]);
+
+   Fout[m].r = SUB32_ovflw(Fout->r, HALF_OF(scratch[3].r));
+   Fout[m].i = SUB32_ovflw(Fout->i, HALF_OF(scratch[3].i));
+
+   C_MULBYSCALAR( scratch[0] , epi3_i );
+
+   C_ADDTO(*Fout,scratch[3]);
+
+   Fout[2*m].r = ADD32_ovflw(Fout[m].r, scratch[0].i);
+   Fout[2*m].i = SUB32_ovflw(Fout[m].i, scratch[0].r);
+
+   Fout[m].r = SUB32_ovflw(Fout[m].r, scratch[0].i);
+   Fout[m].i = ADD32_ovflw(Fout[m].i, scratch[0].r);
+}
+
+static OPUS_INLINE void kf_bfly3_seq(kiss_fft_cpx * OPUS_RESTRICT Fout,
+      const kiss_twiddle_cpx * OPUS_RESTRICT tw, int m, int N, int mm)
+{
+   int i, j;
+   for (i=0;i<N;i++)
+   {
+      kiss_fft_cpx * OPUS_RESTRICT F = Fout + i*mm;
+      const kiss_twiddle_cpx * OPUS_RESTRICT t = tw;
+      for (j=0;j<m;j+=4)
+      {
+         kf_bfly3_one(F, t, m);
+         kf_bfly3_one(F+1, t+2, m);
+         kf_bfly3_one(F+2, t+4, m);
+         kf_bfly3_one(F+3, t+6, m);
+         F += 4;
+         t += 8;
+      }
+   }
+}
+
+/* Radix-5 is always the outermost stage, so it runs once (N==1). tw holds
+   {w^u, w^2u, w^3u, w^4u} back to back. */
+static OPUS_INLINE void kf_bfly5_seq(kiss_fft_cpx * OPUS_RESTRICT Fout,
+      const kiss_twiddle_cpx * OPUS_RESTRICT tw, int m)
+{
+   kiss_fft_cpx *Fout0,*Fout1,*Fout2,*Fout3,*Fout4;
+   int u;
+   kiss_fft_cpx scratch[13];
+   const opus_val16 ya_r = 10126;
+   const opus_val16 ya_i = -31164;
+   const opus_val16 yb_r = -26510;
+   const opus_val16 yb_i = -19261;
+
+   Fout0=Fout;
+   Fout1=Fout0+m;
+   Fout2=Fout0+2*m;
+   Fout3=Fout0+3*m;
+   Fout4=Fout0+4*m;
+
+   for ( u=0; u<m; ++u ) {
+      scratch[0] = *Fout0;
+
+      C_MUL(scratch[1] ,*Fout1, tw[0]);
+      C_MUL(scratch[2] ,*Fout2, tw[1]);
+      C_MUL(scratch[3] ,*Fout3, tw[2]);
+      C_MUL(scratch[4] ,*Fout4, tw[3]);
+      tw += 4;
+
+      C_ADD( scratch[7],scratch[1],scratch[4]);
+      C_SUB( scratch[10],scratch[1],scratch[4]);
+      C_ADD( scratch[8],scratch[2],scratch[3]);
+      C_SUB( scratch[9],scratch[2],scratch[3]);
+
+      Fout0->r = ADD32_ovflw(Fout0->r, ADD32_ovflw(scratch[7].r, scratch[8].r));
+      Fout0->i = ADD32_ovflw(Fout0->i, ADD32_ovflw(scratch[7].i, scratch[8].i));
+
+      scratch[5].r = ADD32_ovflw(scratch[0].r, ADD32_ovflw(S_MUL(scratch[7].r,ya_r), S_MUL(scratch[8].r,yb_r)));
+      scratch[5].i = ADD32_ovflw(scratch[0].i, ADD32_ovflw(S_MUL(scratch[7].i,ya_r), S_MUL(scratch[8].i,yb_r)));
+
+      scratch[6].r =  ADD32_ovflw(S_MUL(scratch[10].i,ya_i), S_MUL(scratch[9].i,yb_i));
+      scratch[6].i = NEG32_ovflw(ADD32_ovflw(S_MUL(scratch[10].r,ya_i), S_MUL(scratch[9].r,yb_i)));
+
+      C_SUB(*Fout1,scratch[5],scratch[6]);
+      C_ADD(*Fout4,scratch[5],scratch[6]);
+
+      scratch[11].r = ADD32_ovflw(scratch[0].r, ADD32_ovflw(S_MUL(scratch[7].r,yb_r), S_MUL(scratch[8].r,ya_r)));
+      scratch[11].i = ADD32_ovflw(scratch[0].i, ADD32_ovflw(S_MUL(scratch[7].i,yb_r), S_MUL(scratch[8].i,ya_r)));
+      scratch[12].r = SUB32_ovflw(S_MUL(scratch[9].i,ya_i), S_MUL(scratch[10].i,yb_i));
+      scratch[12].i = SUB32_ovflw(S_MUL(scratch[10].r,yb_i), S_MUL(scratch[9].r,ya_i));
+
+      C_ADD(*Fout2,scratch[11],scratch[12]);
+      C_SUB(*Fout3,scratch[11],scratch[12]);
+
+      ++Fout0;++Fout1;++Fout2;++Fout3;++Fout4;
+   }
+}
+
+/* The stages run from the innermost (last factor) to the outermost, exactly
+   as in opus_fft_impl_c(). The arguments are the (m, N, m2) triplets it
+   derives from the factors of each static state:
+     480: {5,96, 3,32, 4,8, 2,4, 4,1}
+     240: {5,48, 3,16, 4,4, 4,1}
+     120: {5,24, 3,8, 2,4, 4,1}
+      60: {5,12, 3,4, 4,1} */
+
+static void opus_fft480(kiss_fft_cpx *fout)
+{
+   kf_bfly4_m1(fout, 120);
+   kf_bfly2_m4(fout, 60);
+   kf_bfly4_seq(fout, fft_seq_twiddles480_2, 8, 15, 32);
+   kf_bfly3_seq(fout, fft_seq_twiddles480_1, 32, 5, 96);
+   kf_bfly5_seq(fout, fft_seq_twiddles480_0, 96);
+}
+
+static void opus_fft240(kiss_fft_cpx *fout)
+{
+   kf_bfly4_m1(fout, 60);
+   kf_bfly4_seq(fout, fft_seq_twiddles240_2, 4, 15, 16);
+   kf_bfly3_seq(fout, fft_seq_twiddles240_1, 16, 5, 48);
+   kf_bfly5_seq(fout, fft_seq_twiddles240_0, 48);
+}
+
+static void opus_fft120(kiss_fft_cpx *fout)
+{
+   kf_bfly4_m1(fout, 30);
+   kf_bfly2_m4(fout, 15);
+   kf_bfly3_seq(fout, fft_seq_twiddles120_1, 8, 5, 24);
+   kf_bfly5_seq(fout, fft_seq_twiddles120_0, 24);
+}
+
+static void opus_fft60(kiss_fft_cpx *fout)
+{
+   kf_bfly4_m1(fout, 15);
+   kf_bfly3_seq(fout, fft_seq_twiddles60_1, 4, 5, 12);
+   kf_bfly5_seq(fout, fft_seq_twiddles60_0, 12);
+}
+
+void opus_fft_impl_static(const kiss_fft_state *st, kiss_fft_cpx *fout)
+{
+   switch (st->nfft)
+   {
+   case 480:
+      opus_fft480(fout);
+      break;
+   case 240:
+      opus_fft240(fout);
+      break;
+   case 120:
+      opus_fft120(fout);
+      break;
+   case 60:
+      opus_fft60(fout);
+      break;
+   default:
+      opus_fft_impl_c(st, fout);
+      break;
+   }
+}
+
+#endif /* ENABLE_STATIC_FFT && FIXED_POINT && !CUSTOM_MODES */
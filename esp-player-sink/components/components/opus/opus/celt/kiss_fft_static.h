@@ -0,0 +1,48 @@
+/* Copyright (c) 2023 Xiph.Org Foundation */
+/**
+   @file kiss_fft_static.h
+   @brief FFT kernels specialized for the static 48 kHz fixed-point modes
+ */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#if !defined(KISS_FFT_STATIC_H)
+#define KISS_FFT_STATIC_H
+
+#include "kiss_fft.h"
+
+#if defined(ENABLE_STATIC_FFT) && defined(FIXED_POINT) && !defined(CUSTOM_MODES)
+
+/** In-place FFT on bit-reversed input with the stages of the 480/240/120/60
+    point transforms of the 48 kHz mode unrolled at compile time. Any other
+    size falls back to opus_fft_impl_c(). Bit-exact with the generic path. */
+void opus_fft_impl_static(const kiss_fft_state *st, kiss_fft_cpx *fout);
+
+#define OVERRIDE_OPUS_FFT_IMPL (1)
+#define opus_fft_impl(_st, _fout) opus_fft_impl_static(_st, _fout)
+
+#endif /* ENABLE_STATIC_FFT && FIXED_POINT && !CUSTOM_MODES */
+
+#endif
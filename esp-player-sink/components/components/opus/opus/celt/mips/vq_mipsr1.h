@@ -37,7 +37,7 @@
 #include "arch.h"
 
 #define OVERRIDE_vq_exp_rotation1
-static void exp_rotation1(celt_norm *X, int len, int stride, opus_val16 c, opus_val16 s)
+void exp_rotation1_c(celt_norm *X, int len, int stride, opus_val16 c, opus_val16 s)
 {
    int i;
    opus_val16 ms;
@@ -0,0 +1,284 @@
+/* The contents of this file was automatically generated by dump_modes.c
+   with arguments: 48000 960
+   It contains the per-stage sequential FFT twiddles used by kiss_fft_static.c. */
+#include "kiss_fft.h"
+
+#ifndef FFT_SEQ_TWIDDLES480_0
+#define FFT_SEQ_TWIDDLES480_0
+static const kiss_twiddle_cpx fft_seq_twiddles480_0[384] = {
+{32767, 0}, {32767, 0}, {32767, 0}, {32767, 0},
+{32766, -429}, {32757, -858}, {32743, -1287}, {32724, -1715},
+{32757, -858}, {32724, -1715}, {32667, -2570}, {32588, -3425},
+{32743, -1287}, {32667, -2570}, {32541, -3851}, {32364, -5125},
+{32724, -1715}, {32588, -3425}, {32364, -5125}, {32051, -6813},
+{32698, -2143}, {32488, -4277}, {32138, -6393}, {31652, -8481},
+{32667, -2570}, {32364, -5125}, {31863, -7650}, {31165, -10126},
+{32631, -2998}, {32219, -5971}, {31539, -8895}, {30592, -11741},
+{32588, -3425}, {32051, -6813}, {31165, -10126}, {29936, -13328},
+{32541, -3851}, {31863, -7650}, {30743, -11340}, {29197, -14875},
+{32488, -4277}, {31652, -8481}, {30274, -12540}, {28379, -16384},
+{32429, -4701}, {31419, -9306}, {29758, -13718}, {27482, -17845},
+{32364, -5125}, {31165, -10126}, {29197, -14875}, {26510, -19260},
+{32295, -5548}, {30889, -10937}, {28590, -16010}, {25466, -20621},
+{32219, -5971}, {30592, -11741}, {27940, -17119}, {24353, -21926},
+{32138, -6393}, {30274, -12540}, {27246, -18205}, {23171, -23171},
+{32051, -6813}, {29936, -13328}, {26510, -19260}, {21927, -24352},
+{31960, -7231}, {29577, -14107}, {25734, -20286}, {20622, -25465},
+{31863, -7650}, {29197, -14875}, {24918, -21281}, {19261, -26509},
+{31760, -8067}, {28797, -15635}, {24063, -22242}, {17846, -27481},
+{31652, -8481}, {28379, -16384}, {23171, -23171}, {16385, -28378},
+{31539, -8895}, {27940, -17119}, {22244, -24063}, {14878, -29197},
+{31419, -9306}, {27482, -17845}, {21282, -24917}, {13329, -29934},
+{31294, -9716}, {27006, -18560}, {20288, -25733}, {11744, -30592},
+{31165, -10126}, {26510, -19260}, {19261, -26509}, {10127, -31164},
+{31030, -10532}, {25997, -19947}, {18205, -27246}, {8482, -31652},
+{30889, -10937}, {25466, -20621}, {17122, -27940}, {6815, -32051},
+{30743, -11340}, {24918, -21281}, {16012, -28590}, {5127, -32364},
+{30592, -11741}, {24353, -21926}, {14878, -29197}, {3426, -32588},
+{30436, -12141}, {23770, -22555}, {13720, -29757}, {1716, -32724},
+{30274, -12540}, {23171, -23171}, {12540, -30274}, {0, -32767},
+{30107, -12935}, {22557, -23769}, {11342, -30743}, {-1715, -32724},
+{29936, -13328}, {21927, -24352}, {10127, -31164}, {-3425, -32588},
+{29758, -13718}, {21282, -24917}, {8895, -31537}, {-5125, -32364},
+{29577, -14107}, {20622, -25465}, {7650, -31862}, {-6813, -32051},
+{29390, -14493}, {19949, -25997}, {6393, -32138}, {-8481, -31652},
+{29197, -14875}, {19261, -26509}, {5127, -32364}, {-10126, -31165},
+{29000, -15257}, {18561, -27004}, {3852, -32541}, {-11741, -30592},
+{28797, -15635}, {17846, -27481}, {2572, -32667}, {-13328, -29936},
+{28590, -16010}, {17122, -27940}, {1287, -32742}, {-14875, -29197},
+{28379, -16384}, {16385, -28378}, {0, -32767}, {-16384, -28379},
+{28162, -16753}, {15636, -28797}, {-1287, -32743}, {-17845, -27482},
+{27940, -17119}, {14878, -29197}, {-2570, -32667}, {-19260, -26510},
+{27714, -17484}, {14108, -29576}, {-3851, -32541}, {-20621, -25466},
+{27482, -17845}, {13329, -29934}, {-5125, -32364}, {-21926, -24353},
+{27246, -18205}, {12540, -30274}, {-6393, -32138}, {-23171, -23171},
+{27006, -18560}, {11744, -30592}, {-7650, -31863}, {-24352, -21927},
+{26760, -18911}, {10939, -30889}, {-8895, -31539}, {-25465, -20622},
+{26510, -19260}, {10127, -31164}, {-10126, -31165}, {-26509, -19261},
+{26257, -19606}, {9307, -31418}, {-11340, -30743}, {-27481, -17846},
+{25997, -19947}, {8482, -31652}, {-12540, -30274}, {-28378, -16385},
+{25734, -20286}, {7650, -31862}, {-13718, -29758}, {-29197, -14878},
+{25466, -20621}, {6815, -32051}, {-14875, -29197}, {-29934, -13329},
+{25194, -20952}, {5973, -32219}, {-16010, -28590}, {-30592, -11744},
+{24918, -21281}, {5127, -32364}, {-17119, -27940}, {-31164, -10127},
+{24637, -21605}, {4278, -32487}, {-18205, -27246}, {-31652, -8482},
+{24353, -21926}, {3426, -32588}, {-19260, -26510}, {-32051, -6815},
+{24063, -22242}, {2572, -32667}, {-20286, -25734}, {-32364, -5127},
+{23770, -22555}, {1716, -32724}, {-21281, -24918}, {-32588, -3426},
+{23473, -22865}, {860, -32757}, {-22242, -24063}, {-32724, -1716},
+{23171, -23171}, {0, -32767}, {-23171, -23171}, {-32767, 0},
+{22866, -23472}, {-858, -32757}, {-24063, -22244}, {-32724, 1715},
+{22557, -23769}, {-1715, -32724}, {-24917, -21282}, {-32588, 3425},
+{22244, -24063}, {-2570, -32667}, {-25733, -20288}, {-32364, 5125},
+{21927, -24352}, {-3425, -32588}, {-26509, -19261}, {-32051, 6813},
+{21606, -24636}, {-4277, -32488}, {-27246, -18205}, {-31652, 8481},
+{21282, -24917}, {-5125, -32364}, {-27940, -17122}, {-31165, 10126},
+{20954, -25194}, {-5971, -32219}, {-28590, -16012}, {-30592, 11741},
+{20622, -25465}, {-6813, -32051}, {-29197, -14878}, {-29936, 13328},
+{20288, -25733}, {-7650, -31863}, {-29757, -13720}, {-29197, 14875},
+{19949, -25997}, {-8481, -31652}, {-30274, -12540}, {-28379, 16384},
+{19607, -26255}, {-9306, -31419}, {-30743, -11342}, {-27482, 17845},
+{19261, -26509}, {-10126, -31165}, {-31164, -10127}, {-26510, 19260},
+{18914, -26760}, {-10937, -30889}, {-31537, -8895}, {-25466, 20621},
+{18561, -27004}, {-11741, -30592}, {-31862, -7650}, {-24353, 21926},
+{18205, -27246}, {-12540, -30274}, {-32138, -6393}, {-23171, 23171},
+{17846, -27481}, {-13328, -29936}, {-32364, -5127}, {-21927, 24352},
+{17485, -27713}, {-14107, -29577}, {-32541, -3852}, {-20622, 25465},
+{17122, -27940}, {-14875, -29197}, {-32667, -2572}, {-19261, 26509},
+{16755, -28162}, {-15635, -28797}, {-32742, -1287}, {-17846, 27481},
+{16385, -28378}, {-16384, -28379}, {-32767, 0}, {-16385, 28378},
+{16012, -28590}, {-17119, -27940}, {-32743, 1287}, {-14878, 29197},
+{15636, -28797}, {-17845, -27482}, {-32667, 2570}, {-13329, 29934},
+{15258, -28999}, {-18560, -27006}, {-32541, 3851}, {-11744, 30592},
+{14878, -29197}, {-19260, -26510}, {-32364, 5125}, {-10127, 31164},
+{14494, -29389}, {-19947, -25997}, {-32138, 6393}, {-8482, 31652},
+{14108, -29576}, {-20621, -25466}, {-31863, 7650}, {-6815, 32051},
+{13720, -29757}, {-21281, -24918}, {-31539, 8895}, {-5127, 32364},
+{13329, -29934}, {-21926, -24353}, {-31165, 10126}, {-3426, 32588},
+{12937, -30107}, {-22555, -23770}, {-30743, 11340}, {-1716, 32724},
+{12540, -30274}, {-23171, -23171}, {-30274, 12540}, {0, 32767},
+{12142, -30435}, {-23769, -22557}, {-29758, 13718}, {1715, 32724},
+{11744, -30592}, {-24352, -21927}, {-29197, 14875}, {3425, 32588},
+{11342, -30743}, {-24917, -21282}, {-28590, 16010}, {5125, 32364},
+{10939, -30889}, {-25465, -20622}, {-27940, 17119}, {6813, 32051},
+{10534, -31030}, {-25997, -19949}, {-27246, 18205}, {8481, 31652},
+};
+#endif
+
+#ifndef FFT_SEQ_TWIDDLES480_1
+#define FFT_SEQ_TWIDDLES480_1
+static const kiss_twiddle_cpx fft_seq_twiddles480_1[64] = {
+{32767, 0}, {32767, 0}, {32698, -2143}, {32488, -4277},
+{32488, -4277}, {31652, -8481}, {32138, -6393}, {30274, -12540},
+{31652, -8481}, {28379, -16384}, {31030, -10532}, {25997, -19947},
+{30274, -12540}, {23171, -23171}, {29390, -14493}, {19949, -25997},
+{28379, -16384}, {16385, -28378}, {27246, -18205}, {12540, -30274},
+{25997, -19947}, {8482, -31652}, {24637, -21605}, {4278, -32487},
+{23171, -23171}, {0, -32767}, {21606, -24636}, {-4277, -32488},
+{19949, -25997}, {-8481, -31652}, {18205, -27246}, {-12540, -30274},
+{16385, -28378}, {-16384, -28379}, {14494, -29389}, {-19947, -25997},
+{12540, -30274}, {-23171, -23171}, {10534, -31030}, {-25997, -19949},
+{8482, -31652}, {-28378, -16385}, {6393, -32138}, {-30274, -12540},
+{4278, -32487}, {-31652, -8482}, {2144, -32698}, {-32487, -4278},
+{0, -32767}, {-32767, 0}, {-2143, -32698}, {-32488, 4277},
+{-4277, -32488}, {-31652, 8481}, {-6393, -32138}, {-30274, 12540},
+{-8481, -31652}, {-28379, 16384}, {-10532, -31030}, {-25997, 19947},
+{-12540, -30274}, {-23171, 23171}, {-14493, -29390}, {-19949, 25997},
+};
+#endif
+
+#ifndef FFT_SEQ_TWIDDLES480_2
+#define FFT_SEQ_TWIDDLES480_2
+static const kiss_twiddle_cpx fft_seq_twiddles480_2[24] = {
+{32767, 0}, {32767, 0}, {32767, 0}, {32138, -6393},
+{30274, -12540}, {27246, -18205}, {30274, -12540}, {23171, -23171},
+{12540, -30274}, {27246, -18205}, {12540, -30274}, {-6393, -32138},
+{23171, -23171}, {0, -32767}, {-23171, -23171}, {18205, -27246},
+{-12540, -30274}, {-32138, -6393}, {12540, -30274}, {-23171, -23171},
+{-30274, 12540}, {6393, -32138}, {-30274, -12540}, {-18205, 27246},
+};
+#endif
+
+#ifndef FFT_SEQ_TWIDDLES240_0
+#define FFT_SEQ_TWIDDLES240_0
+static const kiss_twiddle_cpx fft_seq_twiddles240_0[192] = {
+{32767, 0}, {32767, 0}, {32767, 0}, {32767, 0},
+{32757, -858}, {32724, -1715}, {32667, -2570}, {32588, -3425},
+{32724, -1715}, {32588, -3425}, {32364, -5125}, {32051, -6813},
+{32667, -2570}, {32364, -5125}, {31863, -7650}, {31165, -10126},
+{32588, -3425}, {32051, -6813}, {31165, -10126}, {29936, -13328},
+{32488, -4277}, {31652, -8481}, {30274, -12540}, {28379, -16384},
+{32364, -5125}, {31165, -10126}, {29197, -14875}, {26510, -19260},
+{32219, -5971}, {30592, -11741}, {27940, -17119}, {24353, -21926},
+{32051, -6813}, {29936, -13328}, {26510, -19260}, {21927, -24352},
+{31863, -7650}, {29197, -14875}, {24918, -21281}, {19261, -26509},
+{31652, -8481}, {28379, -16384}, {23171, -23171}, {16385, -28378},
+{31419, -9306}, {27482, -17845}, {21282, -24917}, {13329, -29934},
+{31165, -10126}, {26510, -19260}, {19261, -26509}, {10127, -31164},
+{30889, -10937}, {25466, -20621}, {17122, -27940}, {6815, -32051},
+{30592, -11741}, {24353, -21926}, {14878, -29197}, {3426, -32588},
+{30274, -12540}, {23171, -23171}, {12540, -30274}, {0, -32767},
+{29936, -13328}, {21927, -24352}, {10127, -31164}, {-3425, -32588},
+{29577, -14107}, {20622, -25465}, {7650, -31862}, {-6813, -32051},
+{29197, -14875}, {19261, -26509}, {5127, -32364}, {-10126, -31165},
+{28797, -15635}, {17846, -27481}, {2572, -32667}, {-13328, -29936},
+{28379, -16384}, {16385, -28378}, {0, -32767}, {-16384, -28379},
+{27940, -17119}, {14878, -29197}, {-2570, -32667}, {-19260, -26510},
+{27482, -17845}, {13329, -29934}, {-5125, -32364}, {-21926, -24353},
+{27006, -18560}, {11744, -30592}, {-7650, -31863}, {-24352, -21927},
+{26510, -19260}, {10127, -31164}, {-10126, -31165}, {-26509, -19261},
+{25997, -19947}, {8482, -31652}, {-12540, -30274}, {-28378, -16385},
+{25466, -20621}, {6815, -32051}, {-14875, -29197}, {-29934, -13329},
+{24918, -21281}, {5127, -32364}, {-17119, -27940}, {-31164, -10127},
+{24353, -21926}, {3426, -32588}, {-19260, -26510}, {-32051, -6815},
+{23770, -22555}, {1716, -32724}, {-21281, -24918}, {-32588, -3426},
+{23171, -23171}, {0, -32767}, {-23171, -23171}, {-32767, 0},
+{22557, -23769}, {-1715, -32724}, {-24917, -21282}, {-32588, 3425},
+{21927, -24352}, {-3425, -32588}, {-26509, -19261}, {-32051, 6813},
+{21282, -24917}, {-5125, -32364}, {-27940, -17122}, {-31165, 10126},
+{20622, -25465}, {-6813, -32051}, {-29197, -14878}, {-29936, 13328},
+{19949, -25997}, {-8481, -31652}, {-30274, -12540}, {-28379, 16384},
+{19261, -26509}, {-10126, -31165}, {-31164, -10127}, {-26510, 19260},
+{18561, -27004}, {-11741, -30592}, {-31862, -7650}, {-24353, 21926},
+{17846, -27481}, {-13328, -29936}, {-32364, -5127}, {-21927, 24352},
+{17122, -27940}, {-14875, -29197}, {-32667, -2572}, {-19261, 26509},
+{16385, -28378}, {-16384, -28379}, {-32767, 0}, {-16385, 28378},
+{15636, -28797}, {-17845, -27482}, {-32667, 2570}, {-13329, 29934},
+{14878, -29197}, {-19260, -26510}, {-32364, 5125}, {-10127, 31164},
+{14108, -29576}, {-20621, -25466}, {-31863, 7650}, {-6815, 32051},
+{13329, -29934}, {-21926, -24353}, {-31165, 10126}, {-3426, 32588},
+{12540, -30274}, {-23171, -23171}, {-30274, 12540}, {0, 32767},
+{11744, -30592}, {-24352, -21927}, {-29197, 14875}, {3425, 32588},
+{10939, -30889}, {-25465, -20622}, {-27940, 17119}, {6813, 32051},
+};
+#endif
+
+#ifndef FFT_SEQ_TWIDDLES240_1
+#define FFT_SEQ_TWIDDLES240_1
+static const kiss_twiddle_cpx fft_seq_twiddles240_1[32] = {
+{32767, 0}, {32767, 0}, {32488, -4277}, {31652, -8481},
+{31652, -8481}, {28379, -16384}, {30274, -12540}, {23171, -23171},
+{28379, -16384}, {16385, -28378}, {25997, -19947}, {8482, -31652},
+{23171, -23171}, {0, -32767}, {19949, -25997}, {-8481, -31652},
+{16385, -28378}, {-16384, -28379}, {12540, -30274}, {-23171, -23171},
+{8482, -31652}, {-28378, -16385}, {4278, -32487}, {-31652, -8482},
+{0, -32767}, {-32767, 0}, {-4277, -32488}, {-31652, 8481},
+{-8481, -31652}, {-28379, 16384}, {-12540, -30274}, {-23171, 23171},
+};
+#endif
+
+#ifndef FFT_SEQ_TWIDDLES240_2
+#define FFT_SEQ_TWIDDLES240_2
+static const kiss_twiddle_cpx fft_seq_twiddles240_2[12] = {
+{32767, 0}, {32767, 0}, {32767, 0}, {30274, -12540},
+{23171, -23171}, {12540, -30274}, {23171, -23171}, {0, -32767},
+{-23171, -23171}, {12540, -30274}, {-23171, -23171}, {-30274, 12540},
+};
+#endif
+
+#ifndef FFT_SEQ_TWIDDLES120_0
+#define FFT_SEQ_TWIDDLES120_0
+static const kiss_twiddle_cpx fft_seq_twiddles120_0[96] = {
+{32767, 0}, {32767, 0}, {32767, 0}, {32767, 0},
+{32724, -1715}, {32588, -3425}, {32364, -5125}, {32051, -6813},
+{32588, -3425}, {32051, -6813}, {31165, -10126}, {29936, -13328},
+{32364, -5125}, {31165, -10126}, {29197, -14875}, {26510, -19260},
+{32051, -6813}, {29936, -13328}, {26510, -19260}, {21927, -24352},
+{31652, -8481}, {28379, -16384}, {23171, -23171}, {16385, -28378},
+{31165, -10126}, {26510, -19260}, {19261, -26509}, {10127, -31164},
+{30592, -11741}, {24353, -21926}, {14878, -29197}, {3426, -32588},
+{29936, -13328}, {21927, -24352}, {10127, -31164}, {-3425, -32588},
+{29197, -14875}, {19261, -26509}, {5127, -32364}, {-10126, -31165},
+{28379, -16384}, {16385, -28378}, {0, -32767}, {-16384, -28379},
+{27482, -17845}, {13329, -29934}, {-5125, -32364}, {-21926, -24353},
+{26510, -19260}, {10127, -31164}, {-10126, -31165}, {-26509, -19261},
+{25466, -20621}, {6815, -32051}, {-14875, -29197}, {-29934, -13329},
+{24353, -21926}, {3426, -32588}, {-19260, -26510}, {-32051, -6815},
+{23171, -23171}, {0, -32767}, {-23171, -23171}, {-32767, 0},
+{21927, -24352}, {-3425, -32588}, {-26509, -19261}, {-32051, 6813},
+{20622, -25465}, {-6813, -32051}, {-29197, -14878}, {-29936, 13328},
+{19261, -26509}, {-10126, -31165}, {-31164, -10127}, {-26510, 19260},
+{17846, -27481}, {-13328, -29936}, {-32364, -5127}, {-21927, 24352},
+{16385, -28378}, {-16384, -28379}, {-32767, 0}, {-16385, 28378},
+{14878, -29197}, {-19260, -26510}, {-32364, 5125}, {-10127, 31164},
+{13329, -29934}, {-21926, -24353}, {-31165, 10126}, {-3426, 32588},
+{11744, -30592}, {-24352, -21927}, {-29197, 14875}, {3425, 32588},
+};
+#endif
+
+#ifndef FFT_SEQ_TWIDDLES120_1
+#define FFT_SEQ_TWIDDLES120_1
+static const kiss_twiddle_cpx fft_seq_twiddles120_1[16] = {
+{32767, 0}, {32767, 0}, {31652, -8481}, {28379, -16384},
+{28379, -16384}, {16385, -28378}, {23171, -23171}, {0, -32767},
+{16385, -28378}, {-16384, -28379}, {8482, -31652}, {-28378, -16385},
+{0, -32767}, {-32767, 0}, {-8481, -31652}, {-28379, 16384},
+};
+#endif
+
+#ifndef FFT_SEQ_TWIDDLES60_0
+#define FFT_SEQ_TWIDDLES60_0
+static const kiss_twiddle_cpx fft_seq_twiddles60_0[48] = {
+{32767, 0}, {32767, 0}, {32767, 0}, {32767, 0},
+{32588, -3425}, {32051, -6813}, {31165, -10126}, {29936, -13328},
+{32051, -6813}, {29936, -13328}, {26510, -19260}, {21927, -24352},
+{31165, -10126}, {26510, -19260}, {19261, -26509}, {10127, -31164},
+{29936, -13328}, {21927, -24352}, {10127, -31164}, {-3425, -32588},
+{28379, -16384}, {16385, -28378}, {0, -32767}, {-16384, -28379},
+{26510, -19260}, {10127, -31164}, {-10126, -31165}, {-26509, -19261},
+{24353, -21926}, {3426, -32588}, {-19260, -26510}, {-32051, -6815},
+{21927, -24352}, {-3425, -32588}, {-26509, -19261}, {-32051, 6813},
+{19261, -26509}, {-10126, -31165}, {-31164, -10127}, {-26510, 19260},
+{16385, -28378}, {-16384, -28379}, {-32767, 0}, {-16385, 28378},
+{13329, -29934}, {-21926, -24353}, {-31165, 10126}, {-3426, 32588},
+};
+#endif
+
+#ifndef FFT_SEQ_TWIDDLES60_1
+#define FFT_SEQ_TWIDDLES60_1
+static const kiss_twiddle_cpx fft_seq_twiddles60_1[8] = {
+{32767, 0}, {32767, 0}, {28379, -16384}, {16385, -28378},
+{16385, -28378}, {-16384, -28379}, {0, -32767}, {-32767, 0},
+};
+#endif
+
@@ -30,6 +30,7 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
 
 #include "stack_alloc.h"
 #include "kiss_fft.h"
@@ -83,6 +84,33 @@ void check(kiss_fft_cpx  * in,kiss_fft_cpx  * out,int nfft,int isinverse)
     }
 }
 
+#if defined(OVERRIDE_OPUS_FFT_IMPL)
+/* The specialized kernels must be bit-exact with the generic ones. */
+void check_impl(const kiss_fft_state *cfg,int nfft)
+{
+    size_t buflen = sizeof(kiss_fft_cpx)*nfft;
+    kiss_fft_cpx *x;
+    kiss_fft_cpx *y;
+    int k;
+
+    x = (kiss_fft_cpx*)malloc(buflen);
+    y = (kiss_fft_cpx*)malloc(buflen);
+    for (k=0;k<nfft;++k) {
+        x[k].r = ((rand() % 32767) - 16384) * 4096;
+        x[k].i = ((rand() % 32767) - 16384) * 4096;
+    }
+    memcpy(y, x, buflen);
+    opus_fft_impl(cfg, x);
+    opus_fft_impl_c(cfg, y);
+    if (memcmp(x, y, buflen) != 0) {
+        printf("** nfft=%d specialized FFT is not bit-exact **\n", nfft);
+        ret = 1;
+    }
+    free(x);
+    free(y);
+}
+#endif
+
 void test1d(int nfft,int isinverse,int arch)
 {
     size_t buflen = sizeof(kiss_fft_cpx)*nfft;
@@ -134,6 +162,10 @@ void test1d(int nfft,int isinverse,int arch)
     /*for (k=0;k<nfft;++k) printf("%d %d ", out[k].r, out[k].i);printf("\n");*/
 
     check(in,out,nfft,isinverse);
+#if defined(OVERRIDE_OPUS_FFT_IMPL)
+    if (!isinverse)
+       check_impl(cfg,nfft);
+#endif
 
     free(in);
     free(out);
@@ -52,7 +52,7 @@ void test_rotation(int N, int K)
    opus_val16 x1[MAX_SIZE];
    for (i=0;i<N;i++)
       x1[i] = x0[i] = rand()%32767-16384;
-   exp_rotation(x1, N, 1, 1, K, SPREAD_NORMAL);
+   exp_rotation(x1, N, 1, 1, K, SPREAD_NORMAL, 0);
    for (i=0;i<N;i++)
    {
       err += (x0[i]-(double)x1[i])*(x0[i]-(double)x1[i]);
@@ -60,7 +60,7 @@ void test_rotation(int N, int K)
    }
    snr0 = 20*log10(ener/err);
    err = ener = 0;
-   exp_rotation(x1, N, -1, 1, K, SPREAD_NORMAL);
+   exp_rotation(x1, N, -1, 1, K, SPREAD_NORMAL, 0);
    for (i=0;i<N;i++)
    {
       err += (x0[i]-(double)x1[i])*(x0[i]-(double)x1[i]);
@@ -0,0 +1,165 @@
+/* Copyright (c) 2008-2011 Xiph.Org Foundation
+   Written by Jean-Marc Valin */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Checks that the op_pvq_search() and exp_rotation1() selected for this CPU
+   give exactly the same result as the C versions, except for the SSE2 search
+   which is allowed to pick different (but equally valid) pulse positions.
+   op_pvq_search_avx2() is not dispatched but is checked directly. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vq.h"
+#include "cpu_support.h"
+#include "os_support.h"
+#include "stack_alloc.h"
+
+#define MAX_SIZE 176
+
+int ret=0;
+
+static opus_val16 rand_sample(int sparse)
+{
+   if (sparse && rand()%4)
+      return 0;
+#ifdef FIXED_POINT
+   return rand()%32767-16384;
+#else
+   return (rand()%32767-16384)/16384.f;
+#endif
+}
+
+static int exact_pvq_search(int arch)
+{
+#if defined(OPUS_X86_MAY_HAVE_SSE2) && !defined(FIXED_POINT)
+   /* op_pvq_search_sse2() uses a different projection and a reciprocal
+      approximation, the levels that dispatch to it do not match exactly. */
+   return (arch & OPUS_ARCHMASK) < 2;
+#else
+   (void)arch;
+   return 1;
+#endif
+}
+
+void test_pvq_search(int N, int K, int sparse, int arch)
+{
+   int i;
+   celt_norm x0[MAX_SIZE];
+   celt_norm x1[MAX_SIZE];
+   celt_norm x2[MAX_SIZE];
+   int iy0[MAX_SIZE+3];
+   int iy1[MAX_SIZE+3];
+   opus_val16 yy0, yy1;
+   for (i=0;i<N;i++)
+      x2[i] = x1[i] = x0[i] = rand_sample(sparse);
+   yy0 = op_pvq_search_c(x0, iy0, K, N, arch);
+   yy1 = op_pvq_search(x1, iy1, K, N, arch);
+   if (exact_pvq_search(arch) && (yy0 != yy1 || memcmp(iy0, iy1, N*sizeof(*iy0)) != 0))
+   {
+      fprintf(stderr, "op_pvq_search() mismatch for size %d (%d pulses%s)\n",
+            N, K, sparse ? ", sparse" : "");
+      ret = 1;
+   }
+#if defined(OPUS_X86_MAY_HAVE_AVX2) && !defined(FIXED_POINT)
+   if ((arch & OPUS_ARCHMASK) >= 4)
+   {
+      yy1 = op_pvq_search_avx2(x2, iy1, K, N, arch);
+      if (yy0 != yy1 || memcmp(iy0, iy1, N*sizeof(*iy0)) != 0)
+      {
+         fprintf(stderr, "op_pvq_search_avx2() mismatch for size %d (%d pulses%s)\n",
+               N, K, sparse ? ", sparse" : "");
+         ret = 1;
+      }
+   }
+#endif
+}
+
+void test_rotation1(int len, int stride, int arch)
+{
+   int i;
+   celt_norm x0[MAX_SIZE];
+   celt_norm x1[MAX_SIZE];
+   opus_val16 c, s;
+   for (i=0;i<len;i++)
+      x1[i] = x0[i] = rand_sample(0);
+   c = QCONST16(.9f, 15);
+   s = QCONST16(.43f, 15);
+   exp_rotation1_c(x0, len, stride, c, -s);
+   exp_rotation1(x1, len, stride, c, -s, arch);
+   if (memcmp(x0, x1, len*sizeof(*x0)) != 0)
+   {
+      fprintf(stderr, "exp_rotation1() mismatch for size %d (stride %d)\n", len, stride);
+      ret = 1;
+   }
+}
+
+int main(void)
+{
+   static const int sizes[] = {2, 3, 4, 7, 8, 9, 15, 16, 17, 23, 32, 36, 48, 64, 72, 96, 144, 176};
+   int i, j, k;
+   int arch;
+   ALLOC_STACK;
+   arch = opus_select_arch();
+   printf("Testing VQ kernels for arch %d\n", arch);
+   for (i=0;i<(int)(sizeof(sizes)/sizeof(sizes[0]));i++)
+   {
+      int N = sizes[i];
+      for (k=1;k<=2*N+8;k+=(k<8?1:k/4))
+      {
+         for (j=0;j<20;j++)
+         {
+            test_pvq_search(N, k, 0, arch);
+            test_pvq_search(N, k, 1, arch);
+         }
+      }
+      for (k=1;2*k+1<=N;k++)
+         test_rotation1(N, k, arch);
+   }
+   /* Silence, which takes the "too small" path of the projection */
+   {
+      celt_norm x[MAX_SIZE];
+      int iy0[MAX_SIZE+3];
+      int iy1[MAX_SIZE+3];
+      opus_val16 yy0, yy1;
+      OPUS_CLEAR(x, 64);
+      yy0 = op_pvq_search_c(x, iy0, 100, 64, arch);
+      OPUS_CLEAR(x, 64);
+      yy1 = op_pvq_search(x, iy1, 100, 64, arch);
+      if (exact_pvq_search(arch) && (yy0 != yy1 || memcmp(iy0, iy1, 64*sizeof(*iy0)) != 0))
+      {
+         fprintf(stderr, "op_pvq_search() mismatch on silence\n");
+         ret = 1;
+      }
+   }
+   if (ret == 0)
+      printf("All VQ kernels match the C reference\n");
+   return ret;
+}
@@ -44,7 +44,7 @@
 #endif
 
 #ifndef OVERRIDE_vq_exp_rotation1
-static void exp_rotation1(celt_norm *X, int len, int stride, opus_val16 c, opus_val16 s)
+void exp_rotation1_c(celt_norm *X, int len, int stride, opus_val16 c, opus_val16 s)
 {
    int i;
    opus_val16 ms;
@@ -71,7 +71,7 @@ static void exp_rotation1(celt_norm *X, int len, int stride, opus_val16 c, opus_
 }
 #endif /* OVERRIDE_vq_exp_rotation1 */
 
-void exp_rotation(celt_norm *X, int len, int dir, int stride, int K, int spread)
+void exp_rotation(celt_norm *X, int len, int dir, int stride, int K, int spread, int arch)
 {
    static const int SPREAD_FACTOR[3]={15,10,5};
    int i;
@@ -106,12 +106,12 @@ void exp_rotation(celt_norm *X, int len, int dir, int stride, int K, int spread)
       if (dir < 0)
       {
          if (stride2)
-            exp_rotation1(X+i*len, len, stride2, s, c);
-         exp_rotation1(X+i*len, len, 1, c, s);
+            exp_rotation1(X+i*len, len, stride2, s, c, arch);
+         exp_rotation1(X+i*len, len, 1, c, s, arch);
       } else {
-         exp_rotation1(X+i*len, len, 1, c, -s);
+         exp_rotation1(X+i*len, len, 1, c, -s, arch);
          if (stride2)
-            exp_rotation1(X+i*len, len, stride2, s, -c);
+            exp_rotation1(X+i*len, len, stride2, s, -c, arch);
       }
    }
 }
@@ -341,7 +341,7 @@ unsigned alg_quant(celt_norm *X, int N, int K, int spread, int B, ec_enc *enc,
    /* Covers vectorization by up to 4. */
    ALLOC(iy, N+3, int);
 
-   exp_rotation(X, N, 1, B, K, spread);
+   exp_rotation(X, N, 1, B, K, spread, arch);
 
    yy = op_pvq_search(X, iy, K, N, arch);
 
@@ -350,7 +350,7 @@ unsigned alg_quant(celt_norm *X, int N, int K, int spread, int B, ec_enc *enc,
    if (resynth)
    {
       normalise_residual(iy, X, N, yy, gain);
-      exp_rotation(X, N, -1, B, K, spread);
+      exp_rotation(X, N, -1, B, K, spread, arch);
    }
 
    collapse_mask = extract_collapse_mask(iy, N, B);
@@ -361,7 +361,7 @@ unsigned alg_quant(celt_norm *X, int N, int K, int spread, int B, ec_enc *enc,
 /** Decode pulse vector and combine the result with the pitch vector to produce
     the final normalised signal in the current band. */
 unsigned alg_unquant(celt_norm *X, int N, int K, int spread, int B,
-      ec_dec *dec, opus_val16 gain)
+      ec_dec *dec, opus_val16 gain, int arch)
 {
    opus_val32 Ryy;
    unsigned collapse_mask;
@@ -373,7 +373,7 @@ unsigned alg_unquant(celt_norm *X, int N, int K, int spread, int B,
    ALLOC(iy, N, int);
    Ryy = decode_pulses(iy, N, K, dec);
    normalise_residual(iy, X, N, Ryy, gain);
-   exp_rotation(X, N, -1, B, K, spread);
+   exp_rotation(X, N, -1, B, K, spread, arch);
    collapse_mask = extract_collapse_mask(iy, N, B);
    RESTORE_STACK;
    return collapse_mask;
@@ -37,11 +37,18 @@
 #include "entdec.h"
 #include "modes.h"
 
-#if (defined(OPUS_X86_MAY_HAVE_SSE2) && !defined(FIXED_POINT))
+#if ((defined(OPUS_X86_MAY_HAVE_SSE2) || defined(OPUS_X86_MAY_HAVE_AVX2)) && !defined(FIXED_POINT))
 #include "x86/vq_sse.h"
 #endif
 
-void exp_rotation(celt_norm *X, int len, int dir, int stride, int K, int spread);
+void exp_rotation(celt_norm *X, int len, int dir, int stride, int K, int spread, int arch);
+
+void exp_rotation1_c(celt_norm *X, int len, int stride, opus_val16 c, opus_val16 s);
+
+#if !defined(OVERRIDE_EXP_ROTATION1)
+#define exp_rotation1(X, len, stride, c, s, arch) \
+    ((void)(arch), exp_rotation1_c(X, len, stride, c, s))
+#endif
 
 opus_val16 op_pvq_search_c(celt_norm *X, int *iy, int K, int N, int arch);
 
@@ -70,7 +77,7 @@ unsigned alg_quant(celt_norm *X, int N, int K, int spread, int B, ec_enc *enc,
  * @ret A mask indicating which blocks in the band received pulses
  */
 unsigned alg_unquant(celt_norm *X, int N, int K, int spread, int B,
-      ec_dec *dec, opus_val16 gain);
+      ec_dec *dec, opus_val16 gain, int arch);
 
 void renormalise_vector(celt_norm *X, int N, opus_val16 gain, int arch);
 
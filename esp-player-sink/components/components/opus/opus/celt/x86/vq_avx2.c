@@ -0,0 +1,434 @@
+/* Copyright (c) 2007-2008 CSIRO
+   Copyright (c) 2007-2009 Xiph.Org Foundation
+   Copyright (c) 2007-2016 Jean-Marc Valin */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <immintrin.h>
+#include "celt_lpc.h"
+#include "stack_alloc.h"
+#include "mathops.h"
+#include "vq.h"
+#include "x86cpu.h"
+
+#ifndef FIXED_POINT
+
+/* The comparison of op_pvq_search_c() between the best position so far
+   (num/den) and a candidate (r/d), for 8 candidates at a time. Returns the
+   lanes where the candidate wins. */
+#define PVQ_BEATS(r8, d8, num8, den8) _mm256_cmp_ps(_mm256_mul_ps(den8, r8), \
+      _mm256_mul_ps(d8, num8), _CMP_GT_OQ)
+
+/* Exact sequential search: a block of 8 is only looked at closely when one
+   of its positions beats the best so far. The winning lanes are then taken
+   in order, each one against the best left by the previous one, so ties and
+   successive improvements resolve as in op_pvq_search_c(). */
+static int pvq_search_walk(const celt_norm *X, const celt_norm *y,
+      opus_val32 xy, opus_val16 yy, int N)
+{
+   int j;
+   int best_id;
+   __m256 xy8, yy8, num8, den8;
+   xy8 = _mm256_set1_ps(xy);
+   yy8 = _mm256_set1_ps(yy);
+   num8 = _mm256_set1_ps(MULT16_16_Q15(ADD32(xy, X[0]), ADD32(xy, X[0])));
+   den8 = _mm256_set1_ps(ADD16(yy, y[0]));
+   best_id = 0;
+   for (j=1;j<N;j+=8)
+   {
+      __m256 r8, d8;
+      int valid, mask;
+      r8 = _mm256_add_ps(xy8, _mm256_loadu_ps(&X[j]));
+      d8 = _mm256_add_ps(yy8, _mm256_loadu_ps(&y[j]));
+      r8 = _mm256_mul_ps(r8, r8);
+      /* Ignore the lanes past the end of the band */
+      valid = N-j >= 8 ? 0xFF : (1 << (N-j)) - 1;
+      mask = _mm256_movemask_ps(PVQ_BEATS(r8, d8, num8, den8)) & valid;
+      while (mask != 0)
+      {
+         __m256i k8;
+         int k;
+         k = EC_ILOG(mask & -mask) - 1;
+         best_id = j+k;
+         k8 = _mm256_set1_epi32(k);
+         num8 = _mm256_permutevar8x32_ps(r8, k8);
+         den8 = _mm256_permutevar8x32_ps(d8, k8);
+         mask = _mm256_movemask_ps(PVQ_BEATS(r8, d8, num8, den8));
+         mask &= valid & ~((2 << k) - 1);
+      }
+   }
+   return best_id;
+}
+
+/* Branch-free search. The candidate m is the first position with the
+   largest Rxy/sqrt(Ryy), approximated with the reciprocal square root as in
+   op_pvq_search_sse2(). The sequential C loop is guaranteed to end on m if m
+   beats every position before it and no position after it beats m, which a
+   second pass checks with the exact comparison. Returns -1 when that check
+   fails (near ties), in which case the caller falls back to
+   pvq_search_walk(). Relies on the padding of y[] past N being so large that
+   those positions can never win. */
+static int pvq_search_fast(const celt_norm *X, const celt_norm *y,
+      opus_val32 xy, opus_val16 yy, int N)
+{
+   int j;
+   int m, jm;
+   int mask;
+   __m256 xy8, yy8, max0, max1, num8, den8, bad;
+   __m256i idx8, id0, id1;
+   xy8 = _mm256_set1_ps(xy);
+   yy8 = _mm256_set1_ps(yy);
+   /* Each lane keeps the first position where it saw its largest key. Even
+      and odd blocks are tracked separately to shorten the dependency chain. */
+   max0 = max1 = _mm256_set1_ps(-1.f);
+   id0 = id1 = _mm256_setzero_si256();
+   idx8 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+   for (j=0;j<N;j+=16)
+   {
+      __m256 k0, k1, gt0, gt1;
+      __m256i idx1;
+      k0 = _mm256_mul_ps(_mm256_add_ps(xy8, _mm256_loadu_ps(&X[j])),
+            _mm256_rsqrt_ps(_mm256_add_ps(yy8, _mm256_loadu_ps(&y[j]))));
+      k1 = _mm256_mul_ps(_mm256_add_ps(xy8, _mm256_loadu_ps(&X[j+8])),
+            _mm256_rsqrt_ps(_mm256_add_ps(yy8, _mm256_loadu_ps(&y[j+8]))));
+      idx1 = _mm256_add_epi32(idx8, _mm256_set1_epi32(8));
+      gt0 = _mm256_cmp_ps(k0, max0, _CMP_GT_OQ);
+      gt1 = _mm256_cmp_ps(k1, max1, _CMP_GT_OQ);
+      max0 = _mm256_blendv_ps(max0, k0, gt0);
+      max1 = _mm256_blendv_ps(max1, k1, gt1);
+      id0 = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(id0),
+            _mm256_castsi256_ps(idx8), gt0));
+      id1 = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(id1),
+            _mm256_castsi256_ps(idx1), gt1));
+      idx8 = _mm256_add_epi32(idx8, _mm256_set1_epi32(16));
+   }
+   /* Lowest position among the lanes holding the largest key */
+   {
+      __m256 max8;
+      __m256i big, c0, c1;
+      __m128 m4;
+      __m128i i4;
+      max8 = _mm256_max_ps(max0, max1);
+      m4 = _mm_max_ps(_mm256_castps256_ps128(max8), _mm256_extractf128_ps(max8, 1));
+      m4 = _mm_max_ps(m4, _mm_shuffle_ps(m4, m4, _MM_SHUFFLE(1, 0, 3, 2)));
+      m4 = _mm_max_ps(m4, _mm_shuffle_ps(m4, m4, _MM_SHUFFLE(2, 3, 0, 1)));
+      max8 = _mm256_broadcastss_ps(m4);
+      big = _mm256_set1_epi32(N);
+      c0 = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(big),
+            _mm256_castsi256_ps(id0), _mm256_cmp_ps(max0, max8, _CMP_EQ_OQ)));
+      c1 = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(big),
+            _mm256_castsi256_ps(id1), _mm256_cmp_ps(max1, max8, _CMP_EQ_OQ)));
+      c0 = _mm256_min_epi32(c0, c1);
+      i4 = _mm_min_epi32(_mm256_castsi256_si128(c0), _mm256_extracti128_si256(c0, 1));
+      i4 = _mm_min_epi32(i4, _mm_shuffle_epi32(i4, _MM_SHUFFLE(1, 0, 3, 2)));
+      i4 = _mm_min_epi32(i4, _mm_shuffle_epi32(i4, _MM_SHUFFLE(2, 3, 0, 1)));
+      m = _mm_cvtsi128_si32(i4);
+      /* Only possible with NaNs in the input */
+      if (m >= N)
+         return -1;
+   }
+
+   num8 = _mm256_set1_ps(MULT16_16_Q15(ADD32(xy, X[m]), ADD32(xy, X[m])));
+   den8 = _mm256_set1_ps(ADD16(yy, y[m]));
+   bad = _mm256_setzero_ps();
+   jm = m&~7;
+   /* m must beat every position before it... */
+   for (j=0;j<jm;j+=8)
+   {
+      __m256 r8, d8;
+      r8 = _mm256_add_ps(xy8, _mm256_loadu_ps(&X[j]));
+      d8 = _mm256_add_ps(yy8, _mm256_loadu_ps(&y[j]));
+      r8 = _mm256_mul_ps(r8, r8);
+      bad = _mm256_or_ps(bad, _mm256_cmp_ps(_mm256_mul_ps(d8, num8),
+            _mm256_mul_ps(den8, r8), _CMP_NGT_UQ));
+   }
+   mask = _mm256_movemask_ps(bad);
+   /* ...and no position after it may beat m */
+   {
+      __m256 r8, d8;
+      r8 = _mm256_add_ps(xy8, _mm256_loadu_ps(&X[jm]));
+      d8 = _mm256_add_ps(yy8, _mm256_loadu_ps(&y[jm]));
+      r8 = _mm256_mul_ps(r8, r8);
+      mask |= ~_mm256_movemask_ps(PVQ_BEATS(num8, den8, r8, d8)) & ((1 << (m-jm)) - 1);
+      mask |= _mm256_movemask_ps(PVQ_BEATS(r8, d8, num8, den8)) & ~((2 << (m-jm)) - 1);
+   }
+   bad = _mm256_setzero_ps();
+   for (j=jm+8;j<N;j+=8)
+   {
+      __m256 r8, d8;
+      r8 = _mm256_add_ps(xy8, _mm256_loadu_ps(&X[j]));
+      d8 = _mm256_add_ps(yy8, _mm256_loadu_ps(&y[j]));
+      r8 = _mm256_mul_ps(r8, r8);
+      bad = _mm256_or_ps(bad, PVQ_BEATS(r8, d8, num8, den8));
+   }
+   mask |= _mm256_movemask_ps(bad);
+   return mask ? -1 : m;
+}
+
+/* Same as pvq_search_fast() for bands that fit in a single block of 8,
+   which is most of them. Everything stays in registers. */
+static int pvq_search_fast8(const celt_norm *X, const celt_norm *y,
+      opus_val32 xy, opus_val16 yy, int N)
+{
+   int m;
+   int mask;
+   __m256 r8, d8, k8, max8, num8, den8;
+   __m256i m8;
+   r8 = _mm256_add_ps(_mm256_set1_ps(xy), _mm256_loadu_ps(X));
+   d8 = _mm256_add_ps(_mm256_set1_ps(yy), _mm256_loadu_ps(y));
+   k8 = _mm256_mul_ps(r8, _mm256_rsqrt_ps(d8));
+   r8 = _mm256_mul_ps(r8, r8);
+   max8 = _mm256_max_ps(k8, _mm256_permute2f128_ps(k8, k8, 1));
+   max8 = _mm256_max_ps(max8, _mm256_permute_ps(max8, _MM_SHUFFLE(1, 0, 3, 2)));
+   max8 = _mm256_max_ps(max8, _mm256_permute_ps(max8, _MM_SHUFFLE(2, 3, 0, 1)));
+   mask = _mm256_movemask_ps(_mm256_cmp_ps(k8, max8, _CMP_EQ_OQ)) & ((1 << N) - 1);
+   if (mask == 0)
+      return -1;
+   m = EC_ILOG(mask & -mask) - 1;
+   m8 = _mm256_set1_epi32(m);
+   num8 = _mm256_permutevar8x32_ps(r8, m8);
+   den8 = _mm256_permutevar8x32_ps(d8, m8);
+   /* m must beat every position before it and no position after it may
+      beat m */
+   mask = ~_mm256_movemask_ps(PVQ_BEATS(num8, den8, r8, d8)) & ((1 << m) - 1);
+   mask |= _mm256_movemask_ps(PVQ_BEATS(r8, d8, num8, den8)) & ((1 << N) - (2 << m));
+   return mask ? -1 : m;
+}
+
+/* Unlike op_pvq_search_sse2(), this is bit-exact with op_pvq_search_c().
+   Every score is computed with the same float operations as the C code, 8
+   lanes at a time. Each pulse first tries the branch-free candidate search
+   and only falls back to the sequential walk when the candidate fails the
+   exact comparison, e.g. on ties. */
+opus_val16 op_pvq_search_avx2(celt_norm *_X, int *_iy, int K, int N, int arch)
+{
+   int i, j;
+   int pulsesLeft;
+   opus_val32 sum;
+   opus_val32 xy;
+   opus_val16 yy;
+   VARDECL(celt_norm, X);
+   VARDECL(celt_norm, y);
+   VARDECL(int, iy);
+   VARDECL(int, signx);
+   VARDECL(float, tmp);
+   SAVE_STACK;
+
+   (void)arch;
+   /* Padded so that the vector loops never need a tail */
+   ALLOC(X, N+16, celt_norm);
+   ALLOC(y, N+16, celt_norm);
+   ALLOC(iy, N+8, int);
+   ALLOC(signx, N+8, int);
+   ALLOC(tmp, 2*(N+8), float);
+
+   OPUS_COPY(X, _X, N);
+   OPUS_CLEAR(&X[N], 16);
+   OPUS_CLEAR(y, N+16);
+   for (j=0;j<N;j+=8)
+   {
+      __m256 x8;
+      x8 = _mm256_loadu_ps(&X[j]);
+      /* Same as X[j]<0 in the C code, so -0 stays positive */
+      _mm256_storeu_si256((__m256i*)&signx[j], _mm256_srli_epi32(_mm256_castps_si256(
+            _mm256_cmp_ps(x8, _mm256_setzero_ps(), _CMP_LT_OQ)), 31));
+      /* Get rid of the sign */
+      x8 = _mm256_andnot_ps(_mm256_set1_ps(-0.f), x8);
+      _mm256_storeu_ps(&X[j], x8);
+      _mm256_storeu_si256((__m256i*)&iy[j], _mm256_setzero_si256());
+   }
+
+   xy = yy = 0;
+
+   pulsesLeft = K;
+
+   /* Do a pre-search by projecting on the pyramid */
+   if (K > (N>>1))
+   {
+      opus_val16 rcp;
+      __m256 rcp8;
+      __m256i pulses8;
+      /* The sums are accumulated in the same order as the C code */
+      sum = 0;
+      j=0; do {
+         sum += X[j];
+      }  while (++j<N);
+
+      /* If X is too small, just replace it with a pulse at 0 */
+      /* Prevents infinities and NaNs from causing too many pulses
+         to be allocated. 64 is an approximation of infinity here. */
+      if (!(sum > EPSILON && sum < 64))
+      {
+         X[0] = QCONST16(1.f,14);
+         j=1; do
+            X[j]=0;
+         while (++j<N);
+         sum = QCONST16(1.f,14);
+      }
+      /* Using K+e with e < 1 guarantees we cannot get more than K pulses. */
+      rcp = EXTRACT16(MULT16_32_Q16(K+0.8f, celt_rcp(sum)));
+      rcp8 = _mm256_set1_ps(rcp);
+      pulses8 = _mm256_setzero_si256();
+      for (j=0;j<N;j+=8)
+      {
+         __m256 x8, y8;
+         __m256i iy8;
+         x8 = _mm256_loadu_ps(&X[j]);
+         y8 = _mm256_floor_ps(_mm256_mul_ps(rcp8, x8));
+         iy8 = _mm256_cvttps_epi32(y8);
+         /* Padding lanes have X=0 and so never get pulses */
+         pulses8 = _mm256_add_epi32(pulses8, iy8);
+         _mm256_storeu_si256((__m256i*)&iy[j], iy8);
+         _mm256_storeu_ps(&tmp[j], _mm256_mul_ps(y8, y8));
+         _mm256_storeu_ps(&tmp[N+8+j], _mm256_mul_ps(x8, y8));
+         /* double the y[] vector so we don't have to do it in the search loop. */
+         _mm256_storeu_ps(&y[j], _mm256_add_ps(y8, y8));
+      }
+      j=0; do {
+         yy = ADD32(yy, tmp[j]);
+         xy = ADD32(xy, tmp[N+8+j]);
+      }  while (++j<N);
+      {
+         __m128i p4;
+         p4 = _mm_add_epi32(_mm256_castsi256_si128(pulses8),
+               _mm256_extracti128_si256(pulses8, 1));
+         p4 = _mm_add_epi32(p4, _mm_shuffle_epi32(p4, _MM_SHUFFLE(1, 0, 3, 2)));
+         p4 = _mm_add_epi32(p4, _mm_shuffle_epi32(p4, _MM_SHUFFLE(2, 3, 0, 1)));
+         pulsesLeft -= _mm_cvtsi128_si32(p4);
+      }
+   }
+   celt_sig_assert(pulsesLeft>=0);
+
+   /* This should never happen, but just in case it does (e.g. on silence)
+      we fill the first bin with pulses. */
+   if (pulsesLeft > N+3)
+   {
+      opus_val16 tmp0 = (opus_val16)pulsesLeft;
+      yy = MAC16_16(yy, tmp0, tmp0);
+      yy = MAC16_16(yy, tmp0, y[0]);
+      iy[0] += pulsesLeft;
+      pulsesLeft=0;
+   }
+
+   /* Positions past the end of the band can never win the search */
+   for (j=N;j<N+16;j++)
+      y[j] = 1e30f;
+
+   for (i=0;i<pulsesLeft;i++)
+   {
+      int best_id;
+      /* The squared magnitude term gets added anyway, so we might as well
+         add it outside the loop */
+      yy = ADD16(yy, 1);
+
+      best_id = N <= 8 ? pvq_search_fast8(X, y, xy, yy, N) : pvq_search_fast(X, y, xy, yy, N);
+      if (opus_unlikely(best_id < 0))
+         best_id = pvq_search_walk(X, y, xy, yy, N);
+
+      /* Updating the sums of the new pulse(s) */
+      xy = ADD32(xy, EXTEND32(X[best_id]));
+      /* We're multiplying y[j] by two so we don't have to do it here */
+      yy = ADD16(yy, y[best_id]);
+
+      /* Only now that we've made the final choice, update y/iy */
+      /* Multiplying y[j] by 2 so we don't have to do it everywhere else */
+      y[best_id] += 2;
+      iy[best_id]++;
+   }
+
+   /* Put the original sign back */
+   for (j=0;j<N;j+=8)
+   {
+      __m256i y8, s8;
+      y8 = _mm256_loadu_si256((__m256i*)&iy[j]);
+      s8 = _mm256_sub_epi32(_mm256_setzero_si256(),
+            _mm256_loadu_si256((__m256i*)&signx[j]));
+      y8 = _mm256_sub_epi32(_mm256_xor_si256(y8, s8), s8);
+      _mm256_storeu_si256((__m256i*)&iy[j], y8);
+   }
+   OPUS_COPY(_iy, iy, N);
+   RESTORE_STACK;
+   return yy;
+}
+
+/* Same arithmetic as exp_rotation1() in vq.c. Iterations that are at least
+   stride apart are independent, so with stride >= 8 the two passes can be
+   done 8 positions at a time without changing the result. */
+void exp_rotation1_avx2(celt_norm *X, int len, int stride, opus_val16 c, opus_val16 s)
+{
+   int i;
+   opus_val16 ms;
+   __m256 c8, s8, ms8;
+   ms = NEG16(s);
+   c8 = _mm256_set1_ps(c);
+   s8 = _mm256_set1_ps(s);
+   ms8 = _mm256_set1_ps(ms);
+   i = 0;
+   if (stride >= 8)
+   {
+      for (;i+8<=len-stride;i+=8)
+      {
+         __m256 x1, x2;
+         x1 = _mm256_loadu_ps(&X[i]);
+         x2 = _mm256_loadu_ps(&X[i+stride]);
+         _mm256_storeu_ps(&X[i+stride], _mm256_add_ps(_mm256_mul_ps(c8, x2), _mm256_mul_ps(s8, x1)));
+         _mm256_storeu_ps(&X[i], _mm256_add_ps(_mm256_mul_ps(c8, x1), _mm256_mul_ps(ms8, x2)));
+      }
+   }
+   for (;i<len-stride;i++)
+   {
+      celt_norm x1, x2;
+      x1 = X[i];
+      x2 = X[i+stride];
+      X[i+stride] = EXTRACT16(PSHR32(MAC16_16(MULT16_16(c, x2),  s, x1), 15));
+      X[i]        = EXTRACT16(PSHR32(MAC16_16(MULT16_16(c, x1), ms, x2), 15));
+   }
+   i = len-2*stride-1;
+   if (stride >= 8)
+   {
+      for (;i>=7;i-=8)
+      {
+         __m256 x1, x2;
+         x1 = _mm256_loadu_ps(&X[i-7]);
+         x2 = _mm256_loadu_ps(&X[i-7+stride]);
+         _mm256_storeu_ps(&X[i-7+stride], _mm256_add_ps(_mm256_mul_ps(c8, x2), _mm256_mul_ps(s8, x1)));
+         _mm256_storeu_ps(&X[i-7], _mm256_add_ps(_mm256_mul_ps(c8, x1), _mm256_mul_ps(ms8, x2)));
+      }
+   }
+   for (;i>=0;i--)
+   {
+      celt_norm x1, x2;
+      x1 = X[i];
+      x2 = X[i+stride];
+      X[i+stride] = EXTRACT16(PSHR32(MAC16_16(MULT16_16(c, x2),  s, x1), 15));
+      X[i]        = EXTRACT16(PSHR32(MAC16_16(MULT16_16(c, x1), ms, x2), 15));
+   }
+}
+
+#endif
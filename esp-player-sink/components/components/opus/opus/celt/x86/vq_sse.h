@@ -47,4 +47,30 @@ extern opus_val16 (*const OP_PVQ_SEARCH_IMPL[OPUS_ARCHMASK + 1])(
 #endif
 #endif
 
+#if defined(OPUS_X86_MAY_HAVE_AVX2) && !defined(FIXED_POINT)
+/* Bit-exact with op_pvq_search_c(), but slower than the SSE2 search on
+   real bands, so it is not dispatched. */
+opus_val16 op_pvq_search_avx2(celt_norm *_X, int *iy, int K, int N, int arch);
+#endif
+
+#if defined(OPUS_X86_MAY_HAVE_AVX2) && !defined(FIXED_POINT)
+#define OVERRIDE_EXP_ROTATION1
+
+void exp_rotation1_avx2(celt_norm *X, int len, int stride, opus_val16 c, opus_val16 s);
+
+#if defined(OPUS_X86_PRESUME_AVX2)
+#define exp_rotation1(X, len, stride, c, s, arch) \
+    ((void)(arch), exp_rotation1_avx2(X, len, stride, c, s))
+
+#else
+
+extern void (*const EXP_ROTATION1_IMPL[OPUS_ARCHMASK + 1])(
+      celt_norm *X, int len, int stride, opus_val16 c, opus_val16 s);
+
+#  define exp_rotation1(X, len, stride, c, s, arch) \
+    ((*EXP_ROTATION1_IMPL[(arch) & OPUS_ARCHMASK])(X, len, stride, c, s))
+
+#endif
+#endif
+
 #endif
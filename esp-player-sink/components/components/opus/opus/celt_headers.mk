@@ -16,6 +16,7 @@ celt/fixed_generic.h \
 celt/float_cast.h \
 celt/_kiss_fft_guts.h \
 celt/kiss_fft.h \
+celt/kiss_fft_static.h \
 celt/laplace.h \
 celt/mathops.h \
 celt/mdct.h \
@@ -31,6 +32,7 @@ celt/stack_alloc.h \
 celt/vq.h \
 celt/static_modes_float.h \
 celt/static_modes_fixed.h \
+celt/static_fft_fixed.h \
 celt/static_modes_float_arm_ne10.h \
 celt/static_modes_fixed_arm_ne10.h \
 celt/arm/armcpu.h \
@@ -8,6 +8,7 @@ celt/entcode.c \
 celt/entdec.c \
 celt/entenc.c \
 celt/kiss_fft.c \
+celt/kiss_fft_static.c \
 celt/laplace.c \
 celt/mathops.c \
 celt/mdct.c \
@@ -33,6 +34,9 @@ CELT_SOURCES_SSE4_1 = \
 celt/x86/celt_lpc_sse4_1.c \
 celt/x86/pitch_sse4_1.c
 
+CELT_SOURCES_AVX2 = \
+celt/x86/vq_avx2.c
+
 CELT_SOURCES_ARM_RTCD = \
 celt/arm/armcpu.c \
 celt/arm/arm_celt_map.c
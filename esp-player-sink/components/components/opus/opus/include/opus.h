@@ -493,6 +493,59 @@ OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decode_float(
     int decode_fec
 ) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(4);
 
+/** Decode several consecutive Opus packets into one contiguous buffer.
+  * This gives the same output and leaves the decoder in the same state as
+  * calling opus_decode() once per packet, but validates the decoder once and
+  * only re-derives the packet configuration when the TOC byte changes, which
+  * matters for short (2.5 ms and 5 ms) frames arriving in bursts.
+  * @param [in] st <tt>OpusDecoder*</tt>: Decoder state
+  * @param [in] data <tt>const unsigned char*const*</tt>: Array of \a count payloads.
+  *  A NULL entry (or a zero length) is concealed with the duration of the
+  *  previous packet.
+  * @param [in] len <tt>const opus_int32*</tt>: Array of \a count payload lengths in bytes
+  * @param [in] count <tt>int</tt>: Number of packets
+  * @param [out] pcm <tt>opus_int16*</tt>: Output signal (interleaved if 2 channels), with the
+  *  packets decoded back to back. length is frame_size*channels*sizeof(opus_int16)
+  * @param [in] frame_size Number of samples per channel of available space in \a pcm.
+  * @param [out] packets_decoded <tt>int*</tt>: Number of packets consumed. May be NULL.
+  *  Decoding stops at the first packet that fails; if that is not the first
+  *  packet, the samples decoded so far are returned and the caller can
+  *  resume (or conceal) from there.
+  * @returns Number of decoded samples per channel, or @ref opus_errorcodes
+  *  if the first packet could not be decoded.
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decode_batch(
+    OpusDecoder *st,
+    const unsigned char * const *data,
+    const opus_int32 *len,
+    int count,
+    opus_int16 *pcm,
+    int frame_size,
+    int *packets_decoded
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(2) OPUS_ARG_NONNULL(3) OPUS_ARG_NONNULL(5);
+
+/** Decode several consecutive Opus packets with floating point output.
+  * @see opus_decode_batch
+  * @param [in] st <tt>OpusDecoder*</tt>: Decoder state
+  * @param [in] data <tt>const unsigned char*const*</tt>: Array of \a count payloads
+  * @param [in] len <tt>const opus_int32*</tt>: Array of \a count payload lengths in bytes
+  * @param [in] count <tt>int</tt>: Number of packets
+  * @param [out] pcm <tt>float*</tt>: Output signal (interleaved if 2 channels). length
+  *  is frame_size*channels*sizeof(float)
+  * @param [in] frame_size Number of samples per channel of available space in \a pcm.
+  * @param [out] packets_decoded <tt>int*</tt>: Number of packets consumed. May be NULL.
+  * @returns Number of decoded samples per channel, or @ref opus_errorcodes
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decode_batch_float(
+    OpusDecoder *st,
+    const unsigned char * const *data,
+    const opus_int32 *len,
+    int count,
+    float *pcm,
+    int frame_size,
+    int *packets_decoded
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(2) OPUS_ARG_NONNULL(3) OPUS_ARG_NONNULL(5);
+
 /** Perform a CTL function on an Opus decoder.
   *
   * Generally the request and subsequent arguments are generated
@@ -169,6 +169,8 @@ extern "C" {
 #define OPUS_SET_PHASE_INVERSION_DISABLED_REQUEST 4046
 #define OPUS_GET_PHASE_INVERSION_DISABLED_REQUEST 4047
 #define OPUS_GET_IN_DTX_REQUEST              4049
+#define OPUS_SET_ANALYSIS_INTERVAL_REQUEST   4060
+#define OPUS_GET_ANALYSIS_INTERVAL_REQUEST   4061
 
 /** Defines for the presence of extended APIs. */
 #define OPUS_HAVE_OPUS_PROJECTION_H
@@ -620,6 +622,26 @@ extern "C" {
   * @hideinitializer */
 #define OPUS_GET_PREDICTION_DISABLED(x) OPUS_GET_PREDICTION_DISABLED_REQUEST, __opus_check_int_ptr(x)
 
+/** Configures how often the encoder runs its signal analysis (tonality,
+  * bandwidth detection and the speech/music classifier). With an interval
+  * of N greater than 3, the analysis runs on 3 consecutive frames out of
+  * every N (the tonality estimate needs consecutive frames) and the other
+  * frames reuse the result of the last of them. Intervals of 1 to 3 run the
+  * analysis on every frame. This saves CPU when the signal type is already
+  * known, e.g. with OPUS_SET_SIGNAL(OPUS_SIGNAL_MUSIC), at the cost of slower
+  * reaction to changes in the signal. The bitstream is unaffected.
+  * The analysis only runs in float builds at high complexity.
+  * @see OPUS_GET_ANALYSIS_INTERVAL
+  * @param[in] x <tt>opus_int32</tt>: Interval in frames, 1 (default,
+  *                                   every frame) to 50.
+  * @hideinitializer */
+#define OPUS_SET_ANALYSIS_INTERVAL(x) OPUS_SET_ANALYSIS_INTERVAL_REQUEST, __opus_check_int(x)
+/** Gets the encoder's configured analysis interval.
+  * @see OPUS_SET_ANALYSIS_INTERVAL
+  * @param[out] x <tt>opus_int32 *</tt>: Interval in frames, 1 to 50.
+  * @hideinitializer */
+#define OPUS_GET_ANALYSIS_INTERVAL(x) OPUS_GET_ANALYSIS_INTERVAL_REQUEST, __opus_check_int_ptr(x)
+
 /**@}*/
 
 /** @defgroup opus_genericctls Generic CTLs
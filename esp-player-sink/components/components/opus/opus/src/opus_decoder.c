@@ -746,6 +746,137 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
    return nb_samples;
 }
 
+#if !defined(FIXED_POINT) || !defined(DISABLE_FLOAT_API)
+/* Upper bound on the samples per channel a batch decodes, used to size the
+   conversion buffer of the opus_decode_batch() variants that convert. */
+static int opus_decoder_get_batch_samples(const OpusDecoder *st,
+      const unsigned char * const *data, const opus_int32 *len, int count)
+{
+   int i;
+   int total = 0;
+   int duration = st->last_packet_duration>0 ? st->last_packet_duration : st->frame_size;
+   for (i=0;i<count;i++)
+   {
+      if (data[i]==NULL || len[i]==0)
+         total += duration;
+      else if (len[i]>0)
+      {
+         int nb_samples = opus_packet_get_nb_samples(data[i], len[i], st->Fs);
+         if (nb_samples<=0)
+            break;
+         duration = nb_samples;
+         total += nb_samples;
+      } else
+         break;
+   }
+   return IMAX(total, 1);
+}
+#endif
+
+/* Decodes count packets back to back into pcm, as a loop of
+   opus_decode_native() calls would, but validating the state once and
+   re-deriving the mode, bandwidth, frame size and stream channels from the
+   TOC byte only when it changes from one packet to the next. */
+static int opus_decode_batch_native(OpusDecoder *st,
+      const unsigned char * const *data, const opus_int32 *len, int count,
+      opus_val16 *pcm, int frame_size, int *packets_decoded, int soft_clip)
+{
+   int i;
+   int nb_samples;
+   int last_toc;
+   int packet_frame_size, packet_bandwidth, packet_mode, packet_stream_channels;
+   /* 48 x 2.5 ms = 120 ms */
+   opus_int16 size[48];
+   VALIDATE_OPUS_DECODER(st);
+   if (count<0 || frame_size<=0)
+      return OPUS_BAD_ARG;
+
+   last_toc = -1;
+   packet_frame_size = packet_bandwidth = packet_mode = packet_stream_channels = 0;
+   nb_samples = 0;
+   for (i=0;i<count;i++)
+   {
+      const unsigned char *packet = data[i];
+      opus_val16 *out = pcm+nb_samples*st->channels;
+      int avail = frame_size-nb_samples;
+      int ret;
+      if (packet==NULL || len[i]==0)
+      {
+         /* Conceal a lost packet with the duration of the previous one. */
+         int duration = st->last_packet_duration>0 ? st->last_packet_duration : st->frame_size;
+         if (duration > avail)
+            ret = OPUS_BUFFER_TOO_SMALL;
+         else
+            ret = opus_decode_native(st, NULL, 0, out, duration, 0, 0, NULL, soft_clip);
+      } else if (len[i]<0) {
+         ret = OPUS_BAD_ARG;
+      } else {
+         int nb_frames, offset, j;
+         unsigned char toc;
+         if (packet[0] != last_toc)
+         {
+            packet_mode = opus_packet_get_mode(packet);
+            packet_bandwidth = opus_packet_get_bandwidth(packet);
+            packet_frame_size = opus_packet_get_samples_per_frame(packet, st->Fs);
+            packet_stream_channels = opus_packet_get_nb_channels(packet);
+            last_toc = packet[0];
+         }
+         nb_frames = opus_packet_parse_impl(packet, len[i], 0, &toc, NULL,
+                                            size, &offset, NULL);
+         if (nb_frames<0)
+            ret = nb_frames;
+         else if (nb_frames*packet_frame_size > avail)
+            ret = OPUS_BUFFER_TOO_SMALL;
+         else {
+            /* Update the state as the last step to avoid updating it on an invalid packet */
+            st->mode = packet_mode;
+            st->bandwidth = packet_bandwidth;
+            st->frame_size = packet_frame_size;
+            st->stream_channels = packet_stream_channels;
+            packet += offset;
+            ret = 0;
+            for (j=0;j<nb_frames;j++)
+            {
+               int frame_ret;
+               frame_ret = opus_decode_frame(st, packet, size[j], out+ret*st->channels, avail-ret, 0);
+               if (frame_ret<0)
+               {
+                  ret = frame_ret;
+                  break;
+               }
+               celt_assert(frame_ret==packet_frame_size);
+               packet += size[j];
+               ret += frame_ret;
+            }
+            if (ret>=0)
+            {
+               st->last_packet_duration = ret;
+#ifndef FIXED_POINT
+               if (soft_clip)
+                  opus_pcm_soft_clip(out, ret, st->channels, st->softclip_mem);
+               else
+                  st->softclip_mem[0]=st->softclip_mem[1]=0;
+#endif
+            }
+         }
+      }
+      if (ret<0)
+      {
+         /* Report the error only if nothing could be decoded, otherwise
+            return what we have and let the caller resume at packet i. */
+         if (i==0)
+            return ret;
+         break;
+      }
+      nb_samples += ret;
+   }
+   if (packets_decoded)
+      *packets_decoded = i;
+   if (OPUS_CHECK_ARRAY(pcm, nb_samples*st->channels))
+      OPUS_PRINT_INT(nb_samples);
+   return nb_samples;
+}
+
 #ifdef FIXED_POINT
 
 int opus_decode(OpusDecoder *st, const unsigned char *data,
@@ -792,6 +923,44 @@ int opus_decode_float(OpusDecoder *st, const unsigned char *data,
 }
 #endif
 
+int opus_decode_batch(OpusDecoder *st, const unsigned char * const *data,
+      const opus_int32 *len, int count, opus_val16 *pcm, int frame_size,
+      int *packets_decoded)
+{
+   return opus_decode_batch_native(st, data, len, count, pcm, frame_size,
+         packets_decoded, 0);
+}
+
+#ifndef DISABLE_FLOAT_API
+int opus_decode_batch_float(OpusDecoder *st, const unsigned char * const *data,
+      const opus_int32 *len, int count, float *pcm, int frame_size,
+      int *packets_decoded)
+{
+   VARDECL(opus_int16, out);
+   int ret, i;
+   ALLOC_STACK;
+
+   if(frame_size<=0 || count<0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   frame_size = IMIN(frame_size, opus_decoder_get_batch_samples(st, data, len, count));
+   celt_assert(st->channels == 1 || st->channels == 2);
+   ALLOC(out, frame_size*st->channels, opus_int16);
+
+   ret = opus_decode_batch_native(st, data, len, count, out, frame_size,
+         packets_decoded, 0);
+   if (ret > 0)
+   {
+      for (i=0;i<ret*st->channels;i++)
+         pcm[i] = (1.f/32768.f)*(out[i]);
+   }
+   RESTORE_STACK;
+   return ret;
+}
+#endif
+
 
 #else
 int opus_decode(OpusDecoder *st, const unsigned char *data,
@@ -837,6 +1006,42 @@ int opus_decode_float(OpusDecoder *st, const unsigned char *data,
    return opus_decode_native(st, data, len, pcm, frame_size, decode_fec, 0, NULL, 0);
 }
 
+int opus_decode_batch(OpusDecoder *st, const unsigned char * const *data,
+      const opus_int32 *len, int count, opus_int16 *pcm, int frame_size,
+      int *packets_decoded)
+{
+   VARDECL(float, out);
+   int ret, i;
+   ALLOC_STACK;
+
+   if(frame_size<=0 || count<0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   frame_size = IMIN(frame_size, opus_decoder_get_batch_samples(st, data, len, count));
+   celt_assert(st->channels == 1 || st->channels == 2);
+   ALLOC(out, frame_size*st->channels, float);
+
+   ret = opus_decode_batch_native(st, data, len, count, out, frame_size,
+         packets_decoded, 1);
+   if (ret > 0)
+   {
+      for (i=0;i<ret*st->channels;i++)
+         pcm[i] = FLOAT2INT16(out[i]);
+   }
+   RESTORE_STACK;
+   return ret;
+}
+
+int opus_decode_batch_float(OpusDecoder *st, const unsigned char * const *data,
+      const opus_int32 *len, int count, opus_val16 *pcm, int frame_size,
+      int *packets_decoded)
+{
+   return opus_decode_batch_native(st, data, len, count, pcm, frame_size,
+         packets_decoded, 0);
+}
+
 #endif
 
 int opus_decoder_ctl(OpusDecoder *st, int request, ...)
@@ -59,6 +59,7 @@ void print_usage( char* argv[] )
     fprintf(stderr, "-framesize <2.5|5|10|20|40|60|80|100|120> : frame size in ms; default: 20 \n" );
     fprintf(stderr, "-max_payload <bytes> : maximum payload size in bytes, default: 1024\n" );
     fprintf(stderr, "-complexity <comp>   : complexity, 0 (lowest) ... 10 (highest); default: 10\n" );
+    fprintf(stderr, "-analysis_interval <n> : run the signal analysis on 3 frames out of every n (n > 3); default: 1\n" );
     fprintf(stderr, "-inbandfec           : enable SILK inband FEC\n" );
     fprintf(stderr, "-forcemono           : force mono encoding, even for stereo input\n" );
     fprintf(stderr, "-dtx                 : enable SILK DTX\n" );
@@ -225,6 +226,7 @@ int main(int argc, char *argv[])
     int use_vbr;
     int max_payload_bytes;
     int complexity;
+    int analysis_interval;
     int use_inbandfec;
     int use_dtx;
     int forcechannels;
@@ -335,6 +337,7 @@ int main(int argc, char *argv[])
     use_vbr = 1;
     max_payload_bytes = MAX_PACKET;
     complexity = 10;
+    analysis_interval = 1;
     use_inbandfec = 0;
     forcechannels = OPUS_AUTO;
     use_dtx = 0;
@@ -400,6 +403,10 @@ int main(int argc, char *argv[])
             check_encoder_option(decode_only, "-complexity");
             complexity = atoi( argv[ args + 1 ] );
             args += 2;
+        } else if( strcmp( argv[ args ], "-analysis_interval" ) == 0 ) {
+            check_encoder_option(decode_only, "-analysis_interval");
+            analysis_interval = atoi( argv[ args + 1 ] );
+            args += 2;
         } else if( strcmp( argv[ args ], "-inbandfec" ) == 0 ) {
             use_inbandfec = 1;
             args++;
@@ -529,6 +536,7 @@ int main(int argc, char *argv[])
        opus_encoder_ctl(enc, OPUS_SET_VBR(use_vbr));
        opus_encoder_ctl(enc, OPUS_SET_VBR_CONSTRAINT(cvbr));
        opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(complexity));
+       opus_encoder_ctl(enc, OPUS_SET_ANALYSIS_INTERVAL(analysis_interval));
        opus_encoder_ctl(enc, OPUS_SET_INBAND_FEC(use_inbandfec));
        opus_encoder_ctl(enc, OPUS_SET_FORCE_CHANNELS(forcechannels));
        opus_encoder_ctl(enc, OPUS_SET_DTX(use_dtx));
@@ -55,6 +55,8 @@
 
 #ifndef DISABLE_FLOAT_API
 #define PSEUDO_SNR_THRESHOLD 316.23f    /* 10^(25/10) */
+/* Consecutive frames the analysis needs before its tonality can be trusted */
+#define ANALYSIS_WARMUP_FRAMES 3
 #endif
 
 typedef struct {
@@ -88,6 +90,7 @@ struct OpusEncoder {
     int          arch;
     int          use_dtx;                 /* general DTX for both SILK and CELT */
     int          fec_config;
+    int          analysis_interval;
 #ifndef DISABLE_FLOAT_API
     TonalityAnalysisState analysis;
 #endif
@@ -115,6 +118,9 @@ struct OpusEncoder {
     int          detected_bandwidth;
     int          nb_no_activity_ms_Q1;
     opus_val32   peak_signal_energy;
+    /* Position in the analysis decimation cycle, and the last trusted result */
+    int          analysis_frame;
+    AnalysisInfo analysis_last;
 #endif
     int          nonfinal_frame; /* current frame is not the final in a packet */
     opus_uint32  rangeFinal;
@@ -251,6 +257,7 @@ int opus_encoder_init(OpusEncoder* st, opus_int32 Fs, int channels, int applicat
     st->encoder_buffer = st->Fs/100;
     st->lsb_depth = 24;
     st->variable_duration = OPUS_FRAMESIZE_ARG;
+    st->analysis_interval = 1;
 
     /* Delay compensation of 4 ms (2.5 ms for SILK's extra look-ahead
        + 1.5 ms for SILK resamplers and stereo prediction) */
@@ -1129,11 +1136,32 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
 #endif
     {
        is_silence = is_digital_silence(pcm, frame_size, st->channels, lsb_depth);
-       analysis_read_pos_bak = st->analysis.read_pos;
-       analysis_read_subframe_bak = st->analysis.read_subframe;
-       run_analysis(&st->analysis, celt_mode, analysis_pcm, analysis_size, frame_size,
-             c1, c2, analysis_channels, st->Fs,
-             lsb_depth, downmix, &analysis_info);
+       /* With a decimated analysis, it runs on ANALYSIS_WARMUP_FRAMES
+          consecutive frames out of every analysis_interval. The tonality
+          estimate relies on phase differences between consecutive windows,
+          so only the result of the last frame of a run is trusted and reused
+          until the next run completes. The analysis state is left untouched
+          on skipped frames, so its read and write positions stay in step. */
+       int analysis_phase = st->analysis_frame;
+       if (st->analysis_interval > ANALYSIS_WARMUP_FRAMES &&
+             ++st->analysis_frame >= st->analysis_interval)
+          st->analysis_frame = 0;
+       if (st->analysis_interval <= ANALYSIS_WARMUP_FRAMES ||
+             analysis_phase < ANALYSIS_WARMUP_FRAMES || !st->analysis_last.valid)
+       {
+          analysis_read_pos_bak = st->analysis.read_pos;
+          analysis_read_subframe_bak = st->analysis.read_subframe;
+          run_analysis(&st->analysis, celt_mode, analysis_pcm, analysis_size, frame_size,
+                c1, c2, analysis_channels, st->Fs,
+                lsb_depth, downmix, &analysis_info);
+       }
+       if (st->analysis_interval > ANALYSIS_WARMUP_FRAMES)
+       {
+          if (analysis_phase == ANALYSIS_WARMUP_FRAMES-1 || !st->analysis_last.valid)
+             st->analysis_last = analysis_info;
+          else
+             analysis_info = st->analysis_last;
+       }
 
        /* Track the peak signal energy */
        if (!is_silence && analysis_info.activity_probability > DTX_ACTIVITY_THRESHOLD)
@@ -1141,6 +1169,8 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
                 compute_frame_energy(pcm, frame_size, st->channels, st->arch));
     } else if (st->analysis.initialized) {
        tonality_analysis_reset(&st->analysis);
+       st->analysis_frame = 0;
+       st->analysis_last.valid = 0;
     }
 #else
     (void)analysis_pcm;
@@ -2657,6 +2687,22 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
            *value = st->silk_mode.reducedDependency;
         }
         break;
+        case OPUS_SET_ANALYSIS_INTERVAL_REQUEST:
+        {
+           opus_int32 value = va_arg(ap, opus_int32);
+           if (value < 1 || value > 50)
+              goto bad_arg;
+           st->analysis_interval = value;
+        }
+        break;
+        case OPUS_GET_ANALYSIS_INTERVAL_REQUEST:
+        {
+           opus_int32 *value = va_arg(ap, opus_int32*);
+           if (!value)
+              goto bad_arg;
+           *value = st->analysis_interval;
+        }
+        break;
         case OPUS_SET_PHASE_INVERSION_DISABLED_REQUEST:
         {
             opus_int32 value = va_arg(ap, opus_int32);
@@ -1360,6 +1360,16 @@ opus_int32 test_enc_api(void)
      "    OPUS_SET_PREDICTION_DISABLED ................. OK.\n",
      "    OPUS_GET_PREDICTION_DISABLED ................. OK.\n")
 
+   err=opus_encoder_ctl(enc,OPUS_GET_ANALYSIS_INTERVAL(&i));
+   if(i!=1)test_failed();
+   cfgs++;
+   err=opus_encoder_ctl(enc,OPUS_GET_ANALYSIS_INTERVAL(null_int_ptr));
+   if(err!=OPUS_BAD_ARG)test_failed();
+   cfgs++;
+   CHECK_SETGET(OPUS_SET_ANALYSIS_INTERVAL(i),OPUS_GET_ANALYSIS_INTERVAL(&i),0,51,4,1,
+     "    OPUS_SET_ANALYSIS_INTERVAL ................... OK.\n",
+     "    OPUS_GET_ANALYSIS_INTERVAL ................... OK.\n")
+
    err=opus_encoder_ctl(enc,OPUS_GET_EXPERT_FRAME_DURATION(null_int_ptr));
    if(err!=OPUS_BAD_ARG)test_failed();
    cfgs++;
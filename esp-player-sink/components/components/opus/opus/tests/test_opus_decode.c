@@ -380,6 +380,90 @@ int test_decoder_code0(int no_fuzz)
    return 0;
 }
 
+/* opus_decode_batch() must be indistinguishable from a loop of opus_decode(). */
+int test_decode_batch(void)
+{
+   static const int durations[3] = {120, 240, 960};
+   const int max_frame = 960;
+   const int npackets = 10;
+   OpusEncoder *enc;
+   OpusDecoder *dec_loop;
+   OpusDecoder *dec_batch;
+   opus_int16 *in;
+   opus_int16 *out_loop;
+   opus_int16 *out_batch;
+   unsigned char *packets;
+   const unsigned char *data[10];
+   opus_int32 len[10];
+   opus_uint32 rng_loop, rng_batch;
+   int d, i, err, decoded, total;
+
+   fprintf(stdout,"  Testing opus_decode_batch... ");
+   in = (opus_int16 *)malloc(sizeof(*in)*max_frame*2);
+   out_loop = (opus_int16 *)malloc(sizeof(*out_loop)*max_frame*2*npackets);
+   out_batch = (opus_int16 *)malloc(sizeof(*out_batch)*max_frame*2*npackets);
+   packets = (unsigned char *)malloc(1276*npackets);
+   enc = opus_encoder_create(48000, 2, OPUS_APPLICATION_AUDIO, &err);
+   if(err!=OPUS_OK || enc==NULL)test_failed();
+   dec_loop = opus_decoder_create(48000, 2, &err);
+   if(err!=OPUS_OK || dec_loop==NULL)test_failed();
+   dec_batch = opus_decoder_create(48000, 2, &err);
+   if(err!=OPUS_OK || dec_batch==NULL)test_failed();
+
+   if(opus_decode_batch(dec_batch, data, len, -1, out_batch, max_frame, NULL)!=OPUS_BAD_ARG)test_failed();
+   if(opus_decode_batch(dec_batch, data, len, 1, out_batch, 0, NULL)!=OPUS_BAD_ARG)test_failed();
+
+   for(d=0;d<3;d++)
+   {
+      int frame = durations[d];
+      if(opus_encoder_ctl(enc, OPUS_SET_BITRATE(120000))!=OPUS_OK)test_failed();
+      for(i=0;i<npackets;i++)
+      {
+         int j;
+         for(j=0;j<frame*2;j++)in[j]=(opus_int16)((fast_rand()&4095)-2048);
+         len[i] = opus_encode(enc, in, frame, packets+1276*i, 1276);
+         if(len[i]<0 || len[i]>1276)test_failed();
+         data[i] = packets+1276*i;
+      }
+      /* One lost packet in the middle of the burst. */
+      data[npackets/2] = NULL;
+      len[npackets/2] = 0;
+
+      total = 0;
+      for(i=0;i<npackets;i++)
+      {
+         int ret;
+         ret = opus_decode(dec_loop, data[i], len[i], out_loop+total*2,
+               data[i] ? max_frame : frame, 0);
+         if(ret!=frame)test_failed();
+         total += ret;
+      }
+      decoded = -1;
+      if(opus_decode_batch(dec_batch, data, len, npackets, out_batch, max_frame*npackets, &decoded)!=total)test_failed();
+      if(decoded!=npackets)test_failed();
+      if(memcmp(out_loop, out_batch, sizeof(*out_loop)*total*2)!=0)test_failed();
+      if(opus_decoder_ctl(dec_loop, OPUS_GET_FINAL_RANGE(&rng_loop))!=OPUS_OK)test_failed();
+      if(opus_decoder_ctl(dec_batch, OPUS_GET_FINAL_RANGE(&rng_batch))!=OPUS_OK)test_failed();
+      if(rng_loop!=rng_batch)test_failed();
+
+      /* Running out of space stops the batch early and reports it. */
+      if(opus_decode_batch(dec_batch, data, len, npackets, out_batch, frame*3, &decoded)!=frame*3)test_failed();
+      if(decoded!=3)test_failed();
+      if(opus_decoder_ctl(dec_loop, OPUS_RESET_STATE)!=OPUS_OK)test_failed();
+      if(opus_decoder_ctl(dec_batch, OPUS_RESET_STATE)!=OPUS_OK)test_failed();
+   }
+
+   opus_encoder_destroy(enc);
+   opus_decoder_destroy(dec_loop);
+   opus_decoder_destroy(dec_batch);
+   free(in);
+   free(out_loop);
+   free(out_batch);
+   free(packets);
+   printf("OK.\n");
+   return 0;
+}
+
 #ifndef DISABLE_FLOAT_API
 void test_soft_clip(void)
 {
@@ -455,6 +539,7 @@ int main(int _argc, char **_argv)
      into the decoders. This is helpful because garbage data
      may cause the decoders to clip, which angers CLANG IOC.*/
    test_decoder_code0(getenv("TEST_OPUS_NOFUZZ")!=NULL);
+   test_decode_batch();
 #ifndef DISABLE_FLOAT_API
    test_soft_clip();
 #endif
@@ -0,0 +1,166 @@
+/*
+ * Decode throughput of opus_decode_batch() against a loop of opus_decode()
+ * calls, for the short frames where the fixed cost of each call matters most.
+ *
+ * The packets are encoded once from a synthetic stereo signal at the nominal
+ * bitrate of the host, then decoded in bursts of `burst` packets, the way the
+ * sink finds several packets queued after a network stall. Both methods start
+ * from a reset decoder and must produce the same PCM. Each measurement is the
+ * fastest of ROUNDS runs, the two methods alternate so that frequency changes
+ * affect both alike.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "opus.h"
+
+#define RATE            48000
+#define CHANNELS        2
+#define BITRATE         120000  /* nominal bitrate of the host encoder */
+#define SECONDS         4
+#define ROUNDS          15
+#define MAX_PACKET      1500
+#define MAX_BURST       16
+
+typedef struct {
+    int frame_size;
+    int count;
+    unsigned char (*data)[MAX_PACKET];
+    opus_int32 *len;
+} stream_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void fail(const char *what, int err)
+{
+    fprintf(stderr, "%s: %s\n", what, opus_strerror(err));
+    exit(1);
+}
+
+/* a few partials with a slow tremolo and some noise, so that CELT spends its bits like on music */
+static void make_signal(opus_int16 *pcm, int samples)
+{
+    static const double freqs[] = { 110.0, 220.5, 443.0, 1250.0, 3150.0, 7400.0 };
+    uint32_t seed = 1;
+    for (int i = 0; i < samples; i++) {
+        double t = (double)i / RATE;
+        for (int c = 0; c < CHANNELS; c++) {
+            double v = 0;
+            for (size_t k = 0; k < sizeof(freqs) / sizeof(freqs[0]); k++) {
+                v += sin(2 * M_PI * freqs[k] * (1 + 0.002 * c) * t) * (0.5 + 0.5 * sin(2 * M_PI * (0.3 + k) * t)) / (k + 2);
+            }
+            seed = seed * 1664525u + 1013904223u;
+            v += ((int32_t)(seed >> 16) - 32768) / 32768.0 * 0.02;
+            pcm[i * CHANNELS + c] = (opus_int16)lrint(v * 12000);
+        }
+    }
+}
+
+static void encode_stream(stream_t *s, int frame_size, const opus_int16 *pcm)
+{
+    int err;
+    OpusEncoder *enc = opus_encoder_create(RATE, CHANNELS, OPUS_APPLICATION_AUDIO, &err);
+    if (err != OPUS_OK) {
+        fail("opus_encoder_create", err);
+    }
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(BITRATE));
+    opus_encoder_ctl(enc, OPUS_SET_SIGNAL(OPUS_SIGNAL_MUSIC));
+    s->frame_size = frame_size;
+    s->count = SECONDS * RATE / frame_size;
+    s->data = malloc((size_t)s->count * MAX_PACKET);
+    s->len = malloc((size_t)s->count * sizeof(opus_int32));
+    for (int i = 0; i < s->count; i++) {
+        s->len[i] = opus_encode(enc, pcm + (size_t)i * frame_size * CHANNELS, frame_size, s->data[i], MAX_PACKET);
+        if (s->len[i] < 0) {
+            fail("opus_encode", s->len[i]);
+        }
+    }
+    opus_encoder_destroy(enc);
+}
+
+/* decodes the whole stream in bursts, returns the time in ns */
+static uint64_t decode_stream(OpusDecoder *dec, const stream_t *s, int burst, int batch, opus_int16 *out)
+{
+    const unsigned char *data[MAX_BURST];
+    opus_int16 *pcm = out;
+
+    opus_decoder_ctl(dec, OPUS_RESET_STATE);
+    uint64_t start = now_ns();
+    for (int i = 0; i < s->count; i += burst) {
+        int n = s->count - i < burst ? s->count - i : burst;
+        if (batch) {
+            for (int k = 0; k < n; k++) {
+                data[k] = s->data[i + k];
+            }
+            int decoded;
+            int samples = opus_decode_batch(dec, data, &s->len[i], n, pcm, n * s->frame_size, &decoded);
+            if (samples < 0 || decoded != n) {
+                fail("opus_decode_batch", samples < 0 ? samples : OPUS_INTERNAL_ERROR);
+            }
+            pcm += samples * CHANNELS;
+        } else {
+            for (int k = 0; k < n; k++) {
+                int samples = opus_decode(dec, s->data[i + k], s->len[i + k], pcm, s->frame_size, 0);
+                if (samples < 0) {
+                    fail("opus_decode", samples);
+                }
+                pcm += samples * CHANNELS;
+            }
+        }
+    }
+    return now_ns() - start;
+}
+
+int main(void)
+{
+    static const int frame_sizes[] = { 120, 240 };     /* 2.5 ms and 5 ms */
+    static const int bursts[] = { 1, 2, 4, 8, 16 };
+    const int total = SECONDS * RATE;
+    opus_int16 *pcm = malloc((size_t)total * CHANNELS * sizeof(opus_int16));
+    opus_int16 *out_single = malloc((size_t)total * CHANNELS * sizeof(opus_int16));
+    opus_int16 *out_batch = malloc((size_t)total * CHANNELS * sizeof(opus_int16));
+    int err;
+    OpusDecoder *dec = opus_decoder_create(RATE, CHANNELS, &err);
+    if (err != OPUS_OK) {
+        fail("opus_decoder_create", err);
+    }
+
+    make_signal(pcm, total);
+    printf("%d Hz stereo, %d bps, %d s per run, fastest of %d runs\n", RATE, BITRATE, SECONDS, ROUNDS);
+    printf("  frame  burst   single us/pkt   batch us/pkt   speedup\n");
+    for (size_t f = 0; f < sizeof(frame_sizes) / sizeof(frame_sizes[0]); f++) {
+        stream_t s;
+        encode_stream(&s, frame_sizes[f], pcm);
+        for (size_t b = 0; b < sizeof(bursts) / sizeof(bursts[0]); b++) {
+            uint64_t best[2] = { UINT64_MAX, UINT64_MAX };
+            for (int r = 0; r < ROUNDS; r++) {
+                uint64_t t = decode_stream(dec, &s, bursts[b], 0, out_single);
+                best[0] = t < best[0] ? t : best[0];
+                t = decode_stream(dec, &s, bursts[b], 1, out_batch);
+                best[1] = t < best[1] ? t : best[1];
+            }
+            if (memcmp(out_single, out_batch, (size_t)s.count * s.frame_size * CHANNELS * sizeof(opus_int16)) != 0) {
+                fprintf(stderr, "batch output differs from single calls\n");
+                return 1;
+            }
+            printf("  %4.1f ms  %4d   %13.2f   %12.2f   %6.3f\n", s.frame_size * 1000.0 / RATE, bursts[b],
+                   best[0] / 1e3 / s.count, best[1] / 1e3 / s.count, (double)best[0] / best[1]);
+        }
+        free(s.data);
+        free(s.len);
+    }
+    opus_decoder_destroy(dec);
+    free(pcm);
+    free(out_single);
+    free(out_batch);
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include "audio_mem.h"
+#include "audio_trace.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#define TAG "audio_mem"
+
+#define MAX_BUDGET_ENTRIES 10
+#define MAX_WATCHED_TASKS 4
+
+typedef struct {
+    const char* name;
+    size_t bytes;
+    bool heap;
+} budget_entry_t;
+
+static budget_entry_t s_budget[MAX_BUDGET_ENTRIES];
+static int s_budget_count;
+
+#if AUDIO_STATIC_MEMORY
+#if !AUDIO_RX_RAW
+static uint8_t s_pool_storage[poolqueueSTORAGE_SIZE(PACKET_POOL_BLOCKS, MAX_AGGREGATE_PACKET)]
+    __attribute__((aligned(portBYTE_ALIGNMENT)));
+static StaticPoolQueue_t s_pool;
+#endif
+static uint8_t s_decoder_arena[AUDIO_DECODER_ARENA_SIZE] __attribute__((aligned(8)));
+// ESP-IDF的StackType_t是uint8_t，栈深度就是字节数
+#if !AUDIO_RX_RAW
+static StackType_t s_tcp_server_stack[AUDIO_TCP_SERVER_STACK];
+#endif
+static StackType_t s_decode_stack[AUDIO_DECODE_STACK];
+#if AUDIO_TRACE_ENABLE
+static StackType_t s_trace_stack[AUDIO_TRACE_STACK];
+#endif
+static StaticTask_t s_tcbs[AUDIO_TASK_COUNT];
+#endif
+
+static const struct {
+    uint32_t stack_bytes;
+#if AUDIO_STATIC_MEMORY
+    StackType_t* stack;
+#endif
+} s_tasks[AUDIO_TASK_COUNT] = {
+#if AUDIO_STATIC_MEMORY
+#if !AUDIO_RX_RAW
+    [AUDIO_TASK_TCP_SERVER] = {AUDIO_TCP_SERVER_STACK, s_tcp_server_stack},
+#endif
+    [AUDIO_TASK_DECODE] = {AUDIO_DECODE_STACK, s_decode_stack},
+#if AUDIO_TRACE_ENABLE
+    [AUDIO_TASK_TRACE] = {AUDIO_TRACE_STACK, s_trace_stack},
+#endif
+#else
+    [AUDIO_TASK_TCP_SERVER] = {AUDIO_TCP_SERVER_STACK},
+    [AUDIO_TASK_DECODE] = {AUDIO_DECODE_STACK},
+    [AUDIO_TASK_TRACE] = {AUDIO_TRACE_STACK},
+#endif
+};
+
+// 堆钩子里只读这几个变量，不加锁、不打印
+static TaskHandle_t s_watched[MAX_WATCHED_TASKS];
+static volatile uint32_t s_violations;
+static volatile size_t s_last_violation_size;
+static volatile TaskHandle_t s_last_violation_task;
+static uint32_t s_reported_violations;
+static portMUX_TYPE s_watch_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void audio_mem_account(const char* name, size_t bytes, bool heap) {
+    if (s_budget_count == MAX_BUDGET_ENTRIES) {
+        ESP_LOGW(TAG, "Too many budget entries, %s not recorded", name);
+        return;
+    }
+    s_budget[s_budget_count++] = (budget_entry_t){name, bytes, heap};
+}
+
+#if !AUDIO_RX_RAW
+PoolQueueHandle_t audio_mem_create_pool(void) {
+#if AUDIO_STATIC_MEMORY
+    PoolQueueHandle_t pool = xPoolQueueCreateStatic(PACKET_POOL_BLOCKS, MAX_AGGREGATE_PACKET, s_pool_storage, &s_pool);
+    audio_mem_account("packet pool", sizeof(s_pool_storage) + sizeof(s_pool), false);
+#elif defined(CONFIG_HEAP_AUDIO_ARENA)
+    // 池的存储区和控制块都从音频区分配，开机时不在会话里，之后一直保留
+    size_t storage_size = poolqueueSTORAGE_SIZE(PACKET_POOL_BLOCKS, MAX_AGGREGATE_PACKET);
+    uint8_t* storage = heap_caps_malloc(storage_size, MALLOC_CAP_AUDIO);
+    StaticPoolQueue_t* pool_buf = heap_caps_malloc(sizeof(StaticPoolQueue_t), MALLOC_CAP_AUDIO);
+    PoolQueueHandle_t pool = (storage != NULL && pool_buf != NULL)
+                                 ? xPoolQueueCreateStatic(PACKET_POOL_BLOCKS, MAX_AGGREGATE_PACKET, storage, pool_buf)
+                                 : NULL;
+    audio_mem_account("packet pool", storage_size + sizeof(StaticPoolQueue_t), true);
+#else
+    PoolQueueHandle_t pool = xPoolQueueCreate(PACKET_POOL_BLOCKS, MAX_AGGREGATE_PACKET);
+    audio_mem_account("packet pool",
+                      poolqueueSTORAGE_SIZE(PACKET_POOL_BLOCKS, MAX_AGGREGATE_PACKET) + sizeof(StaticPoolQueue_t), true);
+#endif
+    if (pool == NULL) {
+        ESP_LOGE(TAG, "Unable to create the packet pool");
+        abort();
+    }
+    return pool;
+}
+#endif
+
+OpusDecoder* audio_mem_create_decoder(opus_int32 sample_rate, int channels) {
+    int size = opus_decoder_get_size(channels);
+#if AUDIO_STATIC_MEMORY
+    if (size <= 0 || size > AUDIO_DECODER_ARENA_SIZE) {
+        ESP_LOGE(TAG, "Opus decoder needs %d bytes, arena has %d", size, AUDIO_DECODER_ARENA_SIZE);
+        abort();
+    }
+    OpusDecoder* decoder = (OpusDecoder*)s_decoder_arena;
+    int err = opus_decoder_init(decoder, sample_rate, channels);
+    audio_mem_account("opus decoder", sizeof(s_decoder_arena), false);
+#elif defined(CONFIG_HEAP_AUDIO_ARENA)
+    // 解码器状态是音频区里最大的一块，放在别的堆对象旁边，重连多了就可能找不到这么大的连续空间
+    int err = OPUS_ALLOC_FAIL;
+    OpusDecoder* decoder = size > 0 ? heap_caps_malloc(size, MALLOC_CAP_AUDIO) : NULL;
+    if (decoder != NULL) {
+        err = opus_decoder_init(decoder, sample_rate, channels);
+    }
+    audio_mem_account("opus decoder", size, true);
+#else
+    int err;
+    OpusDecoder* decoder = opus_decoder_create(sample_rate, channels, &err);
+    audio_mem_account("opus decoder", size, true);
+#endif
+    if (err != OPUS_OK) {
+        ESP_LOGE(TAG, "Unable to create the decoder: %s", opus_strerror(err));
+        abort();
+    }
+    return decoder;
+}
+
+TaskHandle_t audio_mem_create_task(audio_task_t task, TaskFunction_t fn, const char* name, void* arg,
+                                   UBaseType_t priority, BaseType_t core) {
+    TaskHandle_t handle = NULL;
+#if AUDIO_STATIC_MEMORY
+    if (s_tasks[task].stack == NULL) {
+        ESP_LOGE(TAG, "No stack reserved for task %s", name);
+        abort();
+    }
+    handle = xTaskCreateStaticPinnedToCore(fn, name, s_tasks[task].stack_bytes, arg, priority, s_tasks[task].stack,
+                                           &s_tcbs[task], core);
+    audio_mem_account(name, s_tasks[task].stack_bytes + sizeof(StaticTask_t), false);
+#else
+    xTaskCreatePinnedToCore(fn, name, s_tasks[task].stack_bytes, arg, priority, &handle, core);
+    audio_mem_account(name, s_tasks[task].stack_bytes + sizeof(StaticTask_t), true);
+#endif
+    if (handle == NULL) {
+        ESP_LOGE(TAG, "Unable to create task %s", name);
+        abort();
+    }
+    return handle;
+}
+
+void audio_mem_report(void) {
+    size_t total[2] = {0, 0};
+    ESP_LOGI(TAG, "Audio engine memory budget (%s mode):", AUDIO_STATIC_MEMORY ? "static" : "heap");
+    for (int i = 0; i < s_budget_count; i++) {
+        ESP_LOGI(TAG, "  %-20s %7u B  %s", s_budget[i].name, s_budget[i].bytes, s_budget[i].heap ? "heap" : "static");
+        total[s_budget[i].heap] += s_budget[i].bytes;
+    }
+    ESP_LOGI(TAG, "  total %u B static, %u B heap", total[0], total[1]);
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE
+    // 各核小块缓存里的空闲块在堆看来是已分配的，先还给堆，下面的余量和最大块才准
+    multi_heap_cache_stats_t cache;
+    heap_caps_cache_get_stats(&cache);
+    heap_caps_cache_flush();
+    ESP_LOGI(TAG, "Small block cache: %u hits, %u refills, %u free overflows, %u B cached",
+             cache.alloc_hits, cache.alloc_misses, cache.free_overflows, cache.cached_bytes);
+#endif
+    // 碎片率：空闲内存里不在最大空闲块中的比例，重连后这个值一直涨说明堆在碎片化
+    multi_heap_info_t heap;
+    heap_caps_get_info(&heap, MALLOC_CAP_INTERNAL);
+    ESP_LOGI(TAG, "Internal heap free %u B, largest block %u B (fragmentation %u%%), minimum free %u B",
+             heap.total_free_bytes, heap.largest_free_block,
+             heap.total_free_bytes ? 100 - heap.largest_free_block * 100 / heap.total_free_bytes : 0,
+             heap.minimum_free_bytes);
+#ifdef CONFIG_HEAP_AUDIO_ARENA
+    multi_heap_arena_info_t arena;
+    heap_caps_audio_get_info(&arena);
+    ESP_LOGI(TAG, "Audio arena %u/%u B used, peak %u B, %u B on free lists, largest free %u B, %u failed allocs",
+             arena.allocated_bytes, arena.total_bytes, arena.peak_bytes, arena.free_list_bytes,
+             arena.largest_free_block, arena.failed_allocs);
+#endif
+#ifndef CONFIG_HEAP_USE_HOOKS
+    ESP_LOGW(TAG, "CONFIG_HEAP_USE_HOOKS is off, heap allocations on the audio path are not checked");
+#endif
+}
+
+void audio_mem_watch(bool on) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&s_watch_lock);
+    for (int i = 0; i < MAX_WATCHED_TASKS; i++) {
+        if (on ? s_watched[i] == NULL : s_watched[i] == self) {
+            s_watched[i] = on ? self : NULL;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_watch_lock);
+}
+
+void audio_mem_check(void) {
+    uint32_t violations = s_violations;
+    if (violations == s_reported_violations) {
+        return;
+    }
+    TaskHandle_t task = s_last_violation_task;
+    ESP_LOGW(TAG, "%u heap allocations on the audio path, last one %u B in task %s",
+             violations, s_last_violation_size, task ? pcTaskGetName(task) : "?");
+    s_reported_violations = violations;
+}
+
+#ifdef CONFIG_HEAP_USE_HOOKS
+// 每次堆分配成功后都会调到这里，可能在cache关闭时被调用，必须放在IRAM
+void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    if (xPortInIsrContext() || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+        return;
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < MAX_WATCHED_TASKS; i++) {
+        if (s_watched[i] == self) {
+            s_violations++;
+            s_last_violation_size = size;
+            s_last_violation_task = self;
+#if AUDIO_MEM_ASSERT_NO_ALLOC
+            assert(0 && "heap allocation on the audio path");
+#endif
+            return;
+        }
+    }
+}
+#endif
@@ -0,0 +1,61 @@
+// 音频引擎的内存：池队列、解码任务和接收任务的栈、Opus解码器状态都在开机时一次建好，
+// 之后每次连接断开重连都复用，不再走堆，反复重连也不会把堆碎片化。
+// 静态内存模式下这些对象全部用*CreateStatic和编译期确定大小的静态区，占用在链接时就能看到。
+// 开机时audio_mem_report()打印内存预算；打开CONFIG_HEAP_USE_HOOKS时，音频链路上的任务在堆上分配内存会被记下来。
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/pool_queue.h"
+#include "opus.h"
+
+// 置1时音频引擎的对象全部放在静态区，置0时开机从堆上各分配一次；
+// 置0且打开CONFIG_HEAP_AUDIO_ARENA时，池和解码器从开机划出的音频区(MALLOC_CAP_AUDIO)分配，不和其他堆对象混在一起
+#define AUDIO_STATIC_MEMORY 1
+// 置1时音频链路上的任务在堆上分配内存直接断言失败，置0时只计数，由audio_mem_check()打印出来
+#define AUDIO_MEM_ASSERT_NO_ALLOC 0
+
+// 置1时接收走tcp_recv/udp_recv回调(audio_rx_raw.c)，pbuf直接进解码队列，不需要池队列和接收任务；
+// 置0时走BSD socket，由接收任务recv进池里的块
+#define AUDIO_RX_RAW 1
+
+// 接收任务直接recv进池里的块，解码任务用完再还回池，队列里只传块指针和长度，不拷贝包数据
+#define PACKET_POOL_BLOCKS 10
+// 主机端用repacketizer聚合后的最大包长，和主机保持一致
+#define MAX_AGGREGATE_PACKET 1500
+// TCP上每个包前面是2字节大端的包长，板子按它分包，不依赖PSH：主机连着发的包可能被合并进一个段。UDP一个数据报就是一个包，没有包头
+#define PACKET_HEADER_LEN 2
+// Opus解码器状态的静态区，48kHz立体声定点解码器实际约26KB，开机时检查opus_decoder_get_size()不超过它
+#define AUDIO_DECODER_ARENA_SIZE (28 * 1024)
+
+// 音频引擎的任务，栈大小按字节
+typedef enum {
+    AUDIO_TASK_TCP_SERVER,  // 监听、接收包，AUDIO_RX_RAW时不创建
+    AUDIO_TASK_DECODE,      // 解码、写I2S
+    AUDIO_TASK_TRACE,       // 导出跟踪事件，AUDIO_TRACE_ENABLE为0时不创建
+    AUDIO_TASK_COUNT,
+} audio_task_t;
+
+#define AUDIO_TCP_SERVER_STACK 25000
+#define AUDIO_DECODE_STACK 18000
+#define AUDIO_TRACE_STACK 4096
+
+// 以下创建函数都只在开机时调用一次，失败时直接abort，开机阶段内存不够没有继续运行的意义
+#if !AUDIO_RX_RAW
+PoolQueueHandle_t audio_mem_create_pool(void);
+#endif
+OpusDecoder* audio_mem_create_decoder(opus_int32 sample_rate, int channels);
+TaskHandle_t audio_mem_create_task(audio_task_t task, TaskFunction_t fn, const char* name, void* arg,
+                                   UBaseType_t priority, BaseType_t core);
+
+// 把不在上面几个对象里的内存记进预算报告，heap为true表示是从堆上分配的(比如I2S驱动的DMA缓冲区)
+void audio_mem_account(const char* name, size_t bytes, bool heap);
+// 打印内存预算：每个对象的大小和来源、合计，以及当前的堆余量
+void audio_mem_report(void);
+
+// 开始/停止监视当前任务在堆上分配内存，监视期间的每次分配都算一次违例
+void audio_mem_watch(bool on);
+// 有新的违例时打印次数和最近一次的大小、任务名，由音频任务定期调用
+void audio_mem_check(void);
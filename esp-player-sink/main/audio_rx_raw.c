@@ -0,0 +1,474 @@
+#include "audio_rx_raw.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/tcp.h"
+#include "lwip/udp.h"
+#include "lwip/tcpip.h"
+#include "opus.h"
+
+#include "audio_mem.h"
+#include "audio_trace.h"
+
+#define TAG "audio_rx_raw"
+
+// 和hello_world_main.c里的保持一致
+#define RATE 48000
+#define REPORT_LEN 10
+#define REPORT_JITTER_UNIT_US 100
+// 和socket路径的KEEPALIVE_*一致，单位ms
+#define KEEPALIVE_IDLE_MS (7200 * 1000)
+#define KEEPALIVE_INTERVAL_MS (75 * 1000)
+#define KEEPALIVE_COUNT 10
+// 接收窗口按播放缓冲的目标时长和实测码率设置，窗口里最多是这么长的音频(两个聚合包)。
+// 主机多出来的数据留在它自己按时延目标设置的发送缓冲里，而不是占着板子的接收缓冲
+#define PLAYOUT_TARGET_MS 80
+// 连接刚建立、还没测到码率时按主机的默认码率算
+#define NOMINAL_BITRATE 120000
+// 每隔这么久按这段时间收到的字节数重新算一次窗口
+#define WINDOW_UPDATE_US 1000000
+
+// 以下变量除注明的以外只在tcpip线程里访问
+typedef struct {
+    struct tcp_pcb* pcb;
+    struct pbuf* partial;   // 还没拆成包的数据，从包头开始
+    struct pbuf* held;      // 解码队列满时收完的包先放在这里，不回确认，主机就不会发下一个包
+    tcpwnd_size_t window;   // 当前的接收窗口目标
+    tcpwnd_size_t shrink;   // 窗口还要缩小的字节数，从之后收到的数据里扣
+    uint32_t rate_bytes;    // 从rate_start开始收到的字节数
+    int64_t rate_start;
+    int64_t first_segment;  // 当前包第一个段到达(或上一个报告发出)的时间
+    int64_t last_report;    // 上一个报告发出的时间
+} rx_conn_t;
+
+static rx_conn_t s_conn;
+static struct udp_pcb* s_udp;
+static uint16_t s_port;
+static const volatile uint32_t* s_underruns;
+// 解码任务释放pbuf后通过它让tcpip线程重试放入held的包，开机时分配好，之后不再分配
+static struct tcpip_callback_msg* s_kick_msg;
+static volatile bool s_holding;   // 解码任务也会读
+
+static QueueHandle_t s_queue;
+static StaticQueue_t s_queue_buf;
+static uint8_t s_queue_storage[AUDIO_RX_QUEUE_LEN * sizeof(struct pbuf*)];
+// 跨多个pbuf的包拼成连续的一块给解码器，只有解码任务用
+static unsigned char s_linear[MAX_AGGREGATE_PACKET];
+
+// RFC3550的到达抖动，以包里的音频时长作为发送间隔
+static int64_t s_last_arrival;
+static int s_last_duration_us;
+static int64_t s_jitter_us;
+static uint16_t s_seq;  // 包序号，解码任务那边按同样的顺序计数
+
+// 统计，每秒由audio_rx_raw_report()打印后清零
+static volatile uint32_t s_packets;
+static volatile uint32_t s_linearized;
+static volatile uint32_t s_held;
+static volatile uint32_t s_dropped;
+static volatile uint32_t s_quickacks;
+// 每包的有效时延: 第一个段到达到报告发出(含held的时间)；主机周转: 报告发出到下一个包的第一个段到达
+static volatile uint32_t s_latency_count;
+static volatile uint32_t s_latency_sum_us;
+static volatile uint32_t s_latency_max_us;
+static volatile uint32_t s_turnaround_count;
+static volatile uint32_t s_turnaround_sum_us;
+static volatile uint32_t s_turnaround_max_us;
+static volatile uint32_t s_window;
+
+// 一个包收完时更新到达抖动，必须在放进解码队列之前调用，放进去之后pbuf可能已经被解码任务释放了
+static void rx_arrival(struct pbuf* p) {
+    unsigned char toc[2] = {0, 0};
+    pbuf_copy_partial(p, toc, sizeof(toc), 0);   // opus_packet_get_nb_samples只看前两个字节
+    int nb_samples = opus_packet_get_nb_samples(toc, p->tot_len, RATE);
+    int64_t arrival = esp_timer_get_time();
+    if (s_last_arrival != 0) {
+        int64_t d = (arrival - s_last_arrival) - s_last_duration_us;
+        if (d < 0) d = -d;
+        s_jitter_us += (d - s_jitter_us) / 16;
+    }
+    s_last_arrival = arrival;
+    s_last_duration_us = nb_samples > 0 ? (int)((int64_t)nb_samples * 1000000 / RATE) : 0;
+}
+
+// 链路报告: "ok" | 解码队列积压包数 | 欠载次数低8位 | 抖动(大端2字节,单位100us) | 保留
+static void link_report(char* report) {
+    int jitter_units = (int)(s_jitter_us / REPORT_JITTER_UNIT_US);
+    if (jitter_units > 0xFFFF) jitter_units = 0xFFFF;
+    UBaseType_t waiting = uxQueueMessagesWaiting(s_queue);
+    memset(report, 0, REPORT_LEN);
+    report[0] = 'o';
+    report[1] = 'k';
+    report[2] = (char)(waiting > 0xFF ? 0xFF : waiting);
+    report[3] = (char)(*s_underruns & 0xFF);
+    report[4] = (char)(jitter_units >> 8);
+    report[5] = (char)(jitter_units & 0xFF);
+}
+
+// 把一个完整的包交给解码任务，放进队列后pbuf归解码任务所有
+static bool rx_post(struct pbuf* p) {
+    uint16_t len = p->tot_len;
+    if (xQueueSend(s_queue, &p, 0) != pdPASS) {
+        return false;
+    }
+    audio_trace(TRACE_RX, s_seq++, len);
+    s_packets++;
+    return true;
+}
+
+static void rx_conn_reset(void) {
+    if (s_conn.partial != NULL) {
+        pbuf_free(s_conn.partial);
+    }
+    if (s_conn.held != NULL) {
+        pbuf_free(s_conn.held);
+    }
+    memset(&s_conn, 0, sizeof(s_conn));
+    s_holding = false;
+}
+
+static tcpwnd_size_t rx_window_for(uint32_t bitrate_bps) {
+    uint32_t wnd = (uint32_t)((uint64_t)bitrate_bps * PLAYOUT_TARGET_MS / 8000);
+    // 至少能放下一个最大的包，并且不少于两个段，免得拆成两段的包等窗口更新
+    uint32_t min = MAX_AGGREGATE_PACKET > 2 * TCP_MSS ? MAX_AGGREGATE_PACKET : 2 * TCP_MSS;
+    if (wnd < min) wnd = min;
+    // TCP_WND(CONFIG_LWIP_TCP_WND_DEFAULT)是编译时的上限
+    if (wnd > TCP_WND) wnd = TCP_WND;
+    return (tcpwnd_size_t)wnd;
+}
+
+static void rx_set_window(struct tcp_pcb* pcb, tcpwnd_size_t target) {
+    if (target > s_conn.window) {
+        // 先抵掉还没扣完的缩小量，剩下的tcp_recved()，窗口更新够大的话lwIP立即通告
+        tcpwnd_size_t grow = target - s_conn.window;
+        if (s_conn.shrink >= grow) {
+            s_conn.shrink -= grow;
+        } else {
+            tcp_recved(pcb, grow - s_conn.shrink);
+            s_conn.shrink = 0;
+        }
+    } else {
+        // 不能直接减rcv_wnd：lwIP会截掉超出rcv_wnd的数据，主机按已经通告的窗口发出的段就得重传
+        s_conn.shrink += s_conn.window - target;
+    }
+    s_conn.window = target;
+    s_window = target;
+}
+
+// 收下的数据归还接收窗口，要缩小窗口时少还一些，通告的窗口随着数据到达变小
+static void rx_recved(struct tcp_pcb* pcb, uint16_t len) {
+    uint16_t keep = s_conn.shrink < len ? (uint16_t)s_conn.shrink : len;
+    s_conn.shrink -= keep;
+    if (len > keep) {
+        tcp_recved(pcb, len - keep);
+    }
+}
+
+// 按最近一段时间实测的码率调整接收窗口
+static void rx_window_track(struct tcp_pcb* pcb, uint16_t len) {
+    int64_t now = esp_timer_get_time();
+    s_conn.rate_bytes += len;
+    if (now - s_conn.rate_start < WINDOW_UPDATE_US) {
+        return;
+    }
+    uint32_t bitrate = (uint32_t)((uint64_t)s_conn.rate_bytes * 8 * 1000000 / (now - s_conn.rate_start));
+    rx_set_window(pcb, rx_window_for(bitrate));
+    s_conn.rate_bytes = 0;
+    s_conn.rate_start = now;
+}
+
+static void rx_latency(volatile uint32_t* count, volatile uint32_t* sum, volatile uint32_t* max, int64_t us) {
+    uint32_t v = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+    (*count)++;
+    *sum += v;
+    if (v > *max) *max = v;
+}
+
+// 给主机回一个报告，主机收到报告才发下一个包
+static void tcp_report(void) {
+    char report[REPORT_LEN];
+    link_report(report);
+    tcp_write(s_conn.pcb, report, REPORT_LEN, TCP_WRITE_FLAG_COPY);
+    tcp_output(s_conn.pcb);
+    int64_t now = esp_timer_get_time();
+    rx_latency(&s_latency_count, &s_latency_sum_us, &s_latency_max_us, now - s_conn.first_segment);
+    s_conn.last_report = now;
+    // partial里剩下的下一个包从现在算起，partial是空的话等它第一个段到达时再重新记
+    s_conn.first_segment = now;
+}
+
+// TCP包放进解码队列并回确认，队列满时先放在held里
+static void tcp_deliver(struct pbuf* p) {
+    if (!rx_post(p)) {
+        s_conn.held = p;
+        s_holding = true;
+        s_held++;
+        return;
+    }
+    tcp_report();
+}
+
+// 断开连接，主机重连后从新的包边界开始。pcb还在时调用，调用后不能再碰pcb
+static void rx_abort(struct tcp_pcb* pcb) {
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, NULL);
+    tcp_err(pcb, NULL);
+    rx_conn_reset();
+    tcp_abort(pcb);
+}
+
+// 按包长从partial里拆出收完的包交给解码任务，返回回了几个报告；包长不对时返回-1，由调用者断开连接。
+// 有包被held时停下，剩下的数据留在partial里，等rx_kick()放进队列后接着拆
+static int rx_parse(struct tcp_pcb* pcb) {
+    int reports = 0;
+    while (s_conn.held == NULL && s_conn.partial != NULL && s_conn.partial->tot_len >= PACKET_HEADER_LEN) {
+        unsigned char header[PACKET_HEADER_LEN];
+        pbuf_copy_partial(s_conn.partial, header, PACKET_HEADER_LEN, 0);
+        uint16_t len = (uint16_t)((header[0] << 8) | header[1]);
+        if (len == 0 || len > MAX_AGGREGATE_PACKET) {
+            // 只丢这个包的话，后面的数据就没法再分包了
+            ESP_LOGE(TAG, "Bad packet length %u, dropping the connection", len);
+            s_dropped++;
+            return -1;
+        }
+        if (s_conn.partial->tot_len < PACKET_HEADER_LEN + len) {
+            break;
+        }
+        struct pbuf* packet;
+        if (s_conn.partial->tot_len == PACKET_HEADER_LEN + len) {
+            // 通常的情况：收到的正好是一个包，去掉包头，pbuf链直接进解码队列
+            packet = pbuf_free_header(s_conn.partial, PACKET_HEADER_LEN);
+            s_conn.partial = NULL;
+        } else {
+            // 后面跟着下一个包的数据(主机连着发的包被合并进了一个段)，这个包拷出来，剩下的留在partial里
+            packet = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+            if (packet != NULL) {
+                pbuf_copy_partial(s_conn.partial, packet->payload, len, PACKET_HEADER_LEN);
+            }
+            s_conn.partial = pbuf_free_header(s_conn.partial, PACKET_HEADER_LEN + len);
+        }
+        rx_window_track(pcb, PACKET_HEADER_LEN + len);
+        if (packet == NULL) {
+            // 没内存拷这个包，丢掉它，报告照发，主机不用等到超时
+            s_dropped++;
+            tcp_report();
+        } else {
+            rx_arrival(packet);
+            tcp_deliver(packet);
+        }
+        if (s_conn.held == NULL) {
+            reports++;
+        }
+    }
+    return reports;
+}
+
+// tcpip线程里执行，解码任务释放pbuf后重试held的包，再接着拆partial里剩下的包
+static void rx_kick(void* ctx) {
+    if (s_conn.held == NULL) {
+        return;
+    }
+    struct pbuf* p = s_conn.held;
+    s_conn.held = NULL;
+    s_holding = false;
+    tcp_deliver(p);
+    if (rx_parse(s_conn.pcb) < 0) {
+        rx_abort(s_conn.pcb);
+    }
+}
+
+static err_t on_tcp_recv(void* arg, struct tcp_pcb* pcb, struct pbuf* p, err_t err) {
+    if (p == NULL) {
+        ESP_LOGW(TAG, "Connection closed");
+        rx_conn_reset();
+        tcp_arg(pcb, NULL);
+        tcp_recv(pcb, NULL);
+        tcp_err(pcb, NULL);
+        if (tcp_close(pcb) != ERR_OK) {
+            tcp_abort(pcb);
+            return ERR_ABRT;
+        }
+        return ERR_OK;
+    }
+    if (s_conn.held != NULL) {
+        // 停等协议下主机收到确认前不会再发，真有数据就让lwIP先留着(refused_data)，之后再交上来
+        return ERR_MEM;
+    }
+    rx_recved(pcb, p->tot_len);
+    if (s_conn.partial == NULL) {
+        s_conn.first_segment = esp_timer_get_time();
+        if (s_conn.last_report != 0) {
+            rx_latency(&s_turnaround_count, &s_turnaround_sum_us, &s_turnaround_max_us,
+                       s_conn.first_segment - s_conn.last_report);
+        }
+        s_conn.partial = p;
+    } else {
+        pbuf_cat(s_conn.partial, p);
+    }
+    // 包边界只看包头里的包长，主机的send()和段不是一一对应的
+    int reports = rx_parse(pcb);
+    if (reports < 0) {
+        rx_abort(pcb);  // partial里已经接上了p，一起释放
+        return ERR_ABRT;
+    }
+    // 没有报告可以捎带ACK时立即确认(相当于TCP_QUICKACK)，回调返回后lwIP会调用tcp_output()发出去：
+    // 包还没收完时，没关Nagle的发送方要等这个ACK才发包的最后一段，延迟确认会让它多等到下一个快定时器
+    // (最多TCP_TMR_INTERVAL)；包被held时，主机一直收不到ACK会按RTO重传，而这个包只是在等解码队列
+    if (reports == 0) {
+        tcp_ack_now(pcb);
+        s_quickacks++;
+    }
+    return ERR_OK;
+}
+
+static void on_tcp_err(void* arg, err_t err) {
+    // pcb已经被lwIP释放了
+    ESP_LOGE(TAG, "Connection error %d", err);
+    rx_conn_reset();
+}
+
+static err_t on_tcp_accept(void* arg, struct tcp_pcb* newpcb, err_t err) {
+    if (err != ERR_OK || newpcb == NULL) {
+        return ERR_VAL;
+    }
+    if (s_conn.pcb != NULL) {
+        // 主机重连时旧连接可能还没断开，直接丢掉旧连接
+        ESP_LOGW(TAG, "New connection, dropping the old one");
+        struct tcp_pcb* old = s_conn.pcb;
+        tcp_arg(old, NULL);
+        tcp_recv(old, NULL);
+        tcp_err(old, NULL);
+        rx_conn_reset();
+        tcp_abort(old);
+    }
+    s_conn.pcb = newpcb;
+    // 会话参数：报告只有10字节，关掉Nagle，不等上一个报告的ACK就发出去；
+    // 接收窗口先按默认码率设置，之后按实测码率调整
+    tcp_nagle_disable(newpcb);
+    s_conn.window = TCP_WND;
+    rx_set_window(newpcb, rx_window_for(NOMINAL_BITRATE));
+    s_conn.rate_start = esp_timer_get_time();
+    ip_set_option(newpcb, SOF_KEEPALIVE);
+    newpcb->keep_idle = KEEPALIVE_IDLE_MS;
+#if LWIP_TCP_KEEPALIVE
+    newpcb->keep_intvl = KEEPALIVE_INTERVAL_MS;
+    newpcb->keep_cnt = KEEPALIVE_COUNT;
+#endif
+    tcp_recv(newpcb, on_tcp_recv);
+    tcp_err(newpcb, on_tcp_err);
+    ESP_LOGI(TAG, "Connection accepted ip address: %s", ipaddr_ntoa(&newpcb->remote_ip));
+    return ERR_OK;
+}
+
+// UDP一个数据报就是一个包，队列满时直接丢掉，报告发回给发送方
+static void on_udp_recv(void* arg, struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* addr, u16_t port) {
+    char report[REPORT_LEN];
+    if (p->tot_len > MAX_AGGREGATE_PACKET) {
+        pbuf_free(p);
+        s_dropped++;
+        return;
+    }
+    rx_arrival(p);
+    if (!rx_post(p)) {
+        pbuf_free(p);
+        s_dropped++;
+        return;
+    }
+    link_report(report);
+    struct pbuf* r = pbuf_alloc(PBUF_TRANSPORT, REPORT_LEN, PBUF_RAM);
+    if (r != NULL) {
+        memcpy(r->payload, report, REPORT_LEN);
+        udp_sendto(pcb, r, addr, port);
+        pbuf_free(r);
+    }
+}
+
+static void rx_setup(void* ctx) {
+    struct tcp_pcb* pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+    if (pcb != NULL) {
+        ip_set_option(pcb, SOF_REUSEADDR);
+    }
+    if (pcb == NULL || tcp_bind(pcb, IP_ANY_TYPE, s_port) != ERR_OK) {
+        ESP_LOGE(TAG, "Unable to bind TCP port %d", s_port);
+        abort();
+    }
+    struct tcp_pcb* listen_pcb = tcp_listen_with_backlog(pcb, 1);
+    if (listen_pcb == NULL) {
+        ESP_LOGE(TAG, "Unable to listen on TCP port %d", s_port);
+        abort();
+    }
+    tcp_accept(listen_pcb, on_tcp_accept);
+
+    s_udp = udp_new_ip_type(IPADDR_TYPE_ANY);
+    if (s_udp == NULL || udp_bind(s_udp, IP_ANY_TYPE, s_port) != ERR_OK) {
+        ESP_LOGE(TAG, "Unable to bind UDP port %d", s_port);
+        abort();
+    }
+    udp_recv(s_udp, on_udp_recv, NULL);
+    ESP_LOGI(TAG, "Listening on TCP and UDP port %d", s_port);
+}
+
+void audio_rx_raw_start(uint16_t port, const volatile uint32_t* underruns) {
+    s_port = port;
+    s_underruns = underruns;
+    s_queue = xQueueCreateStatic(AUDIO_RX_QUEUE_LEN, sizeof(struct pbuf*), s_queue_storage, &s_queue_buf);
+    audio_mem_account("rx pbuf queue", sizeof(s_queue_storage) + sizeof(s_queue_buf), false);
+    audio_mem_account("rx linear buffer", sizeof(s_linear), false);
+    s_kick_msg = tcpip_callbackmsg_new(rx_kick, NULL);
+    if (s_kick_msg == NULL || tcpip_callback(rx_setup, NULL) != ERR_OK) {
+        ESP_LOGE(TAG, "Unable to start the receiver");
+        abort();
+    }
+}
+
+void audio_rx_raw_receive(audio_rx_packet_t* pkt) {
+    xQueueReceive(s_queue, &pkt->p, portMAX_DELAY);
+    pkt->len = pkt->p->tot_len;
+    if (pkt->p->len == pkt->p->tot_len) {
+        pkt->data = pkt->p->payload;
+    } else {
+        pbuf_copy_partial(pkt->p, s_linear, pkt->p->tot_len, 0);
+        pkt->data = s_linear;
+        s_linearized++;
+    }
+}
+
+void audio_rx_raw_release(audio_rx_packet_t* pkt) {
+    // ESP32的lwIP开了SYS_LIGHTWEIGHT_PROT，pbuf_free可以在tcpip线程以外调用
+    pbuf_free(pkt->p);
+    pkt->p = NULL;
+    if (s_holding) {
+        // 让出了队列位置，失败说明tcpip邮箱满了，下一个包释放时再试
+        tcpip_callbackmsg_trycallback(s_kick_msg);
+    }
+}
+
+UBaseType_t audio_rx_raw_waiting(void) {
+    return uxQueueMessagesWaiting(s_queue);
+}
+
+void audio_rx_raw_report(void) {
+    printf("rx %u packets/s, %u linearized, %u held, %u dropped\n",
+           s_packets, s_linearized, s_held, s_dropped);
+    if (s_latency_count > 0) {
+        printf("rx tcp latency avg %u max %u us, host turnaround avg %u max %u us, window %u, %u quick acks\n",
+               s_latency_sum_us / s_latency_count, s_latency_max_us,
+               s_turnaround_count ? s_turnaround_sum_us / s_turnaround_count : 0, s_turnaround_max_us,
+               s_window, s_quickacks);
+    }
+    s_packets = 0;
+    s_linearized = 0;
+    s_held = 0;
+    s_dropped = 0;
+    s_quickacks = 0;
+    s_latency_count = 0;
+    s_latency_sum_us = 0;
+    s_latency_max_us = 0;
+    s_turnaround_count = 0;
+    s_turnaround_sum_us = 0;
+    s_turnaround_max_us = 0;
+}
@@ -0,0 +1,32 @@
+// 回调方式的接收：不走BSD socket，直接在tcpip线程里用tcp_recv/udp_recv回调收包。
+// socket路径每个包都要经过tcpip线程的邮箱、netconn信号量唤醒接收任务，再把pbuf链拷贝进池里的块；
+// 回调路径在tcpip线程里按包头的包长(PACKET_HEADER_LEN)把收到的pbuf拼成链，去掉包头后连同pbuf的引用一起放进解码队列，
+// 解码任务用完再pbuf_free。包数据一般不拷贝，只有跨多个pbuf的包在解码前要拼成连续的一块，
+// 以及一个段里同时带着下一个包的开头时，这个包要拷出来。
+// 链路报告也在回调里直接tcp_write回去，不需要单独的接收任务。
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "lwip/pbuf.h"
+
+// 解码队列最多积压的包数，积压的pbuf占着Wi-Fi驱动的接收缓冲区，不能比CONFIG_ESP32_WIFI_DYNAMIC_RX_BUFFER_NUM大太多
+#define AUDIO_RX_QUEUE_LEN 10
+
+// 解码任务取到的一个包
+typedef struct {
+    struct pbuf* p;         // 包的pbuf链，audio_rx_raw_release()时释放
+    unsigned char* data;    // 连续的包数据，单个pbuf时直接指向payload
+    int len;
+} audio_rx_packet_t;
+
+// 开机时调用一次，在port上同时监听TCP和UDP；underruns是解码任务的欠载计数，放进链路报告
+void audio_rx_raw_start(uint16_t port, const volatile uint32_t* underruns);
+
+// 解码任务调用：阻塞取下一个包，用完后必须调用audio_rx_raw_release()
+void audio_rx_raw_receive(audio_rx_packet_t* pkt);
+void audio_rx_raw_release(audio_rx_packet_t* pkt);
+// 解码队列里还在等的包数
+UBaseType_t audio_rx_raw_waiting(void);
+// 打印并清零接收统计，由解码任务每秒调用
+void audio_rx_raw_report(void);
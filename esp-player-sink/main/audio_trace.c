@@ -0,0 +1,184 @@
+#include "audio_trace.h"
+#include "audio_mem.h"
+
+#if AUDIO_TRACE_ENABLE
+
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+
+#define TAG "audio_trace"
+
+// 环形缓冲区的记录数，必须是2的幂。400包/秒、每包4条事件时能存1.2秒，导出间隔的十几倍
+#define TRACE_RING_RECORDS 2048
+// 每个核至少每隔这么久插一条同步事件，CPU周期计数器240MHz时约18秒回绕一次
+#define TRACE_SYNC_INTERVAL_US 100000
+// 导出任务每隔这么久把缓冲区里的事件发给主机
+#define TRACE_DRAIN_MS 100
+#define TRACE_BATCH_RECORDS 128
+// 主机只连不发，空闲这么久后开始探测，连续几次没有回应就断开，主机掉电时不会一直占着导出端口
+#define TRACE_KEEPALIVE_IDLE_S 5
+#define TRACE_KEEPALIVE_INTERVAL_S 1
+#define TRACE_KEEPALIVE_COUNT 3
+
+static audio_trace_record_t s_ring[TRACE_RING_RECORDS];
+static audio_trace_record_t s_batch[TRACE_BATCH_RECORDS];   // 导出任务每次从环形缓冲区取出来发送的一批
+static uint32_t s_head;             // 下一条写入的位置，只增不减，用掩码取下标
+static uint32_t s_tail;             // 下一条导出的位置
+static uint32_t s_dropped;          // 缓冲区满丢掉的事件数
+static uint32_t s_last_sync[portNUM_PROCESSORS];
+static uint32_t s_sync_pending;     // 按核的位图，置位的核下一条事件前先插同步事件
+static uint32_t s_sync_cycles;
+static volatile bool s_enabled;     // 主机连上导出端口后才记录
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void trace_server_task(void* pvParameters);
+
+// 调用者持有s_lock
+static inline void ring_put(uint32_t cycles, uint32_t arg, uint16_t seq, uint8_t event, uint8_t core) {
+    if (s_head - s_tail >= TRACE_RING_RECORDS) {
+        s_dropped++;
+        return;
+    }
+    audio_trace_record_t* r = &s_ring[s_head & (TRACE_RING_RECORDS - 1)];
+    r->cycles = cycles;
+    r->arg = arg;
+    r->seq = seq;
+    r->event = event;
+    r->core = core;
+    s_head++;
+}
+
+void audio_trace(uint8_t event, uint16_t seq, uint32_t arg) {
+    if (!s_enabled) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    uint8_t core = (uint8_t)xPortGetCoreID();
+    uint32_t cycles = esp_cpu_get_cycle_count();
+    if ((s_sync_pending & (1 << core)) || cycles - s_last_sync[core] > s_sync_cycles) {
+        ring_put(cycles, (uint32_t)esp_timer_get_time(), 0, TRACE_SYNC, core);
+        s_last_sync[core] = cycles;
+        s_sync_pending &= ~(1 << core);
+    }
+    ring_put(cycles, arg, seq, event, core);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void audio_trace_init(void) {
+    s_sync_cycles = TRACE_SYNC_INTERVAL_US * esp_rom_get_cpu_ticks_per_us();
+    audio_mem_account("trace ring", sizeof(s_ring) + sizeof(s_batch), false);
+    // 优先级低于接收和解码任务，导出只占它们的空闲时间
+    audio_mem_create_task(AUDIO_TASK_TRACE, trace_server_task, "trace", NULL, 2, 0);
+}
+
+// 主机从不发数据，读到EOF或出错就是已经断开。没有事件可导出时send不会失败，靠这里及时停止记录
+static bool client_alive(int sock) {
+    char c;
+    int len = recv(sock, &c, 1, MSG_DONTWAIT);
+    return len > 0 || (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+// 把缓冲区里的事件取出来发完，发送失败返回false
+static bool drain(int sock) {
+    while (1) {
+        portENTER_CRITICAL(&s_lock);
+        uint32_t n = s_head - s_tail;
+        if (n > TRACE_BATCH_RECORDS - 1) {
+            n = TRACE_BATCH_RECORDS - 1;    // 留一条的位置给丢弃事件
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            s_batch[i] = s_ring[(s_tail + i) & (TRACE_RING_RECORDS - 1)];
+        }
+        s_tail += n;
+        uint32_t dropped = s_dropped;
+        s_dropped = 0;
+        portEXIT_CRITICAL(&s_lock);
+
+        if (dropped != 0) {
+            audio_trace_record_t* r = &s_batch[n++];
+            memset(r, 0, sizeof(*r));
+            r->event = TRACE_DROPPED;
+            r->arg = dropped;
+        }
+        if (n == 0) {
+            return true;
+        }
+        const char* p = (const char*)s_batch;
+        int to_write = n * sizeof(audio_trace_record_t);
+        while (to_write > 0) {
+            int written = send(sock, p, to_write, 0);
+            if (written < 0) {
+                return false;
+            }
+            p += written;
+            to_write -= written;
+        }
+    }
+}
+
+static void trace_server_task(void* pvParameters) {
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(AUDIO_TRACE_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    int listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (listen_sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        vTaskDelete(NULL);
+        return;
+    }
+    int opt = 1;
+    setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (bind(listen_sock, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_sock, 1) != 0) {
+        ESP_LOGE(TAG, "Unable to listen on port %d: errno %d", AUDIO_TRACE_PORT, errno);
+        close(listen_sock);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    while (1) {
+        int sock = accept(listen_sock, NULL, NULL);
+        if (sock < 0) {
+            ESP_LOGE(TAG, "Unable to accept connection: errno %d", errno);
+            break;
+        }
+        int idle = TRACE_KEEPALIVE_IDLE_S;
+        int interval = TRACE_KEEPALIVE_INTERVAL_S;
+        int count = TRACE_KEEPALIVE_COUNT;
+        setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt));
+        setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+        setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+        setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+        uint32_t mhz = esp_rom_get_cpu_ticks_per_us();
+        uint8_t header[8] = {'A', 'T', 'R', 'C', AUDIO_TRACE_VERSION, sizeof(audio_trace_record_t),
+                             (uint8_t)(mhz & 0xFF), (uint8_t)(mhz >> 8)};
+        if (send(sock, header, sizeof(header), 0) == sizeof(header)) {
+            ESP_LOGI(TAG, "Trace client connected");
+            portENTER_CRITICAL(&s_lock);
+            s_head = s_tail = 0;
+            s_dropped = 0;
+            s_sync_pending = (1 << portNUM_PROCESSORS) - 1;
+            s_enabled = true;
+            portEXIT_CRITICAL(&s_lock);
+            do {
+                vTaskDelay(pdMS_TO_TICKS(TRACE_DRAIN_MS));
+            } while (client_alive(sock) && drain(sock));
+            s_enabled = false;
+            ESP_LOGI(TAG, "Trace client disconnected");
+        }
+        shutdown(sock, 0);
+        close(sock);
+    }
+    close(listen_sock);
+    vTaskDelete(NULL);
+}
+
+#endif
@@ -0,0 +1,43 @@
+// 音频链路的二进制跟踪：接收、解码、I2S各阶段在关键点记一条事件到内存环形缓冲区，
+// 由一个低优先级任务从旁路TCP端口AUDIO_TRACE_PORT导出，主机端trace_stats工具统计各阶段耗时分布。
+// 记录一条事件只读一次CPU周期计数器再写12字节，不走UART，不影响音频时序。
+#pragma once
+
+#include <stdint.h>
+
+// 置0时所有audio_trace()调用编译为空
+#define AUDIO_TRACE_ENABLE 1
+#define AUDIO_TRACE_PORT 1029
+
+// 事件类型，和主机端trace_stats.cpp保持一致
+enum {
+    TRACE_SYNC = 0,         // 时间同步，arg为esp_timer_get_time()的低32位，主机据此把各核的周期计数换算到同一时间轴
+    TRACE_RX = 1,           // 收到一个完整的包，arg为包长
+    TRACE_DECODE_START = 2, // 解码任务从池队列取到包，arg为队列里还剩的包数
+    TRACE_DECODE_END = 3,   // 解码完成，arg为解出的采样数
+    TRACE_I2S_END = 4,      // i2s_write返回，arg为写入的字节数
+    TRACE_UNDERRUN = 5,     // 播放时间线追上了解码，arg为累计欠载次数
+    TRACE_DROPPED = 6,      // 环形缓冲区满丢掉的事件数，由导出任务插入
+};
+
+// 导出流的开头: "ATRC" | 版本(1字节) | 每条记录字节数(1字节) | CPU频率MHz(2字节,小端)
+#define AUDIO_TRACE_MAGIC "ATRC"
+#define AUDIO_TRACE_VERSION 1
+
+// 一条事件记录，小端，12字节
+typedef struct {
+    uint32_t cycles;    // esp_cpu_get_cycle_count()，每个核各自计数
+    uint32_t arg;
+    uint16_t seq;       // 包序号，接收任务和解码任务各自按包计数，池队列先进先出所以序号一一对应
+    uint8_t event;
+    uint8_t core;
+} audio_trace_record_t;
+
+#if AUDIO_TRACE_ENABLE
+// 创建环形缓冲区和导出任务，主机连上导出端口后才开始记录
+void audio_trace_init(void);
+void audio_trace(uint8_t event, uint16_t seq, uint32_t arg);
+#else
+static inline void audio_trace_init(void) {}
+static inline void audio_trace(uint8_t event, uint16_t seq, uint32_t arg) {}
+#endif
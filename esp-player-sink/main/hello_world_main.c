@@ -9,11 +9,13 @@
 #include "esp_flash.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/pool_queue.h"
 #include "freertos/event_groups.h"
 #include "freertos/task.h"
 #include "sdkconfig.h"
 
 #include "esp_event.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
@@ -28,8 +30,13 @@
 #include "lwip/sockets.h"
 
 #include "driver/i2s.h"
+#include "esp_timer.h"
 #include <sys/time.h>
 
+#include "audio_mem.h"
+#include "audio_rx_raw.h"
+#include "audio_trace.h"
+
 #define ESP_WIFI_SSID "dududu"
 #define ESP_WIFI_PASS "00000000"
 #define ESP_MAXIMUM_RETRY 5
@@ -51,19 +58,33 @@ static EventGroupHandle_t s_wifi_event_group;
 #define FRAMELEN 2.5
 #define CHANNELS 2
 #define frame_size (RATE/1000*20)
+// 主机端用repacketizer把多帧聚合成一个包，最长AGGREGATE_BUDGET_MS，和主机保持一致
+#define AGGREGATE_BUDGET_MS 40
+#define MAX_DECODE_SAMPLES (RATE/1000*AGGREGATE_BUDGET_MS)
+// 聚合包解码后可能有多帧，放在静态区避免占用任务栈
+static opus_int16 s_pcm_out[MAX_DECODE_SAMPLES*CHANNELS];
 static int s_retry_num = 0;
 
-QueueHandle_t xqueue_data;		//创建队列的句柄,要定义为全局变量
-QueueHandle_t xqueue_len;		//创建队列的句柄,要定义为全局变量
+// 回传给主机的链路报告，主机据此调整编码复杂度和码率
+// 确认包10字节: "ok" | 解码队列积压包数 | 欠载次数低8位 | 抖动(大端2字节,单位100us) | 保留
+#define REPORT_JITTER_UNIT_US 100
+static volatile uint32_t s_underruns = 0;	//播放时间线追上了解码，I2S断流的次数
+
+// 池队列、解码器、任务都在开机时由audio_mem建好，每次连接复用
+#if !AUDIO_RX_RAW
+PoolQueueHandle_t xpool_data;	//数据包池队列的句柄,要定义为全局变量
+#endif
 
 void wifi_init_sta(void);
 static void event_handler(void* arg,
                           esp_event_base_t event_base,
                           int32_t event_id,
                           void* event_data);
+#if !AUDIO_RX_RAW
 static void tcp_server_task(void* pvParameters);
-static void do_retransmit(const int sock);
 static void do_decode(const int sock);
+#endif
+static void do_retransmit(const int sock);
 static void do_decode2(void* pvParameters);
 void i2s_config_proc();
 
@@ -103,16 +124,47 @@ void app_main(void) {
 
     printf("Minimum free heap size: %d bytes\n",
            esp_get_minimum_free_heap_size());
+
+    // 音频引擎开机时一次建好，之后重连都复用，连接期间不再分配内存
+#if !AUDIO_RX_RAW
+    xpool_data = audio_mem_create_pool();//池里的块都用完时接收任务阻塞等解码任务归还
+#endif
+    OpusDecoder* decoder = audio_mem_create_decoder(RATE, CHANNELS);
+    audio_mem_account("pcm out buffer", sizeof(s_pcm_out), false);
+    // I2S驱动的DMA缓冲区只能由驱动从堆上分配，开机装一次不再卸载，按装驱动前后的堆余量记账
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE
+    heap_caps_cache_flush();
+#endif
+    size_t heap_before_i2s = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    i2s_config_proc();
+#ifdef CONFIG_HEAP_SIZE_CLASS_CACHE
+    heap_caps_cache_flush();
+#endif
+    audio_mem_account("i2s driver + dma", heap_before_i2s - heap_caps_get_free_size(MALLOC_CAP_DEFAULT), true);
+    audio_mem_create_task(AUDIO_TASK_DECODE, do_decode2, "decode__", decoder, 5, 1);
+    audio_trace_init();
+#if AUDIO_RX_RAW
+    // 收包在tcpip线程的回调里完成，不需要接收任务
+    audio_rx_raw_start(PORT, &s_underruns);
+#else
 #ifdef CONFIG_EXAMPLE_IPV4
-    xTaskCreatePinnedToCore(tcp_server_task, "tcp_server", 25000, (void*)AF_INET, 5, NULL,0);
+    audio_mem_create_task(AUDIO_TASK_TCP_SERVER, tcp_server_task, "tcp_server", (void*)AF_INET, 5, 0);
 #endif
 #ifdef CONFIG_EXAMPLE_IPV6
     xTaskCreatePinnedToCore(tcp_server_task, "tcp_server", 25000, (void*)AF_INET6, 5, NULL,0);
 #endif
+#endif
+    audio_mem_report();
 
     for (int i = 10000; i >= 0; i--) {
        // printf("Restarting in %d seconds...\n", i);
         vTaskDelay(10000 / portTICK_PERIOD_MS);
+#ifdef CONFIG_HEAP_PROFILING
+        // 每10分钟打印一次堆分配的采样结果，用audiostream-host/heap_profile解析；在main任务里打，不占音频任务的时间
+        if (i % 60 == 0) {
+            heap_caps_profile_dump();
+        }
+#endif
     }
     //printf("Restarting now.\n");
     fflush(stdout);
@@ -238,6 +290,7 @@ static void do_retransmit(const int sock) {
     } while (len > 0);
 }
 
+#if !AUDIO_RX_RAW
 static void tcp_server_task(void* pvParameters) {
     char addr_str[128];
     int addr_family = (int)pvParameters;
@@ -316,6 +369,8 @@ static void tcp_server_task(void* pvParameters) {
         setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval,
                    sizeof(int));
         setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(int));
+        // 报告只有10字节，不等上一个报告的ACK就发出去
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &keepAlive, sizeof(int));
         // Convert ip address to string
         if (source_addr.ss_family == PF_INET) {
             inet_ntoa_r(((struct sockaddr_in*)&source_addr)->sin_addr, addr_str,
@@ -329,10 +384,6 @@ static void tcp_server_task(void* pvParameters) {
 #endif
         ESP_LOGI(TAG, "Socket accepted ip address: %s", addr_str);
 
-        i2s_config_proc();
-
-        ESP_LOGI(TAG, "i2s config end.\n");
-
         do_decode(sock);
 
         ESP_LOGI(TAG, "Exit Decoding.\n");
@@ -347,32 +398,60 @@ CLEAN_UP:
     vTaskDelete(NULL);
 }
 
+// 收满len字节，lwIP的recv()不支持MSG_WAITALL。返回len，连接关闭返回0，出错返回-1
+static int recv_all(const int sock, unsigned char* buf, int len) {
+    int got = 0;
+    while (got < len) {
+        int n = recv(sock, buf + got, len - got, 0);
+        if (n <= 0) {
+            return n;
+        }
+        got += n;
+    }
+    return got;
+}
+
 static void do_decode(const int sock) {
     int err, len;
-    unsigned char rx_buffer[640];
+    unsigned char header[PACKET_HEADER_LEN];
+    unsigned char *rx_buffer;
     struct timeval start, end,start1,end1,start2,end2,start3,end3,start4,end4;
 	int a=0;
     char confirm[10]="ok";
+    // RFC3550的到达抖动，以包里的音频时长作为发送间隔
+    int64_t last_arrival = 0;
+    int last_duration_us = 0;
+    int64_t jitter_us = 0;
+    static uint16_t seq = 0;	//包序号，解码任务那边按同样的顺序计数，解码任务跨连接一直运行，所以重连后接着数
 
-    xqueue_data = xQueueCreate( 10, 450);//这个是初始化队列，char就是队列的数据类型，允许结构体型
-    xqueue_len = xQueueCreate( 10, sizeof( int ) );//这个是初始化队列，char就是队列的数据类型，允许结构体型
-    xTaskCreatePinnedToCore(do_decode2, "decode__", 18000, NULL, 5, NULL,1);
-
+    audio_mem_watch(true);
     while (1) {
         //printf("do_decode core is %d\n",xPortGetCoreID());
-        gettimeofday(&start,NULL);
         //---------------------------------------------------------------------//
         //gettimeofday(&start3,NULL);
         //gettimeofday(&start1,NULL);
-        len = recv(sock,rx_buffer, sizeof(rx_buffer), 0);
+        xPoolQueueAcquire(xpool_data, (void **)&rx_buffer, portMAX_DELAY);
+        // 先收包头里的包长，再收满整个包，一次recv()可能只有半个包，也可能带着下一个包的开头
+        len = recv_all(sock, header, PACKET_HEADER_LEN);
+        if (len > 0) {
+            int packet_len = (header[0] << 8) | header[1];
+            if (packet_len == 0 || packet_len > MAX_AGGREGATE_PACKET) {
+                ESP_LOGE(TAG, "Bad packet length %d", packet_len);
+                xPoolQueueRelease(xpool_data, rx_buffer);
+                break;
+            }
+            len = recv_all(sock, rx_buffer, packet_len);
+        }
         //gettimeofday(&end1,NULL);
 		//printf("len=%d           recv %dus\n",len,end1.tv_usec-start1.tv_usec);
         //-------------------------------------------------------------------//
         if (len < 0) {
             ESP_LOGE(TAG, "Error occurred during receiving: errno %d", errno);
+            xPoolQueueRelease(xpool_data, rx_buffer);
 			break;
         } else if (len == 0) {
             ESP_LOGW(TAG, "Connection closed");
+            xPoolQueueRelease(xpool_data, rx_buffer);
 			break;
         }
         else {
@@ -380,6 +459,23 @@ static void do_decode(const int sock) {
             //rx_buffer[len] = 0;  // Null-terminate whatever is received and
                                  // treat it like a string
             //ESP_LOGI(TAG, "Received %d", len);
+			audio_trace(TRACE_RX, seq, len);
+			int64_t arrival = esp_timer_get_time();
+			int nb_samples = opus_packet_get_nb_samples(rx_buffer, len, RATE);
+			if (last_arrival != 0) {
+				int64_t d = (arrival - last_arrival) - last_duration_us;
+				if (d < 0) d = -d;
+				jitter_us += (d - jitter_us) / 16;
+			}
+			last_arrival = arrival;
+			last_duration_us = nb_samples > 0 ? (int)((int64_t)nb_samples * 1000000 / RATE) : 0;
+			int jitter_units = (int)(jitter_us / REPORT_JITTER_UNIT_US);
+			if (jitter_units > 0xFFFF) jitter_units = 0xFFFF;
+			UBaseType_t waiting = uxPoolQueueMessagesWaiting(xpool_data);
+			confirm[2] = (char)(waiting > 0xFF ? 0xFF : waiting);
+			confirm[3] = (char)(s_underruns & 0xFF);
+			confirm[4] = (char)(jitter_units >> 8);
+			confirm[5] = (char)(jitter_units & 0xFF);
 			//gettimeofday(&start1,NULL);
 			send(sock,confirm,10,0);	
 			//gettimeofday(&end1,NULL);
@@ -391,14 +487,8 @@ static void do_decode(const int sock) {
             const TickType_t xTicksToWait = pdMS_TO_TICKS(100);  //阻塞时间，此参数指示当队列空的时候任务进入阻塞态等待队列有数据的最大时间。如果为0的话当队列空的时候就立即返回；当为portMAX_DELAY的话就会一直等待，直到队列有数据，也就是死等，但是INCLUDE_vTaskSuspend必须为1。
 
 			//gettimeofday(&start1,NULL);
-            xStatus = xQueueSendToFront( xqueue_len, &len,portMAX_DELAY);
-			//gettimeofday(&end1,NULL);
-            if( xStatus == pdPASS){
-                //printf("send_queue len ok,is %dus\n",end1.tv_usec-start1.tv_usec);
-            }
-    
-			//gettimeofday(&start1,NULL);
-            xStatus = xQueueSendToFront( xqueue_data, &rx_buffer,portMAX_DELAY);//把数据写入队列
+            xStatus = xPoolQueuePost(xpool_data, rx_buffer, len);//把块交给解码任务，只传指针和长度
+            seq++;
 			//gettimeofday(&end1,NULL);
             if( xStatus == pdPASS){
                 //printf("send_queue data ok,is %dus\n",end1.tv_usec-start1.tv_usec);
@@ -430,23 +520,28 @@ static void do_decode(const int sock) {
             //ESP_LOGI(TAG,"memset %dus",end1.tv_usec-start1.tv_usec);
             //ESP_LOGI(TAG,"end2 %dus",end2.tv_usec-start2.tv_usec);
         }
-        gettimeofday(&end,NULL);
-		printf("                            socket   one time %lf ms\n",((end.tv_sec-start.tv_sec)*1000.0+(end.tv_usec-start.tv_usec)/1000.0));
     }
+    audio_mem_watch(false);
 }
+#endif
 static void do_decode2(void* pvParameters){
-    int err,len;
-    OpusDecoder* decoder = opus_decoder_create(RATE, CHANNELS, &err);
-    if (err < 0) {
-        fprintf(stderr, "failed to create decoder: %s\n", opus_strerror(err));
-    }
-    opus_int16 out1[1920];
+    int len;
+    OpusDecoder* decoder = (OpusDecoder*)pvParameters;
+    opus_int16 *out1 = s_pcm_out;
     int decodeSamples;
-    unsigned char rx_buffer[640];
+    unsigned char *rx_buffer;
+    // 每解码1秒音频统计一次解码耗时和包数
+    int64_t decode_us = 0;
+    int decoded_samples = 0;
+    int packets = 0;
+    // 已经交给I2S的音频播放到什么时刻，新数据到得比这个晚就是欠载
+    int64_t playout_end = 0;
+    uint16_t seq = 0;	//和接收任务的包序号一一对应
     const TickType_t xTicksToWait = pdMS_TO_TICKS(50);
     struct timeval start, end,start1,end1,start2,end2,start3,end3,start4,end4;
 	gettimeofday(&start3,NULL);
     int a=0;
+    audio_mem_watch(true);
     while(1){
         //printf("do_decode2 core is %d\n",xPortGetCoreID());
         BaseType_t xStatus;			//返回值
@@ -454,31 +549,71 @@ static void do_decode2(void* pvParameters){
         //printf("xQueueReceive data before %d \n",start4.tv_usec);
 
 		//gettimeofday(&start1,NULL);
-        xStatus = xQueueReceive( xqueue_data, &rx_buffer, portMAX_DELAY );  //从队列中取一条数据到data_get
+#if AUDIO_RX_RAW
+        audio_rx_packet_t pkt;
+        audio_rx_raw_receive(&pkt);  //从解码队列取一个包，pbuf还没释放，数据直接在pbuf里
+        rx_buffer = pkt.data;
+        len = pkt.len;
+        audio_trace(TRACE_DECODE_START, seq, audio_rx_raw_waiting());
+#else
+        size_t block_len;
+        rx_buffer = pvPoolQueueReceive(xpool_data, &block_len, portMAX_DELAY);  //从池队列中取一个块，块里就是接收任务recv到的数据
 		//gettimeofday(&end1,NULL);
-        if( xStatus == pdPASS){
-           // printf("recv data ok,is %d us\n",end1.tv_usec-start1.tv_usec);
-        }
+        len = (int)block_len;
+        audio_trace(TRACE_DECODE_START, seq, uxPoolQueueMessagesWaiting(xpool_data));
+#endif
         //printf("xQueueReceive data after %d \n",end1.tv_usec);
 
-		//gettimeofday(&start1,NULL);
-        xStatus = xQueueReceive( xqueue_len, &len, portMAX_DELAY );  //从队列中取一条数据到data_get
-		//gettimeofday(&end1,NULL);
-        if( xStatus == pdPASS){
-            //printf("recv len ok,len=%d ,is %dus\n",len,end1.tv_usec-start1.tv_usec);
-        }
-        //printf("xQueueReceive len after %d \n",end1.tv_usec);
-
-        //gettimeofday(&start1,NULL);
+        int64_t decode_start = esp_timer_get_time();
         decodeSamples =
-        opus_decode(decoder, rx_buffer, len, out1, frame_size, 0);
+        opus_decode(decoder, rx_buffer, len, out1, MAX_DECODE_SAMPLES, 0);
+        decode_us += esp_timer_get_time() - decode_start;
+#if AUDIO_RX_RAW
+        audio_rx_raw_release(&pkt);	//解码完就释放pbuf，不用等I2S写完
+#else
+        xPoolQueueRelease(xpool_data, rx_buffer);	//解码完就还回池，不用等I2S写完
+#endif
+        audio_trace(TRACE_DECODE_END, seq, decodeSamples < 0 ? 0 : decodeSamples);
+        if (decodeSamples < 0) {
+            ESP_LOGE(TAG, "opus_decode failed: %s", opus_strerror(decodeSamples));
+            seq++;
+            continue;
+        }
+        packets++;
+        decoded_samples += decodeSamples;
+        if (decoded_samples >= RATE) {
+#if AUDIO_RX_RAW
+            printf("decode %lld us per second of audio, %d packets/s\n",
+                   decode_us * RATE / decoded_samples, packets * RATE / decoded_samples);
+            audio_rx_raw_report();
+#else
+            PoolQueueStats_t pool_stats;
+            vPoolQueueGetStats(xpool_data, &pool_stats, pdTRUE);
+            printf("decode %lld us per second of audio, %d packets/s, pool max %d/%d blocks\n",
+                   decode_us * RATE / decoded_samples, packets * RATE / decoded_samples,
+                   pool_stats.uxMaxBlocksInUse, pool_stats.uxBlockCount);
+#endif
+            decode_us = 0;
+            decoded_samples = 0;
+            packets = 0;
+            audio_mem_check();
+        }
         //gettimeofday(&end1,NULL);
     	//printf("opus_decode %dus\n",end1.tv_usec-start1.tv_usec);
         //printf("decodeSamples= %d\n", decodeSamples);
         //printf("decoder  after %d \n",end1.tv_usec);
+        int64_t now = esp_timer_get_time();
+        if (playout_end != 0 && now > playout_end) {
+            s_underruns++;
+            audio_trace(TRACE_UNDERRUN, seq, s_underruns);
+        }
+        playout_end = (now > playout_end ? now : playout_end) +
+                      (int64_t)decodeSamples * 1000000 / RATE;
         size_t BytesWritten;
         //gettimeofday(&start1,NULL);
         ESP_ERROR_CHECK(i2s_write(I2S_NUM_0, out1, decodeSamples*4, &BytesWritten, portMAX_DELAY));
+        audio_trace(TRACE_I2S_END, seq, BytesWritten);
+        seq++;
         //gettimeofday(&end1,NULL);
         //printf("i2s_write %dus\n",end1.tv_usec-start1.tv_usec);
         //printf("BytesWritten=%d\n",BytesWritten);
@@ -487,7 +622,9 @@ static void do_decode2(void* pvParameters){
 
 	        gettimeofday(&end3,NULL);
             printf("ceshi is %lf ms\n",((end3.tv_sec-start3.tv_sec)*1000.0+(end3.tv_usec-start3.tv_usec)/1000.0));
-            break;
+            //解码任务开机建好后一直运行，每2000包重新计时
+            start3 = end3;
+            a = 0;
         }
 
         //gettimeofday(&end4,NULL);